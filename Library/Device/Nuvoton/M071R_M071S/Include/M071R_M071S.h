@@ -103,6 +103,9 @@ typedef enum IRQn {
 /*@}*/ /* end of group CMSIS */
 
 
+#if defined(HOST_SIM)
+#include "host_sim.h"                   /* Host-side register model simulator                     */
+#endif
 #include "core_cm0.h"                   /* Cortex-M0 processor and core peripherals               */
 #include "system_M071R_M071S.h"          /* System                                                 */
 
@@ -292,7 +295,11 @@ typedef enum IRQn {
 
 typedef volatile unsigned char  vu8;        ///< Define 8-bit unsigned volatile data type
 typedef volatile unsigned short vu16;       ///< Define 16-bit unsigned volatile data type
+#if defined(HOST_SIM)
+typedef volatile unsigned int   vu32;       ///< Define 32-bit unsigned volatile data type (LP64 host build)
+#else
 typedef volatile unsigned long  vu32;       ///< Define 32-bit unsigned volatile data type
+#endif
 
 /**
   * @brief Get a 8-bit unsigned value from specified address
@@ -507,6 +514,11 @@ typedef volatile unsigned long  vu32;       ///< Define 32-bit unsigned volatile
 #include "pdma.h"
 #include "clk.h"
 #include "ebi.h"
+#include "trace.h"
+#include "kvs.h"
+#include "fwu.h"
+#include "usbd_msc.h"
+#include "usbd_cdc.h"
 #endif
 
 /*@}*/ /* end of REGISTER group Definitions */
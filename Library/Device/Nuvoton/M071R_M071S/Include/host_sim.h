@@ -0,0 +1,270 @@
+/**************************************************************************//**
+ * @file     host_sim.h
+ * @version  V1.00
+ * @brief    M071R_M071S Series host-side register model simulator header file
+ *
+ * @details  When HOST_SIM is defined, M071R_M071S.h includes this file in place of the
+ *           Cortex-M0 intrinsic headers so the Standard Driver and the sample code can be
+ *           compiled with a native Linux GCC and executed against register models.
+ *
+ *           Peripheral registers stay at their real addresses (AHB 0x50000000, APB1 0x40000000,
+ *           APB2 0x40100000, SCS 0xE000E000). Every access traps, the owning model refreshes or
+ *           consumes the register, and the simulated HCLK clock advances. Interrupt handlers with
+ *           the names of the GCC startup file are invoked when an enabled IRQ line is asserted.
+ *
+ *           The intended target is i386 (ILP32, the same data model as the Cortex-M0):
+ *
+ *               gcc -m32 -DHOST_SIM -I<CMSIS/Include> -I<Device/Include> -I<StdDriver/inc> \
+ *                   main.c <StdDriver/src sources but retarget.c> system_M071R_M071S.c     \
+ *                   <Source/host sources>
+ *
+ *           On x86-64 add -no-pie -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast and keep every
+ *           buffer handed to PDMA static, because PDMA address registers hold only 32 bits.
+ *
+ *           Flash is not executable on the host. APROM above the first page and LDROM are mapped
+ *           read-only at their real addresses; page 0 cannot be mapped because of mmap_min_addr.
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2026 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#ifndef __HOST_SIM_H__
+#define __HOST_SIM_H__
+
+#include <stdint.h>
+
+/* The GCC intrinsics in core_cmInstr.h and core_cmFunc.h are Thumb assembly. Claim their
+   include guards and provide host equivalents instead. */
+#define __CORE_CMINSTR_H
+#define __CORE_CMFUNC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @addtogroup HOST_SIM Host Simulator
+  @{
+*/
+
+/** @addtogroup HOST_SIM_EXPORTED_CONSTANTS Host Simulator Exported Constants
+  @{
+*/
+
+#define SIM_UART_NUM            3           /*!< Number of simulated UART ports (UART0 ~ UART2) */
+#define SIM_SPI_NUM             2           /*!< Number of simulated SPI ports (SPI0 ~ SPI1) */
+#define SIM_APROM_SIZE          0x20000     /*!< Simulated APROM size (128 KB) */
+
+#define SIM_USBD_NAK            (-1)        /*!< SIM_UsbdIn/SIM_UsbdOut: endpoint answered NAK */
+#define SIM_USBD_STALL          (-2)        /*!< SIM_UsbdIn/SIM_UsbdOut: endpoint answered STALL */
+#define SIM_USBD_NO_EP          (-3)        /*!< SIM_UsbdIn/SIM_UsbdOut: no endpoint is configured for the address */
+
+/*@}*/ /* end of group HOST_SIM_EXPORTED_CONSTANTS */
+
+
+/** @addtogroup HOST_SIM_EXPORTED_FUNCTIONS Host Simulator Exported Functions
+  @{
+*/
+
+/**
+  * @brief      Callback of a device attached to a simulated SPI port
+  * @param[in]  u32Port     SPI port index.
+  * @param[in]  u32SsMask   Slave select lines asserted during this transfer (bit0: SS0, bit1: SS1).
+  * @param[in]  u32TxData   Data shifted out on MOSI, right aligned.
+  * @param[in]  u32BitLen   Transfer bit length, 1 ~ 32.
+  * @return     Data shifted in on MISO, right aligned.
+  */
+typedef uint32_t (*SIM_SPI_DEVICE_T)(uint32_t u32Port, uint32_t u32SsMask, uint32_t u32TxData, uint32_t u32BitLen);
+
+/**
+  * @brief      Callback invoked when the CPU waits for an interrupt and no model has a pending event
+  * @return     Non-zero if the callback produced new stimulus, 0 to terminate the simulation.
+  */
+typedef int32_t (*SIM_IDLE_CB_T)(void);
+
+/**
+  * @brief      Callback invoked on a system reset request (AIRCR.SYSRESETREQ)
+  */
+typedef void (*SIM_RESET_CB_T)(void);
+
+/* Core */
+void     SIM_Init(void);
+uint64_t SIM_GetCycles(void);
+uint32_t SIM_GetHCLKFreq(void);
+void     SIM_Advance(uint32_t u32Cycles);
+void     SIM_AdvanceUs(uint32_t u32Us);
+void     SIM_WaitForInterrupt(void);
+void     SIM_SetAccessCost(uint32_t u32Cycles);
+void     SIM_SetIdleCallback(SIM_IDLE_CB_T pfnIdle);
+void     SIM_SetResetCallback(SIM_RESET_CB_T pfnReset);
+uint32_t SIM_GetPrimask(void);
+void     SIM_SetPrimask(uint32_t u32Primask);
+void     SIM_EnableIrq(void);
+
+/* UART */
+uint32_t SIM_UartInject(uint32_t u32Port, const uint8_t *pu8Data, uint32_t u32Len);
+uint32_t SIM_UartRead(uint32_t u32Port, uint8_t *pu8Buf, uint32_t u32Len);
+uint32_t SIM_UartPending(uint32_t u32Port);
+void     SIM_UartSetEcho(uint32_t u32Port, uint32_t u32Enable);
+void     SIM_UartConnect(uint32_t u32Port0, uint32_t u32Port1);
+uint32_t SIM_UartGetOverrunCount(uint32_t u32Port);
+
+/* SPI */
+void     SIM_SpiAttach(uint32_t u32Port, SIM_SPI_DEVICE_T pfnDevice);
+
+/* FMC */
+void     SIM_FmcLoad(uint32_t u32Addr, const void *pvData, uint32_t u32Len);
+void     SIM_FmcDump(uint32_t u32Addr, void *pvBuf, uint32_t u32Len);
+void     SIM_FmcErase(uint32_t u32Addr, uint32_t u32Len);
+void     SIM_FmcSetTiming(uint32_t u32ProgramUs, uint32_t u32EraseUs);
+uint32_t SIM_FmcGetEraseCount(uint32_t u32Addr);
+uint32_t SIM_FmcGetProgramCount(void);
+
+/* USBD */
+void     SIM_UsbdAttach(uint32_t u32Attach);
+void     SIM_UsbdBusReset(void);
+void     SIM_UsbdSetup(const uint8_t au8Setup[8]);
+int32_t  SIM_UsbdIn(uint32_t u32EpAddr, uint8_t *pu8Buf, uint32_t u32Size);
+int32_t  SIM_UsbdOut(uint32_t u32EpAddr, const uint8_t *pu8Data, uint32_t u32Len);
+int32_t  SIM_UsbdControl(const uint8_t au8Setup[8], uint8_t *pu8Data, uint32_t u32Len);
+
+/* Memory view used by PDMA and by the harness: returns a host pointer for a device address */
+void    *SIM_MemPtr(uint32_t u32Addr, uint32_t u32Len);
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Cortex-M0 intrinsics                                                                                   */
+/*---------------------------------------------------------------------------------------------------------*/
+#define __BKPT(value)   __builtin_trap()
+
+static inline void __NOP(void)
+{
+    SIM_Advance(1);
+}
+
+static inline void __WFI(void)
+{
+    SIM_WaitForInterrupt();
+}
+
+static inline void __WFE(void)
+{
+    SIM_WaitForInterrupt();
+}
+
+static inline void __SEV(void)
+{
+}
+
+static inline void __ISB(void)
+{
+    __sync_synchronize();
+}
+
+static inline void __DSB(void)
+{
+    __sync_synchronize();
+}
+
+static inline void __DMB(void)
+{
+    __sync_synchronize();
+}
+
+static inline uint32_t __REV(uint32_t value)
+{
+    return __builtin_bswap32(value);
+}
+
+static inline uint32_t __REV16(uint32_t value)
+{
+    return ((value & 0xFF00FF00UL) >> 8) | ((value & 0x00FF00FFUL) << 8);
+}
+
+static inline int32_t __REVSH(int32_t value)
+{
+    return (int32_t)(int16_t)__builtin_bswap16((uint16_t)value);
+}
+
+static inline uint32_t __ROR(uint32_t op1, uint32_t op2)
+{
+    op2 &= 31;
+    return (op2 == 0) ? op1 : ((op1 >> op2) | (op1 << (32 - op2)));
+}
+
+static inline void __enable_irq(void)
+{
+    SIM_EnableIrq();
+}
+
+static inline void __disable_irq(void)
+{
+    SIM_SetPrimask(1);
+}
+
+static inline uint32_t __get_PRIMASK(void)
+{
+    return SIM_GetPrimask();
+}
+
+static inline void __set_PRIMASK(uint32_t priMask)
+{
+    SIM_SetPrimask(priMask);
+}
+
+static inline uint32_t __get_CONTROL(void)
+{
+    return 0;
+}
+
+static inline void __set_CONTROL(uint32_t control)
+{
+    (void)control;
+}
+
+static inline uint32_t __get_IPSR(void)
+{
+    return 0;
+}
+
+static inline uint32_t __get_APSR(void)
+{
+    return 0;
+}
+
+static inline uint32_t __get_xPSR(void)
+{
+    return 0x01000000UL;
+}
+
+static inline uint32_t __get_PSP(void)
+{
+    return 0;
+}
+
+static inline void __set_PSP(uint32_t topOfProcStack)
+{
+    (void)topOfProcStack;
+}
+
+static inline uint32_t __get_MSP(void)
+{
+    return 0;
+}
+
+static inline void __set_MSP(uint32_t topOfMainStack)
+{
+    (void)topOfMainStack;
+}
+
+/*@}*/ /* end of group HOST_SIM_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group HOST_SIM */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __HOST_SIM_H__ */
+
+/*** (C) COPYRIGHT 2026 Nuvoton Technology Corp. ***/
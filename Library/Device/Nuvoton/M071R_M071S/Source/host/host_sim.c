@@ -0,0 +1,1044 @@
+/**************************************************************************//**
+ * @file     host_sim.c
+ * @version  V1.00
+ * @brief    M071R_M071S Series host simulator core: address windows, access traps, HCLK clock,
+ *           NVIC, SysTick, SCB, CLK and GCR models
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2026 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include "host_sim_model.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE     0x100000
+#endif
+
+#define SIM_PAGE_SIZE           0x1000UL
+#define SIM_MAX_MODELS          32
+#define SIM_MAX_PENDING         8
+#define SIM_X86_TF              0x100UL     /* EFLAGS trap flag: single step */
+#define SIM_PF_WRITE            0x2UL       /* Page fault error code: write access */
+#define SIM_POLL_SKIP           8           /* Identical reads in a row that make a polling loop */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Address windows                                                                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+typedef struct
+{
+    uint32_t u32Base;
+    uint32_t u32Size;
+    uint8_t *pu8Alias;
+} SIM_WINDOW_T;
+
+static SIM_WINDOW_T s_asWindow[] =
+{
+    { AHB_BASE,   0x11000, 0 },
+    { APB1_BASE,  0xE1000, 0 },
+    { APB2_BASE,  0x55000, 0 },
+    { SCS_BASE,   0x01000, 0 },
+};
+
+#define SIM_WINDOW_NUM          (sizeof(s_asWindow) / sizeof(s_asWindow[0]))
+
+typedef struct
+{
+    uint32_t            u32Addr;
+    int32_t             i32IsWrite;
+    uint32_t            u32Old;
+    const SIM_MODEL_T  *psModel;
+} SIM_ACCESS_T;
+
+static const SIM_MODEL_T *s_apsModel[SIM_MAX_MODELS];
+static uint32_t s_u32ModelNum;
+
+static SIM_ACCESS_T s_asPending[SIM_MAX_PENDING];
+static volatile uint32_t s_u32PendingNum;
+
+/* Polling loop detection: the last register read, its value and how often it was read in a row */
+static uint32_t s_u32PollAddr;
+static uint32_t s_u32PollVal;
+static uint32_t s_u32PollCnt;
+
+static int32_t  s_i32Inited;
+static uint64_t s_u64Now;
+static uint32_t s_u32AccessCost = 2;
+static uint32_t s_u32Primask;
+static int32_t  s_i32ActiveException;
+
+static SIM_IDLE_CB_T  s_pfnIdle;
+static SIM_RESET_CB_T s_pfnReset;
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Exception handlers. The names and the vector order follow startup_M071R_M071S.S                        */
+/*---------------------------------------------------------------------------------------------------------*/
+void Default_Handler(void);
+
+#define SIM_WEAK_HANDLER(name)  void name(void) __attribute__((weak, alias("Default_Handler")))
+
+SIM_WEAK_HANDLER(PendSV_Handler);
+SIM_WEAK_HANDLER(SysTick_Handler);
+SIM_WEAK_HANDLER(BOD_IRQHandler);
+SIM_WEAK_HANDLER(WDT_IRQHandler);
+SIM_WEAK_HANDLER(EINT0_IRQHandler);
+SIM_WEAK_HANDLER(EINT1_IRQHandler);
+SIM_WEAK_HANDLER(GPAB_IRQHandler);
+SIM_WEAK_HANDLER(GPCDEF_IRQHandler);
+SIM_WEAK_HANDLER(PWMA_IRQHandler);
+SIM_WEAK_HANDLER(PWMB_IRQHandler);
+SIM_WEAK_HANDLER(TMR0_IRQHandler);
+SIM_WEAK_HANDLER(TMR1_IRQHandler);
+SIM_WEAK_HANDLER(TMR2_IRQHandler);
+SIM_WEAK_HANDLER(TMR3_IRQHandler);
+SIM_WEAK_HANDLER(UART02_IRQHandler);
+SIM_WEAK_HANDLER(UART1_IRQHandler);
+SIM_WEAK_HANDLER(SPI0_IRQHandler);
+SIM_WEAK_HANDLER(SPI1_IRQHandler);
+SIM_WEAK_HANDLER(I2C0_IRQHandler);
+SIM_WEAK_HANDLER(I2C1_IRQHandler);
+SIM_WEAK_HANDLER(USBD_IRQHandler);
+SIM_WEAK_HANDLER(PDMA_IRQHandler);
+SIM_WEAK_HANDLER(PWRWU_IRQHandler);
+SIM_WEAK_HANDLER(ADC_IRQHandler);
+SIM_WEAK_HANDLER(RTC_IRQHandler);
+
+static void (* const s_apfnIrqHandler[32])(void) =
+{
+    BOD_IRQHandler,     WDT_IRQHandler,     EINT0_IRQHandler,   EINT1_IRQHandler,
+    GPAB_IRQHandler,    GPCDEF_IRQHandler,  PWMA_IRQHandler,    PWMB_IRQHandler,
+    TMR0_IRQHandler,    TMR1_IRQHandler,    TMR2_IRQHandler,    TMR3_IRQHandler,
+    UART02_IRQHandler,  UART1_IRQHandler,   SPI0_IRQHandler,    SPI1_IRQHandler,
+    Default_Handler,    Default_Handler,    I2C0_IRQHandler,    I2C1_IRQHandler,
+    Default_Handler,    Default_Handler,    Default_Handler,    USBD_IRQHandler,
+    Default_Handler,    Default_Handler,    PDMA_IRQHandler,    Default_Handler,
+    PWRWU_IRQHandler,   ADC_IRQHandler,     Default_Handler,    RTC_IRQHandler,
+};
+
+void Default_Handler(void)
+{
+    fprintf(stderr, "sim: unhandled exception %d at cycle %llu\n",
+            s_i32ActiveException, (unsigned long long)s_u64Now);
+    abort();
+}
+
+/* SystemInit() is called by Reset_Handler on the target. Run it too if it is linked. */
+extern void SystemInit(void) __attribute__((weak));
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Window and model lookup                                                                                */
+/*---------------------------------------------------------------------------------------------------------*/
+static SIM_WINDOW_T *SIM_FindWindow(uint32_t u32Addr)
+{
+    uint32_t i;
+
+    for(i = 0; i < SIM_WINDOW_NUM; i++)
+    {
+        if((u32Addr - s_asWindow[i].u32Base) < s_asWindow[i].u32Size)
+            return &s_asWindow[i];
+    }
+    return NULL;
+}
+
+static const SIM_MODEL_T *SIM_FindModel(uint32_t u32Addr)
+{
+    uint32_t i;
+
+    for(i = 0; i < s_u32ModelNum; i++)
+    {
+        if((u32Addr - s_apsModel[i]->u32Base) < s_apsModel[i]->u32Size)
+            return s_apsModel[i];
+    }
+    return NULL;
+}
+
+void *SIM_Backdoor(uint32_t u32Addr)
+{
+    SIM_WINDOW_T *psWin = SIM_FindWindow(u32Addr);
+
+    if(psWin == NULL)
+    {
+        fprintf(stderr, "sim: backdoor access outside the register windows: 0x%08x\n", u32Addr);
+        abort();
+    }
+    return psWin->pu8Alias + (u32Addr - psWin->u32Base);
+}
+
+void *SIM_MemPtr(uint32_t u32Addr, uint32_t u32Len)
+{
+    void *pvFlash;
+
+    if(SIM_FindWindow(u32Addr) != NULL)
+        return SIM_Backdoor(u32Addr);
+
+    pvFlash = SIM_FmcPtr(u32Addr, u32Len);
+    if(pvFlash != NULL)
+        return pvFlash;
+
+    return (void *)(uintptr_t)u32Addr;
+}
+
+void SIM_RegisterModel(const SIM_MODEL_T *psModel)
+{
+    if(s_u32ModelNum >= SIM_MAX_MODELS)
+    {
+        fprintf(stderr, "sim: too many models\n");
+        abort();
+    }
+    s_apsModel[s_u32ModelNum++] = psModel;
+    if(psModel->pfnReset)
+        psModel->pfnReset(psModel->pvCtx);
+}
+
+void SIM_ResetModel(const char *pcName)
+{
+    uint32_t i;
+
+    for(i = 0; i < s_u32ModelNum; i++)
+    {
+        if((strcmp(s_apsModel[i]->pcName, pcName) == 0) && s_apsModel[i]->pfnReset)
+            s_apsModel[i]->pfnReset(s_apsModel[i]->pvCtx);
+    }
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Clock                                                                                                  */
+/*---------------------------------------------------------------------------------------------------------*/
+uint32_t SIM_GetPLLFreq(void)
+{
+    static const uint32_t au32NoTbl[4] = {1, 2, 2, 4};
+    uint32_t u32PllCon = SIM_BD(CLK)->PLLCON;
+    uint32_t u32Fin, u32NF, u32NR, u32NO;
+
+    if(u32PllCon & (CLK_PLLCON_PD_Msk | CLK_PLLCON_OE_Msk))
+        return 0;
+
+    u32Fin = (u32PllCon & CLK_PLLCON_PLL_SRC_HIRC) ? __HIRC : __HXT;
+    if(u32PllCon & CLK_PLLCON_BP_Msk)
+        return u32Fin;
+
+    u32NO = au32NoTbl[(u32PllCon & CLK_PLLCON_OUT_DV_Msk) >> CLK_PLLCON_OUT_DV_Pos];
+    u32NF = ((u32PllCon & CLK_PLLCON_FB_DV_Msk) >> CLK_PLLCON_FB_DV_Pos) + 2;
+    u32NR = ((u32PllCon & CLK_PLLCON_IN_DV_Msk) >> CLK_PLLCON_IN_DV_Pos) + 2;
+
+    return (((u32Fin >> 2) * u32NF) / (u32NR * u32NO)) << 2;
+}
+
+uint32_t SIM_GetHCLKFreq(void)
+{
+    uint32_t u32Freq;
+
+    switch(SIM_BD(CLK)->CLKSEL0 & CLK_CLKSEL0_HCLK_S_Msk)
+    {
+        case 0:
+            u32Freq = __HXT;
+            break;
+        case 1:
+            u32Freq = __LXT;
+            break;
+        case 2:
+            u32Freq = SIM_GetPLLFreq();
+            break;
+        case 3:
+            u32Freq = __LIRC;
+            break;
+        default:
+            u32Freq = __HIRC;
+            break;
+    }
+
+    u32Freq /= (SIM_BD(CLK)->CLKDIV & CLK_CLKDIV_HCLK_N_Msk) + 1;
+
+    return (u32Freq != 0) ? u32Freq : __HIRC;
+}
+
+uint64_t SIM_CyclesFor(uint64_t u64Ticks, uint32_t u32TickFreq)
+{
+    uint64_t u64Hclk = SIM_GetHCLKFreq();
+
+    if(u32TickFreq == 0)
+        return SIM_NO_EVENT;
+
+    return (u64Ticks * u64Hclk + u32TickFreq - 1) / u32TickFreq;
+}
+
+uint64_t SIM_Now(void)
+{
+    return s_u64Now;
+}
+
+/* The CPU is held off for u64Cycles, e.g. instruction fetch from flash during an ISP operation.
+   Interrupts raised meanwhile are taken after the stalled access. */
+void SIM_Stall(uint64_t u64Cycles)
+{
+    s_u64Now += u64Cycles;
+    SIM_Sync();
+}
+
+uint64_t SIM_GetCycles(void)
+{
+    return s_u64Now;
+}
+
+void SIM_SetAccessCost(uint32_t u32Cycles)
+{
+    s_u32AccessCost = u32Cycles;
+}
+
+void SIM_SetIdleCallback(SIM_IDLE_CB_T pfnIdle)
+{
+    s_pfnIdle = pfnIdle;
+}
+
+void SIM_SetResetCallback(SIM_RESET_CB_T pfnReset)
+{
+    s_pfnReset = pfnReset;
+}
+
+void SIM_SystemReset(void)
+{
+    if(s_pfnReset)
+        s_pfnReset();
+
+    fprintf(stderr, "sim: system reset requested at cycle %llu\n", (unsigned long long)s_u64Now);
+    exit(0);
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  SCS: NVIC, SCB and SysTick                                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+#define SCS_SYST_CSR        0x010
+#define SCS_SYST_RVR        0x014
+#define SCS_SYST_CVR        0x018
+#define SCS_SYST_CALIB      0x01C
+#define SCS_NVIC_ISER       0x100
+#define SCS_NVIC_ICER       0x180
+#define SCS_NVIC_ISPR       0x200
+#define SCS_NVIC_ICPR       0x280
+#define SCS_NVIC_IPR        0x400
+#define SCS_SCB_CPUID       0xD00
+#define SCS_SCB_ICSR        0xD04
+#define SCS_SCB_AIRCR       0xD0C
+#define SCS_SCB_SHPR3       0xD20
+
+typedef struct
+{
+    uint32_t u32Enabled;        /* NVIC enable bits */
+    uint32_t u32SwPending;      /* NVIC pending bits set by software */
+    uint32_t u32Lines;          /* Interrupt lines asserted by the models */
+    int32_t  i32SysTickPending;
+    int32_t  i32PendSVPending;
+
+    /* SysTick: the counter held u32RefVal at cycle u64Ref */
+    uint32_t u32Ctrl;
+    uint32_t u32RefVal;
+    uint64_t u64Ref;
+    uint32_t u32CountFlag;
+} SIM_SCS_T;
+
+static SIM_SCS_T s_sScs;
+
+#define SCS_REG(off)        (*(volatile uint32_t *)SIM_Backdoor(SCS_BASE + (off)))
+
+static uint32_t SysTick_Freq(void)
+{
+    if(s_sScs.u32Ctrl & SysTick_CTRL_CLKSOURCE_Msk)
+        return SIM_GetHCLKFreq();
+
+    switch((SIM_BD(CLK)->CLKSEL0 & CLK_CLKSEL0_STCLK_S_Msk) >> CLK_CLKSEL0_STCLK_S_Pos)
+    {
+        case 0:
+            return __HXT;
+        case 1:
+            return __LXT;
+        case 2:
+            return __HXT / 2;
+        case 3:
+            return SIM_GetHCLKFreq() / 2;
+        default:
+            return __HIRC / 2;
+    }
+}
+
+static int32_t SysTick_Running(void)
+{
+    return (s_sScs.u32Ctrl & SysTick_CTRL_ENABLE_Msk) && (SCS_REG(SCS_SYST_RVR) & 0xFFFFFF);
+}
+
+/* Counter value at cycle u64Now, assuming no zero crossing since the reference point */
+static uint32_t SysTick_Value(uint64_t u64Now)
+{
+    uint64_t u64Ticks;
+    uint32_t u32Load = SCS_REG(SCS_SYST_RVR) & 0xFFFFFF;
+
+    if(!SysTick_Running())
+        return s_sScs.u32RefVal;
+
+    u64Ticks = ((u64Now - s_sScs.u64Ref) * SysTick_Freq()) / SIM_GetHCLKFreq();
+
+    if(s_sScs.u32RefVal == 0)
+        return (u64Ticks == 0) ? 0 : (u32Load - (uint32_t)(u64Ticks - 1));
+
+    return s_sScs.u32RefVal - (uint32_t)u64Ticks;
+}
+
+static uint64_t SysTick_NextZero(void)
+{
+    uint32_t u32Load = SCS_REG(SCS_SYST_RVR) & 0xFFFFFF;
+    uint64_t u64Ticks;
+
+    if(!SysTick_Running())
+        return SIM_NO_EVENT;
+
+    u64Ticks = (s_sScs.u32RefVal == 0) ? ((uint64_t)u32Load + 1) : s_sScs.u32RefVal;
+
+    return s_sScs.u64Ref + SIM_CyclesFor(u64Ticks, SysTick_Freq());
+}
+
+static void SysTick_Update(uint64_t u64Now)
+{
+    uint64_t u64Zero;
+
+    while((u64Zero = SysTick_NextZero()) <= u64Now)
+    {
+        s_sScs.u64Ref = u64Zero;
+        s_sScs.u32RefVal = 0;
+        s_sScs.u32CountFlag = 1;
+        if(s_sScs.u32Ctrl & SysTick_CTRL_TICKINT_Msk)
+            s_sScs.i32SysTickPending = 1;
+    }
+}
+
+static void SCS_Reset(void *pvCtx)
+{
+    (void)pvCtx;
+    memset(&s_sScs, 0, sizeof(s_sScs));
+    memset(SIM_Backdoor(SCS_BASE), 0, 0x1000);
+    SCS_REG(SCS_SCB_CPUID) = 0x410CC200;
+    SCS_REG(SCS_SCB_AIRCR) = 0xFA050000;
+    SCS_REG(SCS_SYST_CALIB) = 0x80000000;
+}
+
+static void SCS_PreAccess(void *pvCtx, uint32_t u32Offset)
+{
+    uint32_t u32Pending = s_sScs.u32SwPending | s_sScs.u32Lines;
+
+    (void)pvCtx;
+    switch(u32Offset)
+    {
+        case SCS_SYST_CSR:
+            SCS_REG(SCS_SYST_CSR) = s_sScs.u32Ctrl | (s_sScs.u32CountFlag << SysTick_CTRL_COUNTFLAG_Pos);
+            break;
+        case SCS_SYST_CVR:
+            SCS_REG(SCS_SYST_CVR) = SysTick_Value(s_u64Now);
+            break;
+        case SCS_NVIC_ISER:
+        case SCS_NVIC_ICER:
+            SCS_REG(u32Offset) = s_sScs.u32Enabled;
+            break;
+        case SCS_NVIC_ISPR:
+        case SCS_NVIC_ICPR:
+            SCS_REG(u32Offset) = u32Pending;
+            break;
+        case SCS_SCB_ICSR:
+            SCS_REG(SCS_SCB_ICSR) = (s_sScs.i32SysTickPending ? SCB_ICSR_PENDSTSET_Msk : 0) |
+                                    (s_sScs.i32PendSVPending ? SCB_ICSR_PENDSVSET_Msk : 0) |
+                                    ((u32Pending & s_sScs.u32Enabled) ? SCB_ICSR_ISRPENDING_Msk : 0) |
+                                    ((s_i32ActiveException >= 0) ? (uint32_t)s_i32ActiveException : 0);
+            break;
+        case SCS_SCB_AIRCR:
+            SCS_REG(SCS_SCB_AIRCR) = 0xFA050000;
+            break;
+        default:
+            break;
+    }
+}
+
+static void SCS_PostAccess(void *pvCtx, uint32_t u32Offset, int32_t i32IsWrite, uint32_t u32Old)
+{
+    uint32_t u32Val = SCS_REG(u32Offset);
+
+    (void)pvCtx;
+    (void)u32Old;
+
+    if(!i32IsWrite)
+    {
+        if(u32Offset == SCS_SYST_CSR)
+            s_sScs.u32CountFlag = 0;
+        return;
+    }
+
+    switch(u32Offset)
+    {
+        case SCS_SYST_CSR:
+            /* Freeze the counter with the old settings, then restart with the new ones */
+            s_sScs.u32RefVal = SysTick_Value(s_u64Now);
+            s_sScs.u64Ref = s_u64Now;
+            s_sScs.u32Ctrl = u32Val & (SysTick_CTRL_ENABLE_Msk | SysTick_CTRL_TICKINT_Msk | SysTick_CTRL_CLKSOURCE_Msk);
+            break;
+        case SCS_SYST_RVR:
+            SCS_REG(SCS_SYST_RVR) = u32Val & 0xFFFFFF;
+            break;
+        case SCS_SYST_CVR:
+            s_sScs.u32RefVal = 0;
+            s_sScs.u64Ref = s_u64Now;
+            s_sScs.u32CountFlag = 0;
+            break;
+        case SCS_NVIC_ISER:
+            s_sScs.u32Enabled |= u32Val;
+            break;
+        case SCS_NVIC_ICER:
+            s_sScs.u32Enabled &= ~u32Val;
+            break;
+        case SCS_NVIC_ISPR:
+            s_sScs.u32SwPending |= u32Val;
+            break;
+        case SCS_NVIC_ICPR:
+            s_sScs.u32SwPending &= ~u32Val;
+            break;
+        case SCS_SCB_ICSR:
+            if(u32Val & SCB_ICSR_PENDSTSET_Msk)
+                s_sScs.i32SysTickPending = 1;
+            if(u32Val & SCB_ICSR_PENDSTCLR_Msk)
+                s_sScs.i32SysTickPending = 0;
+            if(u32Val & SCB_ICSR_PENDSVSET_Msk)
+                s_sScs.i32PendSVPending = 1;
+            if(u32Val & SCB_ICSR_PENDSVCLR_Msk)
+                s_sScs.i32PendSVPending = 0;
+            break;
+        case SCS_SCB_AIRCR:
+            if(((u32Val >> 16) == 0x05FA) && (u32Val & SCB_AIRCR_SYSRESETREQ_Msk))
+                SIM_SystemReset();
+            break;
+        default:
+            break;
+    }
+}
+
+static void SCS_Update(void *pvCtx, uint64_t u64Now)
+{
+    (void)pvCtx;
+    SysTick_Update(u64Now);
+}
+
+static uint64_t SCS_NextEvent(void *pvCtx)
+{
+    (void)pvCtx;
+    return SysTick_NextZero();
+}
+
+static const SIM_MODEL_T s_sScsModel =
+{
+    "SCS", SCS_BASE, 0x1000, NULL,
+    SCS_Reset, SCS_PreAccess, SCS_PostAccess, SCS_Update, SCS_NextEvent, NULL
+};
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  CLK: every oscillator is reported stable as soon as it is enabled                                      */
+/*---------------------------------------------------------------------------------------------------------*/
+static void CLK_ModelReset(void *pvCtx)
+{
+    CLK_T *clk = SIM_BD(CLK);
+
+    (void)pvCtx;
+    memset(clk, 0, 0x100);
+    clk->PWRCON  = CLK_PWRCON_OSC22M_EN_Msk | CLK_PWRCON_OSC10K_EN_Msk | CLK_PWRCON_XTL12M_EN_Msk;
+    clk->AHBCLK  = CLK_AHBCLK_ISP_EN_Msk;
+    clk->APBCLK  = CLK_APBCLK_WDT_EN_Msk;
+    clk->CLKSEL0 = 0x3F;
+    clk->CLKSEL1 = 0xFFFFFFFF;
+    clk->CLKSEL2 = 0x000000FF;
+    clk->PLLCON  = 0x0005C22E;
+}
+
+static void CLK_ModelPreAccess(void *pvCtx, uint32_t u32Offset)
+{
+    CLK_T *clk = SIM_BD(CLK);
+    uint32_t u32Sts = 0;
+
+    (void)pvCtx;
+    if(u32Offset != offsetof(CLK_T, CLKSTATUS))
+        return;
+
+    if(clk->PWRCON & CLK_PWRCON_XTL12M_EN_Msk)
+        u32Sts |= CLK_CLKSTATUS_XTL12M_STB_Msk;
+    if(clk->PWRCON & CLK_PWRCON_XTL32K_EN_Msk)
+        u32Sts |= CLK_CLKSTATUS_XTL32K_STB_Msk;
+    if(clk->PWRCON & CLK_PWRCON_OSC22M_EN_Msk)
+        u32Sts |= CLK_CLKSTATUS_OSC22M_STB_Msk;
+    if(clk->PWRCON & CLK_PWRCON_OSC10K_EN_Msk)
+        u32Sts |= CLK_CLKSTATUS_OSC10K_STB_Msk;
+    if(!(clk->PLLCON & CLK_PLLCON_PD_Msk))
+        u32Sts |= CLK_CLKSTATUS_PLL_STB_Msk;
+
+    clk->CLKSTATUS = u32Sts;
+}
+
+static const SIM_MODEL_T s_sClkModel =
+{
+    "CLK", CLK_BASE, 0x100, NULL,
+    CLK_ModelReset, CLK_ModelPreAccess, NULL, NULL, NULL, NULL
+};
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  GCR: write protection sequence, chip/CPU reset and IP reset                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint32_t s_u32UnlockStep;
+
+static void GCR_ModelReset(void *pvCtx)
+{
+    GCR_T *gcr = SIM_BD(SYS);
+
+    (void)pvCtx;
+    memset(gcr, 0, 0x200);
+    SIM_RO(gcr->PDID) = 0x10007101;
+    gcr->RSTSRC = SYS_RSTSRC_RSTS_POR_Msk | SYS_RSTSRC_RSTS_RESET_Msk;
+    s_u32UnlockStep = 0;
+}
+
+static void GCR_ModelPostAccess(void *pvCtx, uint32_t u32Offset, int32_t i32IsWrite, uint32_t u32Old)
+{
+    static const uint8_t au8Key[3] = {0x59, 0x16, 0x88};
+    static const struct
+    {
+        uint32_t    u32Msk;
+        const char *pcName;
+    } asIpRst[] =
+    {
+        { SYS_IPRSTC2_UART0_RST_Msk, "UART0" },
+        { SYS_IPRSTC2_UART1_RST_Msk, "UART1" },
+        { SYS_IPRSTC2_UART2_RST_Msk, "UART2" },
+        { SYS_IPRSTC2_SPI0_RST_Msk,  "SPI0"  },
+        { SYS_IPRSTC2_SPI1_RST_Msk,  "SPI1"  },
+        { SYS_IPRSTC2_USBD_RST_Msk,  "USBD"  },
+    };
+    GCR_T *gcr = SIM_BD(SYS);
+    uint32_t u32Val, i;
+
+    (void)pvCtx;
+    if(!i32IsWrite)
+        return;
+
+    switch(u32Offset)
+    {
+        case offsetof(GCR_T, REGWRPROT):
+            u32Val = gcr->REGWRPROT & 0xFF;
+            if((u32Old & 1) && (u32Val != 0))
+            {
+                /* Already unlocked: only writing 0 locks again */
+                gcr->REGWRPROT = 1;
+                break;
+            }
+            if(u32Val == au8Key[s_u32UnlockStep])
+                s_u32UnlockStep++;
+            else
+                s_u32UnlockStep = (u32Val == au8Key[0]) ? 1 : 0;
+
+            gcr->REGWRPROT = (s_u32UnlockStep == 3) ? 1 : 0;
+            if(s_u32UnlockStep == 3)
+                s_u32UnlockStep = 0;
+            break;
+
+        case offsetof(GCR_T, RSTSRC):
+            /* Write 1 to clear */
+            gcr->RSTSRC = u32Old & ~gcr->RSTSRC;
+            break;
+
+        case offsetof(GCR_T, IPRSTC1):
+            u32Val = gcr->IPRSTC1;
+            if(u32Val & (SYS_IPRSTC1_CHIP_RST_Msk | SYS_IPRSTC1_CPU_RST_Msk))
+                SIM_SystemReset();
+            if(u32Val & SYS_IPRSTC1_PDMA_RST_Msk)
+                SIM_ResetModel("PDMA");
+            break;
+
+        case offsetof(GCR_T, IPRSTC2):
+            u32Val = gcr->IPRSTC2;
+            for(i = 0; i < sizeof(asIpRst) / sizeof(asIpRst[0]); i++)
+            {
+                if(u32Val & asIpRst[i].u32Msk)
+                    SIM_ResetModel(asIpRst[i].pcName);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static const SIM_MODEL_T s_sGcrModel =
+{
+    "GCR", GCR_BASE, 0x200, NULL,
+    GCR_ModelReset, NULL, GCR_ModelPostAccess, NULL, NULL, NULL
+};
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Time and interrupts                                                                                    */
+/*---------------------------------------------------------------------------------------------------------*/
+void SIM_Sync(void)
+{
+    uint32_t i, u32Lines = 0;
+
+    for(i = 0; i < s_u32ModelNum; i++)
+    {
+        if(s_apsModel[i]->pfnUpdate)
+            s_apsModel[i]->pfnUpdate(s_apsModel[i]->pvCtx, s_u64Now);
+    }
+
+    for(i = 0; i < s_u32ModelNum; i++)
+    {
+        if(s_apsModel[i]->pfnIrq)
+            u32Lines |= s_apsModel[i]->pfnIrq(s_apsModel[i]->pvCtx);
+    }
+    s_sScs.u32Lines = u32Lines;
+}
+
+static uint64_t SIM_NextEvent(void)
+{
+    uint64_t u64Next = SIM_NO_EVENT, u64Evt;
+    uint32_t i;
+
+    for(i = 0; i < s_u32ModelNum; i++)
+    {
+        if(s_apsModel[i]->pfnNextEvent)
+        {
+            u64Evt = s_apsModel[i]->pfnNextEvent(s_apsModel[i]->pvCtx);
+            if(u64Evt < u64Next)
+                u64Next = u64Evt;
+        }
+    }
+    return u64Next;
+}
+
+static uint32_t SIM_Priority(int32_t i32Exception)
+{
+    uint32_t u32Reg, u32Shift;
+
+    if(i32Exception < 16)
+    {
+        u32Reg = SCS_REG(SCS_SCB_SHPR3);
+        u32Shift = (i32Exception == 15) ? 24 : 16;
+    }
+    else
+    {
+        u32Reg = SCS_REG(SCS_NVIC_IPR + (((i32Exception - 16) >> 2) << 2));
+        u32Shift = ((i32Exception - 16) & 3) * 8;
+    }
+    return (u32Reg >> u32Shift) & 0xC0;
+}
+
+/* Highest priority pending exception, -1 if none. Preemption between handlers is not modelled. */
+static int32_t SIM_PendingException(void)
+{
+    uint32_t u32Irq = (s_sScs.u32Lines | s_sScs.u32SwPending) & s_sScs.u32Enabled;
+    int32_t  i32Best = -1, i;
+    uint32_t u32BestPri = 0x100, u32Pri;
+
+    if(s_sScs.i32PendSVPending)
+    {
+        i32Best = 14;
+        u32BestPri = SIM_Priority(14);
+    }
+    if(s_sScs.i32SysTickPending && ((u32Pri = SIM_Priority(15)) < u32BestPri))
+    {
+        i32Best = 15;
+        u32BestPri = u32Pri;
+    }
+    for(i = 0; i < 32; i++)
+    {
+        if((u32Irq & (1UL << i)) && ((u32Pri = SIM_Priority(16 + i)) < u32BestPri))
+        {
+            i32Best = 16 + i;
+            u32BestPri = u32Pri;
+        }
+    }
+    return i32Best;
+}
+
+void SIM_Dispatch(void)
+{
+    int32_t i32Exc;
+
+    if(!s_i32Inited || (s_i32ActiveException >= 0))
+        return;
+
+    while(!s_u32Primask && ((i32Exc = SIM_PendingException()) >= 0))
+    {
+        s_i32ActiveException = i32Exc;
+        if(i32Exc == 14)
+        {
+            s_sScs.i32PendSVPending = 0;
+            PendSV_Handler();
+        }
+        else if(i32Exc == 15)
+        {
+            s_sScs.i32SysTickPending = 0;
+            SysTick_Handler();
+        }
+        else
+        {
+            s_sScs.u32SwPending &= ~(1UL << (i32Exc - 16));
+            s_apfnIrqHandler[i32Exc - 16]();
+        }
+        s_i32ActiveException = -1;
+        SIM_Sync();
+    }
+}
+
+void SIM_Advance(uint32_t u32Cycles)
+{
+    uint64_t u64Target = s_u64Now + u32Cycles;
+    uint64_t u64Next;
+
+    SIM_Init();
+    while((u64Next = SIM_NextEvent()) <= u64Target)
+    {
+        if(u64Next > s_u64Now)
+            s_u64Now = u64Next;
+        SIM_Sync();
+        SIM_Dispatch();
+    }
+    s_u64Now = u64Target;
+    SIM_Sync();
+    SIM_Dispatch();
+}
+
+void SIM_AdvanceUs(uint32_t u32Us)
+{
+    SIM_Advance((uint32_t)(((uint64_t)SIM_GetHCLKFreq() * u32Us) / 1000000));
+}
+
+void SIM_WaitForInterrupt(void)
+{
+    uint64_t u64Next;
+
+    SIM_Init();
+    SIM_Sync();
+    while(SIM_PendingException() < 0)
+    {
+        u64Next = SIM_NextEvent();
+        if(u64Next == SIM_NO_EVENT)
+        {
+            if(s_pfnIdle && s_pfnIdle())
+            {
+                SIM_Sync();
+                continue;
+            }
+            fprintf(stderr, "sim: WFI with no pending event at cycle %llu\n", (unsigned long long)s_u64Now);
+            exit(0);
+        }
+        if(u64Next > s_u64Now)
+            s_u64Now = u64Next;
+        SIM_Sync();
+    }
+    SIM_Dispatch();
+}
+
+uint32_t SIM_GetPrimask(void)
+{
+    return s_u32Primask;
+}
+
+void SIM_SetPrimask(uint32_t u32Primask)
+{
+    s_u32Primask = u32Primask & 1;
+    if(!s_u32Primask)
+        SIM_Dispatch();
+}
+
+void SIM_EnableIrq(void)
+{
+    SIM_SetPrimask(0);
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Access traps                                                                                           */
+/*                                                                                                         */
+/*  The CPU view of every window is PROT_NONE. An access raises SIGSEGV: the owning model refreshes the    */
+/*  register, the page is opened and the trap flag is set. After the single instruction has executed,     */
+/*  SIGTRAP closes the page again and lets the model react to what was read or written.                   */
+/*                                                                                                         */
+/*  A register that keeps returning the same value is being polled. Nothing can change it before the next */
+/*  model event, so the clock jumps to that event instead of trapping through the whole wait.             */
+/*---------------------------------------------------------------------------------------------------------*/
+#if defined(__x86_64__)
+#define SIM_UC_ERR(uc)          ((uc)->uc_mcontext.gregs[REG_ERR])
+#define SIM_UC_EFL(uc)          ((uc)->uc_mcontext.gregs[REG_EFL])
+#elif defined(__i386__)
+#define SIM_UC_ERR(uc)          ((uc)->uc_mcontext.gregs[REG_ERR])
+#define SIM_UC_EFL(uc)          ((uc)->uc_mcontext.gregs[REG_EFL])
+#else
+#error "HOST_SIM supports x86 hosts only"
+#endif
+
+static void SIM_Fatal(const char *pcMsg, uintptr_t uAddr)
+{
+    fprintf(stderr, "sim: %s 0x%08lx\n", pcMsg, (unsigned long)uAddr);
+    signal(SIGSEGV, SIG_DFL);
+    abort();
+}
+
+static void SIM_SegvHandler(int32_t i32Sig, siginfo_t *psInfo, void *pvCtx)
+{
+    ucontext_t *psUc = (ucontext_t *)pvCtx;
+    uintptr_t uAddr = (uintptr_t)psInfo->si_addr;
+    uint32_t u32Addr = (uint32_t)uAddr;
+    const SIM_MODEL_T *psModel;
+    SIM_ACCESS_T *psAcc;
+
+    (void)i32Sig;
+    if((uAddr != u32Addr) || (SIM_FindWindow(u32Addr) == NULL))
+        SIM_Fatal("invalid memory access at", uAddr);
+    if(s_u32PendingNum >= SIM_MAX_PENDING)
+        SIM_Fatal("too many register accesses in one instruction at", uAddr);
+
+    u32Addr &= ~3UL;
+    s_u64Now += s_u32AccessCost;
+    SIM_Sync();
+
+    psModel = SIM_FindModel(u32Addr);
+    if(psModel && psModel->pfnPreAccess)
+        psModel->pfnPreAccess(psModel->pvCtx, u32Addr - psModel->u32Base);
+
+    psAcc = &s_asPending[s_u32PendingNum++];
+    psAcc->u32Addr = u32Addr;
+    psAcc->i32IsWrite = (SIM_UC_ERR(psUc) & SIM_PF_WRITE) ? 1 : 0;
+    psAcc->u32Old = *(volatile uint32_t *)SIM_Backdoor(u32Addr);
+    psAcc->psModel = psModel;
+
+    mprotect((void *)(uintptr_t)(u32Addr & ~(SIM_PAGE_SIZE - 1)), SIM_PAGE_SIZE, PROT_READ | PROT_WRITE);
+    SIM_UC_EFL(psUc) |= SIM_X86_TF;
+}
+
+static void SIM_TrapHandler(int32_t i32Sig, siginfo_t *psInfo, void *pvCtx)
+{
+    ucontext_t *psUc = (ucontext_t *)pvCtx;
+    SIM_ACCESS_T asAcc[SIM_MAX_PENDING];
+    uint32_t u32Num, i;
+
+    (void)i32Sig;
+    (void)psInfo;
+    SIM_UC_EFL(psUc) &= ~SIM_X86_TF;
+
+    u32Num = s_u32PendingNum;
+    memcpy(asAcc, s_asPending, u32Num * sizeof(SIM_ACCESS_T));
+    s_u32PendingNum = 0;
+
+    for(i = 0; i < u32Num; i++)
+        mprotect((void *)(uintptr_t)(asAcc[i].u32Addr & ~(SIM_PAGE_SIZE - 1)), SIM_PAGE_SIZE, PROT_NONE);
+
+    for(i = 0; i < u32Num; i++)
+    {
+        if(asAcc[i].psModel && asAcc[i].psModel->pfnPostAccess)
+            asAcc[i].psModel->pfnPostAccess(asAcc[i].psModel->pvCtx, asAcc[i].u32Addr - asAcc[i].psModel->u32Base,
+                                            asAcc[i].i32IsWrite, asAcc[i].u32Old);
+    }
+
+    if((u32Num == 1) && !asAcc[0].i32IsWrite &&
+            (asAcc[0].u32Addr == s_u32PollAddr) && (asAcc[0].u32Old == s_u32PollVal))
+    {
+        if(++s_u32PollCnt >= SIM_POLL_SKIP)
+        {
+            uint64_t u64Next = SIM_NextEvent();
+
+            if((u64Next != SIM_NO_EVENT) && (u64Next > s_u64Now))
+                s_u64Now = u64Next;
+            s_u32PollCnt = 0;
+        }
+    }
+    else
+    {
+        s_u32PollAddr = ((u32Num == 1) && !asAcc[0].i32IsWrite) ? asAcc[0].u32Addr : 0;
+        s_u32PollVal = asAcc[0].u32Old;
+        s_u32PollCnt = 0;
+    }
+
+    SIM_Sync();
+    SIM_Dispatch();
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Initialization                                                                                         */
+/*---------------------------------------------------------------------------------------------------------*/
+static void SIM_MapWindow(SIM_WINDOW_T *psWin)
+{
+    int32_t i32Fd;
+    void *pvCpu;
+
+    i32Fd = memfd_create("m071_sim", 0);
+    if((i32Fd < 0) || (ftruncate(i32Fd, psWin->u32Size) != 0))
+        SIM_Fatal("cannot create the register file for window", psWin->u32Base);
+
+    pvCpu = mmap((void *)(uintptr_t)psWin->u32Base, psWin->u32Size, PROT_NONE,
+                 MAP_SHARED | MAP_FIXED_NOREPLACE, i32Fd, 0);
+    if(pvCpu != (void *)(uintptr_t)psWin->u32Base)
+        SIM_Fatal("cannot map the register window at", psWin->u32Base);
+
+    psWin->pu8Alias = mmap(NULL, psWin->u32Size, PROT_READ | PROT_WRITE, MAP_SHARED, i32Fd, 0);
+    if(psWin->pu8Alias == MAP_FAILED)
+        SIM_Fatal("cannot map the backdoor of window", psWin->u32Base);
+
+    close(i32Fd);
+}
+
+void SIM_Init(void)
+{
+    struct sigaction sAct;
+    uint32_t i;
+
+    if(s_i32Inited)
+        return;
+
+    for(i = 0; i < SIM_WINDOW_NUM; i++)
+        SIM_MapWindow(&s_asWindow[i]);
+
+    memset(&sAct, 0, sizeof(sAct));
+    sAct.sa_flags = SA_SIGINFO | SA_NODEFER;
+    sAct.sa_sigaction = (void (*)(int, siginfo_t *, void *))SIM_SegvHandler;
+    sigaction(SIGSEGV, &sAct, NULL);
+    sAct.sa_sigaction = (void (*)(int, siginfo_t *, void *))SIM_TrapHandler;
+    sigaction(SIGTRAP, &sAct, NULL);
+
+    s_i32ActiveException = -1;
+
+    SIM_RegisterModel(&s_sScsModel);
+    SIM_RegisterModel(&s_sGcrModel);
+    SIM_RegisterModel(&s_sClkModel);
+    SIM_UartRegister();
+    SIM_SpiRegister();
+    SIM_PdmaRegister();
+    SIM_FmcRegister();
+    SIM_UsbdRegister();
+
+    s_i32Inited = 1;
+    SIM_Sync();
+}
+
+/* Run before main() so that unmodified sample code starts like it does after Reset_Handler */
+static void __attribute__((constructor)) SIM_Startup(void)
+{
+    SIM_Init();
+    if(SystemInit)
+        SystemInit();
+}
+
+/*** (C) COPYRIGHT 2026 Nuvoton Technology Corp. ***/
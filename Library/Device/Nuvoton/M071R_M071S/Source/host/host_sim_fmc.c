@@ -0,0 +1,456 @@
+/**************************************************************************//**
+ * @file     host_sim_fmc.c
+ * @version  V1.00
+ * @brief    M071R_M071S Series host simulator FMC model
+ *
+ * @details  APROM, LDROM and the two User Configuration words with flash semantics: erase sets a
+ *           512 byte page to 0xFF, program can only clear bits. The ISP commands check ISPEN and the
+ *           APUEN/LDUEN/CFGUEN update enables and report violations through ISPFF. While an ISP
+ *           program or erase is in progress instruction fetch from flash stalls, so the CPU is held
+ *           off for the programmed flash timing.
+ *
+ *           APROM and LDROM are also mapped read-only at their real addresses so that code reading
+ *           flash through pointers (M32(), memcpy) sees the content. The first pages of APROM are
+ *           below vm.mmap_min_addr on most hosts; they are only reachable through the ISP commands.
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2026 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "host_sim_model.h"
+
+#ifndef MAP_FIXED_NOREPLACE
+#define MAP_FIXED_NOREPLACE     0x100000
+#endif
+
+#define SIM_FMC_PAGES           ((SIM_APROM_SIZE + FMC_LDROM_SIZE) / FMC_FLASH_PAGE_SIZE)
+#define SIM_FMC_READ_CYCLES     8
+#define SIM_FMC_CID             0xDA
+
+typedef struct
+{
+    uint8_t  *pu8Aprom;                 /* Read/write alias of the APROM array */
+    uint8_t  *pu8Ldrom;                 /* Read/write alias of the LDROM array */
+    uint32_t  au32Config[2];
+
+    uint32_t  u32ProgramUs;
+    uint32_t  u32EraseUs;
+    uint32_t  au32EraseCnt[SIM_FMC_PAGES];
+    uint32_t  u32ProgramCnt;
+} SIM_FMC_T;
+
+static SIM_FMC_T s_sFmc = { NULL, NULL, { 0xFFFFFFFF, 0xFFFFFFFF }, 25, 20000 };
+
+static const uint32_t s_au32Uid[3] = { 0x4D303731, 0x0000C0DE, 0x20260001 };
+
+static FMC_T *Fmc_Regs(void)
+{
+    return (FMC_T *)SIM_Backdoor(FMC_BASE);
+}
+
+static uint32_t Fmc_DataFlashBase(void)
+{
+    /* CONFIG0[0] DFEN: 0 = Data Flash enabled at the address held in CONFIG1 */
+    return (s_sFmc.au32Config[0] & 0x1) ? 0xFFFFFFFF : (s_sFmc.au32Config[1] & 0x000FFE00);
+}
+
+/* Backing store of a flash address, NULL if the address is not implemented */
+static uint8_t *Fmc_Array(uint32_t u32Addr, uint32_t u32Len)
+{
+    if((u32Addr < SIM_APROM_SIZE) && (u32Len <= SIM_APROM_SIZE - u32Addr))
+        return s_sFmc.pu8Aprom + u32Addr;
+
+    if((u32Addr >= FMC_LDROM_BASE) && (u32Addr - FMC_LDROM_BASE < FMC_LDROM_SIZE) &&
+            (u32Len <= FMC_LDROM_SIZE - (u32Addr - FMC_LDROM_BASE)))
+        return s_sFmc.pu8Ldrom + (u32Addr - FMC_LDROM_BASE);
+
+    return NULL;
+}
+
+static uint32_t Fmc_PageIndex(uint32_t u32Addr)
+{
+    if(u32Addr < SIM_APROM_SIZE)
+        return u32Addr / FMC_FLASH_PAGE_SIZE;
+    return (SIM_APROM_SIZE + (u32Addr - FMC_LDROM_BASE)) / FMC_FLASH_PAGE_SIZE;
+}
+
+/* Update enable check of ISP program and erase */
+static int32_t Fmc_Writable(uint32_t u32Addr)
+{
+    uint32_t u32Con = Fmc_Regs()->ISPCON;
+
+    if((u32Addr & 0xFFF00000) == FMC_CONFIG_BASE)
+        return (u32Con & FMC_ISPCON_CFGUEN_Msk) ? 1 : 0;
+
+    if((u32Addr & 0xFFF00000) == FMC_LDROM_BASE)
+        return (u32Con & FMC_ISPCON_LDUEN_Msk) ? 1 : 0;
+
+    /* Running from APROM, only Data Flash is writable unless APUEN is set */
+    if(!(u32Con & FMC_ISPCON_BS_Msk) && !(u32Con & FMC_ISPCON_APUEN_Msk) && (u32Addr < Fmc_DataFlashBase()))
+        return 0;
+
+    return 1;
+}
+
+static void Fmc_Fail(void)
+{
+    FMC_T *fmc = Fmc_Regs();
+
+    fmc->ISPCON |= FMC_ISPCON_ISPFF_Msk;
+    fmc->ISPSTA |= FMC_ISPSTA_ISPFF_Msk;
+}
+
+static uint64_t Fmc_Cycles(uint32_t u32Us)
+{
+    return ((uint64_t)SIM_GetHCLKFreq() * u32Us) / 1000000;
+}
+
+static void Fmc_Execute(void)
+{
+    FMC_T *fmc = Fmc_Regs();
+    uint32_t u32Addr = fmc->ISPADR, u32Cmd = fmc->ISPCMD;
+    uint8_t *pu8;
+    uint32_t u32Data;
+    uint64_t u64Cycles = SIM_FMC_READ_CYCLES;
+
+    if(!(fmc->ISPCON & FMC_ISPCON_ISPEN_Msk))
+    {
+        Fmc_Fail();
+        return;
+    }
+
+    switch(u32Cmd)
+    {
+        case FMC_ISPCMD_READ:
+            if((u32Addr & 0xFFF00000) == FMC_CONFIG_BASE)
+            {
+                fmc->ISPDAT = s_sFmc.au32Config[(u32Addr >> 2) & 1];
+            }
+            else if((pu8 = Fmc_Array(u32Addr & ~3UL, 4)) != NULL)
+            {
+                memcpy(&u32Data, pu8, 4);
+                fmc->ISPDAT = u32Data;
+            }
+            else
+            {
+                fmc->ISPDAT = 0xFFFFFFFF;
+                Fmc_Fail();
+            }
+            break;
+
+        case FMC_ISPCMD_PROGRAM:
+            u64Cycles = Fmc_Cycles(s_sFmc.u32ProgramUs);
+            if(!Fmc_Writable(u32Addr))
+            {
+                Fmc_Fail();
+            }
+            else if((u32Addr & 0xFFF00000) == FMC_CONFIG_BASE)
+            {
+                s_sFmc.au32Config[(u32Addr >> 2) & 1] &= fmc->ISPDAT;
+                s_sFmc.u32ProgramCnt++;
+            }
+            else if((pu8 = Fmc_Array(u32Addr & ~3UL, 4)) != NULL)
+            {
+                memcpy(&u32Data, pu8, 4);
+                u32Data &= fmc->ISPDAT;
+                memcpy(pu8, &u32Data, 4);
+                s_sFmc.u32ProgramCnt++;
+            }
+            else
+            {
+                Fmc_Fail();
+            }
+            break;
+
+        case FMC_ISPCMD_PAGE_ERASE:
+            u64Cycles = Fmc_Cycles(s_sFmc.u32EraseUs);
+            u32Addr &= ~(FMC_FLASH_PAGE_SIZE - 1);
+            if(!Fmc_Writable(u32Addr))
+            {
+                Fmc_Fail();
+            }
+            else if((u32Addr & 0xFFF00000) == FMC_CONFIG_BASE)
+            {
+                s_sFmc.au32Config[0] = s_sFmc.au32Config[1] = 0xFFFFFFFF;
+            }
+            else if((pu8 = Fmc_Array(u32Addr, FMC_FLASH_PAGE_SIZE)) != NULL)
+            {
+                memset(pu8, 0xFF, FMC_FLASH_PAGE_SIZE);
+                s_sFmc.au32EraseCnt[Fmc_PageIndex(u32Addr)]++;
+            }
+            else
+            {
+                Fmc_Fail();
+            }
+            break;
+
+        case FMC_ISPCMD_VECMAP:
+            fmc->ISPSTA = (fmc->ISPSTA & ~FMC_ISPSTA_VECMAP_Msk) |
+                          (((u32Addr >> 9) << FMC_ISPSTA_VECMAP_Pos) & FMC_ISPSTA_VECMAP_Msk);
+            break;
+
+        case FMC_ISPCMD_READ_UID:
+            fmc->ISPDAT = (u32Addr < 12) ? s_au32Uid[u32Addr >> 2] : 0xFFFFFFFF;
+            break;
+
+        case FMC_ISPCMD_READ_CID:
+            fmc->ISPDAT = SIM_FMC_CID;
+            break;
+
+        case FMC_ISPCMD_READ_DID:
+            fmc->ISPDAT = SIM_BD(SYS)->PDID;
+            break;
+
+        default:
+            Fmc_Fail();
+            break;
+    }
+
+    fmc->ISPTRG = 0;
+    fmc->ISPSTA &= ~FMC_ISPSTA_ISPGO_Msk;
+    SIM_Stall(u64Cycles);
+}
+
+static void Fmc_Reset(void *pvCtx)
+{
+    FMC_T *fmc = Fmc_Regs();
+    uint32_t u32Cbs = (s_sFmc.au32Config[0] >> 6) & 0x3;
+
+    (void)pvCtx;
+    memset(fmc, 0, 0x44);
+    /* CONFIG0[7] CBS: 1 = boot from APROM, 0 = boot from LDROM */
+    fmc->ISPCON = (u32Cbs & 0x2) ? 0 : FMC_ISPCON_BS_Msk;
+    fmc->ISPSTA = u32Cbs << FMC_ISPSTA_CBS_Pos;
+    if(!(u32Cbs & 0x2))
+        fmc->ISPSTA |= (FMC_LDROM_BASE >> 9) << FMC_ISPSTA_VECMAP_Pos;
+}
+
+static void Fmc_PreAccess(void *pvCtx, uint32_t u32Offset)
+{
+    (void)pvCtx;
+    if(u32Offset == offsetof(FMC_T, DFBADR))
+        SIM_RO(Fmc_Regs()->DFBADR) = Fmc_DataFlashBase();
+}
+
+static void Fmc_PostAccess(void *pvCtx, uint32_t u32Offset, int32_t i32IsWrite, uint32_t u32Old)
+{
+    FMC_T *fmc = Fmc_Regs();
+    uint32_t u32Val = *(volatile uint32_t *)((uint8_t *)fmc + u32Offset);
+
+    (void)pvCtx;
+    if(!i32IsWrite)
+        return;
+
+    switch(u32Offset)
+    {
+        case offsetof(FMC_T, ISPCON):
+            /* ISPFF is write 1 to clear */
+            if(u32Val & FMC_ISPCON_ISPFF_Msk)
+            {
+                u32Val &= ~FMC_ISPCON_ISPFF_Msk;
+                fmc->ISPSTA &= ~FMC_ISPSTA_ISPFF_Msk;
+            }
+            else
+            {
+                u32Val |= u32Old & FMC_ISPCON_ISPFF_Msk;
+            }
+            fmc->ISPCON = u32Val;
+            break;
+
+        case offsetof(FMC_T, ISPTRG):
+            if(u32Val & FMC_ISPTRG_ISPGO_Msk)
+            {
+                fmc->ISPSTA |= FMC_ISPSTA_ISPGO_Msk;
+                Fmc_Execute();
+            }
+            break;
+
+        case offsetof(FMC_T, DFBADR):
+            SIM_RO(fmc->DFBADR) = u32Old;
+            break;
+
+        case offsetof(FMC_T, ISPSTA):
+            if(u32Val & FMC_ISPSTA_ISPFF_Msk)
+                fmc->ISPCON &= ~FMC_ISPCON_ISPFF_Msk;
+            fmc->ISPSTA = u32Old & ~(u32Val & FMC_ISPSTA_ISPFF_Msk);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static const SIM_MODEL_T s_sFmcModel =
+{
+    "FMC", FMC_BASE, 0x100, NULL, Fmc_Reset, Fmc_PreAccess, Fmc_PostAccess, NULL, NULL, NULL
+};
+
+static uint32_t Fmc_MinMapAddr(void)
+{
+    FILE *pf = fopen("/proc/sys/vm/mmap_min_addr", "r");
+    unsigned long ulMin = 0x1000;
+
+    if(pf != NULL)
+    {
+        if(fscanf(pf, "%lu", &ulMin) != 1)
+            ulMin = 0x1000;
+        fclose(pf);
+    }
+    if(ulMin < 0x1000)
+        ulMin = 0x1000;
+    return (uint32_t)((ulMin + 0xFFF) & ~0xFFFUL);
+}
+
+/* Create the flash array and map the CPU view of [u32Base + u32From, u32Base + u32Size) read-only */
+static uint8_t *Fmc_MapArray(uint32_t u32Base, uint32_t u32Size, uint32_t u32From)
+{
+    int32_t i32Fd;
+    uint8_t *pu8Alias;
+
+    i32Fd = memfd_create("m071_flash", 0);
+    if((i32Fd < 0) || (ftruncate(i32Fd, u32Size) != 0))
+    {
+        fprintf(stderr, "sim: cannot create the flash array at 0x%08x\n", u32Base);
+        return NULL;
+    }
+
+    pu8Alias = mmap(NULL, u32Size, PROT_READ | PROT_WRITE, MAP_SHARED, i32Fd, 0);
+    if(pu8Alias == MAP_FAILED)
+    {
+        close(i32Fd);
+        return NULL;
+    }
+    memset(pu8Alias, 0xFF, u32Size);
+
+    if((u32From < u32Size) &&
+            (mmap((void *)(uintptr_t)(u32Base + u32From), u32Size - u32From, PROT_READ,
+                  MAP_SHARED | MAP_FIXED_NOREPLACE, i32Fd, u32From) != (void *)(uintptr_t)(u32Base + u32From)))
+        fprintf(stderr, "sim: flash at 0x%08x is only reachable through ISP\n", u32Base + u32From);
+
+    close(i32Fd);
+    return pu8Alias;
+}
+
+void SIM_FmcRegister(void)
+{
+    uint32_t u32Min = Fmc_MinMapAddr();
+
+    if(s_sFmc.pu8Aprom == NULL)
+    {
+        s_sFmc.pu8Aprom = Fmc_MapArray(FMC_APROM_BASE, SIM_APROM_SIZE, u32Min);
+        s_sFmc.pu8Ldrom = Fmc_MapArray(FMC_LDROM_BASE, FMC_LDROM_SIZE, 0);
+    }
+    SIM_RegisterModel(&s_sFmcModel);
+}
+
+void *SIM_FmcPtr(uint32_t u32Addr, uint32_t u32Len)
+{
+    if(s_sFmc.pu8Aprom == NULL)
+        return NULL;
+    return Fmc_Array(u32Addr, u32Len);
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Harness API                                                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+/**
+  * @brief      Write flash content directly, without flash semantics
+  * @param[in]  u32Addr     APROM, LDROM or CONFIG address.
+  * @param[in]  pvData      Content to write.
+  * @param[in]  u32Len      Number of bytes.
+  */
+void SIM_FmcLoad(uint32_t u32Addr, const void *pvData, uint32_t u32Len)
+{
+    uint8_t *pu8;
+
+    SIM_Init();
+    if((u32Addr & 0xFFF00000) == FMC_CONFIG_BASE)
+    {
+        if(((u32Addr & 7) + u32Len) <= sizeof(s_sFmc.au32Config))
+            memcpy((uint8_t *)s_sFmc.au32Config + (u32Addr & 7), pvData, u32Len);
+        return;
+    }
+
+    pu8 = Fmc_Array(u32Addr, u32Len);
+    if(pu8 != NULL)
+        memcpy(pu8, pvData, u32Len);
+}
+
+/**
+  * @brief      Read flash content directly
+  * @param[in]  u32Addr     APROM, LDROM or CONFIG address.
+  * @param[out] pvBuf       Buffer for the content.
+  * @param[in]  u32Len      Number of bytes.
+  */
+void SIM_FmcDump(uint32_t u32Addr, void *pvBuf, uint32_t u32Len)
+{
+    uint8_t *pu8;
+
+    SIM_Init();
+    if((u32Addr & 0xFFF00000) == FMC_CONFIG_BASE)
+    {
+        if(((u32Addr & 7) + u32Len) <= sizeof(s_sFmc.au32Config))
+            memcpy(pvBuf, (uint8_t *)s_sFmc.au32Config + (u32Addr & 7), u32Len);
+        return;
+    }
+
+    pu8 = Fmc_Array(u32Addr, u32Len);
+    if(pu8 != NULL)
+        memcpy(pvBuf, pu8, u32Len);
+    else
+        memset(pvBuf, 0xFF, u32Len);
+}
+
+/**
+  * @brief      Erase a flash range to 0xFF without counting erase cycles
+  */
+void SIM_FmcErase(uint32_t u32Addr, uint32_t u32Len)
+{
+    uint8_t *pu8;
+
+    SIM_Init();
+    pu8 = Fmc_Array(u32Addr, u32Len);
+    if(pu8 != NULL)
+        memset(pu8, 0xFF, u32Len);
+}
+
+/**
+  * @brief      Set the duration of the ISP program and page erase commands
+  * @param[in]  u32ProgramUs    Word program time in microseconds. Default is 25.
+  * @param[in]  u32EraseUs      Page erase time in microseconds. Default is 20000.
+  */
+void SIM_FmcSetTiming(uint32_t u32ProgramUs, uint32_t u32EraseUs)
+{
+    s_sFmc.u32ProgramUs = u32ProgramUs;
+    s_sFmc.u32EraseUs = u32EraseUs;
+}
+
+/**
+  * @brief      Number of ISP page erases of the page holding u32Addr
+  */
+uint32_t SIM_FmcGetEraseCount(uint32_t u32Addr)
+{
+    if(Fmc_Array(u32Addr, 1) == NULL)
+        return 0;
+    return s_sFmc.au32EraseCnt[Fmc_PageIndex(u32Addr)];
+}
+
+/**
+  * @brief      Number of ISP word programs since start-up
+  */
+uint32_t SIM_FmcGetProgramCount(void)
+{
+    return s_sFmc.u32ProgramCnt;
+}
+
+/*** (C) COPYRIGHT 2026 Nuvoton Technology Corp. ***/
@@ -0,0 +1,87 @@
+/**************************************************************************//**
+ * @file     host_sim_model.h
+ * @version  V1.00
+ * @brief    M071R_M071S Series host simulator internal model interface
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2026 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#ifndef __HOST_SIM_MODEL_H__
+#define __HOST_SIM_MODEL_H__
+
+#include <stdint.h>
+#include "NuMicro.h"
+
+#define SIM_NO_EVENT            UINT64_MAX      /* pfnNextEvent: the model has nothing scheduled */
+
+/**
+  * @brief  Register model descriptor
+  * @details A model owns the address range [u32Base, u32Base + u32Size). The CPU view of the range
+  *          traps on every access; models themselves read and write their registers through the
+  *          backdoor alias returned by SIM_Backdoor() so they never trap.
+  */
+typedef struct
+{
+    const char *pcName;
+    uint32_t    u32Base;
+    uint32_t    u32Size;
+    void       *pvCtx;
+
+    /* Restore the reset state of the registers and of the model. */
+    void     (*pfnReset)(void *pvCtx);
+
+    /* Called before a CPU access executes. Refresh the value the CPU is about to read. */
+    void     (*pfnPreAccess)(void *pvCtx, uint32_t u32Offset);
+
+    /* Called after a CPU access executed. u32Old is the register value before the access. */
+    void     (*pfnPostAccess)(void *pvCtx, uint32_t u32Offset, int32_t i32IsWrite, uint32_t u32Old);
+
+    /* Bring the internal state up to HCLK cycle u64Now. */
+    void     (*pfnUpdate)(void *pvCtx, uint64_t u64Now);
+
+    /* Absolute HCLK cycle of the next internal state change, or SIM_NO_EVENT. */
+    uint64_t (*pfnNextEvent)(void *pvCtx);
+
+    /* Bit mask of the NVIC interrupt lines asserted by the model. */
+    uint32_t (*pfnIrq)(void *pvCtx);
+} SIM_MODEL_T;
+
+/* Write access to a register declared read only (__I) in the register structures */
+#define SIM_RO(reg)             (*(volatile uint32_t *)&(reg))
+
+/* Backdoor view of a device register or buffer */
+void *SIM_Backdoor(uint32_t u32Addr);
+#define SIM_BD(p)               ((__typeof__(p))SIM_Backdoor((uint32_t)(uintptr_t)(p)))
+
+/* Core services for the models */
+void     SIM_RegisterModel(const SIM_MODEL_T *psModel);
+void     SIM_ResetModel(const char *pcName);
+uint64_t SIM_Now(void);
+void     SIM_Sync(void);
+void     SIM_Stall(uint64_t u64Cycles);
+void     SIM_Dispatch(void);
+uint32_t SIM_GetPLLFreq(void);
+uint64_t SIM_CyclesFor(uint64_t u64Ticks, uint32_t u32TickFreq);
+void     SIM_SystemReset(void);
+
+/* Peripheral DMA request lines, serviced by the PDMA model. u32Periph uses the PDMA_xxx_TX/RX ids
+   of pdma.h. Return 1 when a unit of data was moved. */
+int32_t  SIM_PdmaTxRequest(uint32_t u32Periph, uint32_t *pu32Data);
+int32_t  SIM_PdmaRxRequest(uint32_t u32Periph, uint32_t u32Data);
+int32_t  SIM_PdmaIsActive(uint32_t u32Periph);
+
+/* Model registration, called by SIM_Init() */
+void SIM_UartRegister(void);
+void SIM_SpiRegister(void);
+void SIM_PdmaRegister(void);
+void SIM_FmcRegister(void);
+void SIM_UsbdRegister(void);
+
+/* Flash array owned by the FMC model, used by SIM_MemPtr() */
+void *SIM_FmcPtr(uint32_t u32Addr, uint32_t u32Len);
+
+#endif /* __HOST_SIM_MODEL_H__ */
+
+/*** (C) COPYRIGHT 2026 Nuvoton Technology Corp. ***/
@@ -0,0 +1,546 @@
+/**************************************************************************//**
+ * @file     host_sim_pdma.c
+ * @version  V1.00
+ * @brief    M071R_M071S Series host simulator PDMA model
+ *
+ * @details  Nine channels with memory-to-memory, peripheral-to-memory and memory-to-peripheral
+ *           modes. Peripheral transfers are paced by the request lines of the UART and SPI models
+ *           through SIM_PdmaTxRequest()/SIM_PdmaRxRequest(); memory-to-memory transfers move one
+ *           word every SIM_PDMA_BEAT_CYCLES HCLK cycles.
+ *
+ *           The CRC channel computes CRC-CCITT/8/16/32 bit by bit from the polynomial, with the
+ *           write data and checksum reverse/complement options, from CPU writes to WDATA or from
+ *           DMA reads at the memory-to-memory rate.
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2026 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "host_sim_model.h"
+
+#define SIM_PDMA_CH_NUM         9
+#define SIM_PDMA_BEAT_CYCLES    4           /* HCLK cycles per word of a memory-to-memory transfer */
+
+#define PDMA_MODE_MEM2MEM       0
+#define PDMA_MODE_IP2MEM        1
+#define PDMA_MODE_MEM2IP        2
+
+typedef struct
+{
+    int32_t  i32Active;
+    uint64_t u64Start;          /* Memory-to-memory: cycle of the trigger */
+    uint32_t u32Done;           /* Memory-to-memory: bytes already moved */
+} SIM_PDMA_CH_T;
+
+typedef struct
+{
+    uint32_t u32State;          /* CRC shift register, before checksum reverse/complement */
+    int32_t  i32Active;         /* DMA running */
+    uint64_t u64Start;
+    uint32_t u32Done;
+} SIM_CRC_T;
+
+static SIM_PDMA_CH_T s_asCh[SIM_PDMA_CH_NUM];
+static SIM_CRC_T s_sCrc;
+
+/* Service selection field of each peripheral id of pdma.h: {register index, bit position} */
+static const uint8_t s_au8SelField[PDMA_ADC + 1][2] =
+{
+    {0, PDMA_PDSSR0_SPI0_TXSEL_Pos},  {0, PDMA_PDSSR0_SPI1_TXSEL_Pos},
+    {0, PDMA_PDSSR0_SPI2_TXSEL_Pos},  {0, PDMA_PDSSR0_SPI3_TXSEL_Pos},
+    {1, PDMA_PDSSR1_UART0_TXSEL_Pos}, {1, PDMA_PDSSR1_UART1_TXSEL_Pos},
+    {2, PDMA_PDSSR2_I2S_TXSEL_Pos},   {0, PDMA_PDSSR0_SPI0_RXSEL_Pos},
+    {0, PDMA_PDSSR0_SPI1_RXSEL_Pos},  {0, PDMA_PDSSR0_SPI2_RXSEL_Pos},
+    {0, PDMA_PDSSR0_SPI3_RXSEL_Pos},  {1, PDMA_PDSSR1_UART0_RXSEL_Pos},
+    {1, PDMA_PDSSR1_UART1_RXSEL_Pos}, {2, PDMA_PDSSR2_I2S_RXSEL_Pos},
+    {1, PDMA_PDSSR1_ADC_RXSEL_Pos},
+};
+
+static PDMA_T *Pdma_Ch(uint32_t u32Ch)
+{
+    return (PDMA_T *)SIM_Backdoor(PDMA0_BASE + 0x100 * u32Ch);
+}
+
+static uint32_t Pdma_Width(PDMA_T *pdma)
+{
+    switch(pdma->CSR & PDMA_CSR_APB_TWS_Msk)
+    {
+        case PDMA_WIDTH_8:
+            return 1;
+        case PDMA_WIDTH_16:
+            return 2;
+        default:
+            return 4;
+    }
+}
+
+static void Pdma_Finish(uint32_t u32Ch)
+{
+    PDMA_T *pdma = Pdma_Ch(u32Ch);
+
+    s_asCh[u32Ch].i32Active = 0;
+    pdma->CSR &= ~PDMA_CSR_TRIG_EN_Msk;
+    pdma->ISR |= PDMA_ISR_BLKD_IF_Msk;
+}
+
+/* Channel serving a peripheral request line, -1 if none is running */
+static int32_t Pdma_FindCh(uint32_t u32Periph, uint32_t u32Mode)
+{
+    PDMA_GCR_T *gcr = SIM_BD(PDMA_GCR);
+    uint32_t u32Sel, u32Ch;
+
+    if(u32Periph > PDMA_ADC)
+        return -1;
+
+    u32Sel = (s_au8SelField[u32Periph][0] == 0) ? gcr->PDSSR0 :
+             (s_au8SelField[u32Periph][0] == 1) ? gcr->PDSSR1 : gcr->PDSSR2;
+    u32Ch = (u32Sel >> s_au8SelField[u32Periph][1]) & 0xF;
+
+    if((u32Ch >= SIM_PDMA_CH_NUM) || !s_asCh[u32Ch].i32Active)
+        return -1;
+    if(((Pdma_Ch(u32Ch)->CSR & PDMA_CSR_MODE_SEL_Msk) >> PDMA_CSR_MODE_SEL_Pos) != u32Mode)
+        return -1;
+
+    return (int32_t)u32Ch;
+}
+
+int32_t SIM_PdmaIsActive(uint32_t u32Periph)
+{
+    return (Pdma_FindCh(u32Periph, PDMA_MODE_MEM2IP) >= 0) || (Pdma_FindCh(u32Periph, PDMA_MODE_IP2MEM) >= 0);
+}
+
+int32_t SIM_PdmaTxRequest(uint32_t u32Periph, uint32_t *pu32Data)
+{
+    int32_t i32Ch = Pdma_FindCh(u32Periph, PDMA_MODE_MEM2IP);
+    PDMA_T *pdma;
+    uint32_t u32Width;
+
+    if(i32Ch < 0)
+        return 0;
+
+    pdma = Pdma_Ch(i32Ch);
+    u32Width = Pdma_Width(pdma);
+    *pu32Data = 0;
+    memcpy(pu32Data, SIM_MemPtr(pdma->CSAR, u32Width), u32Width);
+
+    if((pdma->CSR & PDMA_CSR_SAD_SEL_Msk) != PDMA_SAR_FIX)
+        SIM_RO(pdma->CSAR) += u32Width;
+    SIM_RO(pdma->CBCR) = (pdma->CBCR > u32Width) ? (pdma->CBCR - u32Width) : 0;
+    if(pdma->CBCR == 0)
+        Pdma_Finish(i32Ch);
+
+    return 1;
+}
+
+int32_t SIM_PdmaRxRequest(uint32_t u32Periph, uint32_t u32Data)
+{
+    int32_t i32Ch = Pdma_FindCh(u32Periph, PDMA_MODE_IP2MEM);
+    PDMA_T *pdma;
+    uint32_t u32Width;
+
+    if(i32Ch < 0)
+        return 0;
+
+    pdma = Pdma_Ch(i32Ch);
+    u32Width = Pdma_Width(pdma);
+    memcpy(SIM_MemPtr(pdma->CDAR, u32Width), &u32Data, u32Width);
+
+    if((pdma->CSR & PDMA_CSR_DAD_SEL_Msk) != PDMA_DAR_FIX)
+        SIM_RO(pdma->CDAR) += u32Width;
+    SIM_RO(pdma->CBCR) = (pdma->CBCR > u32Width) ? (pdma->CBCR - u32Width) : 0;
+    if(pdma->CBCR == 0)
+        Pdma_Finish(i32Ch);
+
+    return 1;
+}
+
+static void Pdma_MemUpdate(uint32_t u32Ch, uint64_t u64Now)
+{
+    PDMA_T *pdma = Pdma_Ch(u32Ch);
+    uint32_t u32Total = pdma->BCR & PDMA_BCR_BCR_Msk;
+    uint64_t u64Bytes = ((u64Now - s_asCh[u32Ch].u64Start) / SIM_PDMA_BEAT_CYCLES) * 4;
+
+    if(u64Bytes > u32Total)
+        u64Bytes = u32Total;
+
+    while(s_asCh[u32Ch].u32Done < u64Bytes)
+    {
+        uint32_t u32Word;
+
+        memcpy(&u32Word, SIM_MemPtr(pdma->CSAR, 4), 4);
+        memcpy(SIM_MemPtr(pdma->CDAR, 4), &u32Word, 4);
+        if((pdma->CSR & PDMA_CSR_SAD_SEL_Msk) != PDMA_SAR_FIX)
+            SIM_RO(pdma->CSAR) += 4;
+        if((pdma->CSR & PDMA_CSR_DAD_SEL_Msk) != PDMA_DAR_FIX)
+            SIM_RO(pdma->CDAR) += 4;
+        s_asCh[u32Ch].u32Done += 4;
+        SIM_RO(pdma->CBCR) = u32Total - s_asCh[u32Ch].u32Done;
+    }
+
+    if(s_asCh[u32Ch].u32Done >= u32Total)
+        Pdma_Finish(u32Ch);
+}
+
+static void Pdma_Trigger(uint32_t u32Ch)
+{
+    PDMA_T *pdma = Pdma_Ch(u32Ch);
+    PDMA_GCR_T *gcr = SIM_BD(PDMA_GCR);
+
+    if(!(pdma->CSR & PDMA_CSR_PDMACEN_Msk) || !(gcr->GCRCSR & (PDMA_GCRCSR_CLK0_EN_Msk << u32Ch)))
+    {
+        pdma->CSR &= ~PDMA_CSR_TRIG_EN_Msk;
+        return;
+    }
+
+    SIM_RO(pdma->CSAR) = pdma->SAR;
+    SIM_RO(pdma->CDAR) = pdma->DAR;
+    SIM_RO(pdma->CBCR) = pdma->BCR & PDMA_BCR_BCR_Msk;
+    s_asCh[u32Ch].i32Active = 1;
+    s_asCh[u32Ch].u64Start = SIM_Now();
+    s_asCh[u32Ch].u32Done = 0;
+
+    if(pdma->CBCR == 0)
+        Pdma_Finish(u32Ch);
+}
+
+static void Pdma_ChReset(void *pvCtx)
+{
+    uint32_t u32Ch = (uint32_t)(uintptr_t)pvCtx;
+
+    memset(Pdma_Ch(u32Ch), 0, 0x100);
+    s_asCh[u32Ch].i32Active = 0;
+}
+
+static void Pdma_ChPostAccess(void *pvCtx, uint32_t u32Offset, int32_t i32IsWrite, uint32_t u32Old)
+{
+    uint32_t u32Ch = (uint32_t)(uintptr_t)pvCtx;
+    PDMA_T *pdma = Pdma_Ch(u32Ch);
+
+    if(!i32IsWrite)
+        return;
+
+    switch(u32Offset)
+    {
+        case offsetof(PDMA_T, CSR):
+            if(pdma->CSR & PDMA_CSR_SW_RST_Msk)
+            {
+                pdma->CSR &= ~(PDMA_CSR_SW_RST_Msk | PDMA_CSR_TRIG_EN_Msk);
+                SIM_RO(pdma->CBCR) = 0;
+                s_asCh[u32Ch].i32Active = 0;
+            }
+            if(!(pdma->CSR & PDMA_CSR_PDMACEN_Msk))
+            {
+                pdma->CSR &= ~PDMA_CSR_TRIG_EN_Msk;
+                s_asCh[u32Ch].i32Active = 0;
+            }
+            if((pdma->CSR & PDMA_CSR_TRIG_EN_Msk) && !(u32Old & PDMA_CSR_TRIG_EN_Msk))
+                Pdma_Trigger(u32Ch);
+            break;
+
+        case offsetof(PDMA_T, ISR):
+            pdma->ISR = u32Old & ~pdma->ISR;
+            break;
+
+        case offsetof(PDMA_T, POINT):
+        case offsetof(PDMA_T, CSAR):
+        case offsetof(PDMA_T, CDAR):
+        case offsetof(PDMA_T, CBCR):
+            /* Read only */
+            *(volatile uint32_t *)((uint8_t *)pdma + u32Offset) = u32Old;
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void Pdma_ChUpdate(void *pvCtx, uint64_t u64Now)
+{
+    uint32_t u32Ch = (uint32_t)(uintptr_t)pvCtx;
+
+    if(s_asCh[u32Ch].i32Active &&
+            (((Pdma_Ch(u32Ch)->CSR & PDMA_CSR_MODE_SEL_Msk) >> PDMA_CSR_MODE_SEL_Pos) == PDMA_MODE_MEM2MEM))
+        Pdma_MemUpdate(u32Ch, u64Now);
+}
+
+static uint64_t Pdma_ChNextEvent(void *pvCtx)
+{
+    uint32_t u32Ch = (uint32_t)(uintptr_t)pvCtx;
+    PDMA_T *pdma = Pdma_Ch(u32Ch);
+
+    if(!s_asCh[u32Ch].i32Active ||
+            (((pdma->CSR & PDMA_CSR_MODE_SEL_Msk) >> PDMA_CSR_MODE_SEL_Pos) != PDMA_MODE_MEM2MEM))
+        return SIM_NO_EVENT;
+
+    return s_asCh[u32Ch].u64Start + (((pdma->BCR & PDMA_BCR_BCR_Msk) + 3) / 4) * SIM_PDMA_BEAT_CYCLES;
+}
+
+static uint32_t Pdma_ChIrq(void *pvCtx)
+{
+    PDMA_T *pdma = Pdma_Ch((uint32_t)(uintptr_t)pvCtx);
+
+    return (pdma->ISR & pdma->IER & (PDMA_ISR_BLKD_IF_Msk | PDMA_ISR_TABORT_IF_Msk)) ? (1UL << PDMA_IRQn) : 0;
+}
+
+static void Pdma_GcrReset(void *pvCtx)
+{
+    PDMA_GCR_T *gcr = SIM_BD(PDMA_GCR);
+
+    (void)pvCtx;
+    memset(gcr, 0, 0x100);
+    gcr->PDSSR0 = 0xFFFFFFFF;
+    gcr->PDSSR1 = 0xFFFFFFFF;
+    gcr->PDSSR2 = 0xFFFFFFFF;
+}
+
+static void Pdma_GcrPreAccess(void *pvCtx, uint32_t u32Offset)
+{
+    PDMA_GCR_T *gcr = SIM_BD(PDMA_GCR);
+    uint32_t u32Ch, u32Isr = 0;
+
+    (void)pvCtx;
+    if(u32Offset != offsetof(PDMA_GCR_T, GCRISR))
+        return;
+
+    for(u32Ch = 0; u32Ch < SIM_PDMA_CH_NUM; u32Ch++)
+    {
+        if(Pdma_Ch(u32Ch)->ISR & (PDMA_ISR_BLKD_IF_Msk | PDMA_ISR_TABORT_IF_Msk))
+            u32Isr |= 1UL << u32Ch;
+    }
+    if(SIM_BD(CRC)->DMAISR & (CRC_DMAISR_CRC_BLKD_IF_Msk | CRC_DMAISR_CRC_TABORT_IF_Msk))
+        u32Isr |= PDMA_GCRISR_INTRCRC_Msk;
+    if(u32Isr)
+        u32Isr |= PDMA_GCRISR_INTR_Msk;
+    gcr->GCRISR = u32Isr;
+}
+
+static void Pdma_GcrPostAccess(void *pvCtx, uint32_t u32Offset, int32_t i32IsWrite, uint32_t u32Old)
+{
+    (void)pvCtx;
+    if(i32IsWrite && (u32Offset == offsetof(PDMA_GCR_T, GCRISR)))
+        SIM_BD(PDMA_GCR)->GCRISR = u32Old;
+}
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* CRC channel                                                                                             */
+/*---------------------------------------------------------------------------------------------------------*/
+static uint32_t Crc_Width(uint32_t u32Ctl)
+{
+    switch(u32Ctl & CRC_CTL_CRC_MODE_Msk)
+    {
+        case CRC_8:
+            return 8;
+        case CRC_32:
+            return 32;
+        default:
+            return 16;
+    }
+}
+
+static uint32_t Crc_Poly(uint32_t u32Ctl)
+{
+    switch(u32Ctl & CRC_CTL_CRC_MODE_Msk)
+    {
+        case CRC_8:
+            return 0x07;
+        case CRC_16:
+            return 0x8005;
+        case CRC_32:
+            return 0x04C11DB7;
+        default:
+            return 0x1021;
+    }
+}
+
+static uint32_t Crc_Mask(uint32_t u32Width)
+{
+    return (u32Width == 32) ? 0xFFFFFFFF : ((1UL << u32Width) - 1);
+}
+
+static uint32_t Crc_Reverse(uint32_t u32Data, uint32_t u32Bits)
+{
+    uint32_t u32Out = 0, i;
+
+    for(i = 0; i < u32Bits; i++)
+        u32Out |= ((u32Data >> i) & 1) << (u32Bits - 1 - i);
+
+    return u32Out;
+}
+
+static void Crc_Output(void)
+{
+    CRC_T *crc = SIM_BD(CRC);
+    uint32_t u32Width = Crc_Width(crc->CTL), u32Sum = s_sCrc.u32State;
+
+    if(crc->CTL & CRC_CTL_CHECKSUM_RVS_Msk)
+        u32Sum = Crc_Reverse(u32Sum, u32Width);
+    if(crc->CTL & CRC_CTL_CHECKSUM_COM_Msk)
+        u32Sum = ~u32Sum;
+    SIM_RO(crc->CHECKSUM) = u32Sum & Crc_Mask(u32Width);
+}
+
+/* Feed u32Bytes bytes of u32Data, least significant byte first */
+static void Crc_Feed(uint32_t u32Data, uint32_t u32Bytes)
+{
+    CRC_T *crc = SIM_BD(CRC);
+    uint32_t u32Width = Crc_Width(crc->CTL), u32Poly = Crc_Poly(crc->CTL), u32Byte, i, j;
+
+    for(i = 0; i < u32Bytes; i++)
+    {
+        u32Byte = (u32Data >> (i * 8)) & 0xFF;
+        if(crc->CTL & CRC_CTL_WDATA_COM_Msk)
+            u32Byte ^= 0xFF;
+        if(crc->CTL & CRC_CTL_WDATA_RVS_Msk)
+            u32Byte = Crc_Reverse(u32Byte, 8);
+
+        s_sCrc.u32State ^= u32Byte << (u32Width - 8);
+        for(j = 0; j < 8; j++)
+        {
+            if(s_sCrc.u32State & (1UL << (u32Width - 1)))
+                s_sCrc.u32State = (s_sCrc.u32State << 1) ^ u32Poly;
+            else
+                s_sCrc.u32State <<= 1;
+        }
+        s_sCrc.u32State &= Crc_Mask(u32Width);
+    }
+
+    Crc_Output();
+}
+
+static void Crc_Update(void *pvCtx, uint64_t u64Now)
+{
+    CRC_T *crc = SIM_BD(CRC);
+    uint32_t u32Total = crc->DMABCR & 0xFFFF, u32Word, u32Len;
+    uint64_t u64Bytes = ((u64Now - s_sCrc.u64Start) / SIM_PDMA_BEAT_CYCLES) * 4;
+
+    (void)pvCtx;
+    if(!s_sCrc.i32Active)
+        return;
+
+    if(u64Bytes > u32Total)
+        u64Bytes = u32Total;
+
+    while(s_sCrc.u32Done < u64Bytes)
+    {
+        u32Len = (u32Total - s_sCrc.u32Done < 4) ? (u32Total - s_sCrc.u32Done) : 4;
+        memcpy(&u32Word, SIM_MemPtr(crc->DMACSAR, 4), 4);
+        Crc_Feed(u32Word, u32Len);
+        SIM_RO(crc->DMACSAR) += 4;
+        s_sCrc.u32Done += u32Len;
+        SIM_RO(crc->DMACBCR) = u32Total - s_sCrc.u32Done;
+    }
+
+    if(s_sCrc.u32Done >= u32Total)
+    {
+        s_sCrc.i32Active = 0;
+        crc->CTL &= ~CRC_CTL_TRIG_EN_Msk;
+        crc->DMAISR |= CRC_DMAISR_CRC_BLKD_IF_Msk;
+    }
+}
+
+static uint64_t Crc_NextEvent(void *pvCtx)
+{
+    (void)pvCtx;
+    if(!s_sCrc.i32Active)
+        return SIM_NO_EVENT;
+
+    return s_sCrc.u64Start + (((SIM_BD(CRC)->DMABCR & 0xFFFF) + 3) / 4) * SIM_PDMA_BEAT_CYCLES;
+}
+
+static uint32_t Crc_Irq(void *pvCtx)
+{
+    CRC_T *crc = SIM_BD(CRC);
+
+    (void)pvCtx;
+    return (crc->DMAISR & crc->DMAIER & (CRC_DMAISR_CRC_BLKD_IF_Msk | CRC_DMAISR_CRC_TABORT_IF_Msk)) ?
+           (1UL << PDMA_IRQn) : 0;
+}
+
+static void Crc_Reset(void *pvCtx)
+{
+    (void)pvCtx;
+    memset(SIM_BD(CRC), 0, 0x100);
+    memset(&s_sCrc, 0, sizeof(s_sCrc));
+}
+
+static void Crc_PostAccess(void *pvCtx, uint32_t u32Offset, int32_t i32IsWrite, uint32_t u32Old)
+{
+    CRC_T *crc = SIM_BD(CRC);
+
+    (void)pvCtx;
+    if(!i32IsWrite)
+        return;
+
+    switch(u32Offset)
+    {
+        case offsetof(CRC_T, CTL):
+            if(crc->CTL & CRC_CTL_CRC_RST_Msk)
+            {
+                crc->CTL &= ~(CRC_CTL_CRC_RST_Msk | CRC_CTL_TRIG_EN_Msk);
+                s_sCrc.u32State = crc->SEED & Crc_Mask(Crc_Width(crc->CTL));
+                s_sCrc.i32Active = 0;
+                SIM_RO(crc->DMACBCR) = 0;
+            }
+            if((crc->CTL & CRC_CTL_TRIG_EN_Msk) && !(u32Old & CRC_CTL_TRIG_EN_Msk))
+            {
+                if(!(crc->CTL & CRC_CTL_CRCCEN_Msk) || !(SIM_BD(PDMA_GCR)->GCRCSR & PDMA_GCRCSR_CRC_CLK_EN_Msk))
+                {
+                    crc->CTL &= ~CRC_CTL_TRIG_EN_Msk;
+                    break;
+                }
+                SIM_RO(crc->DMACSAR) = crc->DMASAR;
+                SIM_RO(crc->DMACBCR) = crc->DMABCR & 0xFFFF;
+                s_sCrc.i32Active = 1;
+                s_sCrc.u64Start = SIM_Now();
+                s_sCrc.u32Done = 0;
+                Crc_Update(NULL, s_sCrc.u64Start);
+            }
+            Crc_Output();
+            break;
+
+        case offsetof(CRC_T, WDATA):
+            if((crc->CTL & CRC_CTL_CRCCEN_Msk) && !(crc->CTL & CRC_CTL_TRIG_EN_Msk))
+                Crc_Feed(crc->WDATA, 1UL << ((crc->CTL & CRC_CTL_CPU_WDLEN_Msk) >> CRC_CTL_CPU_WDLEN_Pos));
+            break;
+
+        case offsetof(CRC_T, DMAISR):
+            crc->DMAISR = u32Old & ~crc->DMAISR;
+            break;
+
+        case offsetof(CRC_T, DMACSAR):
+        case offsetof(CRC_T, DMACBCR):
+        case offsetof(CRC_T, CHECKSUM):
+            /* Read only */
+            *(volatile uint32_t *)((uint8_t *)crc + u32Offset) = u32Old;
+            break;
+
+        default:
+            break;
+    }
+}
+
+#define SIM_PDMA_CH_MODEL(n) \
+    { "PDMA", PDMA0_BASE + 0x100 * (n), 0x100, (void *)(uintptr_t)(n), \
+      Pdma_ChReset, NULL, Pdma_ChPostAccess, Pdma_ChUpdate, Pdma_ChNextEvent, Pdma_ChIrq }
+
+static const SIM_MODEL_T s_asPdmaModel[SIM_PDMA_CH_NUM + 2] =
+{
+    SIM_PDMA_CH_MODEL(0), SIM_PDMA_CH_MODEL(1), SIM_PDMA_CH_MODEL(2),
+    SIM_PDMA_CH_MODEL(3), SIM_PDMA_CH_MODEL(4), SIM_PDMA_CH_MODEL(5),
+    SIM_PDMA_CH_MODEL(6), SIM_PDMA_CH_MODEL(7), SIM_PDMA_CH_MODEL(8),
+    { "PDMA", PDMA_GCR_BASE, 0x100, NULL, Pdma_GcrReset, Pdma_GcrPreAccess, Pdma_GcrPostAccess, NULL, NULL, NULL },
+    { "PDMA", CRC_BASE, 0x100, NULL, Crc_Reset, NULL, Crc_PostAccess, Crc_Update, Crc_NextEvent, Crc_Irq },
+};
+
+void SIM_PdmaRegister(void)
+{
+    uint32_t i;
+
+    for(i = 0; i < SIM_PDMA_CH_NUM + 2; i++)
+        SIM_RegisterModel(&s_asPdmaModel[i]);
+}
+
+/*** (C) COPYRIGHT 2026 Nuvoton Technology Corp. ***/
@@ -0,0 +1,380 @@
+/**************************************************************************//**
+ * @file     host_sim_spi.c
+ * @version  V1.00
+ * @brief    M071R_M071S Series host simulator SPI model
+ *
+ * @details  Master mode shift engine with the bus clock of SPI_DIVIDER/SPI_CNTRL2, single buffer and
+ *           8-level FIFO modes, the unit transfer and FIFO threshold interrupts and the PDMA request
+ *           lines. The data shifted in comes from the device attached with SIM_SpiAttach(); without
+ *           a device MISO is looped back from MOSI.
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2026 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "host_sim_model.h"
+
+#define SIM_SPI_FIFO_SIZE       8
+
+typedef struct
+{
+    const char      *pcName;
+    uint32_t         u32Base;
+    uint32_t         u32IrqMsk;
+    uint32_t         u32PdmaTx;
+    uint32_t         u32PdmaRx;
+    SIM_SPI_DEVICE_T pfnDevice;
+
+    uint32_t         au32TxFifo[SIM_SPI_FIFO_SIZE];
+    uint32_t         u32TxHead;
+    uint32_t         u32TxCnt;
+    uint32_t         au32RxFifo[SIM_SPI_FIFO_SIZE];
+    uint32_t         u32RxHead;
+    uint32_t         u32RxCnt;
+
+    uint32_t         u32TxLatch;        /* Single buffer mode: last value written to SPI_TX */
+    uint32_t         u32RxLatch;        /* Single buffer mode: last value received */
+    int32_t          i32Go;             /* Single buffer mode: GO_BUSY was set by software */
+
+    int32_t          i32Busy;
+    uint32_t         u32Shift;
+    uint64_t         u64ShiftEnd;
+
+    uint32_t         u32Sticky;         /* SPI_STATUS flags, write 1 to clear */
+} SIM_SPI_T;
+
+static SIM_SPI_T s_asSpi[SIM_SPI_NUM] =
+{
+    { "SPI0", SPI0_BASE, 1UL << SPI0_IRQn, PDMA_SPI0_TX, PDMA_SPI0_RX },
+    { "SPI1", SPI1_BASE, 1UL << SPI1_IRQn, PDMA_SPI1_TX, PDMA_SPI1_RX },
+};
+
+static SPI_T *Spi_Regs(SIM_SPI_T *psSpi)
+{
+    return (SPI_T *)SIM_Backdoor(psSpi->u32Base);
+}
+
+static uint32_t Spi_BitLen(SPI_T *spi)
+{
+    uint32_t u32Len = (spi->CNTRL & SPI_CNTRL_TX_BIT_LEN_Msk) >> SPI_CNTRL_TX_BIT_LEN_Pos;
+
+    return u32Len ? u32Len : 32;
+}
+
+static uint64_t Spi_TransferCycles(SIM_SPI_T *psSpi)
+{
+    SPI_T *spi = Spi_Regs(psSpi);
+    uint32_t u32SelMsk = (psSpi == &s_asSpi[0]) ? CLK_CLKSEL1_SPI0_S_Msk : CLK_CLKSEL1_SPI1_S_Msk;
+    uint32_t u32Src = (SIM_BD(CLK)->CLKSEL1 & u32SelMsk) ? SIM_GetHCLKFreq() : SIM_GetPLLFreq();
+    uint64_t u64Div = ((spi->DIVIDER & SPI_DIVIDER_DIVIDER_Msk) >> SPI_DIVIDER_DIVIDER_Pos) + 1;
+
+    if(!(spi->CNTRL2 & SPI_CNTRL2_BCn_Msk))
+        u64Div *= 2;
+
+    return SIM_CyclesFor(u64Div * Spi_BitLen(spi), u32Src ? u32Src : SIM_GetHCLKFreq());
+}
+
+static void Spi_Start(SIM_SPI_T *psSpi, uint32_t u32Data, uint64_t u64Start)
+{
+    psSpi->i32Busy = 1;
+    psSpi->u32Shift = u32Data;
+    psSpi->u64ShiftEnd = u64Start + Spi_TransferCycles(psSpi);
+}
+
+/* Start the next transfer if the engine is idle and has something to send */
+static void Spi_Kick(SIM_SPI_T *psSpi, uint64_t u64Start)
+{
+    SPI_T *spi = Spi_Regs(psSpi);
+    uint32_t u32Data;
+
+    if(psSpi->i32Busy)
+        return;
+
+    if(spi->DMA & SPI_DMA_TX_DMA_GO_Msk)
+    {
+        if(SIM_PdmaTxRequest(psSpi->u32PdmaTx, &u32Data))
+            Spi_Start(psSpi, u32Data, u64Start);
+        else
+            spi->DMA &= ~SPI_DMA_TX_DMA_GO_Msk;
+    }
+    else if(spi->DMA & SPI_DMA_RX_DMA_GO_Msk)
+    {
+        /* Receive only: clock out the content of SPI_TX while the RX channel wants data */
+        if(SIM_PdmaIsActive(psSpi->u32PdmaRx))
+            Spi_Start(psSpi, psSpi->u32TxLatch, u64Start);
+        else
+            spi->DMA &= ~SPI_DMA_RX_DMA_GO_Msk;
+    }
+    else if(spi->CNTRL & SPI_CNTRL_FIFO_Msk)
+    {
+        if(psSpi->u32TxCnt)
+        {
+            u32Data = psSpi->au32TxFifo[psSpi->u32TxHead];
+            psSpi->u32TxHead = (psSpi->u32TxHead + 1) % SIM_SPI_FIFO_SIZE;
+            psSpi->u32TxCnt--;
+            Spi_Start(psSpi, u32Data, u64Start);
+        }
+    }
+    else if(psSpi->i32Go)
+    {
+        psSpi->i32Go = 0;
+        Spi_Start(psSpi, psSpi->u32TxLatch, u64Start);
+    }
+}
+
+static void Spi_Done(SIM_SPI_T *psSpi)
+{
+    SPI_T *spi = Spi_Regs(psSpi);
+    uint32_t u32Bits = Spi_BitLen(spi);
+    uint32_t u32Msk = (u32Bits == 32) ? 0xFFFFFFFFUL : ((1UL << u32Bits) - 1);
+    uint32_t u32Tx = psSpi->u32Shift & u32Msk;
+    uint32_t u32Rx;
+
+    psSpi->i32Busy = 0;
+
+    if(psSpi->pfnDevice)
+        u32Rx = psSpi->pfnDevice((uint32_t)(psSpi - s_asSpi), spi->SSR & SPI_SSR_SSR_Msk, u32Tx, u32Bits) & u32Msk;
+    else
+        u32Rx = u32Tx;
+
+    if(spi->DMA & SPI_DMA_RX_DMA_GO_Msk)
+    {
+        if(SIM_PdmaRxRequest(psSpi->u32PdmaRx, u32Rx))
+        {
+            if(!SIM_PdmaIsActive(psSpi->u32PdmaRx))
+                spi->DMA &= ~SPI_DMA_RX_DMA_GO_Msk;
+            spi->CNTRL |= SPI_CNTRL_IF_Msk;
+            return;
+        }
+        spi->DMA &= ~SPI_DMA_RX_DMA_GO_Msk;
+    }
+
+    if(spi->CNTRL & SPI_CNTRL_FIFO_Msk)
+    {
+        if(psSpi->u32RxCnt < SIM_SPI_FIFO_SIZE)
+        {
+            psSpi->au32RxFifo[(psSpi->u32RxHead + psSpi->u32RxCnt) % SIM_SPI_FIFO_SIZE] = u32Rx;
+            psSpi->u32RxCnt++;
+        }
+        else
+        {
+            psSpi->u32Sticky |= SPI_STATUS_RX_OVERRUN_Msk;
+        }
+    }
+    else
+    {
+        psSpi->u32RxLatch = u32Rx;
+    }
+
+    spi->CNTRL |= SPI_CNTRL_IF_Msk;
+}
+
+static void Spi_Refresh(SIM_SPI_T *psSpi)
+{
+    SPI_T *spi = Spi_Regs(psSpi);
+    uint32_t u32Flags = 0, u32Status;
+    uint32_t u32RxTh = (spi->FIFO_CTL & SPI_FIFO_CTL_RX_THRESHOLD_Msk) >> SPI_FIFO_CTL_RX_THRESHOLD_Pos;
+    uint32_t u32TxTh = (spi->FIFO_CTL & SPI_FIFO_CTL_TX_THRESHOLD_Msk) >> SPI_FIFO_CTL_TX_THRESHOLD_Pos;
+
+    if(psSpi->u32RxCnt == 0)
+        u32Flags |= SPI_CNTRL_RX_EMPTY_Msk;
+    if(psSpi->u32RxCnt >= SIM_SPI_FIFO_SIZE)
+        u32Flags |= SPI_CNTRL_RX_FULL_Msk;
+    if(psSpi->u32TxCnt == 0)
+        u32Flags |= SPI_CNTRL_TX_EMPTY_Msk;
+    if(psSpi->u32TxCnt >= SIM_SPI_FIFO_SIZE)
+        u32Flags |= SPI_CNTRL_TX_FULL_Msk;
+
+    spi->CNTRL = (spi->CNTRL & ~(SPI_CNTRL_RX_EMPTY_Msk | SPI_CNTRL_RX_FULL_Msk | SPI_CNTRL_TX_EMPTY_Msk |
+                                 SPI_CNTRL_TX_FULL_Msk | SPI_CNTRL_GO_BUSY_Msk)) | u32Flags |
+                 ((psSpi->i32Busy || psSpi->i32Go || psSpi->u32TxCnt) ? SPI_CNTRL_GO_BUSY_Msk : 0);
+
+    u32Status = u32Flags | psSpi->u32Sticky;
+    u32Status |= (psSpi->u32RxCnt & 0xF) << SPI_STATUS_RX_FIFO_COUNT_Pos;
+    u32Status |= (psSpi->u32TxCnt & 0xF) << SPI_STATUS_TX_FIFO_COUNT_Pos;
+    if(spi->CNTRL & SPI_CNTRL_IF_Msk)
+        u32Status |= SPI_STATUS_IF_Msk;
+    if(psSpi->u32RxCnt > u32RxTh)
+        u32Status |= SPI_STATUS_RX_INTSTS_Msk;
+    if(psSpi->u32TxCnt <= u32TxTh)
+        u32Status |= SPI_STATUS_TX_INTSTS_Msk;
+    spi->STATUS = u32Status;
+
+    if(spi->CNTRL & SPI_CNTRL_FIFO_Msk)
+        SIM_RO(spi->RX) = psSpi->u32RxCnt ? psSpi->au32RxFifo[psSpi->u32RxHead] : 0;
+    else
+        SIM_RO(spi->RX) = psSpi->u32RxLatch;
+}
+
+static void Spi_Reset(void *pvCtx)
+{
+    SIM_SPI_T *psSpi = (SIM_SPI_T *)pvCtx;
+    SPI_T *spi = Spi_Regs(psSpi);
+
+    memset(spi, 0, 0x50);
+    spi->CNTRL = 0x00000004 | SPI_CNTRL_TX_EMPTY_Msk | SPI_CNTRL_RX_EMPTY_Msk;
+    spi->DIVIDER = 0;
+    spi->FIFO_CTL = 0x22000000;
+    psSpi->u32TxHead = psSpi->u32TxCnt = 0;
+    psSpi->u32RxHead = psSpi->u32RxCnt = 0;
+    psSpi->u32TxLatch = psSpi->u32RxLatch = 0;
+    psSpi->i32Go = psSpi->i32Busy = 0;
+    psSpi->u32Sticky = 0;
+    Spi_Refresh(psSpi);
+}
+
+static void Spi_Update(void *pvCtx, uint64_t u64Now)
+{
+    SIM_SPI_T *psSpi = (SIM_SPI_T *)pvCtx;
+
+    Spi_Kick(psSpi, u64Now);
+    while(psSpi->i32Busy && (psSpi->u64ShiftEnd <= u64Now))
+    {
+        uint64_t u64End = psSpi->u64ShiftEnd;
+
+        Spi_Done(psSpi);
+        Spi_Kick(psSpi, u64End);
+    }
+    Spi_Refresh(psSpi);
+}
+
+static uint64_t Spi_NextEvent(void *pvCtx)
+{
+    SIM_SPI_T *psSpi = (SIM_SPI_T *)pvCtx;
+
+    return psSpi->i32Busy ? psSpi->u64ShiftEnd : SIM_NO_EVENT;
+}
+
+static uint32_t Spi_Irq(void *pvCtx)
+{
+    SIM_SPI_T *psSpi = (SIM_SPI_T *)pvCtx;
+    SPI_T *spi = Spi_Regs(psSpi);
+    uint32_t u32Status = spi->STATUS, u32FifoCtl = spi->FIFO_CTL;
+
+    if(((spi->CNTRL & SPI_CNTRL_IE_Msk) && (spi->CNTRL & SPI_CNTRL_IF_Msk)) ||
+            ((u32FifoCtl & SPI_FIFO_CTL_RX_INTEN_Msk) && (u32Status & SPI_STATUS_RX_INTSTS_Msk)) ||
+            ((u32FifoCtl & SPI_FIFO_CTL_TX_INTEN_Msk) && (u32Status & SPI_STATUS_TX_INTSTS_Msk)) ||
+            ((u32FifoCtl & SPI_FIFO_CTL_RXOV_INTEN_Msk) && (u32Status & SPI_STATUS_RX_OVERRUN_Msk)))
+        return psSpi->u32IrqMsk;
+
+    return 0;
+}
+
+static void Spi_PreAccess(void *pvCtx, uint32_t u32Offset)
+{
+    (void)u32Offset;
+    Spi_Refresh((SIM_SPI_T *)pvCtx);
+}
+
+static void Spi_PostAccess(void *pvCtx, uint32_t u32Offset, int32_t i32IsWrite, uint32_t u32Old)
+{
+    SIM_SPI_T *psSpi = (SIM_SPI_T *)pvCtx;
+    SPI_T *spi = Spi_Regs(psSpi);
+    uint32_t u32Val = *(volatile uint32_t *)((uint8_t *)spi + u32Offset);
+
+    switch(u32Offset)
+    {
+        case offsetof(SPI_T, CNTRL):
+            if(!i32IsWrite)
+                break;
+            /* IF is write 1 to clear; GO_BUSY starts a single buffer transfer */
+            if(u32Val & SPI_CNTRL_IF_Msk)
+                u32Val &= ~SPI_CNTRL_IF_Msk;
+            else
+                u32Val |= u32Old & SPI_CNTRL_IF_Msk;
+            if((u32Val & SPI_CNTRL_GO_BUSY_Msk) && !(spi->CNTRL & SPI_CNTRL_FIFO_Msk) && !psSpi->i32Busy)
+                psSpi->i32Go = 1;
+            spi->CNTRL = u32Val;
+            break;
+
+        case offsetof(SPI_T, TX):
+            if(!i32IsWrite)
+                break;
+            if((spi->CNTRL & SPI_CNTRL_FIFO_Msk) && !(spi->DMA & SPI_DMA_TX_DMA_GO_Msk))
+            {
+                if(psSpi->u32TxCnt < SIM_SPI_FIFO_SIZE)
+                {
+                    psSpi->au32TxFifo[(psSpi->u32TxHead + psSpi->u32TxCnt) % SIM_SPI_FIFO_SIZE] = u32Val;
+                    psSpi->u32TxCnt++;
+                }
+            }
+            else
+            {
+                psSpi->u32TxLatch = u32Val;
+            }
+            break;
+
+        case offsetof(SPI_T, RX):
+            if(!i32IsWrite && (spi->CNTRL & SPI_CNTRL_FIFO_Msk) && psSpi->u32RxCnt)
+            {
+                psSpi->u32RxHead = (psSpi->u32RxHead + 1) % SIM_SPI_FIFO_SIZE;
+                psSpi->u32RxCnt--;
+            }
+            break;
+
+        case offsetof(SPI_T, DMA):
+            if(i32IsWrite && (u32Val & SPI_DMA_PDMA_RST_Msk))
+                spi->DMA = 0;
+            break;
+
+        case offsetof(SPI_T, FIFO_CTL):
+            if(!i32IsWrite)
+                break;
+            if(u32Val & SPI_FIFO_CTL_RX_CLR_Msk)
+                psSpi->u32RxHead = psSpi->u32RxCnt = 0;
+            if(u32Val & SPI_FIFO_CTL_TX_CLR_Msk)
+                psSpi->u32TxHead = psSpi->u32TxCnt = 0;
+            spi->FIFO_CTL = u32Val & ~(SPI_FIFO_CTL_RX_CLR_Msk | SPI_FIFO_CTL_TX_CLR_Msk);
+            break;
+
+        case offsetof(SPI_T, STATUS):
+            if(!i32IsWrite)
+                break;
+            psSpi->u32Sticky &= ~(u32Val & (SPI_STATUS_RX_OVERRUN_Msk | SPI_STATUS_TIMEOUT_Msk | SPI_STATUS_SLV_START_INTSTS_Msk));
+            if(u32Val & SPI_STATUS_IF_Msk)
+                spi->CNTRL &= ~SPI_CNTRL_IF_Msk;
+            break;
+
+        default:
+            break;
+    }
+
+    Spi_Update(pvCtx, SIM_Now());
+}
+
+#define SIM_SPI_MODEL(n) \
+    { "SPI" #n, 0, 0x100, &s_asSpi[n], Spi_Reset, Spi_PreAccess, Spi_PostAccess, Spi_Update, Spi_NextEvent, Spi_Irq }
+
+static SIM_MODEL_T s_asSpiModel[SIM_SPI_NUM] =
+{
+    SIM_SPI_MODEL(0),
+    SIM_SPI_MODEL(1),
+};
+
+void SIM_SpiRegister(void)
+{
+    uint32_t i;
+
+    for(i = 0; i < SIM_SPI_NUM; i++)
+    {
+        s_asSpiModel[i].u32Base = s_asSpi[i].u32Base;
+        SIM_RegisterModel(&s_asSpiModel[i]);
+    }
+}
+
+/**
+  * @brief      Attach a device to a SPI port
+  * @param[in]  u32Port     SPI port index, 0 ~ 1.
+  * @param[in]  pfnDevice   Device callback, NULL to loop MOSI back to MISO.
+  */
+void SIM_SpiAttach(uint32_t u32Port, SIM_SPI_DEVICE_T pfnDevice)
+{
+    SIM_Init();
+    if(u32Port < SIM_SPI_NUM)
+        s_asSpi[u32Port].pfnDevice = pfnDevice;
+}
+
+/*** (C) COPYRIGHT 2026 Nuvoton Technology Corp. ***/
@@ -0,0 +1,551 @@
+/**************************************************************************//**
+ * @file     host_sim_uart.c
+ * @version  V1.00
+ * @brief    M071R_M071S Series host simulator UART model
+ *
+ * @details  Models the TX/RX FIFOs, the shift registers with the baud rate and frame format
+ *           programmed in UA_BAUD/UA_LCR, RX FIFO trigger levels, RX time-out, the line status
+ *           error flags and the PDMA request lines. Transmitted characters are captured for the
+ *           harness and optionally echoed to stdout or looped into another port.
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2026 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include "host_sim_model.h"
+
+#define SIM_UART_WIRE_SIZE      4096        /* Characters queued by the harness, not yet on the RX line */
+#define SIM_UART_CAPTURE_SIZE   65536       /* Transmitted characters kept for SIM_UartRead() */
+#define SIM_UART_NO_PDMA        0xFF
+#define SIM_UART_INT_MSK        0x3C00BF00UL    /* xxx_INT and HW_xxx_INT bits of UA_ISR */
+
+typedef struct
+{
+    const char *pcName;
+    uint32_t    u32Base;
+    uint32_t    u32IrqMsk;
+    uint32_t    u32FifoSize;
+    uint32_t    u32PdmaTx;
+    uint32_t    u32PdmaRx;
+
+    uint8_t     au8RxFifo[64];
+    uint32_t    u32RxHead;
+    uint32_t    u32RxCnt;
+
+    uint8_t     au8TxFifo[64];
+    uint32_t    u32TxHead;
+    uint32_t    u32TxCnt;
+
+    int32_t     i32Shifting;
+    uint8_t     u8Shift;
+    uint64_t    u64ShiftEnd;
+
+    uint8_t     au8Wire[SIM_UART_WIRE_SIZE];
+    uint32_t    u32WireHead;
+    uint32_t    u32WireCnt;
+    uint64_t    u64NextArrival;
+
+    uint8_t     au8Capture[SIM_UART_CAPTURE_SIZE];
+    uint32_t    u32CapHead;
+    uint32_t    u32CapCnt;
+
+    uint64_t    u64RxActivity;      /* Last character received or read, restarts the time-out counter */
+    uint32_t    u32Sticky;          /* FSR error flags, write 1 to clear */
+    uint32_t    u32Echo;
+    int32_t     i32Peer;
+    uint32_t    u32Overrun;
+} SIM_UART_T;
+
+static SIM_UART_T s_asUart[SIM_UART_NUM] =
+{
+    { "UART0", UART0_BASE, 1UL << UART02_IRQn, 64, PDMA_UART0_TX, PDMA_UART0_RX },
+    { "UART1", UART1_BASE, 1UL << UART1_IRQn,  16, PDMA_UART1_TX, PDMA_UART1_RX },
+    { "UART2", UART2_BASE, 1UL << UART02_IRQn, 16, SIM_UART_NO_PDMA, SIM_UART_NO_PDMA },
+};
+
+static const uint8_t s_au8RxTrigger[8] = {1, 4, 8, 14, 30, 46, 62, 62};
+
+static UART_T *Uart_Regs(SIM_UART_T *psUart)
+{
+    return (UART_T *)SIM_Backdoor(psUart->u32Base);
+}
+
+static uint32_t Uart_ClockFreq(void)
+{
+    uint32_t u32Freq;
+
+    switch((SIM_BD(CLK)->CLKSEL1 & CLK_CLKSEL1_UART_S_Msk) >> CLK_CLKSEL1_UART_S_Pos)
+    {
+        case 0:
+            u32Freq = __HXT;
+            break;
+        case 1:
+            u32Freq = SIM_GetPLLFreq();
+            break;
+        default:
+            u32Freq = __HIRC;
+            break;
+    }
+    return u32Freq / (((SIM_BD(CLK)->CLKDIV & CLK_CLKDIV_UART_N_Msk) >> CLK_CLKDIV_UART_N_Pos) + 1);
+}
+
+/* UART clocks per bit */
+static uint32_t Uart_Divisor(UART_T *uart)
+{
+    uint32_t u32Baud = uart->BAUD;
+    uint32_t u32Brd = (u32Baud & UART_BAUD_BRD_Msk) + 2;
+
+    if(!(u32Baud & UART_BAUD_DIV_X_EN_Msk))
+        return u32Brd * 16;
+    if(u32Baud & UART_BAUD_DIV_X_ONE_Msk)
+        return u32Brd;
+    return u32Brd * (((u32Baud & UART_BAUD_DIVIDER_X_Msk) >> UART_BAUD_DIVIDER_X_Pos) + 1);
+}
+
+static uint64_t Uart_BitCycles(SIM_UART_T *psUart, uint32_t u32Bits)
+{
+    return SIM_CyclesFor((uint64_t)Uart_Divisor(Uart_Regs(psUart)) * u32Bits, Uart_ClockFreq());
+}
+
+static uint64_t Uart_CharCycles(SIM_UART_T *psUart)
+{
+    uint32_t u32Lcr = Uart_Regs(psUart)->LCR;
+    uint32_t u32Bits;
+
+    u32Bits = 1 + 5 + (u32Lcr & UART_LCR_WLS_Msk) + 1;
+    if(u32Lcr & UART_LCR_PBE_Msk)
+        u32Bits++;
+    if(u32Lcr & UART_LCR_NSB_Msk)
+        u32Bits++;
+
+    return Uart_BitCycles(psUart, u32Bits);
+}
+
+static void Uart_RxPush(SIM_UART_T *psUart, uint8_t u8Data)
+{
+    UART_T *uart = Uart_Regs(psUart);
+
+    psUart->u64RxActivity = SIM_Now();
+
+    if(uart->FCR & UART_FCR_RX_DIS_Msk)
+        return;
+
+    if((uart->IER & UART_IER_DMA_RX_EN_Msk) && (psUart->u32RxCnt == 0) &&
+            SIM_PdmaRxRequest(psUart->u32PdmaRx, u8Data))
+        return;
+
+    if(psUart->u32RxCnt >= psUart->u32FifoSize)
+    {
+        psUart->u32Sticky |= UART_FSR_RX_OVER_IF_Msk;
+        psUart->u32Overrun++;
+        return;
+    }
+    psUart->au8RxFifo[(psUart->u32RxHead + psUart->u32RxCnt) % psUart->u32FifoSize] = u8Data;
+    psUart->u32RxCnt++;
+}
+
+static uint8_t Uart_RxPop(SIM_UART_T *psUart)
+{
+    uint8_t u8Data = psUart->au8RxFifo[psUart->u32RxHead];
+
+    psUart->u32RxHead = (psUart->u32RxHead + 1) % psUart->u32FifoSize;
+    psUart->u32RxCnt--;
+    return u8Data;
+}
+
+static void Uart_TxPush(SIM_UART_T *psUart, uint8_t u8Data)
+{
+    if(psUart->u32TxCnt >= psUart->u32FifoSize)
+    {
+        psUart->u32Sticky |= UART_FSR_TX_OVER_IF_Msk;
+        return;
+    }
+    psUart->au8TxFifo[(psUart->u32TxHead + psUart->u32TxCnt) % psUart->u32FifoSize] = u8Data;
+    psUart->u32TxCnt++;
+}
+
+/* Move the next character of the TX FIFO into the shift register */
+static void Uart_TxStart(SIM_UART_T *psUart, uint64_t u64Start)
+{
+    if(psUart->i32Shifting || (psUart->u32TxCnt == 0))
+        return;
+
+    psUart->u8Shift = psUart->au8TxFifo[psUart->u32TxHead];
+    psUart->u32TxHead = (psUart->u32TxHead + 1) % psUart->u32FifoSize;
+    psUart->u32TxCnt--;
+    psUart->i32Shifting = 1;
+    psUart->u64ShiftEnd = u64Start + Uart_CharCycles(psUart);
+}
+
+static void Uart_TxDone(SIM_UART_T *psUart)
+{
+    uint8_t u8Data = psUart->u8Shift;
+
+    psUart->i32Shifting = 0;
+
+    psUart->au8Capture[(psUart->u32CapHead + psUart->u32CapCnt) % SIM_UART_CAPTURE_SIZE] = u8Data;
+    if(psUart->u32CapCnt < SIM_UART_CAPTURE_SIZE)
+        psUart->u32CapCnt++;
+    else
+        psUart->u32CapHead = (psUart->u32CapHead + 1) % SIM_UART_CAPTURE_SIZE;
+
+    if(psUart->u32Echo)
+    {
+        fputc(u8Data, stdout);
+        fflush(stdout);
+    }
+
+    if(psUart->i32Peer >= 0)
+        Uart_RxPush(&s_asUart[psUart->i32Peer], u8Data);
+}
+
+static uint32_t Uart_RxTrigger(SIM_UART_T *psUart)
+{
+    return s_au8RxTrigger[(Uart_Regs(psUart)->FCR & UART_FCR_RFITL_Msk) >> UART_FCR_RFITL_Pos];
+}
+
+static uint64_t Uart_TimeoutAt(SIM_UART_T *psUart)
+{
+    UART_T *uart = Uart_Regs(psUart);
+    uint32_t u32Toic = (uart->TOR & UART_TOR_TOIC_Msk) >> UART_TOR_TOIC_Pos;
+
+    if((psUart->u32RxCnt == 0) || !(uart->IER & UART_IER_TIME_OUT_EN_Msk))
+        return SIM_NO_EVENT;
+
+    return psUart->u64RxActivity + Uart_BitCycles(psUart, u32Toic ? u32Toic : 1);
+}
+
+static void Uart_Refresh(SIM_UART_T *psUart)
+{
+    UART_T *uart = Uart_Regs(psUart);
+    uint32_t u32Fsr, u32If = 0, u32Int = 0, u32Ier = uart->IER;
+    uint32_t u32Tx = psUart->u32TxCnt, u32Rx = psUart->u32RxCnt;
+
+    u32Fsr = psUart->u32Sticky;
+    u32Fsr |= (u32Rx & 0x3F) << UART_FSR_RX_POINTER_Pos;
+    u32Fsr |= (u32Tx & 0x3F) << UART_FSR_TX_POINTER_Pos;
+    if(u32Rx == 0)
+        u32Fsr |= UART_FSR_RX_EMPTY_Msk;
+    if(u32Rx >= psUart->u32FifoSize)
+        u32Fsr |= UART_FSR_RX_FULL_Msk;
+    if(u32Tx == 0)
+        u32Fsr |= UART_FSR_TX_EMPTY_Msk;
+    if(u32Tx >= psUart->u32FifoSize)
+        u32Fsr |= UART_FSR_TX_FULL_Msk;
+    if((u32Tx == 0) && !psUart->i32Shifting)
+        u32Fsr |= UART_FSR_TE_FLAG_Msk;
+    uart->FSR = u32Fsr;
+
+    if(u32Rx && (u32Rx >= Uart_RxTrigger(psUart)))
+        u32If |= UART_ISR_RDA_IF_Msk;
+    if(u32Tx == 0)
+        u32If |= UART_ISR_THRE_IF_Msk;
+    if(u32Fsr & (UART_FSR_BIF_Msk | UART_FSR_FEF_Msk | UART_FSR_PEF_Msk | UART_FSR_RS485_ADD_DETF_Msk))
+        u32If |= UART_ISR_RLS_IF_Msk;
+    if(Uart_TimeoutAt(psUart) <= SIM_Now())
+        u32If |= UART_ISR_TOUT_IF_Msk;
+    if(u32Fsr & (UART_FSR_RX_OVER_IF_Msk | UART_FSR_TX_OVER_IF_Msk))
+        u32If |= UART_ISR_BUF_ERR_IF_Msk;
+
+    /* The interrupt enable bits of UA_IER line up with the flag bits of UA_ISR */
+    u32Int = (u32If & u32Ier & 0x3F) << UART_ISR_RDA_INT_Pos;
+
+    if(u32Ier & (UART_IER_DMA_TX_EN_Msk | UART_IER_DMA_RX_EN_Msk))
+    {
+        /* In DMA mode the line status, time-out and buffer error events are also reported as HW_xxx */
+        if(u32If & UART_ISR_RLS_IF_Msk)
+            u32If |= UART_ISR_HW_RLS_IF_Msk;
+        if(u32If & UART_ISR_TOUT_IF_Msk)
+            u32If |= UART_ISR_HW_TOUT_IF_Msk;
+        if(u32If & UART_ISR_BUF_ERR_IF_Msk)
+            u32If |= UART_ISR_HW_BUF_ERR_IF_Msk;
+        u32Int |= (u32Int & (UART_ISR_RLS_INT_Msk | UART_ISR_MODEM_INT_Msk | UART_ISR_TOUT_INT_Msk | UART_ISR_BUF_ERR_INT_Msk)) << 16;
+    }
+
+    uart->ISR = u32If | u32Int;
+}
+
+static void Uart_Reset(void *pvCtx)
+{
+    SIM_UART_T *psUart = (SIM_UART_T *)pvCtx;
+
+    memset(Uart_Regs(psUart), 0, 0x40);
+    psUart->u32RxHead = psUart->u32RxCnt = 0;
+    psUart->u32TxHead = psUart->u32TxCnt = 0;
+    psUart->i32Shifting = 0;
+    psUart->u32Sticky = 0;
+    psUart->u64RxActivity = SIM_Now();
+    Uart_Refresh(psUart);
+}
+
+static void Uart_Update(void *pvCtx, uint64_t u64Now)
+{
+    SIM_UART_T *psUart = (SIM_UART_T *)pvCtx;
+    UART_T *uart = Uart_Regs(psUart);
+    uint32_t u32Data;
+    int32_t i32Progress;
+
+    do
+    {
+        i32Progress = 0;
+
+        /* PDMA keeps the TX FIFO filled */
+        if(uart->IER & UART_IER_DMA_TX_EN_Msk)
+        {
+            while((psUart->u32TxCnt < psUart->u32FifoSize) && SIM_PdmaTxRequest(psUart->u32PdmaTx, &u32Data))
+                Uart_TxPush(psUart, (uint8_t)u32Data);
+        }
+
+        /* PDMA drains characters that were received before DMA was enabled */
+        if(uart->IER & UART_IER_DMA_RX_EN_Msk)
+        {
+            while(psUart->u32RxCnt && SIM_PdmaRxRequest(psUart->u32PdmaRx, psUart->au8RxFifo[psUart->u32RxHead]))
+                Uart_RxPop(psUart);
+        }
+
+        if(!psUart->i32Shifting && psUart->u32TxCnt)
+            Uart_TxStart(psUart, u64Now);
+
+        /* Process the earliest of the pending TX completion and RX arrival */
+        if(psUart->i32Shifting && (psUart->u64ShiftEnd <= u64Now) &&
+                (!psUart->u32WireCnt || (psUart->u64ShiftEnd <= psUart->u64NextArrival)))
+        {
+            uint64_t u64End = psUart->u64ShiftEnd;
+
+            Uart_TxDone(psUart);
+            if(uart->IER & UART_IER_DMA_TX_EN_Msk)
+            {
+                while((psUart->u32TxCnt < psUart->u32FifoSize) && SIM_PdmaTxRequest(psUart->u32PdmaTx, &u32Data))
+                    Uart_TxPush(psUart, (uint8_t)u32Data);
+            }
+            Uart_TxStart(psUart, u64End);
+            i32Progress = 1;
+        }
+        else if(psUart->u32WireCnt && (psUart->u64NextArrival <= u64Now))
+        {
+            uint64_t u64Arrival = psUart->u64NextArrival;
+
+            Uart_RxPush(psUart, psUart->au8Wire[psUart->u32WireHead]);
+            psUart->u64RxActivity = u64Arrival;
+            psUart->u32WireHead = (psUart->u32WireHead + 1) % SIM_UART_WIRE_SIZE;
+            psUart->u32WireCnt--;
+            if(psUart->u32WireCnt)
+                psUart->u64NextArrival = u64Arrival + Uart_CharCycles(psUart);
+            i32Progress = 1;
+        }
+    }
+    while(i32Progress);
+
+    Uart_Refresh(psUart);
+}
+
+static uint64_t Uart_NextEvent(void *pvCtx)
+{
+    SIM_UART_T *psUart = (SIM_UART_T *)pvCtx;
+    uint64_t u64Next = SIM_NO_EVENT, u64Tout;
+
+    if(psUart->i32Shifting)
+        u64Next = psUart->u64ShiftEnd;
+    if(psUart->u32WireCnt && (psUart->u64NextArrival < u64Next))
+        u64Next = psUart->u64NextArrival;
+
+    u64Tout = Uart_TimeoutAt(psUart);
+    if((u64Tout > SIM_Now()) && (u64Tout < u64Next))
+        u64Next = u64Tout;
+
+    return u64Next;
+}
+
+static uint32_t Uart_Irq(void *pvCtx)
+{
+    SIM_UART_T *psUart = (SIM_UART_T *)pvCtx;
+    uint32_t u32Isr = Uart_Regs(psUart)->ISR;
+
+    return (u32Isr & SIM_UART_INT_MSK) ? psUart->u32IrqMsk : 0;
+}
+
+static void Uart_PreAccess(void *pvCtx, uint32_t u32Offset)
+{
+    SIM_UART_T *psUart = (SIM_UART_T *)pvCtx;
+
+    if((u32Offset == offsetof(UART_T, DATA)) && psUart->u32RxCnt)
+        Uart_Regs(psUart)->DATA = psUart->au8RxFifo[psUart->u32RxHead];
+    Uart_Refresh(psUart);
+}
+
+static void Uart_PostAccess(void *pvCtx, uint32_t u32Offset, int32_t i32IsWrite, uint32_t u32Old)
+{
+    SIM_UART_T *psUart = (SIM_UART_T *)pvCtx;
+    UART_T *uart = Uart_Regs(psUart);
+    uint32_t u32Val = *(volatile uint32_t *)((uint8_t *)uart + u32Offset);
+
+    switch(u32Offset)
+    {
+        case offsetof(UART_T, DATA):
+            if(i32IsWrite)
+            {
+                Uart_TxPush(psUart, (uint8_t)u32Val);
+                Uart_TxStart(psUart, SIM_Now());
+            }
+            else if(psUart->u32RxCnt)
+            {
+                Uart_RxPop(psUart);
+                psUart->u64RxActivity = SIM_Now();
+            }
+            break;
+
+        case offsetof(UART_T, FCR):
+            if(!i32IsWrite)
+                break;
+            if(u32Val & UART_FCR_RFR_Msk)
+                psUart->u32RxHead = psUart->u32RxCnt = 0;
+            if(u32Val & UART_FCR_TFR_Msk)
+                psUart->u32TxHead = psUart->u32TxCnt = 0;
+            uart->FCR = u32Val & ~(UART_FCR_RFR_Msk | UART_FCR_TFR_Msk);
+            break;
+
+        case offsetof(UART_T, FSR):
+            if(i32IsWrite)
+                psUart->u32Sticky &= ~u32Val;
+            break;
+
+        case offsetof(UART_T, ISR):
+            if(i32IsWrite)
+                uart->ISR = u32Old;
+            break;
+
+        case offsetof(UART_T, IER):
+            if(i32IsWrite && ((u32Val ^ u32Old) & UART_IER_TIME_OUT_EN_Msk))
+                psUart->u64RxActivity = SIM_Now();
+            break;
+
+        default:
+            break;
+    }
+
+    Uart_Update(pvCtx, SIM_Now());
+}
+
+#define SIM_UART_MODEL(n) \
+    { "UART" #n, 0, 0x40, &s_asUart[n], Uart_Reset, Uart_PreAccess, Uart_PostAccess, Uart_Update, Uart_NextEvent, Uart_Irq }
+
+static SIM_MODEL_T s_asUartModel[SIM_UART_NUM] =
+{
+    SIM_UART_MODEL(0),
+    SIM_UART_MODEL(1),
+    SIM_UART_MODEL(2),
+};
+
+void SIM_UartRegister(void)
+{
+    uint32_t i;
+
+    for(i = 0; i < SIM_UART_NUM; i++)
+    {
+        s_asUart[i].i32Peer = -1;
+        s_asUartModel[i].u32Base = s_asUart[i].u32Base;
+        SIM_RegisterModel(&s_asUartModel[i]);
+    }
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Harness API                                                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+/**
+  * @brief      Queue characters on the RX line of a UART port
+  * @param[in]  u32Port     UART port index, 0 ~ 2.
+  * @param[in]  pu8Data     Characters to receive.
+  * @param[in]  u32Len      Number of characters.
+  * @return     Number of characters queued.
+  * @details    Characters arrive back to back at the baud rate and frame format of the port.
+  */
+uint32_t SIM_UartInject(uint32_t u32Port, const uint8_t *pu8Data, uint32_t u32Len)
+{
+    SIM_UART_T *psUart;
+    uint32_t i;
+
+    SIM_Init();
+    if(u32Port >= SIM_UART_NUM)
+        return 0;
+
+    psUart = &s_asUart[u32Port];
+    SIM_Sync();
+    for(i = 0; (i < u32Len) && (psUart->u32WireCnt < SIM_UART_WIRE_SIZE); i++)
+    {
+        if(psUart->u32WireCnt == 0)
+            psUart->u64NextArrival = SIM_Now() + Uart_CharCycles(psUart);
+        psUart->au8Wire[(psUart->u32WireHead + psUart->u32WireCnt) % SIM_UART_WIRE_SIZE] = pu8Data[i];
+        psUart->u32WireCnt++;
+    }
+    return i;
+}
+
+/**
+  * @brief      Read characters transmitted by a UART port
+  * @param[in]  u32Port     UART port index, 0 ~ 2.
+  * @param[out] pu8Buf      Buffer for the characters.
+  * @param[in]  u32Len      Buffer size.
+  * @return     Number of characters copied.
+  */
+uint32_t SIM_UartRead(uint32_t u32Port, uint8_t *pu8Buf, uint32_t u32Len)
+{
+    SIM_UART_T *psUart;
+    uint32_t i;
+
+    SIM_Init();
+    if(u32Port >= SIM_UART_NUM)
+        return 0;
+
+    psUart = &s_asUart[u32Port];
+    for(i = 0; (i < u32Len) && psUart->u32CapCnt; i++)
+    {
+        pu8Buf[i] = psUart->au8Capture[psUart->u32CapHead];
+        psUart->u32CapHead = (psUart->u32CapHead + 1) % SIM_UART_CAPTURE_SIZE;
+        psUart->u32CapCnt--;
+    }
+    return i;
+}
+
+/**
+  * @brief      Number of transmitted characters not yet read by SIM_UartRead()
+  */
+uint32_t SIM_UartPending(uint32_t u32Port)
+{
+    return (u32Port < SIM_UART_NUM) ? s_asUart[u32Port].u32CapCnt : 0;
+}
+
+/**
+  * @brief      Copy the characters transmitted by a port to stdout
+  */
+void SIM_UartSetEcho(uint32_t u32Port, uint32_t u32Enable)
+{
+    if(u32Port < SIM_UART_NUM)
+        s_asUart[u32Port].u32Echo = u32Enable;
+}
+
+/**
+  * @brief      Cross-connect TXD and RXD of two ports. Connecting a port to itself is a loopback.
+  */
+void SIM_UartConnect(uint32_t u32Port0, uint32_t u32Port1)
+{
+    if((u32Port0 >= SIM_UART_NUM) || (u32Port1 >= SIM_UART_NUM))
+        return;
+
+    s_asUart[u32Port0].i32Peer = (int32_t)u32Port1;
+    s_asUart[u32Port1].i32Peer = (int32_t)u32Port0;
+}
+
+/**
+  * @brief      Number of characters dropped because the RX FIFO was full
+  */
+uint32_t SIM_UartGetOverrunCount(uint32_t u32Port)
+{
+    return (u32Port < SIM_UART_NUM) ? s_asUart[u32Port].u32Overrun : 0;
+}
+
+/*** (C) COPYRIGHT 2026 Nuvoton Technology Corp. ***/
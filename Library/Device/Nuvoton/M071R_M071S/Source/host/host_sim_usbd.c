@@ -0,0 +1,459 @@
+/**************************************************************************//**
+ * @file     host_sim_usbd.c
+ * @version  V1.00
+ * @brief    M071R_M071S Series host simulator USBD model
+ *
+ * @details  Models the 512 byte packet buffer SRAM, the eight endpoint engines with their ready,
+ *           stall and data toggle state, the SETUP buffer, the bus, float detect and USB event
+ *           interrupts and the EPSTS transaction status. The USB host is the harness: it issues
+ *           SETUP, IN and OUT transactions through SIM_UsbdSetup()/SIM_UsbdIn()/SIM_UsbdOut(),
+ *           each of which takes the full speed bus time of the packet.
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2026 Nuvoton Technology Corp. All rights reserved.
+ *
+ ******************************************************************************/
+#include <stddef.h>
+#include <string.h>
+#include "host_sim_model.h"
+
+#define SIM_USBD_SRAM_SIZE      512
+#define SIM_USBD_BIT_RATE       12000000    /* Full speed */
+#define SIM_USBD_PKT_OVERHEAD   13          /* SYNC, PID, CRC16, EOP and inter-packet gap, in bytes */
+#define SIM_USBD_NAK_RETRY      10000       /* SIM_UsbdControl: IN/OUT retries on NAK */
+#define SIM_USBD_RESET_US       10000       /* SIM_UsbdBusReset: SE0 duration */
+
+/* EPSTS transaction status */
+#define SIM_USBD_EPSTS_INACK    0
+#define SIM_USBD_EPSTS_INNAK    1
+#define SIM_USBD_EPSTS_OUT0ACK  2
+#define SIM_USBD_EPSTS_OUT1ACK  6
+
+typedef struct
+{
+    uint32_t u32Attached;
+    uint32_t u32BusState;           /* ATTR[3:0] latched with the last bus event */
+    uint32_t u32Events;             /* INTSTS event flags, write 1 to clear */
+    uint32_t u32EpSts;
+    uint32_t u32Ready;              /* Bit n: endpoint n holds or accepts a packet */
+    uint32_t au32Mxpld[USBD_MAX_EP];/* Value armed by the last write of MXPLD */
+} SIM_USBD_T;
+
+static SIM_USBD_T s_sUsbd;
+static uint32_t s_u32HostEp0Max = 64;      /* bMaxPacketSize0 as known to the host */
+
+static USBD_T *Usbd_Regs(void)
+{
+    return (USBD_T *)SIM_Backdoor(USBD_BASE);
+}
+
+static uint8_t *Usbd_Sram(uint32_t u32Offset)
+{
+    return (uint8_t *)SIM_Backdoor(USBD_BUF_BASE) + (u32Offset % SIM_USBD_SRAM_SIZE);
+}
+
+static int32_t Usbd_Online(void)
+{
+    USBD_T *usbd = Usbd_Regs();
+
+    return s_sUsbd.u32Attached && (usbd->ATTR & USBD_ATTR_USB_EN_Msk) && (usbd->ATTR & USBD_ATTR_PHY_EN_Msk) &&
+           !(usbd->DRVSE0 & USBD_DRVSE0_DRVSE0_Msk);
+}
+
+static void Usbd_Refresh(void)
+{
+    USBD_T *usbd = Usbd_Regs();
+    uint32_t u32Sts = s_sUsbd.u32Events;
+
+    if(u32Sts & (USBD_INTSTS_SETUP_Msk | (0xFFUL << USBD_INTSTS_EPEVT0_Pos)))
+        u32Sts |= USBD_INTSTS_USB_STS_Msk;
+
+    usbd->INTSTS = u32Sts;
+    SIM_RO(usbd->EPSTS) = s_sUsbd.u32EpSts;
+    SIM_RO(usbd->FLDET) = s_sUsbd.u32Attached ? USBD_FLDET_FLDET_Msk : 0;
+    usbd->ATTR = (usbd->ATTR & ~0xFUL) | s_sUsbd.u32BusState;
+
+    /* The host sends a SOF every millisecond while the bus is active */
+    if(Usbd_Online())
+        SIM_RO(usbd->FN) = (uint32_t)(SIM_Now() / SIM_CyclesFor(1, 1000)) & USBD_FN_FN_Msk;
+}
+
+static void Usbd_Event(uint32_t u32Flag)
+{
+    s_sUsbd.u32Events |= u32Flag;
+    Usbd_Refresh();
+    SIM_Sync();
+    SIM_Dispatch();
+}
+
+/* Endpoint engine configured for an endpoint address, -1 if none */
+static int32_t Usbd_FindEp(uint32_t u32EpAddr)
+{
+    USBD_T *usbd = Usbd_Regs();
+    uint32_t u32State = (u32EpAddr & EP_INPUT) ? USBD_CFG_EPMODE_IN : USBD_CFG_EPMODE_OUT;
+    int32_t i;
+
+    for(i = 0; i < USBD_MAX_EP; i++)
+    {
+        if(((usbd->EP[i].CFG & USBD_CFG_EP_NUM_Msk) == (u32EpAddr & 0xF)) &&
+                ((usbd->EP[i].CFG & USBD_CFG_STATE_Msk) == u32State))
+            return i;
+    }
+    return -1;
+}
+
+static void Usbd_BusTime(uint32_t u32Bytes)
+{
+    SIM_Advance((uint32_t)SIM_CyclesFor((uint64_t)(u32Bytes + SIM_USBD_PKT_OVERHEAD) * 8, SIM_USBD_BIT_RATE));
+}
+
+static void Usbd_SetEpSts(uint32_t u32Ep, uint32_t u32Sts)
+{
+    s_sUsbd.u32EpSts &= ~(7UL << (USBD_EPSTS_EPSTS0_Pos + 3 * u32Ep));
+    s_sUsbd.u32EpSts |= u32Sts << (USBD_EPSTS_EPSTS0_Pos + 3 * u32Ep);
+}
+
+static void Usbd_Reset(void *pvCtx)
+{
+    USBD_T *usbd = Usbd_Regs();
+    uint32_t u32Attached = s_sUsbd.u32Attached;
+
+    (void)pvCtx;
+    memset(usbd, 0, 0x580);
+    memset(&s_sUsbd, 0, sizeof(s_sUsbd));
+    s_sUsbd.u32Attached = u32Attached;
+    usbd->INTEN = USBD_INTEN_WAKEUP_EN_Msk;
+    usbd->ATTR = 0x40;
+    usbd->DRVSE0 = USBD_DRVSE0_DRVSE0_Msk;
+    Usbd_Refresh();
+}
+
+static void Usbd_PreAccess(void *pvCtx, uint32_t u32Offset)
+{
+    (void)pvCtx;
+    (void)u32Offset;
+    Usbd_Refresh();
+}
+
+static void Usbd_PostAccess(void *pvCtx, uint32_t u32Offset, int32_t i32IsWrite, uint32_t u32Old)
+{
+    USBD_T *usbd = Usbd_Regs();
+    uint32_t u32Val = *(volatile uint32_t *)((uint8_t *)usbd + u32Offset);
+    uint32_t u32Ep;
+
+    (void)pvCtx;
+    if(!i32IsWrite)
+        return;
+
+    if(u32Offset >= offsetof(USBD_T, EP))
+    {
+        u32Ep = (u32Offset - offsetof(USBD_T, EP)) / sizeof(USBD_EP_T);
+        switch((u32Offset - offsetof(USBD_T, EP)) % sizeof(USBD_EP_T))
+        {
+            case offsetof(USBD_EP_T, MXPLD):
+                /* Writing MXPLD arms the endpoint */
+                s_sUsbd.au32Mxpld[u32Ep] = u32Val & USBD_MXPLD_MXPLD_Msk;
+                s_sUsbd.u32Ready |= 1UL << u32Ep;
+                break;
+
+            case offsetof(USBD_EP_T, CFG):
+                if(u32Val & USBD_CFG_CSTALL_Msk)
+                    usbd->EP[u32Ep].CFGP &= ~USBD_CFGP_SSTALL_Msk;
+                break;
+
+            case offsetof(USBD_EP_T, CFGP):
+                if(u32Val & USBD_CFGP_CLRRDY_Msk)
+                {
+                    s_sUsbd.u32Ready &= ~(1UL << u32Ep);
+                    usbd->EP[u32Ep].CFGP = u32Val & ~USBD_CFGP_CLRRDY_Msk;
+                }
+                break;
+
+            default:
+                break;
+        }
+        return;
+    }
+
+    switch(u32Offset)
+    {
+        case offsetof(USBD_T, INTSTS):
+            s_sUsbd.u32Events &= ~u32Val;
+            if(u32Val & USBD_INTSTS_BUS_STS_Msk)
+                s_sUsbd.u32BusState = 0;
+            break;
+
+        case offsetof(USBD_T, EPSTS):
+        case offsetof(USBD_T, FLDET):
+        case offsetof(USBD_T, FN):
+            /* Read only */
+            *(volatile uint32_t *)((uint8_t *)usbd + u32Offset) = u32Old;
+            break;
+
+        default:
+            break;
+    }
+    Usbd_Refresh();
+}
+
+static uint32_t Usbd_Irq(void *pvCtx)
+{
+    USBD_T *usbd = Usbd_Regs();
+    uint32_t u32Sts = usbd->INTSTS, u32En = usbd->INTEN;
+
+    (void)pvCtx;
+    if(((u32En & USBD_INTEN_BUS_IE_Msk) && (u32Sts & USBD_INTSTS_BUS_STS_Msk)) ||
+            ((u32En & USBD_INTEN_USB_IE_Msk) && (u32Sts & USBD_INTSTS_USB_STS_Msk)) ||
+            ((u32En & USBD_INTEN_FLDET_IE_Msk) && (u32Sts & USBD_INTSTS_FLDET_STS_Msk)) ||
+            ((u32En & USBD_INTEN_WAKEUP_IE_Msk) && (u32Sts & USBD_INTSTS_WAKEUP_STS_Msk)))
+        return 1UL << USBD_IRQn;
+
+    return 0;
+}
+
+static const SIM_MODEL_T s_sUsbdModel =
+{
+    "USBD", USBD_BASE, 0x580, NULL, Usbd_Reset, Usbd_PreAccess, Usbd_PostAccess, NULL, NULL, Usbd_Irq
+};
+
+void SIM_UsbdRegister(void)
+{
+    SIM_RegisterModel(&s_sUsbdModel);
+}
+
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Harness API: the USB host                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+/**
+  * @brief      Plug or unplug the USB cable
+  * @param[in]  u32Attach   1 to attach VBUS, 0 to detach.
+  */
+void SIM_UsbdAttach(uint32_t u32Attach)
+{
+    SIM_Init();
+    u32Attach = u32Attach ? 1 : 0;
+    if(s_sUsbd.u32Attached == u32Attach)
+        return;
+
+    s_sUsbd.u32Attached = u32Attach;
+    Usbd_Event(USBD_INTSTS_FLDET_STS_Msk);
+}
+
+/**
+  * @brief      Drive a bus reset
+  * @details    Every endpoint loses its ready state. The bus event interrupt reports USBRST.
+  */
+void SIM_UsbdBusReset(void)
+{
+    SIM_Init();
+    if(!s_sUsbd.u32Attached)
+        return;
+
+    s_sUsbd.u32Ready = 0;
+    s_sUsbd.u32BusState = USBD_ATTR_USBRST_Msk;
+    SIM_AdvanceUs(SIM_USBD_RESET_US);
+    Usbd_Event(USBD_INTSTS_BUS_STS_Msk);
+}
+
+/**
+  * @brief      Send a SETUP transaction to the control endpoint
+  * @param[in]  au8Setup    The 8 byte SETUP packet.
+  * @details    The packet is stored at STBUFSEG, the ready state and the stall of every endpoint with
+  *             endpoint number 0 are cleared, and the SETUP event is raised.
+  */
+void SIM_UsbdSetup(const uint8_t au8Setup[8])
+{
+    USBD_T *usbd;
+    uint32_t i;
+
+    SIM_Init();
+    if(!Usbd_Online())
+        return;
+
+    usbd = Usbd_Regs();
+    for(i = 0; i < 8; i++)
+        *Usbd_Sram((usbd->STBUFSEG & USBD_STBUFSEG_STBUFSEG_Msk) + i) = au8Setup[i];
+
+    for(i = 0; i < USBD_MAX_EP; i++)
+    {
+        if((usbd->EP[i].CFG & USBD_CFG_EP_NUM_Msk) == 0)
+        {
+            s_sUsbd.u32Ready &= ~(1UL << i);
+            usbd->EP[i].CFGP &= ~USBD_CFGP_SSTALL_Msk;
+        }
+    }
+
+    Usbd_BusTime(8);
+    Usbd_Event(USBD_INTSTS_SETUP_Msk);
+}
+
+/**
+  * @brief      Send an IN token
+  * @param[in]  u32EpAddr   Endpoint address, bit 7 set.
+  * @param[out] pu8Buf      Buffer for the data packet.
+  * @param[in]  u32Size     Buffer size.
+  * @return     Packet length, or SIM_USBD_NAK, SIM_USBD_STALL, SIM_USBD_NO_EP.
+  */
+int32_t SIM_UsbdIn(uint32_t u32EpAddr, uint8_t *pu8Buf, uint32_t u32Size)
+{
+    USBD_T *usbd;
+    int32_t i32Ep;
+    uint32_t u32Len, i;
+
+    SIM_Init();
+    if(!Usbd_Online() || ((i32Ep = Usbd_FindEp(u32EpAddr | EP_INPUT)) < 0))
+        return SIM_USBD_NO_EP;
+
+    usbd = Usbd_Regs();
+    if(usbd->EP[i32Ep].CFGP & USBD_CFGP_SSTALL_Msk)
+    {
+        Usbd_BusTime(0);
+        return SIM_USBD_STALL;
+    }
+
+    if(!(s_sUsbd.u32Ready & (1UL << i32Ep)))
+    {
+        Usbd_BusTime(0);
+        if(usbd->INTEN & USBD_INTEN_INNAK_EN_Msk)
+        {
+            Usbd_SetEpSts(i32Ep, SIM_USBD_EPSTS_INNAK);
+            Usbd_Event(USBD_INTSTS_EPEVT0_Msk << i32Ep);
+        }
+        return SIM_USBD_NAK;
+    }
+
+    u32Len = s_sUsbd.au32Mxpld[i32Ep];
+    for(i = 0; (i < u32Len) && (i < u32Size); i++)
+        pu8Buf[i] = *Usbd_Sram((usbd->EP[i32Ep].BUFSEG & USBD_BUFSEG_BUFSEG_Msk) + i);
+
+    Usbd_BusTime(u32Len);
+    s_sUsbd.u32Ready &= ~(1UL << i32Ep);
+    usbd->EP[i32Ep].CFG ^= USBD_CFG_DSQ_SYNC_Msk;
+    Usbd_SetEpSts(i32Ep, SIM_USBD_EPSTS_INACK);
+    Usbd_Event(USBD_INTSTS_EPEVT0_Msk << i32Ep);
+
+    return (int32_t)u32Len;
+}
+
+/**
+  * @brief      Send an OUT transaction
+  * @param[in]  u32EpAddr   Endpoint address, bit 7 clear.
+  * @param[in]  pu8Data     Data packet.
+  * @param[in]  u32Len      Packet length. Bytes beyond the armed MXPLD are dropped.
+  * @return     Number of bytes accepted, or SIM_USBD_NAK, SIM_USBD_STALL, SIM_USBD_NO_EP.
+  */
+int32_t SIM_UsbdOut(uint32_t u32EpAddr, const uint8_t *pu8Data, uint32_t u32Len)
+{
+    USBD_T *usbd;
+    int32_t i32Ep;
+    uint32_t i;
+
+    SIM_Init();
+    if(!Usbd_Online() || ((i32Ep = Usbd_FindEp(u32EpAddr & ~EP_INPUT)) < 0))
+        return SIM_USBD_NO_EP;
+
+    usbd = Usbd_Regs();
+    Usbd_BusTime(u32Len);
+
+    if(usbd->EP[i32Ep].CFGP & USBD_CFGP_SSTALL_Msk)
+        return SIM_USBD_STALL;
+    if(!(s_sUsbd.u32Ready & (1UL << i32Ep)))
+        return SIM_USBD_NAK;
+
+    if(u32Len > s_sUsbd.au32Mxpld[i32Ep])
+        u32Len = s_sUsbd.au32Mxpld[i32Ep];
+    for(i = 0; i < u32Len; i++)
+        *Usbd_Sram((usbd->EP[i32Ep].BUFSEG & USBD_BUFSEG_BUFSEG_Msk) + i) = pu8Data[i];
+
+    usbd->EP[i32Ep].MXPLD = u32Len;
+    s_sUsbd.u32Ready &= ~(1UL << i32Ep);
+    Usbd_SetEpSts(i32Ep, (usbd->EP[i32Ep].CFG & USBD_CFG_DSQ_SYNC_Msk) ? SIM_USBD_EPSTS_OUT1ACK : SIM_USBD_EPSTS_OUT0ACK);
+    usbd->EP[i32Ep].CFG ^= USBD_CFG_DSQ_SYNC_Msk;
+    Usbd_Event(USBD_INTSTS_EPEVT0_Msk << i32Ep);
+
+    return (int32_t)u32Len;
+}
+
+/**
+  * @brief      Run a complete control transfer on endpoint 0
+  * @param[in]  au8Setup    The 8 byte SETUP packet. wLength limits the data stage.
+  * @param[in,out] pu8Data  Data stage buffer: received data for device-to-host requests, data to send
+  *                         for host-to-device requests.
+  * @param[in]  u32Len      Size of pu8Data.
+  * @return     Number of data stage bytes transferred, or SIM_USBD_STALL, SIM_USBD_NAK on time-out,
+  *             SIM_USBD_NO_EP.
+  * @details    NAKed transactions are retried after 10 us, like a host retrying within the frame.
+  */
+int32_t SIM_UsbdControl(const uint8_t au8Setup[8], uint8_t *pu8Data, uint32_t u32Len)
+{
+    uint32_t u32Total = au8Setup[6] | ((uint32_t)au8Setup[7] << 8);
+    uint32_t u32Done = 0, u32Pkt, u32Retry = 0;
+    uint8_t au8Pkt[64];
+    int32_t i32Ret;
+
+    if(u32Total > u32Len)
+        u32Total = u32Len;
+
+    SIM_UsbdSetup(au8Setup);
+
+    /* Data stage */
+    while(u32Done < u32Total)
+    {
+        if(au8Setup[0] & EP_INPUT)
+        {
+            i32Ret = SIM_UsbdIn(EP_INPUT | 0, au8Pkt, sizeof(au8Pkt));
+            if(i32Ret >= 0)
+            {
+                u32Pkt = ((uint32_t)i32Ret < u32Total - u32Done) ? (uint32_t)i32Ret : (u32Total - u32Done);
+                memcpy(pu8Data + u32Done, au8Pkt, u32Pkt);
+                u32Done += u32Pkt;
+
+                /* Learn bMaxPacketSize0 like a host does from the first 8 bytes of the device descriptor */
+                if((au8Setup[1] == GET_DESCRIPTOR) && (au8Setup[3] == DESC_DEVICE) && (u32Done >= 8) && pu8Data[7])
+                    s_u32HostEp0Max = pu8Data[7];
+
+                /* A short packet ends the data stage */
+                if((uint32_t)i32Ret < s_u32HostEp0Max)
+                    break;
+            }
+        }
+        else
+        {
+            u32Pkt = ((u32Total - u32Done) < sizeof(au8Pkt)) ? (u32Total - u32Done) : sizeof(au8Pkt);
+            i32Ret = SIM_UsbdOut(0, pu8Data + u32Done, u32Pkt);
+            if(i32Ret > 0)
+                u32Done += (uint32_t)i32Ret;
+        }
+
+        if(i32Ret == SIM_USBD_NAK)
+        {
+            if(++u32Retry >= SIM_USBD_NAK_RETRY)
+                return SIM_USBD_NAK;
+            SIM_AdvanceUs(10);
+            continue;
+        }
+        if(i32Ret < 0)
+            return i32Ret;
+        u32Retry = 0;
+    }
+
+    /* Status stage: zero length packet in the opposite direction */
+    do
+    {
+        if(au8Setup[0] & EP_INPUT)
+            i32Ret = SIM_UsbdOut(0, au8Pkt, 0);
+        else
+            i32Ret = SIM_UsbdIn(EP_INPUT | 0, au8Pkt, sizeof(au8Pkt));
+
+        if(i32Ret != SIM_USBD_NAK)
+            break;
+        SIM_AdvanceUs(10);
+    }
+    while(++u32Retry < SIM_USBD_NAK_RETRY);
+
+    return (i32Ret < 0) ? i32Ret : (int32_t)u32Done;
+}
+
+/*** (C) COPYRIGHT 2026 Nuvoton Technology Corp. ***/
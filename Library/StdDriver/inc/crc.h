@@ -52,9 +52,43 @@ extern "C"
 #define CRC_CPU_WDATA_16    0x10000000UL            /*!<CRC 16-bit CPU Write Data */
 #define CRC_CPU_WDATA_32    0x20000000UL            /*!<CRC 32-bit CPU Write Data */
 
+/*---------------------------------------------------------------------------------------------------------*/
+/*  DMA Transfer Constant Definitions                                                                      */
+/*---------------------------------------------------------------------------------------------------------*/
+#define CRC_DMA_MAX_COUNT   0xFFFCUL                /*!<Maximum word aligned byte count of one CRC DMA transfer */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Stream Constant Definitions                                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+#define CRC_STREAM_SW       0x00000004UL            /*!<Stream attribute - calculate by software only, without the CRC channel */
+#ifndef CRC_STREAM_DMA_MIN
+#define CRC_STREAM_DMA_MIN  64                      /*!<Minimum word count in bytes fed by DMA. Shorter data are written by the CPU */
+#endif
+#ifndef CRC_SW_SLICE_NUM
+#define CRC_SW_SLICE_NUM    1                       /*!<Software CRC tables, 1, 4 or 8. 1 uses the byte tables in flash, 4 and 8 take that many KB of RAM */
+#endif
+
 /*@}*/ /* end of group CRC_EXPORTED_CONSTANTS */
 
 
+/** @addtogroup CRC_EXPORTED_STRUCTS CRC Exported Structs
+  @{
+*/
+/**
+  * @details    CRC stream context. It is filled by \ref CRC_StreamInit and must not be changed by the application.
+  */
+typedef struct
+{
+    uint32_t u32Mode;       /*!<CRC polynomial mode */
+    uint32_t u32Attribute;  /*!<Parameter attribute */
+    uint32_t u32State;      /*!<CRC value before checksum reverse and complement */
+} CRC_STREAM_T;
+
+/*@}*/ /* end of group CRC_EXPORTED_STRUCTS */
+
+extern int32_t g_CRC_i32ErrCode;
+
+
 /** @addtogroup CRC_EXPORTED_FUNCTIONS CRC Exported Functions
   @{
 */
@@ -144,6 +178,10 @@ extern "C"
 void CRC_Open(uint32_t u32Mode, uint32_t u32Attribute, uint32_t u32Seed, uint32_t u32DataLen);
 void CRC_StartDMATransfer(uint32_t u32SrcAddr, uint32_t u32ByteCount);
 uint32_t CRC_GetChecksum(void);
+uint32_t CRC_DMAChecksum(uint32_t u32SrcAddr, uint32_t u32ByteCount);
+void CRC_StreamInit(CRC_STREAM_T *psStream, uint32_t u32Mode, uint32_t u32Attribute, uint32_t u32Seed);
+void CRC_StreamUpdate(CRC_STREAM_T *psStream, const void *pvData, uint32_t u32Len);
+uint32_t CRC_StreamFinal(CRC_STREAM_T *psStream);
 
 /*@}*/ /* end of group CRC_EXPORTED_FUNCTIONS */
 
@@ -576,6 +576,8 @@ extern void FMC_EnableConfigUpdate(void);
 extern void FMC_DisableConfigUpdate(void);
 extern void FMC_EnableLDUpdate(void);
 extern void FMC_DisableLDUpdate(void);
+extern int32_t FMC_ReadMultiple(uint32_t u32Addr, uint32_t *pu32Buf, uint32_t u32Len);
+extern uint32_t FMC_GetCRC32(uint32_t u32Addr, uint32_t u32Len);
 extern int32_t FMC_ReadConfig(uint32_t *u32Config, uint32_t u32Count);
 extern int32_t FMC_WriteConfig(uint32_t *u32Config, uint32_t u32Count);
 extern void FMC_SetBootSource(int32_t i32BootSrc);
@@ -0,0 +1,78 @@
+/**************************************************************************//**
+ * @file     fwu.h
+ * @version  V3.00
+ * @brief    M071R_M071S series A/B firmware update driver header file
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2013 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __FWU_H__
+#define __FWU_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup FWU_Driver FWU Driver
+  @{
+*/
+
+/** @addtogroup FWU_EXPORTED_CONSTANTS FWU Exported Constants
+  @{
+*/
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Update State Constant Definitions                                                                      */
+/*---------------------------------------------------------------------------------------------------------*/
+#ifndef FWU_KVS_KEY
+#define FWU_KVS_KEY             0xFFFE  /*!<Key of the update state in the key-value store */
+#endif
+#ifndef FWU_MAX_ATTEMPTS
+#define FWU_MAX_ATTEMPTS        3       /*!<Boots of a new image without \ref FWU_Confirm before it is rolled back */
+#endif
+#define FWU_SLOT_NONE           0xFFFFFFFFUL    /*!<No slot */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Return Code Constant Definitions                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+#define FWU_OK                  0       /*!<Operation done */
+#define FWU_ERR_PARAM           (-1)    /*!<Invalid slot layout or image size */
+#define FWU_ERR_STATE           (-2)    /*!<Operation not allowed in current update state */
+#define FWU_ERR_FLASH           (-3)    /*!<Flash program or erase failed */
+#define FWU_ERR_CRC             (-4)    /*!<Image CRC mismatch */
+#define FWU_ERR_NO_IMAGE        (-5)    /*!<No bootable image */
+
+/*@}*/ /* end of group FWU_EXPORTED_CONSTANTS */
+
+
+/** @addtogroup FWU_EXPORTED_FUNCTIONS FWU Exported Functions
+  @{
+*/
+
+int32_t FWU_Open(KVS_T *psKvs, uint32_t u32SlotA, uint32_t u32SlotB, uint32_t u32SlotSize);
+uint32_t FWU_GetRunningSlot(void);
+int32_t FWU_Begin(uint32_t u32Size);
+int32_t FWU_Write(const void *pvData, uint32_t u32Len);
+int32_t FWU_Finish(uint32_t u32Crc);
+int32_t FWU_Confirm(void);
+int32_t FWU_Boot(void);
+
+/*@}*/ /* end of group FWU_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group FWU_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__FWU_H__
+
+/*** (C) COPYRIGHT 2013 Nuvoton Technology Corp. ***/
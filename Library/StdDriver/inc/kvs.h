@@ -0,0 +1,103 @@
+/**************************************************************************//**
+ * @file     kvs.h
+ * @version  V3.00
+ * @brief    M071R_M071S series flash key-value store driver header file
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2013 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __KVS_H__
+#define __KVS_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup KVS_Driver KVS Driver
+  @{
+*/
+
+/** @addtogroup KVS_EXPORTED_CONSTANTS KVS Exported Constants
+  @{
+*/
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Store Size Constant Definitions                                                                        */
+/*---------------------------------------------------------------------------------------------------------*/
+#ifndef KVS_MAX_KEYS
+#define KVS_MAX_KEYS            32      /*!<Maximum number of keys. Each key takes 8 bytes of RAM in KVS_T */
+#endif
+#define KVS_KEY_INVALID         0xFFFF  /*!<Reserved key value. Valid keys are 0x0000 ~ 0xFFFE */
+#define KVS_MAX_VALUE_SIZE      (FMC_FLASH_PAGE_SIZE - 16)  /*!<Maximum value size in bytes. A record must fit in one page */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Return Code Constant Definitions                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+#define KVS_OK                  0       /*!<Operation done */
+#define KVS_ERR_NOT_FOUND       (-1)    /*!<Key does not exist */
+#define KVS_ERR_FULL            (-2)    /*!<No room left for the record or the key */
+#define KVS_ERR_PARAM           (-3)    /*!<Invalid key, size or store geometry */
+#define KVS_ERR_FLASH           (-4)    /*!<Flash program or erase failed */
+
+/*@}*/ /* end of group KVS_EXPORTED_CONSTANTS */
+
+
+/** @addtogroup KVS_EXPORTED_STRUCTS KVS Exported Structs
+  @{
+*/
+/**
+  * @details    Key index entry. It locates the latest record of a key.
+  */
+typedef struct
+{
+    uint16_t u16Key;        /*!<Key */
+    uint16_t u16Len;        /*!<Value size in bytes */
+    uint32_t u32Addr;       /*!<Flash address of the record header */
+} KVS_ENTRY_T;
+
+/**
+  * @details    Key-value store context. It is filled by \ref KVS_Mount and must not be changed by the application.
+  */
+typedef struct
+{
+    uint32_t u32Base;       /*!<Flash address of the first page */
+    uint32_t u32Pages;      /*!<Number of pages in the store */
+    uint32_t u32Oldest;     /*!<Page index of the oldest page in use */
+    uint32_t u32Used;       /*!<Number of pages in use */
+    uint32_t u32Seq;        /*!<Sequence number of the current page */
+    uint32_t u32WriteAddr;  /*!<Flash address of the next record */
+    uint32_t u32Count;      /*!<Number of keys */
+    KVS_ENTRY_T asEntry[KVS_MAX_KEYS]; /*!<Key index */
+} KVS_T;
+
+/*@}*/ /* end of group KVS_EXPORTED_STRUCTS */
+
+
+/** @addtogroup KVS_EXPORTED_FUNCTIONS KVS Exported Functions
+  @{
+*/
+
+int32_t KVS_Mount(KVS_T *psKvs, uint32_t u32Base, uint32_t u32Pages);
+int32_t KVS_Read(KVS_T *psKvs, uint32_t u32Key, void *pvBuf, uint32_t u32Size);
+int32_t KVS_Write(KVS_T *psKvs, uint32_t u32Key, const void *pvData, uint32_t u32Len);
+int32_t KVS_Delete(KVS_T *psKvs, uint32_t u32Key);
+
+/*@}*/ /* end of group KVS_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group KVS_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__KVS_H__
+
+/*** (C) COPYRIGHT 2013 Nuvoton Technology Corp. ***/
@@ -0,0 +1,101 @@
+/**************************************************************************//**
+ * @file     trace.h
+ * @version  V3.00
+ * @brief    M071R_M071S series tokenized trace driver header file
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2013 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup TRACE_Driver TRACE Driver
+  @{
+*/
+
+/** @addtogroup TRACE_EXPORTED_CONSTANTS TRACE Exported Constants
+  @{
+*/
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Trace Record Constant Definitions                                                                      */
+/*---------------------------------------------------------------------------------------------------------*/
+#define TRACE_MAX_ARGS          4               /*!<Maximum number of arguments of one trace record */
+#define TRACE_MAX_RECORD        (3 + 5 * (1 + TRACE_MAX_ARGS)) /*!<Maximum size of one framed trace record in bytes */
+#define TRACE_ID_DROPPED        0xFFFFFFFFUL    /*!<Record ID reporting the number of dropped records in its argument */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Format String Section Definitions                                                                      */
+/*---------------------------------------------------------------------------------------------------------*/
+/*
+    Format strings of trace records are kept in section "trace_fmt" and the record ID is the string address,
+    so the host decoder can rebuild the dictionary from the ELF/AXF file. The section may be placed in a
+    region that is not loaded to flash, e.g. "trace_fmt (INFO) : { KEEP(*(trace_fmt)) }" in a GCC linker
+    script, because the firmware never reads the strings.
+*/
+#if defined (__ICCARM__)
+#define TRACE_FMT_SECTION   _Pragma("location=\"trace_fmt\"") __root    /*!<Place a format string in trace_fmt section */
+#else
+#define TRACE_FMT_SECTION   __attribute__((section("trace_fmt"), used)) /*!<Place a format string in trace_fmt section */
+#endif
+
+/*@}*/ /* end of group TRACE_EXPORTED_CONSTANTS */
+
+
+/** @addtogroup TRACE_EXPORTED_FUNCTIONS TRACE Exported Functions
+  @{
+*/
+
+/**
+  * @brief      Emit a trace record with 0 ~ 4 arguments
+  *
+  * @param[in]  fmt     printf-style format string literal. Only integer, character and pointer conversions
+  *                     are supported because each argument is recorded as a raw 32-bit value.
+  * @param[in]  a1~a4   Arguments
+  *
+  * @return     None
+  *
+  * @details    These macros store the format string in trace_fmt section and write a record of its address
+  *             and the raw arguments to the trace ring buffer. No formatting is done on the target.
+  */
+#define TRACE0(fmt)                     do { TRACE_FMT_SECTION static const char s_acTraceFmt[] = fmt; \
+                                             TRACE_Log(s_acTraceFmt, 0, 0, 0, 0, 0); } while(0)
+#define TRACE1(fmt, a1)                 do { TRACE_FMT_SECTION static const char s_acTraceFmt[] = fmt; \
+                                             TRACE_Log(s_acTraceFmt, 1, (uint32_t)(a1), 0, 0, 0); } while(0)
+#define TRACE2(fmt, a1, a2)             do { TRACE_FMT_SECTION static const char s_acTraceFmt[] = fmt; \
+                                             TRACE_Log(s_acTraceFmt, 2, (uint32_t)(a1), (uint32_t)(a2), 0, 0); } while(0)
+#define TRACE3(fmt, a1, a2, a3)         do { TRACE_FMT_SECTION static const char s_acTraceFmt[] = fmt; \
+                                             TRACE_Log(s_acTraceFmt, 3, (uint32_t)(a1), (uint32_t)(a2), (uint32_t)(a3), 0); } while(0)
+#define TRACE4(fmt, a1, a2, a3, a4)     do { TRACE_FMT_SECTION static const char s_acTraceFmt[] = fmt; \
+                                             TRACE_Log(s_acTraceFmt, 4, (uint32_t)(a1), (uint32_t)(a2), (uint32_t)(a3), (uint32_t)(a4)); } while(0)
+
+
+void TRACE_Open(uint8_t *pu8Buf, uint32_t u32Size);
+void TRACE_Log(const char *pcFmt, uint32_t u32Argc, uint32_t u32Arg1, uint32_t u32Arg2, uint32_t u32Arg3, uint32_t u32Arg4);
+uint32_t TRACE_Read(uint8_t *pu8Buf, uint32_t u32Len);
+uint32_t TRACE_Drain(UART_T *uart);
+uint32_t TRACE_GetDroppedCount(void);
+
+/*@}*/ /* end of group TRACE_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group TRACE_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__TRACE_H__
+
+/*** (C) COPYRIGHT 2013 Nuvoton Technology Corp. ***/
@@ -116,11 +116,90 @@ extern "C"
 /*---------------------------------------------------------------------------------------------------------*/
 #define UART_BAUD_MODE0     (0) /*!< Set UART Baudrate Mode is Mode0 */
 #define UART_BAUD_MODE2     (UART_BAUD_DIV_X_EN_Msk | UART_BAUD_DIV_X_ONE_Msk) /*!< Set UART Baudrate Mode is Mode2 */
+#define UART_BAUD_MODE1(x)  (UART_BAUD_DIV_X_EN_Msk | (((x)-1) << UART_BAUD_DIVIDER_X_Pos)) /*!< Set UART Baudrate Mode is Mode1 with divider M = x, x = 9 ~ 16 */
+
+#define UART_BAUD_INVALID       0xFFFFFFFFUL    /*!< No baud rate setting is available for the requested baud rate */
+#define UART_BAUD_ERR_INVALID   0x7FFFFFFF      /*!< Baud rate error returned when the baud rate is not set */
+#define UART_BAUD_BRD_MIN       8               /*!< Minimum BRD given by \ref UART_CalcBaudSetting, so the receiver has enough clocks to sample each bit */
+#define UART_BAUD_CACHE_SIZE    4               /*!< Number of baud rate settings cached by \ref UART_SetBaudRate */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* UART buffered transfer constants definitions                                                            */
+/*---------------------------------------------------------------------------------------------------------*/
+#define UART_BUF_RX_TRIGGER     UART_FCR_RFITL_8BYTES   /*!< RX FIFO trigger level used by the buffered transfer API */
+#define UART_BUF_RX_TIMEOUT     (40)                    /*!< RX time-out counter used by the buffered transfer API, in bit times (4 characters) */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/* UART PDMA transmit constants definitions                                                                */
+/*---------------------------------------------------------------------------------------------------------*/
+#define UART_DMA_TX_QUEUE_SIZE  (4)     /*!< Number of buffers the PDMA transmit queue can hold. It must be a power of 2 */
 
 
 /*@}*/ /* end of group UART_EXPORTED_CONSTANTS */
 
 
+/** @addtogroup UART_EXPORTED_STRUCTS UART Exported Structs
+  @{
+*/
+/**
+  * @details    UART buffered transfer context. The RX and TX storage is supplied by the caller through
+  *             \ref UART_BufOpen. One byte of each ring is kept free to tell a full ring from an empty one.
+  */
+typedef struct
+{
+    UART_T *uart;                       /*!< UART module served by this context */
+    uint8_t *pu8RxBuf;                  /*!< RX ring storage */
+    uint32_t u32RxSize;                 /*!< RX ring size in bytes */
+    volatile uint32_t u32RxHead;        /*!< RX ring write index, advanced by \ref UART_BufIRQHandler */
+    volatile uint32_t u32RxTail;        /*!< RX ring read index, advanced by \ref UART_BufRead */
+    uint8_t *pu8TxBuf;                  /*!< TX ring storage */
+    uint32_t u32TxSize;                 /*!< TX ring size in bytes */
+    volatile uint32_t u32TxHead;        /*!< TX ring write index, advanced by \ref UART_BufWrite */
+    volatile uint32_t u32TxTail;        /*!< TX ring read index, advanced by \ref UART_BufIRQHandler */
+    volatile uint32_t u32RxOverflow;    /*!< Number of received bytes dropped because the RX ring was full */
+    volatile uint32_t u32LineStatus;    /*!< Accumulated UA_FSR BIF/FEF/PEF/RX_OVER_IF flags, cleared by the caller */
+} UART_BUF_T;
+
+typedef void (*UART_DMA_TX_CB)(const uint8_t *pu8Buf, uint32_t u32Len);   /*!< Functional pointer type declaration for PDMA transmit buffer done callback */
+
+/**
+  * @details    UART PDMA transmit context. Queued buffers are transmitted in place, so they must stay valid
+  *             until the done callback reports them.
+  */
+typedef struct
+{
+    UART_T *uart;                                       /*!< UART module served by this context */
+    uint32_t u32Ch;                                     /*!< PDMA channel used for transmit */
+    UART_DMA_TX_CB pfnDone;                             /*!< Buffer done callback, called in PDMA interrupt. It can be NULL */
+    const uint8_t *apu8Buf[UART_DMA_TX_QUEUE_SIZE];     /*!< Queued buffer addresses */
+    uint32_t au32Len[UART_DMA_TX_QUEUE_SIZE];           /*!< Queued buffer lengths in bytes */
+    volatile uint32_t u32Head;                          /*!< Queue write counter, advanced by \ref UART_DmaTxQueue */
+    volatile uint32_t u32Tail;                          /*!< Queue read counter, advanced by \ref UART_DmaTxIRQHandler. The entry at u32Tail is in transfer */
+    volatile uint32_t u32Busy;                          /*!< 1 while the PDMA channel is transferring */
+    volatile uint32_t u32Abort;                         /*!< Number of PDMA target abort events */
+} UART_DMA_TX_T;
+
+/**
+  * @details    UART circular PDMA receive context. Positions named u32xxxPos are free running byte counters;
+  *             the buffer offset of a position is its distance from u32BasePos.
+  */
+typedef struct
+{
+    UART_T *uart;                       /*!< UART module served by this context */
+    uint32_t u32Ch;                     /*!< PDMA channel used for receive */
+    uint8_t *pu8Buf;                    /*!< Circular receive buffer */
+    uint32_t u32Size;                   /*!< Circular receive buffer size in bytes, 1 ~ 65535 */
+    volatile uint32_t u32BasePos;       /*!< Position of pu8Buf[0] in the current lap, advanced by \ref UART_DmaRxIRQHandler */
+    uint32_t u32ReadPos;                /*!< Position of the next byte returned by \ref UART_DmaRxRead */
+    uint32_t u32ReadIdx;                /*!< Buffer offset of u32ReadPos */
+    uint32_t u32PollPos;                /*!< Write position seen by the last \ref UART_DmaRxPollFrame */
+    uint32_t u32FramePos;               /*!< Write position of the last reported frame end */
+    uint32_t u32Overrun;                /*!< Number of bytes overwritten before they were read */
+} UART_DMA_RX_T;
+
+/*@}*/ /* end of group UART_EXPORTED_STRUCTS */
+
+
 /** @addtogroup UART_EXPORTED_FUNCTIONS UART Exported Functions
   @{
 */
@@ -428,12 +507,37 @@ void UART_EnableFlowCtrl(UART_T* uart);
 void UART_EnableInt(UART_T*  uart, uint32_t u32InterruptFlag);
 void UART_Open(UART_T* uart, uint32_t u32baudrate);
 uint32_t UART_Read(UART_T* uart, uint8_t *pu8RxBuf, uint32_t u32ReadBytes);
+uint32_t UART_CalcBaudSetting(uint32_t u32ClkFreq, uint32_t u32Baudrate, int32_t *pi32ErrPpm);
+int32_t UART_SetBaudRate(UART_T* uart, uint32_t u32Baudrate);
 void UART_SetLine_Config(UART_T* uart, uint32_t u32baudrate, uint32_t u32data_width, uint32_t u32parity, uint32_t  u32stop_bits);
 void UART_SetTimeoutCnt(UART_T* uart, uint32_t u32TOC);
 void UART_SelectIrDAMode(UART_T* uart, uint32_t u32Buadrate, uint32_t u32Direction);
 void UART_SelectRS485Mode(UART_T* uart, uint32_t u32Mode, uint32_t u32Addr);
 void UART_SelectLINMode(UART_T* uart, uint32_t u32Mode, uint32_t u32BreakLength);
 uint32_t UART_Write(UART_T* uart, uint8_t *pu8TxBuf, uint32_t u32WriteBytes);
+void UART_BufClose(UART_BUF_T *psBuf);
+uint32_t UART_BufGetRxCount(UART_BUF_T *psBuf);
+uint32_t UART_BufGetTxCount(UART_BUF_T *psBuf);
+void UART_BufIRQHandler(UART_BUF_T *psBuf);
+void UART_BufOpen(UART_BUF_T *psBuf, UART_T *uart, uint8_t *pu8RxBuf, uint32_t u32RxSize, uint8_t *pu8TxBuf, uint32_t u32TxSize);
+uint32_t UART_BufRead(UART_BUF_T *psBuf, uint8_t *pu8RxBuf, uint32_t u32ReadBytes);
+uint32_t UART_BufWrite(UART_BUF_T *psBuf, uint8_t *pu8TxBuf, uint32_t u32WriteBytes);
+void UART_DmaRxClose(UART_DMA_RX_T *psRx);
+uint32_t UART_DmaRxGetCount(UART_DMA_RX_T *psRx);
+void UART_DmaRxIRQHandler(UART_DMA_RX_T *psRx);
+void UART_DmaRxOpen(UART_DMA_RX_T *psRx, UART_T *uart, uint32_t u32Ch, uint8_t *pu8Buf, uint32_t u32Size);
+uint32_t UART_DmaRxPollFrame(UART_DMA_RX_T *psRx, uint32_t *pu32End);
+uint32_t UART_DmaRxRead(UART_DMA_RX_T *psRx, uint8_t *pu8RxBuf, uint32_t u32ReadBytes);
+void UART_DmaTxClose(UART_DMA_TX_T *psTx);
+uint32_t UART_DmaTxGetFree(UART_DMA_TX_T *psTx);
+void UART_DmaTxIRQHandler(UART_DMA_TX_T *psTx);
+void UART_DmaTxOpen(UART_DMA_TX_T *psTx, UART_T *uart, uint32_t u32Ch, UART_DMA_TX_CB pfnDone);
+int32_t UART_DmaTxQueue(UART_DMA_TX_T *psTx, const uint8_t *pu8Buf, uint32_t u32Len);
+
+/* Non-block printf of the debug port in retarget.c, available when it is built with NONBLOCK_PRINTF */
+void SendChar_IRQHandler(void);
+void SendChar_Flush(void);
+uint32_t SendChar_GetOverflowCount(void);
 
 
 /*@}*/ /* end of group UART_EXPORTED_FUNCTIONS */
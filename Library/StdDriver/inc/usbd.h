@@ -33,11 +33,29 @@ typedef struct s_usbd_info
     const uint8_t **gu8HidReportDesc;     /*!< Pointer for USB HID Report Descriptor      */
     const uint32_t *gu32HidReportSize;    /*!< Pointer for HID Report descriptor Size */
     const uint32_t *gu32ConfigHidDescIdx; /*!< Pointer for HID Descriptor start index */
+    const char * const *gpcStringTbl;     /*!< Pointer for ASCII strings. String descriptor N is generated from entry N when it is not NULL */
+    uint32_t gu32StringNum;               /*!< Number of entries of gu8StringDesc and gpcStringTbl. 0 means 4 entries of gu8StringDesc */
 
 } S_USBD_INFO_T;
 
 extern const S_USBD_INFO_T gsInfo;
 
+typedef void (*EP_HANDLER)(void);           /*!< Functional pointer type declaration for USB endpoint event handler */
+
+/**
+  * @details    One entry of the endpoint configuration table given to \ref USBD_ConfigEpTable.
+  *             The packet buffers of all entries are placed one after another behind the setup packet buffer.
+  */
+typedef struct s_usbd_ep_cfg
+{
+    uint8_t  u8Ep;              /*!< Endpoint buffer number, EP0 ~ EP7 */
+    uint8_t  u8Addr;            /*!< Endpoint address. Add EP_INPUT for an IN endpoint. 0 for the control endpoints */
+    uint8_t  u8Type;            /*!< Endpoint type EP_ISO, EP_BULK or EP_INT. It is ignored for the control endpoints */
+    uint8_t  u8Slots;           /*!< Number of packet buffers. 2 gives a ping-pong pair swapped by \ref USBD_SwapEpBuf */
+    uint16_t u16MaxPktSize;     /*!< Maximum packet size */
+    EP_HANDLER pfnHandler;      /*!< Event handler called by \ref USBD_IRQDispatch. It is ignored for the control endpoints */
+} S_USBD_EP_CFG_T;
+
 /*@}*/ /* end of group USBD_EXPORTED_STRUCTS */
 
 
@@ -47,6 +65,8 @@ extern const S_USBD_INFO_T gsInfo;
 */
 
 #define USBD_BUF_BASE   (USBD_BASE+0x100)
+#define USBD_BUF_SIZE   512     /*!< Size of the USB packet buffer SRAM in bytes */
+#define USBD_SETUP_BUF_LEN  8   /*!< Size of the setup packet buffer at the start of the USB packet buffer SRAM */
 
 
 
@@ -157,6 +177,11 @@ extern const S_USBD_INFO_T gsInfo;
 #define USBD_CFG_EPMODE_IN      (2ul << USBD_CFG_STATE_Pos)/*!< In Endpoint */
 #define USBD_CFG_TYPE_ISO       (1ul << USBD_CFG_ISOCH_Pos) /*!< Isochronous */
 
+/* Define USBD_MEMCOPY_PDMA_CH as a free PDMA channel to let USBD_MemCopy move large word aligned copies by PDMA */
+#ifndef USBD_MEMCOPY_PDMA_MIN
+#define USBD_MEMCOPY_PDMA_MIN   256     /*!< Least byte count of a copy moved by PDMA when USBD_MEMCOPY_PDMA_CH is defined */
+#endif
+
 
 /*@}*/ /* end of group USBD_EXPORTED_CONSTANTS */
 
@@ -191,6 +216,43 @@ extern const S_USBD_INFO_T gsInfo;
   */
 #define Minimum(a,b)        ((a)<(b) ? (a) : (b))
 
+/**
+  * @brief      Get the USB SRAM taken by the packet buffers of one endpoint
+  *
+  * @param[in]  maxpkt  Maximum packet size of the endpoint.
+  * @param[in]  slots   Number of packet buffers of the endpoint.
+  *
+  * @return     Byte count of the packet buffers.
+  *
+  * @details    Each packet buffer is rounded up to 8 bytes as the buffer segment registers are 8-byte aligned.
+  *             The sum over all endpoints plus \ref USBD_SETUP_BUF_LEN must not exceed \ref USBD_BUF_SIZE.
+  *             It can be checked by the preprocessor with \ref USBD_EP_LIST_LEN as \ref USBD_ConfigEpTable does at run time.
+  */
+#define USBD_EP_BUF_LEN(maxpkt, slots)  ((((maxpkt) + 7ul) & ~7ul) * (slots))
+
+/**
+  * @brief      Entry of an endpoint list for an \ref S_USBD_EP_CFG_T table
+  *
+  * @details    An endpoint list is a macro taking an entry macro and calling it once per endpoint with the members of
+  *             \ref S_USBD_EP_CFG_T. Expanding the list with this macro gives the table initializer, so the table and
+  *             the size check of \ref USBD_EP_LIST_LEN cannot drift apart.
+  */
+#define USBD_EP_CFG_ENTRY(ep, addr, type, slots, maxpkt, handler)   {ep, addr, type, slots, maxpkt, handler},
+
+/**
+  * @brief      Packet buffer length of an endpoint list entry, used by \ref USBD_EP_LIST_LEN
+  */
+#define USBD_EP_CFG_LEN(ep, addr, type, slots, maxpkt, handler)     + USBD_EP_BUF_LEN(maxpkt, slots)
+
+/**
+  * @brief      Get the USB SRAM taken by the setup packet buffer and all packet buffers of an endpoint list
+  *
+  * @param[in]  list    The endpoint list macro, see \ref USBD_EP_CFG_ENTRY.
+  *
+  * @return     Byte count of the packet buffers. It can be compared with \ref USBD_BUF_SIZE by the preprocessor.
+  */
+#define USBD_EP_LIST_LEN(list)  (USBD_SETUP_BUF_LEN list(USBD_EP_CFG_LEN))
+
 
 /**
   * @brief    Enable USB
@@ -510,6 +572,10 @@ extern const S_USBD_INFO_T gsInfo;
   */
 #define USBD_GET_EP_STALL(ep)        (*((__IO uint32_t *) ((uint32_t)&USBD->EP[0].CFGP + (uint32_t)((ep) << 4))) & USBD_CFGP_SSTALL_Msk)
 
+#ifdef USBD_MEMCOPY_PDMA_CH
+void USBD_MemCopyPdma(uint32_t *dest, uint32_t *src, int32_t size);
+#endif
+
 /**
   * @brief      To support byte access between USB SRAM and system SRAM
   *
@@ -522,10 +588,45 @@ extern const S_USBD_INFO_T gsInfo;
   * @return     None
   *
   * @details    This function will copy the number of data specified by size and src parameters to the address specified by dest parameter.
+  *             If both pointers are word aligned, the data is copied by word access. USB SRAM supports word access.
+  *             If USBD_MEMCOPY_PDMA_CH is defined, aligned copies of at least USBD_MEMCOPY_PDMA_MIN bytes are moved by PDMA.
   *
   */
 static __INLINE void USBD_MemCopy(uint8_t *dest, uint8_t *src, int32_t size)
 {
+    uint32_t *pu32Dest, *pu32Src;
+
+    if((((uint32_t)dest | (uint32_t)src) & 0x3) == 0)
+    {
+        pu32Dest = (uint32_t *)dest;
+        pu32Src = (uint32_t *)src;
+#ifdef USBD_MEMCOPY_PDMA_CH
+        if(size >= USBD_MEMCOPY_PDMA_MIN)
+        {
+            USBD_MemCopyPdma(pu32Dest, pu32Src, size & ~0x3);
+            pu32Dest += size >> 2;
+            pu32Src += size >> 2;
+            size &= 0x3;
+        }
+#endif
+        while(size >= 16)
+        {
+            pu32Dest[0] = pu32Src[0];
+            pu32Dest[1] = pu32Src[1];
+            pu32Dest[2] = pu32Src[2];
+            pu32Dest[3] = pu32Src[3];
+            pu32Dest += 4;
+            pu32Src += 4;
+            size -= 16;
+        }
+        while(size >= 4)
+        {
+            *pu32Dest++ = *pu32Src++;
+            size -= 4;
+        }
+        dest = (uint8_t *)pu32Dest;
+        src = (uint8_t *)pu32Src;
+    }
     while(size--) *dest++ = *src++;
 }
 
@@ -631,12 +732,14 @@ typedef void (*VENDOR_REQ)(void);           /*!< Functional pointer type declara
 typedef void (*CLASS_REQ)(void);            /*!< Functional pointer type declaration for USB class request callback handler */
 typedef void (*SET_INTERFACE_REQ)(void);    /*!< Functional pointer type declaration for USB set interface request callback handler */
 typedef void (*SET_CONFIG_CB)(void);       /*!< Functional pointer type declaration for USB set configuration request callback handler */
+typedef void (*BUS_EVENT_CB)(uint32_t u32State);   /*!< Functional pointer type declaration for USB bus event callback handler */
 
 /*--------------------------------------------------------------------*/
 void USBD_Open(const S_USBD_INFO_T *param, CLASS_REQ pfnClassReq, SET_INTERFACE_REQ pfnSetInterface);
 void USBD_Start(void);
 void USBD_GetSetupPacket(uint8_t *buf);
 void USBD_ProcessSetupPacket(void);
+void USBD_GetDescriptor(void);
 void USBD_StandardRequest(void);
 void USBD_PrepareCtrlIn(uint8_t *pu8Buf, uint32_t u32Size);
 void USBD_CtrlIn(void);
@@ -646,6 +749,12 @@ void USBD_SwReset(void);
 void USBD_SetVendorRequest(VENDOR_REQ pfnVendorReq);
 void USBD_SetConfigCallback(SET_CONFIG_CB pfnSetConfigCallback);
 void USBD_LockEpStall(uint32_t u32EpBitmap);
+int32_t USBD_ConfigEpTable(const S_USBD_EP_CFG_T *psEpCfg, uint32_t u32Count);
+void USBD_ResetEp(uint32_t u32Ep);
+uint32_t USBD_GetEpSlotBuf(uint32_t u32Ep, uint32_t u32Slot);
+uint32_t USBD_SwapEpBuf(uint32_t u32Ep);
+void USBD_SetBusEventCallback(BUS_EVENT_CB pfnBusEvent);
+void USBD_IRQDispatch(void);
 
 /*@}*/ /* end of group USBD_EXPORTED_FUNCTIONS */
 
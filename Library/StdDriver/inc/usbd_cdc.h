@@ -0,0 +1,112 @@
+/**************************************************************************//**
+ * @file     usbd_cdc.h
+ * @version  V3.00
+ * @brief    M071R_M071S series USB CDC virtual COM port driver header file
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __USBD_CDC_H__
+#define __USBD_CDC_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup USBD_CDC_Driver USBD CDC Driver
+  @{
+*/
+
+/** @addtogroup USBD_CDC_EXPORTED_CONSTANTS USBD CDC Exported Constants
+  @{
+*/
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Port Constant Definitions                                                                              */
+/*---------------------------------------------------------------------------------------------------------*/
+#ifndef USBD_CDC_MAX_PORT
+#define USBD_CDC_MAX_PORT           2       /*!<Maximum number of virtual COM ports. Valid values are 1 and 2 */
+#endif
+#define USBD_CDC_MAX_PKT_SIZE       64      /*!<Maximum packet size of the bulk endpoints */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Class Request Constant Definitions                                                                     */
+/*---------------------------------------------------------------------------------------------------------*/
+#define USBD_CDC_SET_LINE_CODING        0x20    /*!<SET_LINE_CODING request */
+#define USBD_CDC_GET_LINE_CODING        0x21    /*!<GET_LINE_CODING request */
+#define USBD_CDC_SET_CONTROL_LINE_STATE 0x22    /*!<SET_CONTROL_LINE_STATE request */
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Control Signal Constant Definitions                                                                    */
+/*---------------------------------------------------------------------------------------------------------*/
+#define USBD_CDC_CTRL_DTR           0x01    /*!<Data terminal ready bit of \ref USBD_CDC_GetCtrlSignal */
+#define USBD_CDC_CTRL_RTS           0x02    /*!<Request to send bit of \ref USBD_CDC_GetCtrlSignal */
+
+/*@}*/ /* end of group USBD_CDC_EXPORTED_CONSTANTS */
+
+
+/** @addtogroup USBD_CDC_EXPORTED_STRUCTS USBD CDC Exported Structs
+  @{
+*/
+/**
+  * @details    Line coding of GET_LINE_CODING and SET_LINE_CODING. The first 7 bytes are sent on the bus.
+  */
+typedef struct
+{
+    uint32_t u32DTERate;        /*!<Baud rate */
+    uint8_t  u8CharFormat;      /*!<Stop bits. 0: 1, 1: 1.5, 2: 2 */
+    uint8_t  u8ParityType;      /*!<Parity. 0: none, 1: odd, 2: even, 3: mark, 4: space */
+    uint8_t  u8DataBits;        /*!<Data bits. 5 ~ 8 */
+} USBD_CDC_LINE_CODING_T;
+
+/**
+  * @details    Configuration of one virtual COM port. UART TX and RX both run on PDMA, so the port uses two PDMA
+  *             channels of its own.
+  */
+typedef struct
+{
+    UART_T *uart;               /*!<UART module of the port. Valid values are UART0 and UART1 */
+    uint32_t u32Intf;           /*!<Communication class interface number */
+    uint32_t u32InEp;           /*!<Hardware endpoint of bulk IN, e.g. \ref EP2 */
+    uint32_t u32OutEp;          /*!<Hardware endpoint of bulk OUT. It must have two packet buffers */
+    uint32_t u32TxCh;           /*!<PDMA channel for UART transmit */
+    uint32_t u32RxCh;           /*!<PDMA channel for UART receive */
+    uint8_t *pu8RxBuf;          /*!<Circular UART receive buffer */
+    uint32_t u32RxSize;         /*!<Circular UART receive buffer size in bytes. At least 4 packets are recommended */
+} USBD_CDC_PORT_T;
+
+/*@}*/ /* end of group USBD_CDC_EXPORTED_STRUCTS */
+
+
+/** @addtogroup USBD_CDC_EXPORTED_FUNCTIONS USBD CDC Exported Functions
+  @{
+*/
+
+void USBD_CDC_Open(const USBD_CDC_PORT_T *psPorts, uint32_t u32Num);
+void USBD_CDC_SetConfig(void);
+void USBD_CDC_ClassRequest(void);
+void USBD_CDC_BulkIn(uint32_t u32Port);
+void USBD_CDC_BulkOut(uint32_t u32Port);
+void USBD_CDC_PdmaIRQHandler(void);
+void USBD_CDC_Process(void);
+uint32_t USBD_CDC_GetCtrlSignal(uint32_t u32Port);
+
+/*@}*/ /* end of group USBD_CDC_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group USBD_CDC_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__USBD_CDC_H__
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -0,0 +1,96 @@
+/**************************************************************************//**
+ * @file     usbd_msc.h
+ * @version  V3.00
+ * @brief    M071R_M071S series USB mass storage class driver header file
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+ ******************************************************************************/
+#ifndef __USBD_MSC_H__
+#define __USBD_MSC_H__
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup USBD_MSC_Driver USBD MSC Driver
+  @{
+*/
+
+/** @addtogroup USBD_MSC_EXPORTED_CONSTANTS USBD MSC Exported Constants
+  @{
+*/
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Buffer Size Constant Definitions                                                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+#define USBD_MSC_SECTOR_SIZE        512     /*!<Logical sector size in bytes */
+#define USBD_MSC_MAX_PKT_SIZE       64      /*!<Maximum packet size of the bulk endpoints */
+#ifndef USBD_MSC_BUFFER_SIZE
+#define USBD_MSC_BUFFER_SIZE        512     /*!<Size of each of the two storage buffers. It must be a multiple of \ref USBD_MSC_SECTOR_SIZE */
+#endif
+#ifndef USBD_MSC_SYNC_IDLE_MS
+#define USBD_MSC_SYNC_IDLE_MS       100     /*!<Call the sync function of the block device after the host has been idle for this time after a write */
+#endif
+
+/*---------------------------------------------------------------------------------------------------------*/
+/*  Block Device Return Code Constant Definitions                                                          */
+/*---------------------------------------------------------------------------------------------------------*/
+#define USBD_MSC_OK                 0       /*!<Operation done */
+#define USBD_MSC_BUSY               1       /*!<Operation not started. It is called again by \ref USBD_MSC_Process */
+#define USBD_MSC_ERR                (-1)    /*!<Medium error */
+
+/*@}*/ /* end of group USBD_MSC_EXPORTED_CONSTANTS */
+
+
+/** @addtogroup USBD_MSC_EXPORTED_STRUCTS USBD MSC Exported Structs
+  @{
+*/
+/**
+  * @details    Block device of the logical unit. All functions are called from \ref USBD_MSC_Process, never from
+  *             the USB interrupt, so they may wait for the medium. A function that cannot start now can return
+  *             \ref USBD_MSC_BUSY and is called again with the same arguments.
+  */
+typedef struct
+{
+    uint32_t (*pfnGetCapacity)(void);                                           /*!<Number of sectors. 0 if no medium is present */
+    int32_t (*pfnRead)(uint32_t u32Lba, uint32_t u32Count, uint8_t *pu8Buf);   /*!<Read u32Count sectors from u32Lba */
+    int32_t (*pfnWrite)(uint32_t u32Lba, uint32_t u32Count, uint8_t *pu8Buf);  /*!<Write u32Count sectors to u32Lba */
+    int32_t (*pfnSync)(void);                                                   /*!<Write back cached data to the medium. Can be NULL */
+    void (*pfnWriteStart)(uint32_t u32Lba, uint32_t u32Count);                  /*!<A write of u32Count sectors at u32Lba follows. Can be NULL */
+} USBD_MSC_BLKDEV_T;
+
+/*@}*/ /* end of group USBD_MSC_EXPORTED_STRUCTS */
+
+
+/** @addtogroup USBD_MSC_EXPORTED_FUNCTIONS USBD MSC Exported Functions
+  @{
+*/
+
+void USBD_MSC_Open(const USBD_MSC_BLKDEV_T *psBlkDev, const uint8_t *pu8Inquiry, uint32_t u32InEp, uint32_t u32OutEp, uint32_t u32Intf);
+void USBD_MSC_SetConfig(void);
+void USBD_MSC_ClassRequest(void);
+void USBD_MSC_BulkIn(void);
+void USBD_MSC_BulkOut(void);
+void USBD_MSC_Process(void);
+void USBD_MSC_RequestSync(void);
+
+/*@}*/ /* end of group USBD_MSC_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group USBD_MSC_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif //__USBD_MSC_H__
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
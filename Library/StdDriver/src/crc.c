@@ -11,6 +11,8 @@
 *****************************************************************************/
 #include "NuMicro.h"
 
+int32_t g_CRC_i32ErrCode = 0; /*!< CRC global error code */
+
 
 /** @addtogroup Standard_Driver Standard Driver
   @{
@@ -20,6 +22,366 @@
   @{
 */
 
+/*
+    A stream keeps the CRC value before the checksum reverse and complement, which is what the CRC channel
+    shifts. Each update reloads it as the seed, feeds the data and reads it back with the checksum attributes
+    cleared, so several streams can share the channel. The software path shifts the same value left aligned
+    in 32 bits, most significant bit first, so its results are bit-identical to the channel in every mode.
+*/
+
+#define CRC_STREAM_WDATA_ATTR   (CRC_WDATA_RVS | CRC_WDATA_COM)
+
+#if (CRC_SW_SLICE_NUM >= 4)
+static uint32_t s_au32CrcTable[CRC_SW_SLICE_NUM][256];
+static uint32_t s_u32CrcTableMode = 0xFFFFFFFFUL;   /* Polynomial mode of s_au32CrcTable, all ones if not built yet */
+static volatile uint32_t s_u32CrcTableBusy;
+#endif
+static volatile uint32_t s_u32CrcStreamBusy;
+
+/* CRC8 (x^8 + x^2 + x + 1) of a byte */
+static const uint8_t s_au8CrcTable8[256] =
+{
+    0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15, 0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
+    0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65, 0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D,
+    0xE0, 0xE7, 0xEE, 0xE9, 0xFC, 0xFB, 0xF2, 0xF5, 0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
+    0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85, 0xA8, 0xAF, 0xA6, 0xA1, 0xB4, 0xB3, 0xBA, 0xBD,
+    0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2, 0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA,
+    0xB7, 0xB0, 0xB9, 0xBE, 0xAB, 0xAC, 0xA5, 0xA2, 0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
+    0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32, 0x1F, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0D, 0x0A,
+    0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42, 0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A,
+    0x89, 0x8E, 0x87, 0x80, 0x95, 0x92, 0x9B, 0x9C, 0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
+    0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC, 0xC1, 0xC6, 0xCF, 0xC8, 0xDD, 0xDA, 0xD3, 0xD4,
+    0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C, 0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44,
+    0x19, 0x1E, 0x17, 0x10, 0x05, 0x02, 0x0B, 0x0C, 0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
+    0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B, 0x76, 0x71, 0x78, 0x7F, 0x6A, 0x6D, 0x64, 0x63,
+    0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B, 0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13,
+    0xAE, 0xA9, 0xA0, 0xA7, 0xB2, 0xB5, 0xBC, 0xBB, 0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
+    0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB, 0xE6, 0xE1, 0xE8, 0xEF, 0xFA, 0xFD, 0xF4, 0xF3
+};
+
+/* CRC-CCITT (x^16 + x^12 + x^5 + 1) of a byte */
+static const uint16_t s_au16CrcTableCcitt[256] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+
+/* CRC16 (x^16 + x^15 + x^2 + 1) of a byte */
+static const uint16_t s_au16CrcTable16[256] =
+{
+    0x0000, 0x8005, 0x800F, 0x000A, 0x801B, 0x001E, 0x0014, 0x8011,
+    0x8033, 0x0036, 0x003C, 0x8039, 0x0028, 0x802D, 0x8027, 0x0022,
+    0x8063, 0x0066, 0x006C, 0x8069, 0x0078, 0x807D, 0x8077, 0x0072,
+    0x0050, 0x8055, 0x805F, 0x005A, 0x804B, 0x004E, 0x0044, 0x8041,
+    0x80C3, 0x00C6, 0x00CC, 0x80C9, 0x00D8, 0x80DD, 0x80D7, 0x00D2,
+    0x00F0, 0x80F5, 0x80FF, 0x00FA, 0x80EB, 0x00EE, 0x00E4, 0x80E1,
+    0x00A0, 0x80A5, 0x80AF, 0x00AA, 0x80BB, 0x00BE, 0x00B4, 0x80B1,
+    0x8093, 0x0096, 0x009C, 0x8099, 0x0088, 0x808D, 0x8087, 0x0082,
+    0x8183, 0x0186, 0x018C, 0x8189, 0x0198, 0x819D, 0x8197, 0x0192,
+    0x01B0, 0x81B5, 0x81BF, 0x01BA, 0x81AB, 0x01AE, 0x01A4, 0x81A1,
+    0x01E0, 0x81E5, 0x81EF, 0x01EA, 0x81FB, 0x01FE, 0x01F4, 0x81F1,
+    0x81D3, 0x01D6, 0x01DC, 0x81D9, 0x01C8, 0x81CD, 0x81C7, 0x01C2,
+    0x0140, 0x8145, 0x814F, 0x014A, 0x815B, 0x015E, 0x0154, 0x8151,
+    0x8173, 0x0176, 0x017C, 0x8179, 0x0168, 0x816D, 0x8167, 0x0162,
+    0x8123, 0x0126, 0x012C, 0x8129, 0x0138, 0x813D, 0x8137, 0x0132,
+    0x0110, 0x8115, 0x811F, 0x011A, 0x810B, 0x010E, 0x0104, 0x8101,
+    0x8303, 0x0306, 0x030C, 0x8309, 0x0318, 0x831D, 0x8317, 0x0312,
+    0x0330, 0x8335, 0x833F, 0x033A, 0x832B, 0x032E, 0x0324, 0x8321,
+    0x0360, 0x8365, 0x836F, 0x036A, 0x837B, 0x037E, 0x0374, 0x8371,
+    0x8353, 0x0356, 0x035C, 0x8359, 0x0348, 0x834D, 0x8347, 0x0342,
+    0x03C0, 0x83C5, 0x83CF, 0x03CA, 0x83DB, 0x03DE, 0x03D4, 0x83D1,
+    0x83F3, 0x03F6, 0x03FC, 0x83F9, 0x03E8, 0x83ED, 0x83E7, 0x03E2,
+    0x83A3, 0x03A6, 0x03AC, 0x83A9, 0x03B8, 0x83BD, 0x83B7, 0x03B2,
+    0x0390, 0x8395, 0x839F, 0x039A, 0x838B, 0x038E, 0x0384, 0x8381,
+    0x0280, 0x8285, 0x828F, 0x028A, 0x829B, 0x029E, 0x0294, 0x8291,
+    0x82B3, 0x02B6, 0x02BC, 0x82B9, 0x02A8, 0x82AD, 0x82A7, 0x02A2,
+    0x82E3, 0x02E6, 0x02EC, 0x82E9, 0x02F8, 0x82FD, 0x82F7, 0x02F2,
+    0x02D0, 0x82D5, 0x82DF, 0x02DA, 0x82CB, 0x02CE, 0x02C4, 0x82C1,
+    0x8243, 0x0246, 0x024C, 0x8249, 0x0258, 0x825D, 0x8257, 0x0252,
+    0x0270, 0x8275, 0x827F, 0x027A, 0x826B, 0x026E, 0x0264, 0x8261,
+    0x0220, 0x8225, 0x822F, 0x022A, 0x823B, 0x023E, 0x0234, 0x8231,
+    0x8213, 0x0216, 0x021C, 0x8219, 0x0208, 0x820D, 0x8207, 0x0202
+};
+
+/* CRC32 (x^32 + x^26 + x^23 + x^22 + x^16 + x^12 + x^11 + x^10 + x^8 + x^7 + x^5 + x^4 + x^2 + x + 1) */
+static const uint32_t s_au32CrcTable32[256] =
+{
+    0x00000000, 0x04C11DB7, 0x09823B6E, 0x0D4326D9, 0x130476DC, 0x17C56B6B, 0x1A864DB2, 0x1E475005,
+    0x2608EDB8, 0x22C9F00F, 0x2F8AD6D6, 0x2B4BCB61, 0x350C9B64, 0x31CD86D3, 0x3C8EA00A, 0x384FBDBD,
+    0x4C11DB70, 0x48D0C6C7, 0x4593E01E, 0x4152FDA9, 0x5F15ADAC, 0x5BD4B01B, 0x569796C2, 0x52568B75,
+    0x6A1936C8, 0x6ED82B7F, 0x639B0DA6, 0x675A1011, 0x791D4014, 0x7DDC5DA3, 0x709F7B7A, 0x745E66CD,
+    0x9823B6E0, 0x9CE2AB57, 0x91A18D8E, 0x95609039, 0x8B27C03C, 0x8FE6DD8B, 0x82A5FB52, 0x8664E6E5,
+    0xBE2B5B58, 0xBAEA46EF, 0xB7A96036, 0xB3687D81, 0xAD2F2D84, 0xA9EE3033, 0xA4AD16EA, 0xA06C0B5D,
+    0xD4326D90, 0xD0F37027, 0xDDB056FE, 0xD9714B49, 0xC7361B4C, 0xC3F706FB, 0xCEB42022, 0xCA753D95,
+    0xF23A8028, 0xF6FB9D9F, 0xFBB8BB46, 0xFF79A6F1, 0xE13EF6F4, 0xE5FFEB43, 0xE8BCCD9A, 0xEC7DD02D,
+    0x34867077, 0x30476DC0, 0x3D044B19, 0x39C556AE, 0x278206AB, 0x23431B1C, 0x2E003DC5, 0x2AC12072,
+    0x128E9DCF, 0x164F8078, 0x1B0CA6A1, 0x1FCDBB16, 0x018AEB13, 0x054BF6A4, 0x0808D07D, 0x0CC9CDCA,
+    0x7897AB07, 0x7C56B6B0, 0x71159069, 0x75D48DDE, 0x6B93DDDB, 0x6F52C06C, 0x6211E6B5, 0x66D0FB02,
+    0x5E9F46BF, 0x5A5E5B08, 0x571D7DD1, 0x53DC6066, 0x4D9B3063, 0x495A2DD4, 0x44190B0D, 0x40D816BA,
+    0xACA5C697, 0xA864DB20, 0xA527FDF9, 0xA1E6E04E, 0xBFA1B04B, 0xBB60ADFC, 0xB6238B25, 0xB2E29692,
+    0x8AAD2B2F, 0x8E6C3698, 0x832F1041, 0x87EE0DF6, 0x99A95DF3, 0x9D684044, 0x902B669D, 0x94EA7B2A,
+    0xE0B41DE7, 0xE4750050, 0xE9362689, 0xEDF73B3E, 0xF3B06B3B, 0xF771768C, 0xFA325055, 0xFEF34DE2,
+    0xC6BCF05F, 0xC27DEDE8, 0xCF3ECB31, 0xCBFFD686, 0xD5B88683, 0xD1799B34, 0xDC3ABDED, 0xD8FBA05A,
+    0x690CE0EE, 0x6DCDFD59, 0x608EDB80, 0x644FC637, 0x7A089632, 0x7EC98B85, 0x738AAD5C, 0x774BB0EB,
+    0x4F040D56, 0x4BC510E1, 0x46863638, 0x42472B8F, 0x5C007B8A, 0x58C1663D, 0x558240E4, 0x51435D53,
+    0x251D3B9E, 0x21DC2629, 0x2C9F00F0, 0x285E1D47, 0x36194D42, 0x32D850F5, 0x3F9B762C, 0x3B5A6B9B,
+    0x0315D626, 0x07D4CB91, 0x0A97ED48, 0x0E56F0FF, 0x1011A0FA, 0x14D0BD4D, 0x19939B94, 0x1D528623,
+    0xF12F560E, 0xF5EE4BB9, 0xF8AD6D60, 0xFC6C70D7, 0xE22B20D2, 0xE6EA3D65, 0xEBA91BBC, 0xEF68060B,
+    0xD727BBB6, 0xD3E6A601, 0xDEA580D8, 0xDA649D6F, 0xC423CD6A, 0xC0E2D0DD, 0xCDA1F604, 0xC960EBB3,
+    0xBD3E8D7E, 0xB9FF90C9, 0xB4BCB610, 0xB07DABA7, 0xAE3AFBA2, 0xAAFBE615, 0xA7B8C0CC, 0xA379DD7B,
+    0x9B3660C6, 0x9FF77D71, 0x92B45BA8, 0x9675461F, 0x8832161A, 0x8CF30BAD, 0x81B02D74, 0x857130C3,
+    0x5D8A9099, 0x594B8D2E, 0x5408ABF7, 0x50C9B640, 0x4E8EE645, 0x4A4FFBF2, 0x470CDD2B, 0x43CDC09C,
+    0x7B827D21, 0x7F436096, 0x7200464F, 0x76C15BF8, 0x68860BFD, 0x6C47164A, 0x61043093, 0x65C52D24,
+    0x119B4BE9, 0x155A565E, 0x18197087, 0x1CD86D30, 0x029F3D35, 0x065E2082, 0x0B1D065B, 0x0FDC1BEC,
+    0x3793A651, 0x3352BBE6, 0x3E119D3F, 0x3AD08088, 0x2497D08D, 0x2056CD3A, 0x2D15EBE3, 0x29D4F654,
+    0xC5A92679, 0xC1683BCE, 0xCC2B1D17, 0xC8EA00A0, 0xD6AD50A5, 0xD26C4D12, 0xDF2F6BCB, 0xDBEE767C,
+    0xE3A1CBC1, 0xE760D676, 0xEA23F0AF, 0xEEE2ED18, 0xF0A5BD1D, 0xF464A0AA, 0xF9278673, 0xFDE69BC4,
+    0x89B8FD09, 0x8D79E0BE, 0x803AC667, 0x84FBDBD0, 0x9ABC8BD5, 0x9E7D9662, 0x933EB0BB, 0x97FFAD0C,
+    0xAFB010B1, 0xAB710D06, 0xA6322BDF, 0xA2F33668, 0xBCB4666D, 0xB8757BDA, 0xB5365D03, 0xB1F740B4
+};
+
+static const uint8_t s_au8CrcRvs4[16] =
+{
+    0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF
+};
+
+static uint32_t CRC_Width(uint32_t u32Mode)
+{
+    switch(u32Mode)
+    {
+        case CRC_8:
+            return 8;
+
+        case CRC_32:
+            return 32;
+
+        default:
+            return 16;
+    }
+}
+
+static uint32_t CRC_Mask(uint32_t u32Width)
+{
+    return (u32Width == 32) ? 0xFFFFFFFFUL : ((1UL << u32Width) - 1);
+}
+
+#if (CRC_SW_SLICE_NUM >= 4)
+/* Byte table entry of the polynomial mode, left aligned in 32 bits */
+static uint32_t CRC_TableEntry(uint32_t u32Mode, uint32_t u32Index)
+{
+    switch(u32Mode)
+    {
+        case CRC_8:
+            return (uint32_t)s_au8CrcTable8[u32Index] << 24;
+
+        case CRC_16:
+            return (uint32_t)s_au16CrcTable16[u32Index] << 16;
+
+        case CRC_32:
+            return s_au32CrcTable32[u32Index];
+
+        default:
+            return (uint32_t)s_au16CrcTableCcitt[u32Index] << 16;
+    }
+}
+
+static void CRC_BuildTable(uint32_t u32Mode)
+{
+    uint32_t i, j, u32Crc;
+
+    for(i = 0; i < 256; i++)
+        s_au32CrcTable[0][i] = CRC_TableEntry(u32Mode, i);
+
+    /* Table j holds the CRC of a byte followed by j zero bytes */
+    for(j = 1; j < CRC_SW_SLICE_NUM; j++)
+    {
+        for(i = 0; i < 256; i++)
+        {
+            u32Crc = s_au32CrcTable[j - 1][i];
+            s_au32CrcTable[j][i] = (u32Crc << 8) ^ s_au32CrcTable[0][u32Crc >> 24];
+        }
+    }
+
+    s_u32CrcTableMode = u32Mode;
+}
+#endif
+
+/* Write data byte as the CRC channel sees it after the write data complement and reverse */
+static uint32_t CRC_InByte(uint32_t u32Attribute, uint32_t u32Byte)
+{
+    if(u32Attribute & CRC_WDATA_COM)
+        u32Byte ^= 0xFF;
+    if(u32Attribute & CRC_WDATA_RVS)
+        u32Byte = ((uint32_t)s_au8CrcRvs4[u32Byte & 0xF] << 4) | s_au8CrcRvs4[u32Byte >> 4];
+
+    return u32Byte;
+}
+
+#if (CRC_SW_SLICE_NUM >= 4)
+/* Four data bytes in stream order as the most significant byte first */
+static uint32_t CRC_InWord(uint32_t u32Attribute, const uint8_t *pu8Data)
+{
+    return (CRC_InByte(u32Attribute, pu8Data[0]) << 24) | (CRC_InByte(u32Attribute, pu8Data[1]) << 16) |
+           (CRC_InByte(u32Attribute, pu8Data[2]) << 8) | CRC_InByte(u32Attribute, pu8Data[3]);
+}
+#endif
+
+static void CRC_SwUpdate(CRC_STREAM_T *psStream, const uint8_t *pu8Data, uint32_t u32Len)
+{
+    uint32_t u32Width = CRC_Width(psStream->u32Mode);
+    uint32_t u32Shift = 32 - u32Width;
+    uint32_t u32Attr = psStream->u32Attribute;
+    uint32_t u32Crc = psStream->u32State << u32Shift;
+    const uint16_t *pu16Table;
+#if (CRC_SW_SLICE_NUM >= 4)
+    uint32_t u32Word;
+
+    /* The slice tables serve one polynomial at a time. A preempting update keeps to the byte tables in flash. */
+    if((u32Len >= 4) && !s_u32CrcTableBusy)
+    {
+        s_u32CrcTableBusy = 1;
+        if(psStream->u32Mode != s_u32CrcTableMode)
+            CRC_BuildTable(psStream->u32Mode);
+
+#if (CRC_SW_SLICE_NUM >= 8)
+        while(u32Len >= 8)
+        {
+            u32Word = u32Crc ^ CRC_InWord(u32Attr, pu8Data);
+            u32Crc = CRC_InWord(u32Attr, pu8Data + 4);
+            u32Crc = s_au32CrcTable[7][u32Word >> 24] ^ s_au32CrcTable[6][(u32Word >> 16) & 0xFF] ^
+                     s_au32CrcTable[5][(u32Word >> 8) & 0xFF] ^ s_au32CrcTable[4][u32Word & 0xFF] ^
+                     s_au32CrcTable[3][u32Crc >> 24] ^ s_au32CrcTable[2][(u32Crc >> 16) & 0xFF] ^
+                     s_au32CrcTable[1][(u32Crc >> 8) & 0xFF] ^ s_au32CrcTable[0][u32Crc & 0xFF];
+            pu8Data += 8;
+            u32Len -= 8;
+        }
+#endif
+        while(u32Len >= 4)
+        {
+            u32Word = u32Crc ^ CRC_InWord(u32Attr, pu8Data);
+            u32Crc = s_au32CrcTable[3][u32Word >> 24] ^ s_au32CrcTable[2][(u32Word >> 16) & 0xFF] ^
+                     s_au32CrcTable[1][(u32Word >> 8) & 0xFF] ^ s_au32CrcTable[0][u32Word & 0xFF];
+            pu8Data += 4;
+            u32Len -= 4;
+        }
+
+        s_u32CrcTableBusy = 0;
+    }
+#endif
+
+    switch(u32Width)
+    {
+        case 8:
+            while(u32Len--)
+                u32Crc = (uint32_t)s_au8CrcTable8[(u32Crc >> 24) ^ CRC_InByte(u32Attr, *pu8Data++)] << 24;
+            break;
+
+        case 32:
+            while(u32Len--)
+                u32Crc = (u32Crc << 8) ^ s_au32CrcTable32[(u32Crc >> 24) ^ CRC_InByte(u32Attr, *pu8Data++)];
+            break;
+
+        default:
+            pu16Table = (psStream->u32Mode == CRC_16) ? s_au16CrcTable16 : s_au16CrcTableCcitt;
+            while(u32Len--)
+                u32Crc = (u32Crc << 8) ^ ((uint32_t)pu16Table[(u32Crc >> 24) ^ CRC_InByte(u32Attr, *pu8Data++)] << 16);
+            break;
+    }
+
+    psStream->u32State = u32Crc >> u32Shift;
+}
+
+/* Feed data to the CRC channel and return the number of bytes done. The rest is left to software. */
+static uint32_t CRC_HwUpdate(CRC_STREAM_T *psStream, const uint8_t *pu8Data, uint32_t u32Len)
+{
+    uint32_t u32Done = 0, u32Count, u32TimeOutCnt;
+    uint32_t u32Mask = CRC_Mask(CRC_Width(psStream->u32Mode));
+
+    PDMA_GCR->GCRCSR |= PDMA_GCRCSR_CRC_CLK_EN_Msk;
+
+    CRC->SEED = psStream->u32State;
+    CRC->CTL = psStream->u32Mode | (psStream->u32Attribute & CRC_STREAM_WDATA_ATTR) | CRC_CPU_WDATA_8 | CRC_CTL_CRCCEN_Msk;
+    CRC->CTL |= CRC_CTL_CRC_RST_Msk;
+
+    /* Leading bytes up to a word boundary */
+    while((u32Done < u32Len) && ((uint32_t)(pu8Data + u32Done) & 3))
+        CRC->WDATA = pu8Data[u32Done++];
+
+    if(u32Len - u32Done >= CRC_STREAM_DMA_MIN)
+    {
+        while(u32Len - u32Done >= 4)
+        {
+            u32Count = (u32Len - u32Done) & ~3UL;
+            if(u32Count > CRC_DMA_MAX_COUNT)
+                u32Count = CRC_DMA_MAX_COUNT;
+
+            /* The CRC value before the transfer lets software redo it if the transfer does not finish */
+            psStream->u32State = CRC->CHECKSUM & u32Mask;
+            CRC_StartDMATransfer((uint32_t)(pu8Data + u32Done), u32Count);
+
+            u32TimeOutCnt = SystemCoreClock;
+            while(CRC->CTL & CRC_CTL_TRIG_EN_Msk)
+            {
+                if(--u32TimeOutCnt == 0)
+                {
+                    CRC->CTL |= CRC_CTL_CRC_RST_Msk;
+                    return u32Done;
+                }
+            }
+
+            u32Done += u32Count;
+        }
+    }
+    else if(u32Len - u32Done >= 4)
+    {
+        CRC->CTL = (CRC->CTL & ~CRC_CTL_CPU_WDLEN_Msk) | CRC_CPU_WDATA_32;
+        while(u32Len - u32Done >= 4)
+        {
+            CRC->WDATA = *(const uint32_t *)(pu8Data + u32Done);
+            u32Done += 4;
+        }
+        CRC->CTL = (CRC->CTL & ~CRC_CTL_CPU_WDLEN_Msk) | CRC_CPU_WDATA_8;
+    }
+
+    /* Trailing bytes */
+    while(u32Done < u32Len)
+        CRC->WDATA = pu8Data[u32Done++];
+
+    psStream->u32State = CRC->CHECKSUM & u32Mask;
+
+    return u32Done;
+}
+
 /** @addtogroup CRC_EXPORTED_FUNCTIONS CRC Exported Functions
   @{
 */
@@ -93,6 +455,135 @@ uint32_t CRC_GetChecksum(void)
     }
 }
 
+/**
+ * @brief       CRC DMA checksum of a memory region
+ *
+ * @param[in]   u32SrcAddr      Word aligned source address
+ * @param[in]   u32ByteCount    Calculate byte count. It may exceed the 16-bit DMA byte counter.
+ *
+ * @return      Checksum, or 0 if a DMA transfer does not finish in time
+ *
+ * @details     This function continues the checksum of \ref CRC_Open with the region by CRC DMA transfers of
+ *              at most \ref CRC_DMA_MAX_COUNT bytes each, and waits until they are done.
+ *
+ * @note        Global error code g_CRC_i32ErrCode
+ *              -1  DMA transfer time-out
+ */
+uint32_t CRC_DMAChecksum(uint32_t u32SrcAddr, uint32_t u32ByteCount)
+{
+    uint32_t u32Count, u32TimeOutCnt;
+
+    g_CRC_i32ErrCode = 0;
+
+    while(u32ByteCount)
+    {
+        u32Count = (u32ByteCount > CRC_DMA_MAX_COUNT) ? CRC_DMA_MAX_COUNT : u32ByteCount;
+        CRC_StartDMATransfer(u32SrcAddr, u32Count);
+
+        u32TimeOutCnt = SystemCoreClock;
+        while(CRC->CTL & CRC_CTL_TRIG_EN_Msk)
+        {
+            if(--u32TimeOutCnt == 0)
+            {
+                /* Stop the transfer */
+                CRC->CTL |= CRC_CTL_CRC_RST_Msk;
+                g_CRC_i32ErrCode = -1;
+                return 0;
+            }
+        }
+
+        u32SrcAddr += u32Count;
+        u32ByteCount -= u32Count;
+    }
+
+    return CRC_GetChecksum();
+}
+
+/**
+ * @brief       Start a CRC stream
+ *
+ * @param[out]  psStream        Stream context
+ * @param[in]   u32Mode         CRC Polynomial Mode. CRC_CCITT, CRC_8, CRC_16, CRC_32
+ * @param[in]   u32Attribute    Parameter attribute. CRC_CHECKSUM_COM, CRC_CHECKSUM_RVS, CRC_WDATA_COM, CRC_WDATA_RVS,
+ *                              CRC_STREAM_SW
+ * @param[in]   u32Seed         Seed value.
+ *
+ * @return      None
+ *
+ * @details     This function starts a checksum that is fed by \ref CRC_StreamUpdate and read by \ref CRC_StreamFinal.
+ *              The mode, attribute and seed have the same meaning as in \ref CRC_Open, so a stream gives the same
+ *              checksum as the CRC channel over the concatenated data. With CRC_STREAM_SW the checksum is only
+ *              calculated by software, which also runs on a host without the CRC channel.
+ */
+void CRC_StreamInit(CRC_STREAM_T *psStream, uint32_t u32Mode, uint32_t u32Attribute, uint32_t u32Seed)
+{
+    psStream->u32Mode = u32Mode & CRC_CTL_CRC_MODE_Msk;
+    psStream->u32Attribute = u32Attribute;
+    psStream->u32State = u32Seed & CRC_Mask(CRC_Width(psStream->u32Mode));
+}
+
+/**
+ * @brief       Feed data to a CRC stream
+ *
+ * @param[in]   psStream        Stream context
+ * @param[in]   pvData          Data buffer of any alignment
+ * @param[in]   u32Len          Number of bytes
+ *
+ * @return      None
+ *
+ * @details     The data are fed to the CRC channel. Words of a buffer with at least CRC_STREAM_DMA_MIN bytes are
+ *              fed by CRC DMA transfers, and the other bytes are written by the CPU. The buffer is checksummed by
+ *              software instead if the PDMA clock is disabled, a CRC DMA transfer is in progress or another
+ *              stream update is using the CRC channel, for example when this function is called by an interrupt
+ *              handler. The CRC channel must not be used by \ref CRC_Open at the same time.
+ *
+ * @note        The software path is reentrant. With CRC_SW_SLICE_NUM above 1 the RAM slice tables serve one
+ *              polynomial at a time, so an update that preempts another one uses the byte tables in flash.
+ */
+void CRC_StreamUpdate(CRC_STREAM_T *psStream, const void *pvData, uint32_t u32Len)
+{
+    const uint8_t *pu8Data = (const uint8_t *)pvData;
+    uint32_t u32Done = 0;
+
+    if(!(psStream->u32Attribute & CRC_STREAM_SW) && (CLK->AHBCLK & CLK_AHBCLK_PDMA_EN_Msk) && !s_u32CrcStreamBusy &&
+            !(CRC->CTL & CRC_CTL_TRIG_EN_Msk))
+    {
+        s_u32CrcStreamBusy = 1;
+        u32Done = CRC_HwUpdate(psStream, pu8Data, u32Len);
+        s_u32CrcStreamBusy = 0;
+    }
+
+    if(u32Done < u32Len)
+        CRC_SwUpdate(psStream, pu8Data + u32Done, u32Len - u32Done);
+}
+
+/**
+ * @brief       Get the checksum of a CRC stream
+ *
+ * @param[in]   psStream        Stream context
+ *
+ * @return      Checksum of all data fed since \ref CRC_StreamInit
+ *
+ * @details     This function applies the checksum reverse and complement attributes. The stream is not changed,
+ *              so more data can still be fed after it.
+ */
+uint32_t CRC_StreamFinal(CRC_STREAM_T *psStream)
+{
+    uint32_t u32Width = CRC_Width(psStream->u32Mode);
+    uint32_t u32Sum = psStream->u32State, u32Rvs, i;
+
+    if(psStream->u32Attribute & CRC_CHECKSUM_RVS)
+    {
+        for(i = 0, u32Rvs = 0; i < u32Width; i++)
+            u32Rvs |= ((u32Sum >> i) & 1) << (u32Width - 1 - i);
+        u32Sum = u32Rvs;
+    }
+    if(psStream->u32Attribute & CRC_CHECKSUM_COM)
+        u32Sum = ~u32Sum;
+
+    return u32Sum & CRC_Mask(u32Width);
+}
+
 /*@}*/ /* end of group CRC_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group CRC_Driver */
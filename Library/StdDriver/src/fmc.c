@@ -219,6 +219,117 @@ uint32_t FMC_ReadDataFlashBaseAddr(void)
 }
 
 
+/* APROM and Data Flash are mapped on the bus when the chip boots from APROM, except page 0 if VECMAP remaps it */
+static int32_t FMC_IsBusReadable(uint32_t u32Addr)
+{
+    return (u32Addr < FMC_LDROM_BASE) && ((FMC->ISPCON & FMC_ISPCON_BS_Msk) == 0) &&
+           ((u32Addr >= FMC_FLASH_PAGE_SIZE) || (FMC_GetVECMAP() == 0));
+}
+
+/**
+  * @brief       Read flash words to a buffer
+  *
+  * @param[in]   u32Addr    Word aligned flash address including APROM, LDROM, Data Flash, and CONFIG
+  * @param[out]  pu32Buf    The word buffer to store the flash data
+  * @param[in]   u32Len     Number of bytes to read, a multiple of 4
+  *
+  * @retval       0 Success
+  * @retval      -1 Read failed
+  *
+  * @details     APROM and Data Flash are read directly on the bus when the chip boots from APROM, which is
+  *              much faster than one ISP read command per word. The vector page at address 0 shows the
+  *              page selected by VECMAP, so APROM page 0 is read by ISP commands if it is remapped.
+  *              LDROM and CONFIG are always read by ISP commands.
+  *
+  * @note        Global error code g_FMC_i32ErrCode
+  *              -1  Read time-out
+  */
+int32_t FMC_ReadMultiple(uint32_t u32Addr, uint32_t *pu32Buf, uint32_t u32Len)
+{
+    uint32_t *pu32Src;
+
+    g_FMC_i32ErrCode = 0;
+
+    /* Words that are not bus readable */
+    while(u32Len >= 4)
+    {
+        if(FMC_IsBusReadable(u32Addr))
+            break;
+
+        *pu32Buf++ = FMC_Read(u32Addr);
+        if(g_FMC_i32ErrCode != 0)
+            return -1;
+
+        u32Addr += 4;
+        u32Len -= 4;
+    }
+
+    /* The rest is in APROM or Data Flash and mapped on the bus */
+    pu32Src = (uint32_t *)u32Addr;
+    while(u32Len >= 16)
+    {
+        pu32Buf[0] = pu32Src[0];
+        pu32Buf[1] = pu32Src[1];
+        pu32Buf[2] = pu32Src[2];
+        pu32Buf[3] = pu32Src[3];
+        pu32Buf += 4;
+        pu32Src += 4;
+        u32Len -= 16;
+    }
+    while(u32Len >= 4)
+    {
+        *pu32Buf++ = *pu32Src++;
+        u32Len -= 4;
+    }
+
+    return 0;
+}
+
+/**
+  * @brief       Calculate CRC-32 of a flash region
+  *
+  * @param[in]   u32Addr    Word aligned flash address including APROM, LDROM and Data Flash
+  * @param[in]   u32Len     Number of bytes, a multiple of 4
+  *
+  * @return      CRC-32 of the region, the same as zlib crc32 of its bytes
+  *
+  * @details     Bus readable words (see \ref FMC_ReadMultiple) are fed to the CRC channel by CRC DMA transfers,
+  *              which is far faster than reading and summing them by the CPU. The other words are read by ISP
+  *              commands and written to the CRC channel by the CPU. The CRC channel is opened by this function
+  *              and the PDMA clock must be enabled.
+  *
+  * @note        Global error code g_FMC_i32ErrCode
+  *              -1  Read time-out or CRC DMA transfer time-out
+  */
+uint32_t FMC_GetCRC32(uint32_t u32Addr, uint32_t u32Len)
+{
+    uint32_t u32Crc;
+
+    g_FMC_i32ErrCode = 0;
+
+    CRC_Open(CRC_32, CRC_WDATA_RVS | CRC_CHECKSUM_RVS | CRC_CHECKSUM_COM, 0xFFFFFFFF, CRC_CPU_WDATA_32);
+
+    while((u32Len >= 4) && !FMC_IsBusReadable(u32Addr))
+    {
+        CRC_WRITE_DATA(FMC_Read(u32Addr));
+        if(g_FMC_i32ErrCode != 0)
+            return 0;
+
+        u32Addr += 4;
+        u32Len -= 4;
+    }
+
+    u32Crc = CRC_DMAChecksum(u32Addr, u32Len & ~3UL);
+    if(g_CRC_i32ErrCode != 0)
+    {
+        g_FMC_i32ErrCode = -1;
+        return 0;
+    }
+
+    return u32Crc;
+}
+
+
 /**
   * @brief       Read the User Configuration words.
   *
@@ -0,0 +1,387 @@
+/**************************************************************************//**
+ * @file     fwu.c
+ * @version  V3.00
+ * @brief    M071R_M071S series A/B firmware update driver source file
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2013 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include "NuMicro.h"
+
+/*
+    APROM holds a small boot image at address 0 and two application slots, A and B. Each application is
+    linked to run at its slot address. The boot image calls FWU_Boot, which selects a slot, maps the slot
+    to the vector page by VECMAP and resets the CPU, so the application starts without copying anything.
+
+    While the application runs, a new image is written to the other slot. When it is complete and its
+    CRC-32 matches, one key-value store record makes it the trial slot; this record is the atomic switch.
+    The next chip reset boots the trial slot. The new application calls FWU_Confirm once it works; if it
+    resets FWU_MAX_ATTEMPTS times without confirming, e.g. by a watchdog, FWU_Boot rolls back to the
+    confirmed slot.
+*/
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup FWU_Driver FWU Driver
+  @{
+*/
+
+typedef struct
+{
+    uint32_t u32Active;         /* Confirmed slot */
+    uint32_t u32Trial;          /* Slot booted on trial, or FWU_SLOT_NONE */
+    uint32_t u32Attempts;       /* Boots of the trial slot */
+    uint32_t au32Size[2];       /* Image size of each slot, 0 if unknown */
+    uint32_t au32Crc[2];        /* Image CRC-32 of each slot */
+} FWU_STATE_T;
+
+static KVS_T *s_psFwuKvs = 0;
+static uint32_t s_au32FwuSlot[2];
+static uint32_t s_u32FwuSlotSize;
+static FWU_STATE_T s_sFwuState;
+
+static uint32_t s_u32FwuTarget = FWU_SLOT_NONE; /* Slot being written */
+static uint32_t s_u32FwuSize;                   /* Image size */
+static uint32_t s_u32FwuOffset;                 /* Bytes programmed */
+static uint32_t s_u32FwuWord;                   /* Bytes not programmed yet */
+static uint32_t s_u32FwuWordLen;
+
+static int32_t FWU_SaveState(void)
+{
+    return (KVS_Write(s_psFwuKvs, FWU_KVS_KEY, &s_sFwuState, sizeof(s_sFwuState)) == KVS_OK) ? FWU_OK : FWU_ERR_FLASH;
+}
+
+static int32_t FWU_Verify(uint32_t u32Slot)
+{
+    uint32_t u32Size = s_sFwuState.au32Size[u32Slot];
+    uint32_t u32Crc;
+
+    if(u32Size == 0)
+        return FWU_ERR_CRC;
+
+    /* A read or CRC DMA time-out cannot verify the image */
+    u32Crc = FMC_GetCRC32(s_au32FwuSlot[u32Slot], (u32Size + 3) & ~3UL);
+    if((g_FMC_i32ErrCode != 0) || (u32Crc != s_sFwuState.au32Crc[u32Slot]))
+        return FWU_ERR_CRC;
+
+    return FWU_OK;
+}
+
+/* An image starts with its initial stack pointer in SRAM and a reset vector in the slot */
+static int32_t FWU_IsBootable(uint32_t u32Slot)
+{
+    uint32_t au32Vector[2];
+
+    if(FMC_ReadMultiple(s_au32FwuSlot[u32Slot], au32Vector, sizeof(au32Vector)) != 0)
+        return 0;
+
+    return ((au32Vector[0] & 0xFFF00000UL) == SRAM_BASE) &&
+           (au32Vector[1] - s_au32FwuSlot[u32Slot] < s_u32FwuSlotSize);
+}
+
+static int32_t FWU_Program(uint32_t u32Data)
+{
+    uint32_t u32Addr = s_au32FwuSlot[s_u32FwuTarget] + s_u32FwuOffset;
+
+    if((u32Addr & (FMC_FLASH_PAGE_SIZE - 1)) == 0)
+    {
+        if(FMC_Erase(u32Addr) != 0)
+            return FWU_ERR_FLASH;
+    }
+
+    if((FMC_Write(u32Addr, u32Data) != 0) || (FMC_Read(u32Addr) != u32Data))
+        return FWU_ERR_FLASH;
+
+    s_u32FwuOffset += 4;
+
+    return FWU_OK;
+}
+
+/** @addtogroup FWU_EXPORTED_FUNCTIONS FWU Exported Functions
+  @{
+*/
+
+/**
+ * @brief       Open firmware update
+ *
+ * @param[in]   psKvs       Mounted key-value store that keeps the update state under key \ref FWU_KVS_KEY
+ * @param[in]   u32SlotA    Page aligned APROM address of slot A
+ * @param[in]   u32SlotB    Page aligned APROM address of slot B
+ * @param[in]   u32SlotSize Size of each slot in bytes, a multiple of the page size
+ *
+ * @retval      FWU_OK          Update state loaded
+ * @retval      FWU_ERR_PARAM   Invalid slot layout
+ *
+ * @details     This function loads the update state. A store without the state means slot A is confirmed.
+ *              FMC must be enabled by \ref FMC_Open with APROM update enabled, and the PDMA clock must be
+ *              enabled for the CRC channel.
+ */
+int32_t FWU_Open(KVS_T *psKvs, uint32_t u32SlotA, uint32_t u32SlotB, uint32_t u32SlotSize)
+{
+    if(((u32SlotA | u32SlotB | u32SlotSize) & (FMC_FLASH_PAGE_SIZE - 1)) || (u32SlotSize == 0) ||
+            ((u32SlotA < u32SlotB) ? (u32SlotB - u32SlotA < u32SlotSize) : (u32SlotA - u32SlotB < u32SlotSize)))
+        return FWU_ERR_PARAM;
+
+    s_psFwuKvs = psKvs;
+    s_au32FwuSlot[0] = u32SlotA;
+    s_au32FwuSlot[1] = u32SlotB;
+    s_u32FwuSlotSize = u32SlotSize;
+    s_u32FwuTarget = FWU_SLOT_NONE;
+
+    if((KVS_Read(psKvs, FWU_KVS_KEY, &s_sFwuState, sizeof(s_sFwuState)) != sizeof(s_sFwuState)) ||
+            (s_sFwuState.u32Active > 1) || ((s_sFwuState.u32Trial > 1) && (s_sFwuState.u32Trial != FWU_SLOT_NONE)))
+    {
+        s_sFwuState.u32Active = 0;
+        s_sFwuState.u32Trial = FWU_SLOT_NONE;
+        s_sFwuState.u32Attempts = 0;
+        s_sFwuState.au32Size[0] = s_sFwuState.au32Size[1] = 0;
+        s_sFwuState.au32Crc[0] = s_sFwuState.au32Crc[1] = 0;
+    }
+
+    return FWU_OK;
+}
+
+/**
+ * @brief       Get running slot
+ *
+ * @param       None
+ *
+ * @return      0 for slot A, 1 for slot B, or \ref FWU_SLOT_NONE if no slot is mapped to the vector page
+ *
+ * @details     The running slot is the slot selected by VECMAP.
+ */
+uint32_t FWU_GetRunningSlot(void)
+{
+    uint32_t u32VecMap = FMC_GetVECMAP();
+
+    if(u32VecMap == s_au32FwuSlot[0])
+        return 0;
+    if(u32VecMap == s_au32FwuSlot[1])
+        return 1;
+
+    return FWU_SLOT_NONE;
+}
+
+/**
+ * @brief       Begin writing a new image
+ *
+ * @param[in]   u32Size     Image size in bytes
+ *
+ * @retval      FWU_OK          Ready for \ref FWU_Write
+ * @retval      FWU_ERR_PARAM   Image does not fit in a slot
+ * @retval      FWU_ERR_STATE   The running image is not confirmed yet
+ * @retval      FWU_ERR_FLASH   Update state could not be saved
+ *
+ * @details     The new image goes to the slot that is not confirmed. The slot is marked empty before it
+ *              is overwritten, so a power failure during the update never boots a partial image.
+ */
+int32_t FWU_Begin(uint32_t u32Size)
+{
+    uint32_t u32Target = s_sFwuState.u32Active ^ 1;
+
+    if((u32Size == 0) || (u32Size > s_u32FwuSlotSize))
+        return FWU_ERR_PARAM;
+
+    if(FWU_GetRunningSlot() == u32Target)
+        return FWU_ERR_STATE;
+
+    if((s_sFwuState.u32Trial != FWU_SLOT_NONE) || (s_sFwuState.au32Size[u32Target] != 0))
+    {
+        s_sFwuState.u32Trial = FWU_SLOT_NONE;
+        s_sFwuState.au32Size[u32Target] = 0;
+        if(FWU_SaveState() != FWU_OK)
+            return FWU_ERR_FLASH;
+    }
+
+    s_u32FwuTarget = u32Target;
+    s_u32FwuSize = u32Size;
+    s_u32FwuOffset = 0;
+    s_u32FwuWordLen = 0;
+
+    return FWU_OK;
+}
+
+/**
+ * @brief       Write image data
+ *
+ * @param[in]   pvData      Image data following the data of the previous call
+ * @param[in]   u32Len      Data size in bytes. Any size is accepted.
+ *
+ * @retval      FWU_OK          Data written
+ * @retval      FWU_ERR_STATE   No update in progress or more data than the image size
+ * @retval      FWU_ERR_FLASH   Flash program or erase failed. The update must be started again.
+ *
+ * @details     This function programs the data to the target slot and erases each page when it is reached.
+ *              It can be called from the application main loop in small pieces as the data arrives. Code
+ *              fetch from flash stalls while a word is programmed (tens of us) or a page is erased (tens
+ *              of ms), so interrupt latency grows by that much during the update.
+ */
+int32_t FWU_Write(const void *pvData, uint32_t u32Len)
+{
+    const uint8_t *pu8Data = (const uint8_t *)pvData;
+
+    if((s_u32FwuTarget == FWU_SLOT_NONE) || (s_u32FwuOffset + s_u32FwuWordLen + u32Len > s_u32FwuSize))
+        return FWU_ERR_STATE;
+
+    while(u32Len--)
+    {
+        s_u32FwuWord = (s_u32FwuWord >> 8) | ((uint32_t)*pu8Data++ << 24);
+        if(++s_u32FwuWordLen == 4)
+        {
+            s_u32FwuWordLen = 0;
+            if(FWU_Program(s_u32FwuWord) != FWU_OK)
+            {
+                s_u32FwuTarget = FWU_SLOT_NONE;
+                return FWU_ERR_FLASH;
+            }
+        }
+    }
+
+    return FWU_OK;
+}
+
+/**
+ * @brief       Finish writing a new image
+ *
+ * @param[in]   u32Crc      CRC-32 (as zlib crc32) of the image padded with 0xFF to a multiple of 4 bytes
+ *
+ * @retval      FWU_OK          The new image boots on trial after the next chip reset
+ * @retval      FWU_ERR_STATE   No update in progress or the image is incomplete
+ * @retval      FWU_ERR_FLASH   Flash program failed
+ * @retval      FWU_ERR_CRC     The programmed image does not match u32Crc
+ *
+ * @details     This function checks the CRC of the new slot with the CRC DMA channel and then saves the
+ *              update state that selects the slot. The application resets the chip, e.g. by \ref SYS_ResetChip,
+ *              when it is ready to run the new image.
+ */
+int32_t FWU_Finish(uint32_t u32Crc)
+{
+    uint32_t u32Target = s_u32FwuTarget;
+
+    if((u32Target == FWU_SLOT_NONE) || (s_u32FwuOffset + s_u32FwuWordLen != s_u32FwuSize))
+        return FWU_ERR_STATE;
+
+    if(s_u32FwuWordLen)
+    {
+        while(s_u32FwuWordLen++ < 4)
+            s_u32FwuWord = (s_u32FwuWord >> 8) | 0xFF000000UL;
+        s_u32FwuWordLen = 0;
+        if(FWU_Program(s_u32FwuWord) != FWU_OK)
+        {
+            s_u32FwuTarget = FWU_SLOT_NONE;
+            return FWU_ERR_FLASH;
+        }
+    }
+    s_u32FwuTarget = FWU_SLOT_NONE;
+
+    if((FMC_GetCRC32(s_au32FwuSlot[u32Target], s_u32FwuOffset) != u32Crc) || (g_FMC_i32ErrCode != 0))
+        return FWU_ERR_CRC;
+
+    s_sFwuState.u32Trial = u32Target;
+    s_sFwuState.u32Attempts = 0;
+    s_sFwuState.au32Size[u32Target] = s_u32FwuSize;
+    s_sFwuState.au32Crc[u32Target] = u32Crc;
+
+    return FWU_SaveState();
+}
+
+/**
+ * @brief       Confirm the running image
+ *
+ * @param       None
+ *
+ * @retval      FWU_OK          The running image is confirmed
+ * @retval      FWU_ERR_STATE   The running image is not the trial image
+ * @retval      FWU_ERR_FLASH   Update state could not be saved
+ *
+ * @details     A new image calls this function once it has checked that it works. Until then every chip
+ *              reset counts as a failed boot. Calling it from a confirmed image does nothing.
+ */
+int32_t FWU_Confirm(void)
+{
+    uint32_t u32Running = FWU_GetRunningSlot();
+
+    if((s_sFwuState.u32Trial == FWU_SLOT_NONE) && (u32Running == s_sFwuState.u32Active))
+        return FWU_OK;
+
+    if((s_sFwuState.u32Trial == FWU_SLOT_NONE) || (u32Running != s_sFwuState.u32Trial))
+        return FWU_ERR_STATE;
+
+    s_sFwuState.u32Active = s_sFwuState.u32Trial;
+    s_sFwuState.u32Trial = FWU_SLOT_NONE;
+    s_sFwuState.u32Attempts = 0;
+
+    return FWU_SaveState();
+}
+
+/**
+ * @brief       Boot an application slot
+ *
+ * @param       None
+ *
+ * @retval      FWU_ERR_NO_IMAGE    No slot holds a bootable image
+ * @retval      FWU_ERR_FLASH       Update state could not be saved
+ *
+ * @details     This function is called by the boot image at address 0 after \ref FWU_Open. It boots the trial
+ *              slot if there is one, its CRC is correct and it has not failed \ref FWU_MAX_ATTEMPTS boots yet;
+ *              otherwise the trial is dropped and the confirmed slot is booted. The confirmed slot is checked
+ *              by its CRC too, and the other slot becomes the confirmed slot if only that one is intact. The selected slot is
+ *              mapped to the vector page and the CPU is reset, so this function does not return on success.
+ *              Register write protection must be disabled.
+ */
+int32_t FWU_Boot(void)
+{
+    uint32_t u32Slot = s_sFwuState.u32Active;
+    uint32_t u32Trial = s_sFwuState.u32Trial;
+
+    if(u32Trial != FWU_SLOT_NONE)
+    {
+        if((s_sFwuState.u32Attempts < FWU_MAX_ATTEMPTS) && FWU_IsBootable(u32Trial) && (FWU_Verify(u32Trial) == FWU_OK))
+        {
+            s_sFwuState.u32Attempts++;
+            u32Slot = u32Trial;
+        }
+        else
+        {
+            /* Roll back */
+            s_sFwuState.u32Trial = FWU_SLOT_NONE;
+            s_sFwuState.u32Attempts = 0;
+        }
+
+        if(FWU_SaveState() != FWU_OK)
+            return FWU_ERR_FLASH;
+    }
+
+    /* A confirmed image that no longer matches its CRC is replaced by the other slot if that one is intact */
+    if((u32Slot == s_sFwuState.u32Active) && s_sFwuState.au32Size[u32Slot] && (FWU_Verify(u32Slot) != FWU_OK) &&
+            FWU_IsBootable(u32Slot ^ 1) && (FWU_Verify(u32Slot ^ 1) == FWU_OK))
+    {
+        s_sFwuState.au32Size[u32Slot] = 0;
+        u32Slot ^= 1;
+        s_sFwuState.u32Active = u32Slot;
+
+        if(FWU_SaveState() != FWU_OK)
+            return FWU_ERR_FLASH;
+    }
+
+    if(!FWU_IsBootable(u32Slot))
+        return FWU_ERR_NO_IMAGE;
+
+    /* Mask all interrupts so that no handler is fetched from the new vector page before the reset */
+    __set_PRIMASK(1);
+    FMC_SetVectorPageAddr(s_au32FwuSlot[u32Slot]);
+    SYS_ResetCPU();
+    while(1);
+}
+
+
+/*@}*/ /* end of group FWU_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group FWU_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+/*** (C) COPYRIGHT 2013 Nuvoton Technology Corp. ***/
@@ -0,0 +1,495 @@
+/**************************************************************************//**
+ * @file     kvs.c
+ * @version  V3.00
+ * @brief    M071R_M071S series flash key-value store driver source file
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2013 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include "NuMicro.h"
+
+/*
+    The store is a log over a ring of flash pages. Each page in use starts with
+        [magic] [sequence number]
+    and is followed by records
+        [key << 16 | size] [value word 0] ... [value word n] [checksum]
+    A record of size 0xFFFF has no value words and deletes the key. Records are only appended, so updating
+    a value programs a few words instead of erasing a page. Flash words are programmed in that order and the
+    checksum is written last, so a record cut by a power failure fails its checksum and is ignored.
+
+    The pages in use are consecutive in the ring, from the oldest to the current page, and at least one page
+    is kept erased. When the current page is full the next page is started; if that used the last erased
+    page, the live records of the oldest page are copied to the new page before the oldest page is erased.
+    The copies are newer than the originals, so a power failure at any point leaves either of them valid.
+    Pages are always reused in ring order, which spreads erase cycles evenly over the whole store.
+    Deleted keys are never copied, and the oldest page has nothing older to hide, so its delete records are
+    simply dropped.
+*/
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup KVS_Driver KVS Driver
+  @{
+*/
+
+#define KVS_PAGE_MAGIC      0x3153564BUL    /* "KVS1" */
+#define KVS_PAGE_HDR_SIZE   8               /* Magic and sequence number */
+#define KVS_LEN_DELETED     0xFFFF          /* Record size of a delete record */
+#define KVS_ERASED          0xFFFFFFFFUL
+
+static uint32_t KVS_PageAddr(KVS_T *psKvs, uint32_t u32Page)
+{
+    return psKvs->u32Base + (u32Page % psKvs->u32Pages) * FMC_FLASH_PAGE_SIZE;
+}
+
+static uint32_t KVS_ReadWord(uint32_t u32Addr)
+{
+    uint32_t u32Data;
+
+    if(FMC_ReadMultiple(u32Addr, &u32Data, 4) != 0)
+        return KVS_ERASED;
+
+    return u32Data;
+}
+
+static int32_t KVS_Program(uint32_t u32Addr, uint32_t u32Data)
+{
+    if(u32Data != KVS_ERASED)
+        FMC_Write(u32Addr, u32Data);
+
+    return (KVS_ReadWord(u32Addr) == u32Data) ? KVS_OK : KVS_ERR_FLASH;
+}
+
+static uint32_t KVS_Checksum(uint32_t u32Sum, uint32_t u32Data)
+{
+    return ((u32Sum << 5) | (u32Sum >> 27)) ^ u32Data;
+}
+
+/* Value word u32Word of a record, from RAM if pu8Data is given or else from the flash record at u32Src */
+static uint32_t KVS_GetWord(const uint8_t *pu8Data, uint32_t u32Src, uint32_t u32Word, uint32_t u32Len)
+{
+    uint32_t u32Data = KVS_ERASED, i;
+
+    if(pu8Data == NULL)
+        return KVS_ReadWord(u32Src + 4 + u32Word * 4);
+
+    for(i = 0; (i < 4) && (u32Word * 4 + i < u32Len); i++)
+        u32Data = (u32Data & ~(0xFFUL << (i * 8))) | ((uint32_t)pu8Data[u32Word * 4 + i] << (i * 8));
+
+    return u32Data;
+}
+
+static int32_t KVS_Find(KVS_T *psKvs, uint32_t u32Key)
+{
+    uint32_t i;
+
+    for(i = 0; i < psKvs->u32Count; i++)
+    {
+        if(psKvs->asEntry[i].u16Key == u32Key)
+            return (int32_t)i;
+    }
+
+    return -1;
+}
+
+static int32_t KVS_Index(KVS_T *psKvs, uint32_t u32Key, uint32_t u32Len, uint32_t u32Addr)
+{
+    int32_t i32Idx = KVS_Find(psKvs, u32Key);
+
+    if(u32Len == KVS_LEN_DELETED)
+    {
+        if(i32Idx >= 0)
+            psKvs->asEntry[i32Idx] = psKvs->asEntry[--psKvs->u32Count];
+        return KVS_OK;
+    }
+
+    if(i32Idx < 0)
+    {
+        if(psKvs->u32Count == KVS_MAX_KEYS)
+            return KVS_ERR_FULL;
+        i32Idx = (int32_t)psKvs->u32Count++;
+    }
+
+    psKvs->asEntry[i32Idx].u16Key = (uint16_t)u32Key;
+    psKvs->asEntry[i32Idx].u16Len = (uint16_t)u32Len;
+    psKvs->asEntry[i32Idx].u32Addr = u32Addr;
+
+    return KVS_OK;
+}
+
+/* Add the valid records of a page to the index. Returns the address after the last record, or the page end
+   if the page holds something that is not a record. */
+static uint32_t KVS_Scan(KVS_T *psKvs, uint32_t u32Page, int32_t *pi32Ret)
+{
+    uint32_t u32Addr = KVS_PageAddr(psKvs, u32Page) + KVS_PAGE_HDR_SIZE;
+    uint32_t u32End = KVS_PageAddr(psKvs, u32Page) + FMC_FLASH_PAGE_SIZE;
+    uint32_t u32Hdr, u32Len, u32Words, u32Sum, i;
+
+    while(u32Addr < u32End)
+    {
+        u32Hdr = KVS_ReadWord(u32Addr);
+        if(u32Hdr == KVS_ERASED)
+            break;
+
+        u32Len = u32Hdr & 0xFFFF;
+        u32Words = (u32Len == KVS_LEN_DELETED) ? 0 : (u32Len + 3) / 4;
+        if(((u32Hdr >> 16) == KVS_KEY_INVALID) || ((u32Len != KVS_LEN_DELETED) && (u32Len > KVS_MAX_VALUE_SIZE)) ||
+                (u32Addr + 8 + u32Words * 4 > u32End))
+            return u32End;
+
+        u32Sum = u32Hdr;
+        for(i = 0; i < u32Words; i++)
+            u32Sum = KVS_Checksum(u32Sum, KVS_ReadWord(u32Addr + 4 + i * 4));
+
+        if(KVS_ReadWord(u32Addr + 4 + u32Words * 4) == (u32Sum & 0x7FFFFFFFUL))
+        {
+            if(KVS_Index(psKvs, u32Hdr >> 16, u32Len, u32Addr) != KVS_OK)
+                *pi32Ret = KVS_ERR_FULL;
+        }
+
+        u32Addr += 8 + u32Words * 4;
+    }
+
+    return u32Addr;
+}
+
+/* Erase a page unless it is blank already, then write its header */
+static int32_t KVS_Format(KVS_T *psKvs, uint32_t u32Page, uint32_t u32Seq)
+{
+    uint32_t u32Addr = KVS_PageAddr(psKvs, u32Page);
+    uint32_t i;
+
+    for(i = 0; i < FMC_FLASH_PAGE_SIZE; i += 4)
+    {
+        if(KVS_ReadWord(u32Addr + i) != KVS_ERASED)
+        {
+            if(FMC_Erase(u32Addr) != 0)
+                return KVS_ERR_FLASH;
+            break;
+        }
+    }
+
+    /* The magic word makes the page valid, so it is written after the sequence number */
+    if((KVS_Program(u32Addr + 4, u32Seq) != KVS_OK) || (KVS_Program(u32Addr, KVS_PAGE_MAGIC) != KVS_OK))
+        return KVS_ERR_FLASH;
+
+    return KVS_OK;
+}
+
+/* Append a record at the write address. The value comes from pu8Data, or from the flash record at u32Src. */
+static int32_t KVS_Append(KVS_T *psKvs, uint32_t u32Hdr, const uint8_t *pu8Data, uint32_t u32Src)
+{
+    uint32_t u32Addr = psKvs->u32WriteAddr;
+    uint32_t u32Len = u32Hdr & 0xFFFF;
+    uint32_t u32Words = (u32Len == KVS_LEN_DELETED) ? 0 : (u32Len + 3) / 4;
+    uint32_t u32Sum = u32Hdr, u32Data, i;
+    int32_t i32Ret;
+
+    i32Ret = KVS_Program(u32Addr, u32Hdr);
+    for(i = 0; (i < u32Words) && (i32Ret == KVS_OK); i++)
+    {
+        u32Data = KVS_GetWord(pu8Data, u32Src, i, u32Len);
+        u32Sum = KVS_Checksum(u32Sum, u32Data);
+        i32Ret = KVS_Program(u32Addr + 4 + i * 4, u32Data);
+    }
+    if(i32Ret == KVS_OK)
+        i32Ret = KVS_Program(u32Addr + 4 + u32Words * 4, u32Sum & 0x7FFFFFFFUL);
+
+    if(i32Ret != KVS_OK)
+    {
+        /* Nothing more is written to a page with a bad record */
+        psKvs->u32WriteAddr = KVS_PageAddr(psKvs, psKvs->u32Oldest + psKvs->u32Used - 1) + FMC_FLASH_PAGE_SIZE;
+        return i32Ret;
+    }
+
+    psKvs->u32WriteAddr = u32Addr + 8 + u32Words * 4;
+
+    return KVS_OK;
+}
+
+/* Copy the live records of the oldest page to the current page and erase the oldest page */
+static int32_t KVS_Collect(KVS_T *psKvs)
+{
+    uint32_t u32Addr = KVS_PageAddr(psKvs, psKvs->u32Oldest);
+    uint32_t u32Src, i;
+    int32_t i32Ret;
+
+    for(i = 0; i < psKvs->u32Count; i++)
+    {
+        u32Src = psKvs->asEntry[i].u32Addr;
+        if((u32Src >= u32Addr) && (u32Src < u32Addr + FMC_FLASH_PAGE_SIZE))
+        {
+            psKvs->asEntry[i].u32Addr = psKvs->u32WriteAddr;
+            i32Ret = KVS_Append(psKvs, ((uint32_t)psKvs->asEntry[i].u16Key << 16) | psKvs->asEntry[i].u16Len, NULL, u32Src);
+            if(i32Ret != KVS_OK)
+            {
+                psKvs->asEntry[i].u32Addr = u32Src;
+                return i32Ret;
+            }
+        }
+    }
+
+    if(FMC_Erase(u32Addr) != 0)
+        return KVS_ERR_FLASH;
+
+    psKvs->u32Oldest = (psKvs->u32Oldest + 1) % psKvs->u32Pages;
+    psKvs->u32Used--;
+
+    return KVS_OK;
+}
+
+/* Start the next page, and collect the oldest page if no erased page is left */
+static int32_t KVS_Advance(KVS_T *psKvs)
+{
+    uint32_t u32Page = psKvs->u32Oldest + psKvs->u32Used;
+    int32_t i32Ret;
+
+    i32Ret = KVS_Format(psKvs, u32Page, psKvs->u32Seq + 1);
+    if(i32Ret != KVS_OK)
+        return i32Ret;
+
+    psKvs->u32Seq++;
+    psKvs->u32Used++;
+    psKvs->u32WriteAddr = KVS_PageAddr(psKvs, u32Page) + KVS_PAGE_HDR_SIZE;
+
+    if(psKvs->u32Used == psKvs->u32Pages)
+        return KVS_Collect(psKvs);
+
+    return KVS_OK;
+}
+
+/* Make room for a record of u32Size bytes in the current page */
+static int32_t KVS_Reserve(KVS_T *psKvs, uint32_t u32Size)
+{
+    uint32_t u32End, i;
+    int32_t i32Ret;
+
+    /* Each pass erases one page at most, so a store that is still full after a whole round stays full */
+    for(i = 0; i <= psKvs->u32Pages; i++)
+    {
+        u32End = KVS_PageAddr(psKvs, psKvs->u32Oldest + psKvs->u32Used - 1) + FMC_FLASH_PAGE_SIZE;
+        if(psKvs->u32WriteAddr + u32Size <= u32End)
+            return KVS_OK;
+
+        i32Ret = KVS_Advance(psKvs);
+        if(i32Ret != KVS_OK)
+            return i32Ret;
+    }
+
+    return KVS_ERR_FULL;
+}
+
+/** @addtogroup KVS_EXPORTED_FUNCTIONS KVS Exported Functions
+  @{
+*/
+
+/**
+ * @brief       Mount a key-value store
+ *
+ * @param[out]  psKvs       Store context
+ * @param[in]   u32Base     Page aligned flash address of the store, e.g. \ref FMC_ReadDataFlashBaseAddr
+ * @param[in]   u32Pages    Number of flash pages in the store, at least 2
+ *
+ * @retval      KVS_OK          Store mounted
+ * @retval      KVS_ERR_PARAM   Invalid store geometry
+ * @retval      KVS_ERR_FULL    The store has more than \ref KVS_MAX_KEYS keys. Extra keys are not accessible.
+ * @retval      KVS_ERR_FLASH   Flash program or erase failed
+ *
+ * @details     This function scans the store and builds the key index in psKvs. A blank store is formatted.
+ *              Records cut by a power failure are ignored and an interrupted page collection is completed.
+ *              FMC must be enabled by \ref FMC_Open with register write protection disabled, and APROM update
+ *              must be enabled by \ref FMC_EnableAPUpdate if the store is in APROM.
+ */
+int32_t KVS_Mount(KVS_T *psKvs, uint32_t u32Base, uint32_t u32Pages)
+{
+    uint32_t u32Seq, u32Min = KVS_ERASED, u32Max = 0, u32Newest = 0, u32End, i;
+    int32_t i32Ret = KVS_OK;
+
+    if((u32Base & (FMC_FLASH_PAGE_SIZE - 1)) || (u32Pages < 2))
+        return KVS_ERR_PARAM;
+
+    psKvs->u32Base = u32Base;
+    psKvs->u32Pages = u32Pages;
+    psKvs->u32Oldest = 0;
+    psKvs->u32Used = 0;
+    psKvs->u32Count = 0;
+
+    for(i = 0; i < u32Pages; i++)
+    {
+        if(KVS_ReadWord(KVS_PageAddr(psKvs, i)) != KVS_PAGE_MAGIC)
+            continue;
+
+        u32Seq = KVS_ReadWord(KVS_PageAddr(psKvs, i) + 4);
+        if(u32Seq == KVS_ERASED)
+            continue;
+
+        if(u32Seq < u32Min)
+        {
+            u32Min = u32Seq;
+            psKvs->u32Oldest = i;
+        }
+        if(u32Seq >= u32Max)
+        {
+            u32Max = u32Seq;
+            u32Newest = i;
+        }
+        psKvs->u32Used++;
+    }
+
+    if(psKvs->u32Used == 0)
+    {
+        psKvs->u32Seq = 0;
+        return KVS_Advance(psKvs);
+    }
+
+    /* Replay the pages from the oldest one so that later records override earlier ones */
+    psKvs->u32Used = (u32Newest + u32Pages - psKvs->u32Oldest) % u32Pages + 1;
+    psKvs->u32Seq = u32Max;
+    for(i = 0; i < psKvs->u32Used; i++)
+    {
+        u32End = KVS_Scan(psKvs, psKvs->u32Oldest + i, &i32Ret);
+        if(i == psKvs->u32Used - 1)
+            psKvs->u32WriteAddr = u32End;
+    }
+
+    /* Power failed before the oldest page was erased */
+    if(psKvs->u32Used == u32Pages)
+    {
+        if(KVS_Collect(psKvs) != KVS_OK)
+            return KVS_ERR_FLASH;
+    }
+
+    return i32Ret;
+}
+
+/**
+ * @brief       Read a value
+ *
+ * @param[in]   psKvs       Store context
+ * @param[in]   u32Key      Key
+ * @param[out]  pvBuf       Buffer to receive the value
+ * @param[in]   u32Size     Buffer size in bytes. A longer value is truncated.
+ *
+ * @return      Value size in bytes, or \ref KVS_ERR_NOT_FOUND if the key does not exist
+ *
+ * @details     This function looks up the key in the RAM index and reads the value from flash.
+ */
+int32_t KVS_Read(KVS_T *psKvs, uint32_t u32Key, void *pvBuf, uint32_t u32Size)
+{
+    uint8_t *pu8Buf = (uint8_t *)pvBuf;
+    uint32_t u32Addr, u32Len, u32Data = 0, i;
+    int32_t i32Idx = KVS_Find(psKvs, u32Key);
+
+    if(i32Idx < 0)
+        return KVS_ERR_NOT_FOUND;
+
+    u32Addr = psKvs->asEntry[i32Idx].u32Addr + 4;
+    u32Len = psKvs->asEntry[i32Idx].u16Len;
+    for(i = 0; (i < u32Len) && (i < u32Size); i++)
+    {
+        if((i & 3) == 0)
+            u32Data = KVS_ReadWord(u32Addr + i);
+        pu8Buf[i] = (uint8_t)(u32Data >> ((i & 3) * 8));
+    }
+
+    return (int32_t)u32Len;
+}
+
+/**
+ * @brief       Write a value
+ *
+ * @param[in]   psKvs       Store context
+ * @param[in]   u32Key      Key, 0x0000 ~ 0xFFFE
+ * @param[in]   pvData      Value
+ * @param[in]   u32Len      Value size in bytes, 0 ~ \ref KVS_MAX_VALUE_SIZE
+ *
+ * @retval      KVS_OK          Value written
+ * @retval      KVS_ERR_PARAM   Invalid key or size
+ * @retval      KVS_ERR_FULL    No room for the value or the key
+ * @retval      KVS_ERR_FLASH   Flash program or erase failed
+ *
+ * @details     This function appends a record holding the new value. Nothing is written if the value is not
+ *              changed. A flash page is erased only when the current page is full, and then the page is the
+ *              oldest one in the store.
+ */
+int32_t KVS_Write(KVS_T *psKvs, uint32_t u32Key, const void *pvData, uint32_t u32Len)
+{
+    const uint8_t *pu8Data = (const uint8_t *)pvData;
+    uint32_t u32Words = (u32Len + 3) / 4, u32Addr, i;
+    int32_t i32Idx, i32Ret;
+
+    if((u32Key >= KVS_KEY_INVALID) || (u32Len > KVS_MAX_VALUE_SIZE))
+        return KVS_ERR_PARAM;
+
+    i32Idx = KVS_Find(psKvs, u32Key);
+    if(i32Idx < 0)
+    {
+        if(psKvs->u32Count == KVS_MAX_KEYS)
+            return KVS_ERR_FULL;
+    }
+    else if(psKvs->asEntry[i32Idx].u16Len == u32Len)
+    {
+        u32Addr = psKvs->asEntry[i32Idx].u32Addr;
+        for(i = 0; i < u32Words; i++)
+        {
+            if(KVS_ReadWord(u32Addr + 4 + i * 4) != KVS_GetWord(pu8Data, 0, i, u32Len))
+                break;
+        }
+        if(i == u32Words)
+            return KVS_OK;
+    }
+
+    i32Ret = KVS_Reserve(psKvs, 8 + u32Words * 4);
+    if(i32Ret != KVS_OK)
+        return i32Ret;
+
+    u32Addr = psKvs->u32WriteAddr;
+    i32Ret = KVS_Append(psKvs, (u32Key << 16) | u32Len, pu8Data, 0);
+    if(i32Ret != KVS_OK)
+        return i32Ret;
+
+    return KVS_Index(psKvs, u32Key, u32Len, u32Addr);
+}
+
+/**
+ * @brief       Delete a key
+ *
+ * @param[in]   psKvs       Store context
+ * @param[in]   u32Key      Key
+ *
+ * @retval      KVS_OK              Key deleted
+ * @retval      KVS_ERR_NOT_FOUND   Key does not exist
+ * @retval      KVS_ERR_FULL        No room for the delete record
+ * @retval      KVS_ERR_FLASH       Flash program or erase failed
+ *
+ * @details     This function appends a delete record for the key and removes it from the index.
+ */
+int32_t KVS_Delete(KVS_T *psKvs, uint32_t u32Key)
+{
+    int32_t i32Ret;
+
+    if(KVS_Find(psKvs, u32Key) < 0)
+        return KVS_ERR_NOT_FOUND;
+
+    i32Ret = KVS_Reserve(psKvs, 8);
+    if(i32Ret != KVS_OK)
+        return i32Ret;
+
+    i32Ret = KVS_Append(psKvs, (u32Key << 16) | KVS_LEN_DELETED, NULL, 0);
+    if(i32Ret != KVS_OK)
+        return i32Ret;
+
+    return KVS_Index(psKvs, u32Key, KVS_LEN_DELETED, 0);
+}
+
+
+/*@}*/ /* end of group KVS_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group KVS_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+/*** (C) COPYRIGHT 2013 Nuvoton Technology Corp. ***/
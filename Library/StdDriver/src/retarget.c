@@ -277,59 +277,134 @@ void SendChar_ToUART(int ch)
 }
 
 #else
-/* Non-block implement of send char */
-# define BUF_SIZE    512
+/*
+    Non-block implement of send char.
+    SendChar_ToUART is the only producer of the ring buffer, so printf must not be called from interrupt handlers.
+    When the debug port IRQ is enabled in NVIC, the ring buffer is drained by THRE interrupt and the application
+    must call SendChar_IRQHandler() from the debug port IRQ handler (UART02_IRQHandler or UART1_IRQHandler).
+    Otherwise it is drained to the TX FIFO by following SendChar_ToUART calls, and SendChar_ToUART(0) flushes
+    what fits in the TX FIFO.
+*/
+# ifndef NONBLOCK_PRINTF_BUF_SIZE
+#  define NONBLOCK_PRINTF_BUF_SIZE    512
+# endif
+static uint8_t s_au8PrintfBuf[NONBLOCK_PRINTF_BUF_SIZE];
+static volatile uint32_t s_u32PrintfHead = 0;
+static volatile uint32_t s_u32PrintfTail = 0;
+static volatile uint32_t s_u32PrintfOverflow = 0;
+
+/* Move data from ring buffer to TX FIFO. The TX FIFO is checked before each byte unless it is known to be empty. */
+static void SendChar_Drain(uint32_t u32FifoEmpty)
+{
+    uint32_t u32Tail = s_u32PrintfTail;
+    uint32_t u32Head = s_u32PrintfHead;
+    uint32_t u32Cnt = (DEBUG_PORT == UART0) ? UART0_FIFO_SIZE : UART1_FIFO_SIZE;
+
+    while((u32Tail != u32Head) && u32Cnt--)
+    {
+        if(!u32FifoEmpty && (DEBUG_PORT->FSR & UART_FSR_TX_FULL_Msk))
+            break;
+
+        DEBUG_PORT->DATA = s_au8PrintfBuf[u32Tail];
+        if(++u32Tail == NONBLOCK_PRINTF_BUF_SIZE)
+            u32Tail = 0;
+    }
+    s_u32PrintfTail = u32Tail;
+}
+
 void SendChar_ToUART(int ch)
 {
-    static uint8_t u8Buf[BUF_SIZE] = {0};
-    static int32_t i32Head = 0;
-    static int32_t i32Tail = 0;
-    int32_t i32Tmp;
+    IRQn_Type eIRQn = (DEBUG_PORT == UART1) ? UART1_IRQn : UART02_IRQn;
+    uint32_t u32Head = s_u32PrintfHead;
+    uint32_t u32Tail = s_u32PrintfTail;
+    uint32_t u32Free;
 
-    /* Only flush the data in buffer to UART when ch == 0 */
     if(ch)
     {
-        if(ch == '\n')
+        u32Free = (u32Tail > u32Head) ? (u32Tail - u32Head - 1) : (NONBLOCK_PRINTF_BUF_SIZE - 1 - u32Head + u32Tail);
+
+        /* '\n' is sent as "\r\n"; drop both if there is no room for both */
+        if(u32Free < (uint32_t)(((char)ch == '\n') ? 2 : 1))
         {
-            i32Tmp = i32Head+1;
-            if(i32Tmp > BUF_SIZE) i32Tmp = 0;
-            if(i32Tmp != i32Tail)
+            s_u32PrintfOverflow++;
+        }
+        else
+        {
+            if((char)ch == '\n')
             {
-                u8Buf[i32Head] = '\r';
-                i32Head = i32Tmp;
+                s_au8PrintfBuf[u32Head] = '\r';
+                if(++u32Head == NONBLOCK_PRINTF_BUF_SIZE)
+                    u32Head = 0;
             }
-        }
 
-        // Push char
-        i32Tmp = i32Head+1;
-        if(i32Tmp > BUF_SIZE) i32Tmp = 0;
-        if(i32Tmp != i32Tail)
-        {
-            u8Buf[i32Head] = ch;
-            i32Head = i32Tmp;
-        }
+            s_au8PrintfBuf[u32Head] = (uint8_t)ch;
+            if(++u32Head == NONBLOCK_PRINTF_BUF_SIZE)
+                u32Head = 0;
 
+            /* Make the data visible before publishing the new head to the interrupt handler */
+            __DMB();
+            s_u32PrintfHead = u32Head;
+        }
     }
+
+    if(NVIC->ISER[0] & (1UL << (uint32_t)eIRQn))
+        DEBUG_PORT->IER |= UART_IER_THRE_IEN_Msk;
     else
+        SendChar_Drain(0);
+}
+
+/**
+ * @brief    Debug port TX interrupt service for non-block printf
+ *
+ * @param    None
+ *
+ * @returns  None
+ *
+ * @details  Refill TX FIFO from the printf ring buffer on THRE interrupt. THRE interrupt is disabled when the
+ *           ring buffer is empty. It must be called from the debug port IRQ handler.
+ */
+void SendChar_IRQHandler(void)
+{
+    if(DEBUG_PORT->ISR & UART_ISR_THRE_INT_Msk)
     {
-        if(i32Tail == i32Head)
-            return;
+        SendChar_Drain(1);
+        if(s_u32PrintfTail == s_u32PrintfHead)
+            DEBUG_PORT->IER &= ~UART_IER_THRE_IEN_Msk;
     }
+}
 
-    // pop char
-    do
-    {
-        i32Tmp = i32Tail + 1;
-        if(i32Tmp > BUF_SIZE) i32Tmp = 0;
+/**
+ * @brief    Flush non-block printf ring buffer
+ *
+ * @param    None
+ *
+ * @returns  None
+ *
+ * @details  Send all buffered characters by polling and wait until the debug port has finished transmitting.
+ *           It can be used with interrupts disabled, e.g. before entering power down or in a fault handler.
+ */
+void SendChar_Flush(void)
+{
+    DEBUG_PORT->IER &= ~UART_IER_THRE_IEN_Msk;
 
-        if((DEBUG_PORT->FSR & UART_FSR_TX_FULL_Msk) == 0)
-        {
-            DEBUG_PORT->DATA = u8Buf[i32Tail];
-            i32Tail = i32Tmp;
-        }
-        else
-            break; // FIFO full
-    } while(i32Tail != i32Head);
+    while(s_u32PrintfTail != s_u32PrintfHead)
+        SendChar_Drain(0);
+
+    while((DEBUG_PORT->FSR & UART_FSR_TE_FLAG_Msk) == 0) {}
+}
+
+/**
+ * @brief    Get the number of dropped characters of non-block printf
+ *
+ * @param    None
+ *
+ * @returns  Number of characters dropped because the ring buffer was full
+ *
+ * @details  A '\n' dropped together with its '\r' is counted once.
+ */
+uint32_t SendChar_GetOverflowCount(void)
+{
+    return s_u32PrintfOverflow;
 }
 #endif
 
@@ -516,6 +591,10 @@ int _write (int fd, char *ptr, int len)
 {
     int i = len;
 
+#ifdef NONBLOCK_PRINTF
+    while(i--)
+        SendChar_ToUART(*ptr++);
+#else
     while(i--) {
         if(*ptr == '\n') {
             while(DEBUG_PORT->FSR & UART_FSR_TX_FULL_Msk);
@@ -526,6 +605,7 @@ int _write (int fd, char *ptr, int len)
         DEBUG_PORT->DATA = *ptr++;
 
     }
+#endif
     return len;
 }
 
@@ -0,0 +1,261 @@
+/**************************************************************************//**
+ * @file     trace.c
+ * @version  V3.00
+ * @brief    M071R_M071S series tokenized trace driver source file
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2013 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include "NuMicro.h"
+
+/*
+    A trace record is
+        [length] [ID] [argument 1] ... [argument n]
+    length is the number of bytes after the length byte. ID is the format string address and each argument is
+    zigzag encoded; both are stored as little endian base-128 varints, so small values take one byte.
+    Each record is sent as a COBS frame ended by a 0x00 byte, which occurs nowhere else in the stream, so a
+    decoder that loses a byte resynchronizes at the next frame.
+    Records are written to the ring as a whole with interrupts masked, so trace macros can be used in
+    interrupt handlers. Records that do not fit are dropped and reported later by a TRACE_ID_DROPPED record.
+*/
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup TRACE_Driver TRACE Driver
+  @{
+*/
+
+static uint8_t *s_pu8TraceBuf = 0;
+static uint32_t s_u32TraceSize = 0;
+static volatile uint32_t s_u32TraceHead = 0;
+static volatile uint32_t s_u32TraceTail = 0;
+static uint32_t s_u32TracePending = 0;          /* Dropped records not reported yet */
+static volatile uint32_t s_u32TraceDropped = 0; /* Dropped records in total */
+
+static uint32_t TRACE_PutVarint(uint8_t *pu8Out, uint32_t u32Val)
+{
+    uint32_t u32Len = 0;
+
+    while(u32Val >= 0x80)
+    {
+        pu8Out[u32Len++] = (uint8_t)(u32Val | 0x80);
+        u32Val >>= 7;
+    }
+    pu8Out[u32Len++] = (uint8_t)u32Val;
+
+    return u32Len;
+}
+
+/* COBS encode a record shorter than 254 bytes and end the frame with 0x00 */
+static uint32_t TRACE_PutFrame(uint8_t *pu8Out, const uint8_t *pu8Rec, uint32_t u32Len)
+{
+    uint32_t u32Code = 0, u32Pos = 1, i;
+
+    for(i = 0; i < u32Len; i++)
+    {
+        if(pu8Rec[i] == 0)
+        {
+            /* Each zero is replaced by the distance to the next one */
+            pu8Out[u32Code] = (uint8_t)(u32Pos - u32Code);
+            u32Code = u32Pos++;
+        }
+        else
+            pu8Out[u32Pos++] = pu8Rec[i];
+    }
+    pu8Out[u32Code] = (uint8_t)(u32Pos - u32Code);
+    pu8Out[u32Pos++] = 0;
+
+    return u32Pos;
+}
+
+static uint32_t TRACE_PutRecord(uint8_t *pu8Out, uint32_t u32Id, uint32_t u32Argc, const uint32_t *pu32Argv)
+{
+    uint8_t au8Rec[TRACE_MAX_RECORD];
+    uint32_t u32Len, i;
+
+    u32Len = 1 + TRACE_PutVarint(&au8Rec[1], u32Id);
+    for(i = 0; i < u32Argc; i++)
+    {
+        /* Zigzag encoding keeps small negative values short too */
+        u32Len += TRACE_PutVarint(&au8Rec[u32Len], (pu32Argv[i] << 1) ^ ((pu32Argv[i] & 0x80000000UL) ? 0xFFFFFFFFUL : 0));
+    }
+    au8Rec[0] = (uint8_t)(u32Len - 1);
+
+    return TRACE_PutFrame(pu8Out, au8Rec, u32Len);
+}
+
+static void TRACE_Push(const uint8_t *pu8Data, uint32_t u32Len)
+{
+    uint32_t u32Head = s_u32TraceHead;
+
+    while(u32Len--)
+    {
+        s_pu8TraceBuf[u32Head] = *pu8Data++;
+        if(++u32Head == s_u32TraceSize)
+            u32Head = 0;
+    }
+    s_u32TraceHead = u32Head;
+}
+
+/** @addtogroup TRACE_EXPORTED_FUNCTIONS TRACE Exported Functions
+  @{
+*/
+
+/**
+ * @brief       Open trace
+ *
+ * @param[in]   pu8Buf      Ring buffer for trace records
+ * @param[in]   u32Size     Ring buffer size in bytes. One byte is reserved to tell a full ring from an empty one.
+ *
+ * @return      None
+ *
+ * @details     This function sets the ring buffer used by trace macros and clears the dropped record counters.
+ */
+void TRACE_Open(uint8_t *pu8Buf, uint32_t u32Size)
+{
+    s_pu8TraceBuf = pu8Buf;
+    s_u32TraceSize = u32Size;
+    s_u32TraceHead = 0;
+    s_u32TraceTail = 0;
+    s_u32TracePending = 0;
+    s_u32TraceDropped = 0;
+}
+
+/**
+ * @brief       Write a trace record
+ *
+ * @param[in]   pcFmt       Format string in trace_fmt section. Its address is the record ID.
+ * @param[in]   u32Argc     Number of arguments, 0 ~ 4
+ * @param[in]   u32Arg1     Argument 1
+ * @param[in]   u32Arg2     Argument 2
+ * @param[in]   u32Arg3     Argument 3
+ * @param[in]   u32Arg4     Argument 4
+ *
+ * @return      None
+ *
+ * @details     This function is called by TRACE0 ~ TRACE4 macros. The record is dropped if the ring buffer
+ *              does not have enough space or trace is not opened.
+ */
+void TRACE_Log(const char *pcFmt, uint32_t u32Argc, uint32_t u32Arg1, uint32_t u32Arg2, uint32_t u32Arg3, uint32_t u32Arg4)
+{
+    uint8_t au8Rec[TRACE_MAX_RECORD], au8Drop[TRACE_MAX_RECORD];
+    uint32_t au32Argv[TRACE_MAX_ARGS];
+    uint32_t u32RecLen, u32DropLen = 0, u32Free, u32PriMask;
+
+    if(s_u32TraceSize == 0)
+        return;
+
+    au32Argv[0] = u32Arg1;
+    au32Argv[1] = u32Arg2;
+    au32Argv[2] = u32Arg3;
+    au32Argv[3] = u32Arg4;
+    u32RecLen = TRACE_PutRecord(au8Rec, (uint32_t)pcFmt, (u32Argc > TRACE_MAX_ARGS) ? TRACE_MAX_ARGS : u32Argc, au32Argv);
+
+    u32PriMask = __get_PRIMASK();
+    __disable_irq();
+
+    if(s_u32TracePending)
+        u32DropLen = TRACE_PutRecord(au8Drop, TRACE_ID_DROPPED, 1, &s_u32TracePending);
+
+    u32Free = (s_u32TraceTail > s_u32TraceHead) ? (s_u32TraceTail - s_u32TraceHead - 1) :
+              (s_u32TraceSize - 1 - s_u32TraceHead + s_u32TraceTail);
+
+    if(u32Free >= u32DropLen + u32RecLen)
+    {
+        if(u32DropLen)
+        {
+            TRACE_Push(au8Drop, u32DropLen);
+            s_u32TracePending = 0;
+        }
+        TRACE_Push(au8Rec, u32RecLen);
+    }
+    else
+    {
+        s_u32TracePending++;
+        s_u32TraceDropped++;
+    }
+
+    __set_PRIMASK(u32PriMask);
+}
+
+/**
+ * @brief       Read trace data
+ *
+ * @param[out]  pu8Buf      Buffer to receive the trace data
+ * @param[in]   u32Len      Maximum number of bytes to read
+ *
+ * @return      Number of bytes copied to pu8Buf
+ *
+ * @details     This function moves trace data out of the ring buffer so that it can be sent through any
+ *              transport, e.g. \ref UART_BufWrite or a USB endpoint. It must be called from one context only.
+ */
+uint32_t TRACE_Read(uint8_t *pu8Buf, uint32_t u32Len)
+{
+    uint32_t u32Head = s_u32TraceHead;
+    uint32_t u32Tail = s_u32TraceTail;
+    uint32_t u32Count = 0;
+
+    while((u32Count != u32Len) && (u32Tail != u32Head))
+    {
+        pu8Buf[u32Count++] = s_pu8TraceBuf[u32Tail];
+        if(++u32Tail == s_u32TraceSize)
+            u32Tail = 0;
+    }
+    s_u32TraceTail = u32Tail;
+
+    return u32Count;
+}
+
+/**
+ * @brief       Send trace data to UART
+ *
+ * @param[in]   uart    The pointer of the specified UART module
+ *
+ * @return      Number of bytes written to UART TX FIFO
+ *
+ * @details     This function moves trace data to UART TX FIFO until the FIFO is full or the ring buffer is empty.
+ *              It does not wait and is meant to be called from the main loop or a periodic interrupt.
+ */
+uint32_t TRACE_Drain(UART_T *uart)
+{
+    uint32_t u32Head = s_u32TraceHead;
+    uint32_t u32Tail = s_u32TraceTail;
+    uint32_t u32Count = 0;
+
+    while((u32Tail != u32Head) && ((uart->FSR & UART_FSR_TX_FULL_Msk) == 0))
+    {
+        uart->DATA = s_pu8TraceBuf[u32Tail];
+        if(++u32Tail == s_u32TraceSize)
+            u32Tail = 0;
+        u32Count++;
+    }
+    s_u32TraceTail = u32Tail;
+
+    return u32Count;
+}
+
+/**
+ * @brief       Get dropped record count
+ *
+ * @param       None
+ *
+ * @return      Number of records dropped because the ring buffer was full
+ *
+ * @details     This function returns the total number of dropped records since \ref TRACE_Open.
+ */
+uint32_t TRACE_GetDroppedCount(void)
+{
+    return s_u32TraceDropped;
+}
+
+
+/*@}*/ /* end of group TRACE_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group TRACE_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+/*** (C) COPYRIGHT 2013 Nuvoton Technology Corp. ***/
@@ -23,6 +23,79 @@
   @{
 */
 
+/**
+ *    @brief        Calculate UART baud rate setting
+ *
+ *    @param[in]    u32ClkFreq      UART clock frequency in Hz, after UART clock divider.
+ *    @param[in]    u32Baudrate     The requested baud rate.
+ *    @param[out]   pi32ErrPpm      The baud rate error of the returned setting in ppm, positive if faster. It can be NULL.
+ *
+ *    @return       UA_BAUD register value, or \ref UART_BAUD_INVALID if the baud rate cannot be generated.
+ *
+ *    @details      The function evaluates mode 2 (M = 1), mode 1 (M = 9 ~ 16) and mode 0 (M = 16) of
+ *                  Baud Rate = Clock / [M * (BRD + 2)] and returns the setting closest to the requested baud rate.
+ *                  Mode 2 is preferred when several settings give the same error. Settings with BRD below
+ *                  \ref UART_BAUD_BRD_MIN are skipped. It uses 32-bit arithmetic only, so u32ClkFreq must not
+ *                  exceed 268 MHz.
+ */
+uint32_t UART_CalcBaudSetting(uint32_t u32ClkFreq, uint32_t u32Baudrate, int32_t *pi32ErrPpm)
+{
+    uint32_t u32M, u32Div, u32Rate, u32Err, u32Best = UART_BAUD_INVALID, u32BestErr = 0, u32BestRate = 0;
+    int32_t i32Sign;
+
+    /* The divider is at least 2, so a faster baud rate cannot be generated. This also keeps the products below
+       within 32 bits for clocks up to 268 MHz. */
+    if((u32Baudrate == 0) || (u32Baudrate > u32ClkFreq))
+    {
+        if(pi32ErrPpm)
+            *pi32ErrPpm = UART_BAUD_ERR_INVALID;
+        return UART_BAUD_INVALID;
+    }
+
+    /* M = 1 is mode 2; M = 9 ~ 16 is mode 1, where M = 16 is the same divider as mode 0 */
+    for(u32M = 1; u32M <= 16; u32M = (u32M == 1) ? 9 : (u32M + 1))
+    {
+        u32Div = (u32ClkFreq + u32Baudrate * u32M / 2) / (u32Baudrate * u32M);
+        if((u32Div < UART_BAUD_BRD_MIN + 2) || (u32Div > 0xFFFF + 2))
+            continue;
+
+        u32Rate = u32Baudrate * u32M * u32Div;
+        u32Err = (u32ClkFreq > u32Rate) ? (u32ClkFreq - u32Rate) : (u32Rate - u32ClkFreq);
+        if((u32Best == UART_BAUD_INVALID) || (u32Err < u32BestErr))
+        {
+            u32BestErr = u32Err;
+            u32BestRate = u32Rate;
+            if(u32M == 1)
+                u32Best = UART_BAUD_MODE2 | (u32Div - 2);
+            else if(u32M == 16)
+                u32Best = UART_BAUD_MODE0 | (u32Div - 2);
+            else
+                u32Best = UART_BAUD_MODE1(u32M) | (u32Div - 2);
+        }
+    }
+
+    if(pi32ErrPpm)
+    {
+        if(u32Best == UART_BAUD_INVALID)
+            *pi32ErrPpm = UART_BAUD_ERR_INVALID;
+        else
+        {
+            /* (actual - requested) / requested = (clock - baud * M * div) / (baud * M * div). Both terms are
+               scaled down until the error times 1000000 fits in 32 bits. */
+            i32Sign = (u32ClkFreq >= u32BestRate) ? 1 : -1;
+            while(u32BestErr > 0xFFFFFFFFUL / 1000000)
+            {
+                u32BestErr >>= 1;
+                u32BestRate >>= 1;
+            }
+            *pi32ErrPpm = i32Sign * (int32_t)(u32BestErr * 1000000 / u32BestRate);
+        }
+    }
+
+    return u32Best;
+}
+
+
 /**
  *    @brief        Clear UART specified interrupt flag
  *
@@ -195,16 +268,6 @@ void UART_EnableInt(UART_T*  uart, uint32_t u32InterruptFlag)
  */
 void UART_Open(UART_T* uart, uint32_t u32baudrate)
 {
-    uint8_t u8UartClkSrcSel, u8UartClkDivNum;
-    uint32_t au32ClkTbl[4] = {__HXT, 0, 0, __HIRC};
-    uint32_t u32Baud_Div = 0;
-
-    /* Get UART clock source selection */
-    u8UartClkSrcSel = (CLK->CLKSEL1 & CLK_CLKSEL1_UART_S_Msk) >> CLK_CLKSEL1_UART_S_Pos;
-
-    /* Get UART clock divider number */
-    u8UartClkDivNum = (CLK->CLKDIV & CLK_CLKDIV_UART_N_Msk) >> CLK_CLKDIV_UART_N_Pos;
-
     /* Select UART function */
     uart->FUN_SEL = UART_FUNC_SEL_UART;
 
@@ -214,20 +277,9 @@ void UART_Open(UART_T* uart, uint32_t u32baudrate)
     /* Set UART Rx and RTS trigger level */
     uart->FCR &= ~(UART_FCR_RFITL_Msk | UART_FCR_RTS_TRI_LEV_Msk);
 
-    /* Get PLL clock frequency if UART clock source selection is PLL */
-    if(u8UartClkSrcSel == 1)
-        au32ClkTbl[u8UartClkSrcSel] = CLK_GetPLLClockFreq();
-
     /* Set UART baud rate */
     if(u32baudrate != 0)
-    {
-        u32Baud_Div = UART_BAUD_MODE2_DIVIDER((au32ClkTbl[u8UartClkSrcSel]) / (u8UartClkDivNum + 1), u32baudrate);
-
-        if(u32Baud_Div > 0xFFFF)
-            uart->BAUD = (UART_BAUD_MODE0 | UART_BAUD_MODE0_DIVIDER((au32ClkTbl[u8UartClkSrcSel]) / (u8UartClkDivNum + 1), u32baudrate));
-        else
-            uart->BAUD = (UART_BAUD_MODE2 | u32Baud_Div);
-    }
+        UART_SetBaudRate(uart, u32baudrate);
 }
 
 
@@ -264,6 +316,75 @@ uint32_t UART_Read(UART_T* uart, uint8_t *pu8RxBuf, uint32_t u32ReadBytes)
 }
 
 
+/**
+ *    @brief        Set UART baud rate
+ *
+ *    @param[in]    uart            The pointer of the specified UART module.
+ *    @param[in]    u32Baudrate     The requested baud rate.
+ *
+ *    @return       Baud rate error in ppm, positive if faster, or \ref UART_BAUD_ERR_INVALID if the baud rate is not set.
+ *
+ *    @details      The function sets UA_BAUD to the setting given by \ref UART_CalcBaudSetting for the current UART
+ *                  clock. The last \ref UART_BAUD_CACHE_SIZE results are cached together with the UART clock
+ *                  configuration, so switching between known baud rates does not divide or read PLL settings again.
+ */
+int32_t UART_SetBaudRate(UART_T* uart, uint32_t u32Baudrate)
+{
+    static struct
+    {
+        uint32_t u32ClkSel;
+        uint32_t u32ClkDiv;
+        uint32_t u32PllCon;
+        uint32_t u32Baudrate;
+        uint32_t u32Baud;
+        int32_t i32ErrPpm;
+    } s_asCache[UART_BAUD_CACHE_SIZE];
+    static uint32_t s_u32Next = 0;
+
+    uint32_t au32ClkTbl[4] = {__HXT, 0, 0, __HIRC};
+    uint32_t u32ClkSel, u32ClkDiv, u32PllCon, u32Baud, i;
+    int32_t i32ErrPpm;
+
+    if(u32Baudrate == 0)
+        return UART_BAUD_ERR_INVALID;
+
+    u32ClkSel = (CLK->CLKSEL1 & CLK_CLKSEL1_UART_S_Msk) >> CLK_CLKSEL1_UART_S_Pos;
+    u32ClkDiv = (CLK->CLKDIV & CLK_CLKDIV_UART_N_Msk) >> CLK_CLKDIV_UART_N_Pos;
+    u32PllCon = (u32ClkSel == 1) ? CLK->PLLCON : 0;
+
+    for(i = 0; i < UART_BAUD_CACHE_SIZE; i++)
+    {
+        if((s_asCache[i].u32Baudrate == u32Baudrate) && (s_asCache[i].u32ClkSel == u32ClkSel) &&
+                (s_asCache[i].u32ClkDiv == u32ClkDiv) && (s_asCache[i].u32PllCon == u32PllCon))
+        {
+            uart->BAUD = s_asCache[i].u32Baud;
+            return s_asCache[i].i32ErrPpm;
+        }
+    }
+
+    /* Get PLL clock frequency if UART clock source selection is PLL */
+    if(u32ClkSel == 1)
+        au32ClkTbl[u32ClkSel] = CLK_GetPLLClockFreq();
+
+    u32Baud = UART_CalcBaudSetting(au32ClkTbl[u32ClkSel] / (u32ClkDiv + 1), u32Baudrate, &i32ErrPpm);
+    if(u32Baud == UART_BAUD_INVALID)
+        return UART_BAUD_ERR_INVALID;
+
+    s_asCache[s_u32Next].u32ClkSel = u32ClkSel;
+    s_asCache[s_u32Next].u32ClkDiv = u32ClkDiv;
+    s_asCache[s_u32Next].u32PllCon = u32PllCon;
+    s_asCache[s_u32Next].u32Baudrate = u32Baudrate;
+    s_asCache[s_u32Next].u32Baud = u32Baud;
+    s_asCache[s_u32Next].i32ErrPpm = i32ErrPpm;
+    if(++s_u32Next == UART_BAUD_CACHE_SIZE)
+        s_u32Next = 0;
+
+    uart->BAUD = u32Baud;
+
+    return i32ErrPpm;
+}
+
+
 /**
  *    @brief        Set UART line configuration
  *
@@ -292,30 +413,9 @@ uint32_t UART_Read(UART_T* uart, uint8_t *pu8RxBuf, uint32_t u32ReadBytes)
  */
 void UART_SetLine_Config(UART_T* uart, uint32_t u32baudrate, uint32_t u32data_width, uint32_t u32parity, uint32_t  u32stop_bits)
 {
-    uint8_t u8UartClkSrcSel, u8UartClkDivNum;
-    uint32_t au32ClkTbl[4] = {__HXT, 0, 0, __HIRC};
-    uint32_t u32Baud_Div = 0;
-
-    /* Get UART clock source selection */
-    u8UartClkSrcSel = (CLK->CLKSEL1 & CLK_CLKSEL1_UART_S_Msk) >> CLK_CLKSEL1_UART_S_Pos;
-
-    /* Get UART clock divider number */
-    u8UartClkDivNum = (CLK->CLKDIV & CLK_CLKDIV_UART_N_Msk) >> CLK_CLKDIV_UART_N_Pos;
-
-    /* Get PLL clock frequency if UART clock source selection is PLL */
-    if(u8UartClkSrcSel == 1)
-        au32ClkTbl[u8UartClkSrcSel] = CLK_GetPLLClockFreq();
-
     /* Set UART baud rate */
     if(u32baudrate != 0)
-    {
-        u32Baud_Div = UART_BAUD_MODE2_DIVIDER((au32ClkTbl[u8UartClkSrcSel]) / (u8UartClkDivNum + 1), u32baudrate);
-
-        if(u32Baud_Div > 0xFFFF)
-            uart->BAUD = (UART_BAUD_MODE0 | UART_BAUD_MODE0_DIVIDER((au32ClkTbl[u8UartClkSrcSel]) / (u8UartClkDivNum + 1), u32baudrate));
-        else
-            uart->BAUD = (UART_BAUD_MODE2 | u32Baud_Div);
-    }
+        UART_SetBaudRate(uart, u32baudrate);
 
     /* Set UART line configuration */
     uart->LCR = u32data_width | u32parity | u32stop_bits;
@@ -478,6 +578,615 @@ uint32_t UART_Write(UART_T* uart, uint8_t *pu8TxBuf, uint32_t u32WriteBytes)
 }
 
 
+/**
+ *    @brief        Close UART buffered transfer
+ *
+ *    @param[in]    psBuf   The pointer of the UART buffered transfer context.
+ *
+ *    @return       None
+ *
+ *    @details      The function disables the UART interrupts used by the buffered transfer. The NVIC UART IRQ is left
+ *                  enabled, as UART0 and UART2 share one IRQ. Data still pending in the TX ring is discarded.
+ */
+void UART_BufClose(UART_BUF_T *psBuf)
+{
+    UART_DISABLE_INT(psBuf->uart, (UART_IER_RDA_IEN_Msk | UART_IER_THRE_IEN_Msk | UART_IER_RLS_IEN_Msk |
+                                   UART_IER_TOUT_IEN_Msk | UART_IER_BUF_ERR_IEN_Msk));
+    psBuf->u32TxTail = psBuf->u32TxHead;
+}
+
+
+/**
+ *    @brief        Get the number of bytes in RX ring
+ *
+ *    @param[in]    psBuf   The pointer of the UART buffered transfer context.
+ *
+ *    @return       Number of received bytes waiting to be read by \ref UART_BufRead
+ *
+ *    @details      The function is used to get the number of bytes received but not read yet.
+ */
+uint32_t UART_BufGetRxCount(UART_BUF_T *psBuf)
+{
+    uint32_t u32Head = psBuf->u32RxHead;
+    uint32_t u32Tail = psBuf->u32RxTail;
+
+    return (u32Head >= u32Tail) ? (u32Head - u32Tail) : (psBuf->u32RxSize - u32Tail + u32Head);
+}
+
+
+/**
+ *    @brief        Get the number of bytes in TX ring
+ *
+ *    @param[in]    psBuf   The pointer of the UART buffered transfer context.
+ *
+ *    @return       Number of bytes written by \ref UART_BufWrite and not moved to TX FIFO yet
+ *
+ *    @details      The function is used to get the number of bytes waiting to be transmitted.
+ *                  The TX FIFO may still hold data when it returns 0; check \ref UART_IS_TX_EMPTY for line idle.
+ */
+uint32_t UART_BufGetTxCount(UART_BUF_T *psBuf)
+{
+    uint32_t u32Head = psBuf->u32TxHead;
+    uint32_t u32Tail = psBuf->u32TxTail;
+
+    return (u32Head >= u32Tail) ? (u32Head - u32Tail) : (psBuf->u32TxSize - u32Tail + u32Head);
+}
+
+
+/**
+ *    @brief        UART buffered transfer interrupt service
+ *
+ *    @param[in]    psBuf   The pointer of the UART buffered transfer context.
+ *
+ *    @return       None
+ *
+ *    @details      The function must be called from UART02_IRQHandler or UART1_IRQHandler of the application.
+ *                  It moves the RX FIFO content to RX ring on RDA or RX time-out interrupt, refills TX FIFO from
+ *                  TX ring on THRE interrupt and records line status errors in u32LineStatus.
+ *                  UART0 and UART2 share one IRQ, so UART02_IRQHandler may call it for two contexts.
+ */
+void UART_BufIRQHandler(UART_BUF_T *psBuf)
+{
+    UART_T *uart = psBuf->uart;
+    uint32_t u32Fsr, u32Count, u32Head, u32Next, u32Tail;
+    uint32_t u32FifoSize = (uart == UART0) ? UART0_FIFO_SIZE : UART1_FIFO_SIZE;
+
+    u32Fsr = uart->FSR;
+
+    /* Record and clear RX line status and buffer error flags */
+    if(u32Fsr & (UART_FSR_BIF_Msk | UART_FSR_FEF_Msk | UART_FSR_PEF_Msk | UART_FSR_RX_OVER_IF_Msk))
+    {
+        psBuf->u32LineStatus |= u32Fsr & (UART_FSR_BIF_Msk | UART_FSR_FEF_Msk | UART_FSR_PEF_Msk | UART_FSR_RX_OVER_IF_Msk);
+        uart->FSR = (UART_FSR_BIF_Msk | UART_FSR_FEF_Msk | UART_FSR_PEF_Msk | UART_FSR_RX_OVER_IF_Msk);
+    }
+
+    /* Drain RX FIFO. The FIFO level is taken from the FSR snapshot so RX_EMPTY is not polled per byte. */
+    if((u32Fsr & UART_FSR_RX_EMPTY_Msk) == 0)
+    {
+        if(u32Fsr & UART_FSR_RX_FULL_Msk)
+            u32Count = u32FifoSize;
+        else
+            u32Count = (u32Fsr & UART_FSR_RX_POINTER_Msk) >> UART_FSR_RX_POINTER_Pos;
+
+        u32Head = psBuf->u32RxHead;
+        while(u32Count--)
+        {
+            u32Next = u32Head + 1;
+            if(u32Next == psBuf->u32RxSize)
+                u32Next = 0;
+
+            if(u32Next == psBuf->u32RxTail)
+            {
+                /* RX ring full, drop the byte */
+                (void)uart->RBR;
+                psBuf->u32RxOverflow++;
+            }
+            else
+            {
+                psBuf->pu8RxBuf[u32Head] = (uint8_t)uart->RBR;
+                u32Head = u32Next;
+            }
+        }
+        __DMB();
+        psBuf->u32RxHead = u32Head;
+    }
+
+    /* Refill TX FIFO. THRE means TX FIFO is empty, so up to a whole FIFO can be written without checking TX_FULL. */
+    if(uart->ISR & UART_ISR_THRE_INT_Msk)
+    {
+        u32Tail = psBuf->u32TxTail;
+        u32Head = psBuf->u32TxHead;
+        while((u32Tail != u32Head) && u32FifoSize--)
+        {
+            uart->THR = psBuf->pu8TxBuf[u32Tail];
+            if(++u32Tail == psBuf->u32TxSize)
+                u32Tail = 0;
+        }
+        psBuf->u32TxTail = u32Tail;
+
+        if(u32Tail == u32Head)
+            UART_DISABLE_INT(uart, UART_IER_THRE_IEN_Msk);
+    }
+}
+
+
+/**
+ *    @brief        Open UART buffered transfer
+ *
+ *    @param[in]    psBuf       The pointer of the UART buffered transfer context.
+ *    @param[in]    uart        The pointer of the specified UART module.
+ *    @param[in]    pu8RxBuf    The RX ring storage.
+ *    @param[in]    u32RxSize   The RX ring size in bytes. It must be 2 or larger.
+ *    @param[in]    pu8TxBuf    The TX ring storage.
+ *    @param[in]    u32TxSize   The TX ring size in bytes. It must be 2 or larger.
+ *
+ *    @return       None
+ *
+ *    @details      The function initializes the rings, sets RX FIFO trigger level and RX time-out counter and enables
+ *                  RDA, RX time-out, RX line status and buffer error interrupts and NVIC UART IRQ.
+ *                  UART must be opened by \ref UART_Open before. One byte of each ring is reserved.
+ */
+void UART_BufOpen(UART_BUF_T *psBuf, UART_T *uart, uint8_t *pu8RxBuf, uint32_t u32RxSize, uint8_t *pu8TxBuf, uint32_t u32TxSize)
+{
+    psBuf->uart = uart;
+    psBuf->pu8RxBuf = pu8RxBuf;
+    psBuf->u32RxSize = u32RxSize;
+    psBuf->u32RxHead = 0;
+    psBuf->u32RxTail = 0;
+    psBuf->pu8TxBuf = pu8TxBuf;
+    psBuf->u32TxSize = u32TxSize;
+    psBuf->u32TxHead = 0;
+    psBuf->u32TxTail = 0;
+    psBuf->u32RxOverflow = 0;
+    psBuf->u32LineStatus = 0;
+
+    /* Set RX FIFO trigger level and RX time-out so that short bursts are still delivered */
+    uart->FCR = (uart->FCR & ~UART_FCR_RFITL_Msk) | UART_BUF_RX_TRIGGER;
+    UART_SetTimeoutCnt(uart, UART_BUF_RX_TIMEOUT);
+
+    UART_EnableInt(uart, (UART_IER_RDA_IEN_Msk | UART_IER_RLS_IEN_Msk | UART_IER_TOUT_IEN_Msk | UART_IER_BUF_ERR_IEN_Msk));
+}
+
+
+/**
+ *    @brief        Read data from RX ring
+ *
+ *    @param[in]    psBuf           The pointer of the UART buffered transfer context.
+ *    @param[out]   pu8RxBuf        The buffer to receive the data.
+ *    @param[in]    u32ReadBytes    The maximum number of bytes to read.
+ *
+ *    @return       Number of bytes copied to pu8RxBuf
+ *
+ *    @details      The function copies the received data and returns immediately. It does not wait for data.
+ */
+uint32_t UART_BufRead(UART_BUF_T *psBuf, uint8_t *pu8RxBuf, uint32_t u32ReadBytes)
+{
+    uint32_t u32Count = 0;
+    uint32_t u32Head = psBuf->u32RxHead;
+    uint32_t u32Tail = psBuf->u32RxTail;
+
+    while((u32Count != u32ReadBytes) && (u32Tail != u32Head))
+    {
+        pu8RxBuf[u32Count++] = psBuf->pu8RxBuf[u32Tail];
+        if(++u32Tail == psBuf->u32RxSize)
+            u32Tail = 0;
+    }
+    psBuf->u32RxTail = u32Tail;
+
+    return u32Count;
+}
+
+
+/**
+ *    @brief        Write data to TX ring
+ *
+ *    @param[in]    psBuf           The pointer of the UART buffered transfer context.
+ *    @param[in]    pu8TxBuf        The data to transmit.
+ *    @param[in]    u32WriteBytes   The number of bytes to transmit.
+ *
+ *    @return       Number of bytes queued. It is less than u32WriteBytes when TX ring is full.
+ *
+ *    @details      The function queues the data, enables THRE interrupt and returns immediately.
+ */
+uint32_t UART_BufWrite(UART_BUF_T *psBuf, uint8_t *pu8TxBuf, uint32_t u32WriteBytes)
+{
+    uint32_t u32Count = 0;
+    uint32_t u32Head = psBuf->u32TxHead;
+    uint32_t u32Tail = psBuf->u32TxTail;
+    uint32_t u32Next;
+
+    while(u32Count != u32WriteBytes)
+    {
+        u32Next = u32Head + 1;
+        if(u32Next == psBuf->u32TxSize)
+            u32Next = 0;
+        if(u32Next == u32Tail)
+            break;
+
+        psBuf->pu8TxBuf[u32Head] = pu8TxBuf[u32Count++];
+        u32Head = u32Next;
+    }
+
+    if(u32Count)
+    {
+        /* Make the data visible before publishing the new head to the interrupt handler */
+        __DMB();
+        psBuf->u32TxHead = u32Head;
+        UART_ENABLE_INT(psBuf->uart, UART_IER_THRE_IEN_Msk);
+    }
+
+    return u32Count;
+}
+
+
+/**
+ *    @brief        Get UART circular PDMA receive write position
+ *
+ *    @param[in]    psRx        The pointer of the UART circular PDMA receive context.
+ *    @param[out]   pu32Offset  The buffer offset of the returned position. It can be NULL.
+ *
+ *    @return       Free running position of the next byte PDMA will write
+ *
+ *    @details      The position is taken from the PDMA current byte count, so no received byte is touched by CPU.
+ */
+static uint32_t UART_DmaRxWritePos(UART_DMA_RX_T *psRx, uint32_t *pu32Offset)
+{
+    PDMA_T *pdma = (PDMA_T *)((uint32_t) PDMA0_BASE + (0x100 * psRx->u32Ch));
+    uint32_t u32Base, u32Remain;
+
+    /* Retry if the block done interrupt moved the base in between */
+    do
+    {
+        u32Base = psRx->u32BasePos;
+        u32Remain = pdma->CBCR & PDMA_CBCR_CBCR_Msk;
+    }
+    while(u32Base != psRx->u32BasePos);
+
+    /* Remain is 0 between block done and re-arm, which is offset 0 of the next lap */
+    if(pu32Offset)
+        *pu32Offset = (u32Remain == 0) ? 0 : (psRx->u32Size - u32Remain);
+
+    return u32Base + (psRx->u32Size - u32Remain);
+}
+
+
+/**
+ *    @brief        Close UART circular PDMA receive
+ *
+ *    @param[in]    psRx    The pointer of the UART circular PDMA receive context.
+ *
+ *    @return       None
+ *
+ *    @details      The function disables UART RX PDMA request and stops the PDMA channel.
+ */
+void UART_DmaRxClose(UART_DMA_RX_T *psRx)
+{
+    psRx->uart->IER &= ~UART_IER_DMA_RX_EN_Msk;
+    PDMA_DisableInt(psRx->u32Ch, PDMA_IER_BLKD_IE_Msk);
+    PDMA_STOP(psRx->u32Ch);
+}
+
+
+/**
+ *    @brief        Get unread data count of UART circular PDMA receive buffer
+ *
+ *    @param[in]    psRx    The pointer of the UART circular PDMA receive context.
+ *
+ *    @return       Number of bytes \ref UART_DmaRxRead can return now, at most the buffer size
+ *
+ *    @details      The count reaching the buffer size means PDMA is about to overwrite unread data.
+ */
+uint32_t UART_DmaRxGetCount(UART_DMA_RX_T *psRx)
+{
+    uint32_t u32Avail = UART_DmaRxWritePos(psRx, NULL) - psRx->u32ReadPos;
+
+    return (u32Avail > psRx->u32Size) ? psRx->u32Size : u32Avail;
+}
+
+
+/**
+ *    @brief        UART circular PDMA receive interrupt service
+ *
+ *    @param[in]    psRx    The pointer of the UART circular PDMA receive context.
+ *
+ *    @return       None
+ *
+ *    @details      The function must be called from PDMA_IRQHandler of the application. On block transfer done it
+ *                  re-arms the channel at the start of the buffer. Bytes received meanwhile wait in the UART RX FIFO.
+ */
+void UART_DmaRxIRQHandler(UART_DMA_RX_T *psRx)
+{
+    if((PDMA_GET_CH_INT_STS(psRx->u32Ch) & PDMA_ISR_BLKD_IF_Msk) == 0)
+        return;
+
+    PDMA_CLR_CH_INT_FLAG(psRx->u32Ch, PDMA_ISR_BLKD_IF_Msk);
+    PDMA_Trigger(psRx->u32Ch);
+    psRx->u32BasePos += psRx->u32Size;
+}
+
+
+/**
+ *    @brief        Open UART circular PDMA receive
+ *
+ *    @param[in]    psRx        The pointer of the UART circular PDMA receive context.
+ *    @param[in]    uart        The pointer of the specified UART module. Valid values are UART0 and UART1.
+ *    @param[in]    u32Ch       The PDMA channel used for receive.
+ *    @param[in]    pu8Buf      The circular receive buffer.
+ *    @param[in]    u32Size     The circular receive buffer size in bytes. It must be 1 ~ 65535.
+ *
+ *    @return       None
+ *
+ *    @details      The function connects the PDMA channel to UART RX, enables PDMA block transfer done interrupt,
+ *                  NVIC PDMA IRQ and UART RX PDMA request, and starts receiving.
+ *                  UART must be opened by \ref UART_Open and PDMA clock must be enabled before.
+ */
+void UART_DmaRxOpen(UART_DMA_RX_T *psRx, UART_T *uart, uint32_t u32Ch, uint8_t *pu8Buf, uint32_t u32Size)
+{
+    psRx->uart = uart;
+    psRx->u32Ch = u32Ch;
+    psRx->pu8Buf = pu8Buf;
+    psRx->u32Size = u32Size;
+    psRx->u32BasePos = 0;
+    psRx->u32ReadPos = 0;
+    psRx->u32ReadIdx = 0;
+    psRx->u32PollPos = 0;
+    psRx->u32FramePos = 0;
+    psRx->u32Overrun = 0;
+
+    PDMA_Open(1 << u32Ch);
+    PDMA_SetTransferMode(u32Ch, (uart == UART0) ? PDMA_UART0_RX : PDMA_UART1_RX, 0, 0);
+    PDMA_SetTransferAddr(u32Ch, (uint32_t)&uart->RBR, PDMA_SAR_FIX, (uint32_t)pu8Buf, PDMA_DAR_INC);
+    PDMA_SetTransferCnt(u32Ch, PDMA_WIDTH_8, u32Size);
+    PDMA_EnableInt(u32Ch, PDMA_IER_BLKD_IE_Msk);
+    NVIC_EnableIRQ(PDMA_IRQn);
+    PDMA_Trigger(u32Ch);
+
+    uart->IER |= UART_IER_DMA_RX_EN_Msk;
+}
+
+
+/**
+ *    @brief        Check UART circular PDMA receive for a finished frame
+ *
+ *    @param[in]    psRx        The pointer of the UART circular PDMA receive context.
+ *    @param[out]   pu32End     The buffer offset where the frame ended. It can be NULL.
+ *
+ *    @return       Length of the finished frame in bytes, or 0 if no frame finished since the last call
+ *
+ *    @details      A frame is finished when the PDMA write position did not move since the previous call and new
+ *                  data arrived after the last reported frame. Call it periodically, e.g. from a timer interrupt,
+ *                  with a period of the required idle gap (at least 2 character times).
+ *                  RX time-out of UART cannot be used for this because it only counts while data stays in RX FIFO,
+ *                  which never happens while PDMA drains the FIFO.
+ */
+uint32_t UART_DmaRxPollFrame(UART_DMA_RX_T *psRx, uint32_t *pu32End)
+{
+    uint32_t u32Offset;
+    uint32_t u32Pos = UART_DmaRxWritePos(psRx, &u32Offset);
+    uint32_t u32Len;
+
+    if((u32Pos != psRx->u32PollPos) || (u32Pos == psRx->u32FramePos))
+    {
+        psRx->u32PollPos = u32Pos;
+        return 0;
+    }
+
+    u32Len = u32Pos - psRx->u32FramePos;
+    psRx->u32FramePos = u32Pos;
+
+    if(pu32End)
+        *pu32End = u32Offset;
+
+    return u32Len;
+}
+
+
+/**
+ *    @brief        Read data from UART circular PDMA receive buffer
+ *
+ *    @param[in]    psRx            The pointer of the UART circular PDMA receive context.
+ *    @param[out]   pu8RxBuf        The buffer to receive the data.
+ *    @param[in]    u32ReadBytes    The maximum number of bytes to read.
+ *
+ *    @return       Number of bytes copied to pu8RxBuf
+ *
+ *    @details      The function copies the received data and returns immediately. If PDMA has overwritten data
+ *                  that was not read yet, the oldest surviving data is returned and u32Overrun is increased.
+ */
+uint32_t UART_DmaRxRead(UART_DMA_RX_T *psRx, uint8_t *pu8RxBuf, uint32_t u32ReadBytes)
+{
+    uint32_t u32WritePos = UART_DmaRxWritePos(psRx, NULL);
+    uint32_t u32Avail = u32WritePos - psRx->u32ReadPos;
+    uint32_t u32Count, u32Idx;
+
+    if(u32Avail > psRx->u32Size)
+    {
+        /* Skip the lost bytes; the oldest surviving byte is at the write offset */
+        psRx->u32Overrun += u32Avail - psRx->u32Size;
+        psRx->u32ReadIdx = (psRx->u32ReadIdx + (u32Avail - psRx->u32Size)) % psRx->u32Size;
+        psRx->u32ReadPos = u32WritePos - psRx->u32Size;
+        u32Avail = psRx->u32Size;
+    }
+
+    if(u32ReadBytes > u32Avail)
+        u32ReadBytes = u32Avail;
+
+    u32Idx = psRx->u32ReadIdx;
+    for(u32Count = 0; u32Count != u32ReadBytes; u32Count++)
+    {
+        pu8RxBuf[u32Count] = psRx->pu8Buf[u32Idx];
+        if(++u32Idx == psRx->u32Size)
+            u32Idx = 0;
+    }
+    psRx->u32ReadIdx = u32Idx;
+    psRx->u32ReadPos += u32Count;
+
+    return u32Count;
+}
+
+
+/**
+ *    @brief        Start PDMA transfer of the queue entry at u32Tail
+ *
+ *    @param[in]    psTx    The pointer of the UART PDMA transmit context.
+ *
+ *    @return       None
+ *
+ *    @details      Caller must make sure the channel is idle and the queue is not empty.
+ */
+static void UART_DmaTxStart(UART_DMA_TX_T *psTx)
+{
+    uint32_t u32Idx = psTx->u32Tail & (UART_DMA_TX_QUEUE_SIZE - 1);
+
+    psTx->u32Busy = 1;
+    PDMA_SET_SRC_ADDR(psTx->u32Ch, (uint32_t)psTx->apu8Buf[u32Idx]);
+    PDMA_SetTransferCnt(psTx->u32Ch, PDMA_WIDTH_8, psTx->au32Len[u32Idx]);
+    PDMA_Trigger(psTx->u32Ch);
+}
+
+
+/**
+ *    @brief        Close UART PDMA transmit
+ *
+ *    @param[in]    psTx    The pointer of the UART PDMA transmit context.
+ *
+ *    @return       None
+ *
+ *    @details      The function stops the PDMA channel and disables UART TX PDMA request. Queued buffers are dropped
+ *                  without calling the done callback.
+ */
+void UART_DmaTxClose(UART_DMA_TX_T *psTx)
+{
+    PDMA_DisableInt(psTx->u32Ch, PDMA_IER_BLKD_IE_Msk | PDMA_IER_TABORT_IE_Msk);
+    psTx->uart->IER &= ~UART_IER_DMA_TX_EN_Msk;
+    PDMA_STOP(psTx->u32Ch);
+    psTx->u32Busy = 0;
+    psTx->u32Tail = psTx->u32Head;
+}
+
+
+/**
+ *    @brief        Get free entries of UART PDMA transmit queue
+ *
+ *    @param[in]    psTx    The pointer of the UART PDMA transmit context.
+ *
+ *    @return       Number of buffers that can be queued by \ref UART_DmaTxQueue
+ *
+ *    @details      The queue is empty and the transfer is finished when it returns \ref UART_DMA_TX_QUEUE_SIZE.
+ */
+uint32_t UART_DmaTxGetFree(UART_DMA_TX_T *psTx)
+{
+    return UART_DMA_TX_QUEUE_SIZE - (psTx->u32Head - psTx->u32Tail);
+}
+
+
+/**
+ *    @brief        UART PDMA transmit interrupt service
+ *
+ *    @param[in]    psTx    The pointer of the UART PDMA transmit context.
+ *
+ *    @return       None
+ *
+ *    @details      The function must be called from PDMA_IRQHandler of the application. On block transfer done
+ *                  it starts the next queued buffer first and then reports the finished one through the done
+ *                  callback. The UART TX FIFO still holds the tail of the finished buffer at that time, so the
+ *                  line does not go idle between queued buffers.
+ */
+void UART_DmaTxIRQHandler(UART_DMA_TX_T *psTx)
+{
+    uint32_t u32Sts = PDMA_GET_CH_INT_STS(psTx->u32Ch);
+    uint32_t u32Idx;
+
+    if((u32Sts & (PDMA_ISR_BLKD_IF_Msk | PDMA_ISR_TABORT_IF_Msk)) == 0)
+        return;
+
+    PDMA_CLR_CH_INT_FLAG(psTx->u32Ch, u32Sts & (PDMA_ISR_BLKD_IF_Msk | PDMA_ISR_TABORT_IF_Msk));
+    if(u32Sts & PDMA_ISR_TABORT_IF_Msk)
+        psTx->u32Abort++;
+
+    u32Idx = psTx->u32Tail & (UART_DMA_TX_QUEUE_SIZE - 1);
+    psTx->u32Tail++;
+
+    /* Re-arm with the next buffer before running the callback */
+    if(psTx->u32Tail != psTx->u32Head)
+        UART_DmaTxStart(psTx);
+    else
+        psTx->u32Busy = 0;
+
+    if(psTx->pfnDone)
+        psTx->pfnDone(psTx->apu8Buf[u32Idx], psTx->au32Len[u32Idx]);
+}
+
+
+/**
+ *    @brief        Open UART PDMA transmit
+ *
+ *    @param[in]    psTx        The pointer of the UART PDMA transmit context.
+ *    @param[in]    uart        The pointer of the specified UART module. Valid values are UART0 and UART1.
+ *    @param[in]    u32Ch       The PDMA channel used for transmit.
+ *    @param[in]    pfnDone     The buffer done callback. It can be NULL.
+ *
+ *    @return       None
+ *
+ *    @details      The function connects the PDMA channel to UART TX, enables PDMA block transfer done and target
+ *                  abort interrupts, NVIC PDMA IRQ and UART TX PDMA request.
+ *                  UART must be opened by \ref UART_Open and PDMA clock must be enabled before.
+ */
+void UART_DmaTxOpen(UART_DMA_TX_T *psTx, UART_T *uart, uint32_t u32Ch, UART_DMA_TX_CB pfnDone)
+{
+    psTx->uart = uart;
+    psTx->u32Ch = u32Ch;
+    psTx->pfnDone = pfnDone;
+    psTx->u32Head = 0;
+    psTx->u32Tail = 0;
+    psTx->u32Busy = 0;
+    psTx->u32Abort = 0;
+
+    PDMA_Open(1 << u32Ch);
+    PDMA_SetTransferMode(u32Ch, (uart == UART0) ? PDMA_UART0_TX : PDMA_UART1_TX, 0, 0);
+    PDMA_SetTransferAddr(u32Ch, 0, PDMA_SAR_INC, (uint32_t)&uart->THR, PDMA_DAR_FIX);
+    PDMA_EnableInt(u32Ch, PDMA_IER_BLKD_IE_Msk | PDMA_IER_TABORT_IE_Msk);
+    NVIC_EnableIRQ(PDMA_IRQn);
+
+    uart->IER |= UART_IER_DMA_TX_EN_Msk;
+}
+
+
+/**
+ *    @brief        Queue a buffer for UART PDMA transmit
+ *
+ *    @param[in]    psTx        The pointer of the UART PDMA transmit context.
+ *    @param[in]    pu8Buf      The buffer to transmit. It must stay valid until the done callback reports it.
+ *    @param[in]    u32Len      The buffer length in bytes. It must be 1 ~ 65535.
+ *
+ *    @retval       0   The buffer is queued.
+ *    @retval       -1  The queue is full.
+ *
+ *    @details      The function starts the PDMA channel if it is idle and returns immediately.
+ */
+int32_t UART_DmaTxQueue(UART_DMA_TX_T *psTx, const uint8_t *pu8Buf, uint32_t u32Len)
+{
+    uint32_t u32Idx;
+
+    if((psTx->u32Head - psTx->u32Tail) >= UART_DMA_TX_QUEUE_SIZE)
+        return -1;
+
+    u32Idx = psTx->u32Head & (UART_DMA_TX_QUEUE_SIZE - 1);
+    psTx->apu8Buf[u32Idx] = pu8Buf;
+    psTx->au32Len[u32Idx] = u32Len;
+    __DMB();
+    psTx->u32Head++;
+
+    /* Block the channel interrupt so the interrupt handler cannot start the same entry */
+    PDMA_DisableInt(psTx->u32Ch, PDMA_IER_BLKD_IE_Msk | PDMA_IER_TABORT_IE_Msk);
+    if(!psTx->u32Busy)
+        UART_DmaTxStart(psTx);
+    PDMA_EnableInt(psTx->u32Ch, PDMA_IER_BLKD_IE_Msk | PDMA_IER_TABORT_IE_Msk);
+
+    return 0;
+}
+
+
 /*@}*/ /* end of group UART_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group UART_Driver */
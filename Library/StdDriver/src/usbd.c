@@ -49,6 +49,9 @@ static volatile uint32_t g_usbd_CtrlMaxPktSize = 8;
 static volatile uint32_t g_usbd_UsbAltInterface = 0;
 static volatile uint32_t g_usbd_CtrlOutToggle = 0;
 static volatile uint8_t  g_usbd_CtrlInZeroFlag = 0;
+static const char *g_usbd_CtrlInStr = NULL;         /* ASCII string of the string descriptor being sent. NULL if the IN data is in memory */
+static uint32_t g_usbd_CtrlInStrPos = 0;            /* Byte offset in the string descriptor being sent */
+static uint8_t g_usbd_CtrlInStrLen = 0;             /* bLength of the string descriptor being sent */
 
 const S_USBD_INFO_T *g_usbd_sInfo;                  /*!< A pointer for USB information structure */
 
@@ -56,8 +59,27 @@ VENDOR_REQ g_usbd_pfnVendorRequest = NULL;          /*!< USB Vendor Request Func
 CLASS_REQ g_usbd_pfnClassRequest = NULL;            /*!< USB Class Request Functional Pointer */
 SET_INTERFACE_REQ g_usbd_pfnSetInterface = NULL;    /*!< USB Set Interface Functional Pointer */
 SET_CONFIG_CB g_usbd_pfnSetConfigCallback = NULL;   /*!< USB Set configuration callback function pointer */
+BUS_EVENT_CB g_usbd_pfnBusEvent = NULL;             /*!< USB bus event callback function pointer */
 uint32_t g_u32EpStallLock                = 0;       /*!< Bit map flag to lock specified EP when SET_FEATURE */
 
+static uint32_t g_usbd_EpCfg[USBD_MAX_EP];          /* CFG value of each endpoint from the endpoint configuration table */
+static uint16_t g_usbd_EpBuf[USBD_MAX_EP][2];       /* Packet buffer offsets of each endpoint. Both are the same for one buffer */
+static EP_HANDLER g_usbd_pfnEpHandler[USBD_MAX_EP];  /* Event handler of each data endpoint from the endpoint configuration table */
+
+/* Entry of the GET_DESCRIPTOR handler table */
+typedef struct
+{
+    uint8_t u8Type;                     /* Descriptor type */
+    int32_t (*pfnReq)(uint32_t u32Len); /* Handler. u32Len is wLength of the request. It returns -1 to stall */
+} S_USBD_DESC_REQ_T;
+
+/* Entry of the standard request handler table */
+typedef struct
+{
+    int32_t (*pfnReq)(void);            /* Handler. It returns -1 to stall */
+    uint8_t u8Dir;                      /* Data transfer direction of bmRequestType, 0x80 for device to host */
+} S_USBD_STD_REQ_T;
+
 /**
   * @brief      This function makes USBD module to be ready to use
   *
@@ -171,6 +193,214 @@ void USBD_ProcessSetupPacket(void)
     }
 }
 
+/**
+  * @brief      Limit the Control IN data to the descriptor size
+  *
+  * @param[in]  u32DescLen  The descriptor size.
+  * @param[in]  u32Len      The size requested by the host.
+  *
+  * @return     The byte count to send.
+  *
+  * @details    A reply shorter than the request which is a multiple of the maximum packet size must be ended by a
+  *             zero length packet. This function sets the zero length packet flag for it.
+  */
+static uint32_t USBD_CtrlInLimit(uint32_t u32DescLen, uint32_t u32Len)
+{
+    if(u32Len > u32DescLen)
+    {
+        u32Len = u32DescLen;
+        if((u32Len % g_usbd_CtrlMaxPktSize) == 0)
+        {
+            g_usbd_CtrlInZeroFlag = (uint8_t)1;
+        }
+    }
+    return u32Len;
+}
+
+/**
+  * @brief      Load the next Control IN packet
+  *
+  * @param[in]  u32Len  Byte count of the packet.
+  *
+  * @return     None
+  *
+  * @details    Copy the next u32Len bytes of the Control IN data to the EP0 packet buffer. The data of a string
+  *             descriptor from gpcStringTbl is generated from its ASCII string here, so no RAM copy is needed.
+  */
+static void USBD_CtrlInLoad(uint32_t u32Len)
+{
+    uint8_t *pu8Buf = (uint8_t *)USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0);
+    uint32_t u32Pos;
+
+    if(g_usbd_CtrlInStr == NULL)
+    {
+        USBD_MemCopy(pu8Buf, (uint8_t *)g_usbd_CtrlInPointer, u32Len);
+        g_usbd_CtrlInPointer += u32Len;
+    }
+    else
+    {
+        /* bLength, bDescriptorType and then each character in UTF-16LE */
+        for(u32Pos = g_usbd_CtrlInStrPos; u32Pos < g_usbd_CtrlInStrPos + u32Len; u32Pos++)
+        {
+            if(u32Pos == 0)
+                *pu8Buf++ = g_usbd_CtrlInStrLen;
+            else if(u32Pos == 1)
+                *pu8Buf++ = DESC_STRING;
+            else
+                *pu8Buf++ = (u32Pos & 1) ? 0 : (uint8_t)g_usbd_CtrlInStr[(u32Pos - 2) >> 1];
+        }
+        g_usbd_CtrlInStrPos = u32Pos;
+    }
+    g_usbd_CtrlInSize -= u32Len;
+}
+
+/**
+  * @brief      Start the Control IN data stage
+  *
+  * @param[in]  u32Size The IN transfer size.
+  *
+  * @return     None
+  *
+  * @details    Send the first packet with DATA1. \ref USBD_CtrlIn sends the rest.
+  */
+static void USBD_CtrlInStart(uint32_t u32Size)
+{
+    uint32_t u32Len = Minimum(u32Size, g_usbd_CtrlMaxPktSize);
+
+    DBG_PRINTF("Prepare Ctrl In %d\n", u32Size);
+    g_usbd_CtrlInSize = u32Size;
+    USBD_SET_DATA1(EP0);
+    USBD_CtrlInLoad(u32Len);
+    USBD_SET_PAYLOAD_LEN(EP0, u32Len);
+}
+
+/**
+  * @brief      Reply a short Control IN data stage
+  *
+  * @param[in]  u32Data The data in little endian.
+  * @param[in]  u32Len  Byte count of the data, 1 or 2.
+  *
+  * @return     None
+  *
+  * @details    Used by the standard requests which return a status or a setting value.
+  */
+static void USBD_CtrlInReply(uint32_t u32Data, uint32_t u32Len)
+{
+    /* Data stage */
+    M8(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0)) = (uint8_t)u32Data;
+    M8(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0) + 1) = (uint8_t)(u32Data >> 8);
+    USBD_SET_DATA1(EP0);
+    USBD_SET_PAYLOAD_LEN(EP0, u32Len);
+    /* Status stage */
+    USBD_PrepareCtrlOut(0, 0);
+}
+
+/**
+  * @brief      Reply the status stage of a request without data stage
+  *
+  * @param      None
+  *
+  * @return     None
+  */
+static void USBD_CtrlStatusIn(void)
+{
+    USBD_SET_DATA1(EP0);
+    USBD_SET_PAYLOAD_LEN(EP0, 0);
+}
+
+/*--------------------------------------------------------------------------*/
+/* GET_DESCRIPTOR handlers. They return -1 to stall the control pipe */
+static int32_t USBD_DescDevice(uint32_t u32Len)
+{
+    DBG_PRINTF("Get device desc, %d\n", u32Len);
+    USBD_PrepareCtrlIn((uint8_t *)g_usbd_sInfo->gu8DevDesc, USBD_CtrlInLimit(LEN_DEVICE, u32Len));
+    return 0;
+}
+
+static int32_t USBD_DescConfig(uint32_t u32Len)
+{
+    uint32_t u32TotalLen;
+
+    u32TotalLen = g_usbd_sInfo->gu8ConfigDesc[3];
+    u32TotalLen = g_usbd_sInfo->gu8ConfigDesc[2] + (u32TotalLen << 8);
+
+    USBD_PrepareCtrlIn((uint8_t *)g_usbd_sInfo->gu8ConfigDesc, USBD_CtrlInLimit(u32TotalLen, u32Len));
+    return 0;
+}
+
+static int32_t USBD_DescString(uint32_t u32Len)
+{
+    static const uint8_t s_au8LangId[4] = {4, DESC_STRING, 0x09, 0x04};   /* English (United States) */
+    const char *pcStr;
+    uint32_t u32Idx = g_usbd_SetupPacket[2];
+    uint32_t u32Num = g_usbd_sInfo->gu32StringNum ? g_usbd_sInfo->gu32StringNum : 4;
+
+    if(u32Idx >= u32Num)
+    {
+        DBG_PRINTF("Unsupported string desc (%d). Stall ctrl pipe.\n", u32Idx);
+        return -1;
+    }
+
+    /* ASCII string table first. Entry 0 is the language ID list, which is no ASCII string. */
+    if((u32Idx != 0) && (g_usbd_sInfo->gpcStringTbl != NULL) && (g_usbd_sInfo->gpcStringTbl[u32Idx] != NULL))
+    {
+        pcStr = g_usbd_sInfo->gpcStringTbl[u32Idx];
+        g_usbd_CtrlInStrLen = (uint8_t)(2 + 2 * Minimum(strlen(pcStr), 126));
+        g_usbd_CtrlInStrPos = 0;
+        g_usbd_CtrlInStr = pcStr;
+        USBD_CtrlInStart(USBD_CtrlInLimit(g_usbd_CtrlInStrLen, u32Len));
+    }
+    else if((g_usbd_sInfo->gu8StringDesc != NULL) && (g_usbd_sInfo->gu8StringDesc[u32Idx] != NULL))
+    {
+        USBD_PrepareCtrlIn((uint8_t *)g_usbd_sInfo->gu8StringDesc[u32Idx],
+                           USBD_CtrlInLimit(g_usbd_sInfo->gu8StringDesc[u32Idx][0], u32Len));
+    }
+    else if(u32Idx == 0)
+    {
+        USBD_PrepareCtrlIn((uint8_t *)s_au8LangId, USBD_CtrlInLimit(sizeof(s_au8LangId), u32Len));
+    }
+    else
+    {
+        return -1;
+    }
+    return 0;
+}
+
+static int32_t USBD_DescHid(uint32_t u32Len)
+{
+    /* CV3.0 HID Class Descriptor Test,
+       Need to indicate index of the HID Descriptor within gu8ConfigDescriptor, specifically HID Composite device. */
+    uint32_t u32ConfigDescOffset;   // u32ConfigDescOffset is configuration descriptor offset (HID descriptor start index)
+
+    if(g_usbd_sInfo->gu32ConfigHidDescIdx == NULL)
+        return -1;
+    DBG_PRINTF("Get HID desc, %d\n", u32Len);
+    u32ConfigDescOffset = g_usbd_sInfo->gu32ConfigHidDescIdx[g_usbd_SetupPacket[4]];
+    USBD_PrepareCtrlIn((uint8_t *)&g_usbd_sInfo->gu8ConfigDesc[u32ConfigDescOffset], USBD_CtrlInLimit(LEN_HID, u32Len));
+    return 0;
+}
+
+static int32_t USBD_DescHidReport(uint32_t u32Len)
+{
+    uint32_t u32Intf = g_usbd_SetupPacket[4];
+
+    if((g_usbd_sInfo->gu8HidReportDesc == NULL) || (g_usbd_sInfo->gu32HidReportSize == NULL))
+        return -1;
+    USBD_PrepareCtrlIn((uint8_t *)g_usbd_sInfo->gu8HidReportDesc[u32Intf],
+                       USBD_CtrlInLimit(g_usbd_sInfo->gu32HidReportSize[u32Intf], u32Len));
+    return 0;
+}
+
+/* GET_DESCRIPTOR handler of each descriptor type */
+static const S_USBD_DESC_REQ_T s_asUsbdDescReq[] =
+{
+    {DESC_DEVICE,   USBD_DescDevice},
+    {DESC_CONFIG,   USBD_DescConfig},
+    {DESC_STRING,   USBD_DescString},
+    {DESC_HID,      USBD_DescHid},
+    {DESC_HID_RPT,  USBD_DescHidReport},
+};
+
 /**
   * @brief    Process GetDescriptor request
   *
@@ -178,114 +408,178 @@ void USBD_ProcessSetupPacket(void)
   *
   * @return   None
   *
-  * @details  Parse GetDescriptor request and perform the corresponding action.
-  *
+  * @details  Look up the handler of the requested descriptor type and let it prepare the data stage.
+  *           Unsupported descriptors stall the control pipe.
   */
 void USBD_GetDescriptor(void)
 {
-    uint32_t u32Len;
+    uint32_t u32Len, i;
 
     g_usbd_CtrlInZeroFlag = (uint8_t)0;
-    u32Len = 0;
     u32Len = g_usbd_SetupPacket[7];
     u32Len <<= 8;
     u32Len += g_usbd_SetupPacket[6];
 
-    switch(g_usbd_SetupPacket[3])
+    for(i = 0; i < sizeof(s_asUsbdDescReq) / sizeof(s_asUsbdDescReq[0]); i++)
     {
-        // Get Device Descriptor
-        case DESC_DEVICE:
-        {
-            u32Len = Minimum(u32Len, LEN_DEVICE);
-            DBG_PRINTF("Get device desc, %d\n", u32Len);
-            USBD_PrepareCtrlIn((uint8_t *)g_usbd_sInfo->gu8DevDesc, u32Len);
-            USBD_PrepareCtrlOut(0, 0);
-            break;
-        }
-        // Get Configuration Descriptor
-        case DESC_CONFIG:
+        if(s_asUsbdDescReq[i].u8Type == g_usbd_SetupPacket[3])
         {
-            uint32_t u32TotalLen;
-
-            u32TotalLen = g_usbd_sInfo->gu8ConfigDesc[3];
-            u32TotalLen = g_usbd_sInfo->gu8ConfigDesc[2] + (u32TotalLen << 8);
-
-            if(u32Len > u32TotalLen)
+            if(s_asUsbdDescReq[i].pfnReq(u32Len) == 0)
             {
-                u32Len = u32TotalLen;
-                if((u32Len % g_usbd_CtrlMaxPktSize) == 0)
-                {
-                    g_usbd_CtrlInZeroFlag = (uint8_t)1;
-                }
-            }
-            USBD_PrepareCtrlIn((uint8_t *)g_usbd_sInfo->gu8ConfigDesc, u32Len);
-            USBD_PrepareCtrlOut(0, 0);
-            break;
-        }
-        // Get HID Descriptor
-        case DESC_HID:
-        {
-            /* CV3.0 HID Class Descriptor Test,
-               Need to indicate index of the HID Descriptor within gu8ConfigDescriptor, specifically HID Composite device. */
-            uint32_t u32ConfigDescOffset;   // u32ConfigDescOffset is configuration descriptor offset (HID descriptor start index)
-            u32Len = Minimum(u32Len, LEN_HID);
-            DBG_PRINTF("Get HID desc, %d\n", u32Len);
-            u32ConfigDescOffset = g_usbd_sInfo->gu32ConfigHidDescIdx[g_usbd_SetupPacket[4]];
-            USBD_PrepareCtrlIn((uint8_t *)&g_usbd_sInfo->gu8ConfigDesc[u32ConfigDescOffset], u32Len);
-            USBD_PrepareCtrlOut(0, 0);
-            break;
-        }
-        // Get Report Descriptor
-        case DESC_HID_RPT:
-        {
-            if(u32Len > g_usbd_sInfo->gu32HidReportSize[g_usbd_SetupPacket[4]])
-            {
-                u32Len = g_usbd_sInfo->gu32HidReportSize[g_usbd_SetupPacket[4]];
-                if((u32Len % g_usbd_CtrlMaxPktSize) == 0)
-                {
-                    g_usbd_CtrlInZeroFlag = (uint8_t)1;
-                }
+                /* Status stage */
+                USBD_PrepareCtrlOut(0, 0);
+                return;
             }
-            USBD_PrepareCtrlIn((uint8_t *)g_usbd_sInfo->gu8HidReportDesc[g_usbd_SetupPacket[4]], u32Len);
-            USBD_PrepareCtrlOut(0, 0);
             break;
         }
-        // Get String Descriptor
-        case DESC_STRING:
+    }
+
+    // Not support. Reply STALL.
+    USBD_SET_EP_STALL(EP0);
+    USBD_SET_EP_STALL(EP1);
+    DBG_PRINTF("Unsupported get desc type. stall ctrl pipe\n");
+}
+
+/*--------------------------------------------------------------------------*/
+/* Standard request handlers. They return -1 to stall the control pipe */
+static int32_t USBD_StdGetStatus(void)
+{
+    uint32_t u32Sts = 0;
+
+    // Device
+    if(g_usbd_SetupPacket[0] == 0x80)
+    {
+        if(g_usbd_sInfo->gu8ConfigDesc[7] & 0x40) u32Sts |= 1; // Self-Powered/Bus-Powered.
+        if(g_usbd_sInfo->gu8ConfigDesc[7] & 0x20) u32Sts |= (g_usbd_RemoteWakeupEn << 1); // Remote wake up
+    }
+    // Endpoint
+    else if(g_usbd_SetupPacket[0] == 0x82)
+    {
+        u32Sts = USBD_GetStall(g_usbd_SetupPacket[4] & 0xF) ? 1 : 0;
+    }
+
+    USBD_CtrlInReply(u32Sts, 2);
+    DBG_PRINTF("Get status\n");
+    return 0;
+}
+
+static int32_t USBD_StdClearFeature(void)
+{
+    if(g_usbd_SetupPacket[2] == FEATURE_ENDPOINT_HALT)
+    {
+        int32_t epNum, i;
+
+        /* EP number stall is not allow to be clear in MSC class "Error Recovery Test".
+           a flag: g_u32EpStallLock is added to support it */
+        epNum = g_usbd_SetupPacket[4] & 0xF;
+        for(i = 0; i < USBD_MAX_EP; i++)
         {
-            // Get String Descriptor
-            if(g_usbd_SetupPacket[2] < 4)
-            {
-                if(u32Len > g_usbd_sInfo->gu8StringDesc[g_usbd_SetupPacket[2]][0])
-                {
-                    u32Len = g_usbd_sInfo->gu8StringDesc[g_usbd_SetupPacket[2]][0];
-                    if((u32Len % g_usbd_CtrlMaxPktSize) == 0)
-                    {
-                        g_usbd_CtrlInZeroFlag = (uint8_t)1;
-                    }
-                }
-                USBD_PrepareCtrlIn((uint8_t *)g_usbd_sInfo->gu8StringDesc[g_usbd_SetupPacket[2]], u32Len);
-                USBD_PrepareCtrlOut(0, 0);
-                break;
-            }
-            else
+            if(((USBD->EP[i].CFG & 0xF) == epNum) && ((g_u32EpStallLock & (1 << i)) == 0))
             {
-                // Not support. Reply STALL.
-                USBD_SET_EP_STALL(EP0);
-                USBD_SET_EP_STALL(EP1);
-                DBG_PRINTF("Unsupported string desc (%d). Stall ctrl pipe.\n", g_usbd_SetupPacket[2]);
-                break;
+                USBD->EP[i].CFGP &= ~USBD_CFGP_SSTALL_Msk;
+                USBD->EP[i].CFG &= ~USBD_CFG_DSQ_SYNC_Msk;
+                DBG_PRINTF("Clr stall ep%d %x\n", i, USBD->EP[i].CFGP);
             }
         }
-        default:
-            // Not support. Reply STALL.
-            USBD_SET_EP_STALL(EP0);
-            USBD_SET_EP_STALL(EP1);
-            DBG_PRINTF("Unsupported get desc type. stall ctrl pipe\n");
-            break;
     }
+    else if(g_usbd_SetupPacket[2] == FEATURE_DEVICE_REMOTE_WAKEUP)
+        g_usbd_RemoteWakeupEn = 0;
+
+    USBD_CtrlStatusIn();
+    DBG_PRINTF("Clear feature op %d\n", g_usbd_SetupPacket[2]);
+    return 0;
+}
+
+static int32_t USBD_StdSetFeature(void)
+{
+    if(g_usbd_SetupPacket[2] == FEATURE_ENDPOINT_HALT)
+    {
+        USBD_SetStall(g_usbd_SetupPacket[4] & 0xF);
+        DBG_PRINTF("Set feature. stall ep %d\n", g_usbd_SetupPacket[4] & 0xF);
+    }
+    else if(g_usbd_SetupPacket[2] == FEATURE_DEVICE_REMOTE_WAKEUP)
+    {
+        g_usbd_RemoteWakeupEn = 1;
+        DBG_PRINTF("Set feature. enable remote wakeup\n");
+    }
+
+    USBD_CtrlStatusIn();
+    return 0;
+}
+
+static int32_t USBD_StdSetAddress(void)
+{
+    /* The address is taken at the end of the status stage in USBD_CtrlIn */
+    g_usbd_UsbAddr = g_usbd_SetupPacket[2];
+    DBG_PRINTF("Set addr to %d\n", g_usbd_UsbAddr);
+
+    USBD_CtrlStatusIn();
+    return 0;
 }
 
+static int32_t USBD_StdGetDescriptor(void)
+{
+    USBD_GetDescriptor();
+    DBG_PRINTF("Get descriptor\n");
+    return 0;
+}
+
+static int32_t USBD_StdGetConfiguration(void)
+{
+    // Return current configuration setting
+    USBD_CtrlInReply(g_usbd_UsbConfig, 1);
+    DBG_PRINTF("Get configuration\n");
+    return 0;
+}
+
+static int32_t USBD_StdSetConfiguration(void)
+{
+    g_usbd_UsbConfig = g_usbd_SetupPacket[2];
+
+    if(g_usbd_pfnSetConfigCallback)
+        g_usbd_pfnSetConfigCallback();
+
+    USBD_CtrlStatusIn();
+    DBG_PRINTF("Set config to %d\n", g_usbd_UsbConfig);
+    return 0;
+}
+
+static int32_t USBD_StdGetInterface(void)
+{
+    // Return current interface setting
+    USBD_CtrlInReply(g_usbd_UsbAltInterface, 1);
+    DBG_PRINTF("Get interface\n");
+    return 0;
+}
+
+static int32_t USBD_StdSetInterface(void)
+{
+    g_usbd_UsbAltInterface = g_usbd_SetupPacket[2];
+    if(g_usbd_pfnSetInterface != NULL)
+        g_usbd_pfnSetInterface();
+
+    USBD_CtrlStatusIn();
+    DBG_PRINTF("Set interface to %d\n", g_usbd_UsbAltInterface);
+    return 0;
+}
+
+/* Standard request handlers indexed by bRequest */
+static const S_USBD_STD_REQ_T s_asUsbdStdReq[] =
+{
+    {USBD_StdGetStatus,         0x80},  /* GET_STATUS */
+    {USBD_StdClearFeature,      0x00},  /* CLEAR_FEATURE */
+    {NULL,                      0x00},  /* Reserved */
+    {USBD_StdSetFeature,        0x00},  /* SET_FEATURE */
+    {NULL,                      0x00},  /* Reserved */
+    {USBD_StdSetAddress,        0x00},  /* SET_ADDRESS */
+    {USBD_StdGetDescriptor,     0x80},  /* GET_DESCRIPTOR */
+    {NULL,                      0x00},  /* SET_DESCRIPTOR */
+    {USBD_StdGetConfiguration,  0x80},  /* GET_CONFIGURATION */
+    {USBD_StdSetConfiguration,  0x00},  /* SET_CONFIGURATION */
+    {USBD_StdGetInterface,      0x80},  /* GET_INTERFACE */
+    {USBD_StdSetInterface,      0x00},  /* SET_INTERFACE */
+};
+
 /**
   * @brief    Process standard request
   *
@@ -293,188 +587,30 @@ void USBD_GetDescriptor(void)
   *
   * @return   None
   *
-  * @details  Parse standard request and perform the corresponding action.
+  * @details  Call the handler of the request from a table indexed by bRequest. Requests without a handler or with
+  *           the wrong data transfer direction stall the control pipe.
   *
   */
 void USBD_StandardRequest(void)
 {
+    uint32_t u32Req = g_usbd_SetupPacket[1];
+
     /* clear global variables for new request */
     g_usbd_CtrlInPointer = 0;
     g_usbd_CtrlInSize = 0;
 
-    if(g_usbd_SetupPacket[0] & 0x80)    /* request data transfer direction */
+    if((u32Req < sizeof(s_asUsbdStdReq) / sizeof(s_asUsbdStdReq[0])) &&
+            (s_asUsbdStdReq[u32Req].pfnReq != NULL) &&
+            (s_asUsbdStdReq[u32Req].u8Dir == (g_usbd_SetupPacket[0] & 0x80)))
     {
-        // Device to host
-        switch(g_usbd_SetupPacket[1])
-        {
-            case GET_CONFIGURATION:
-            {
-                // Return current configuration setting
-                /* Data stage */
-                M8(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0)) = g_usbd_UsbConfig;
-                USBD_SET_DATA1(EP0);
-                USBD_SET_PAYLOAD_LEN(EP0, 1);
-                /* Status stage */
-                USBD_PrepareCtrlOut(0, 0);
-                DBG_PRINTF("Get configuration\n");
-                break;
-            }
-            case GET_DESCRIPTOR:
-            {
-                USBD_GetDescriptor();
-                /* Status stage */
-                USBD_PrepareCtrlOut(0, 0);
-                DBG_PRINTF("Get descriptor\n");
-                break;
-            }
-            case GET_INTERFACE:
-            {
-                // Return current interface setting
-                /* Data stage */
-                M8(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0)) = g_usbd_UsbAltInterface;
-                USBD_SET_DATA1(EP0);
-                USBD_SET_PAYLOAD_LEN(EP0, 1);
-                /* Status stage */
-                USBD_PrepareCtrlOut(0, 0);
-                DBG_PRINTF("Get interface\n");
-                break;
-            }
-            case GET_STATUS:
-            {
-                // Device
-                if(g_usbd_SetupPacket[0] == 0x80)
-                {
-                    uint8_t u8Tmp;
-
-                    u8Tmp = 0;
-                    if(g_usbd_sInfo->gu8ConfigDesc[7] & 0x40) u8Tmp |= 1; // Self-Powered/Bus-Powered.
-                    if(g_usbd_sInfo->gu8ConfigDesc[7] & 0x20) u8Tmp |= (g_usbd_RemoteWakeupEn << 1); // Remote wake up
-
-                    M8(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0)) = u8Tmp;
-                }
-                // Interface
-                else if(g_usbd_SetupPacket[0] == 0x81)
-                    M8(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0)) = 0;
-                // Endpoint
-                else if(g_usbd_SetupPacket[0] == 0x82)
-                {
-                    uint8_t ep = g_usbd_SetupPacket[4] & 0xF;
-                    M8(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0)) = USBD_GetStall(ep) ? 1 : 0;
-                }
-
-                M8(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0) + 1) = 0;
-                /* Data stage */
-                USBD_SET_DATA1(EP0);
-                USBD_SET_PAYLOAD_LEN(EP0, 2);
-                /* Status stage */
-                USBD_PrepareCtrlOut(0, 0);
-                DBG_PRINTF("Get status\n");
-                break;
-            }
-            default:
-            {
-                /* Setup error, stall the device */
-                USBD_SET_EP_STALL(EP0);
-                USBD_SET_EP_STALL(EP1);
-                DBG_PRINTF("Unknown request. stall ctrl pipe.\n");
-                break;
-            }
-        }
+        if(s_asUsbdStdReq[u32Req].pfnReq() == 0)
+            return;
     }
-    else
-    {
-        // Host to device
-        switch(g_usbd_SetupPacket[1])
-        {
-            case CLEAR_FEATURE:
-            {
-                if(g_usbd_SetupPacket[2] == FEATURE_ENDPOINT_HALT)
-                {
-                    int32_t epNum, i;
-
-                    /* EP number stall is not allow to be clear in MSC class "Error Recovery Test".
-                       a flag: g_u32EpStallLock is added to support it */
-                    epNum = g_usbd_SetupPacket[4] & 0xF;
-                    for(i = 0; i < USBD_MAX_EP; i++)
-                    {
-                        if(((USBD->EP[i].CFG & 0xF) == epNum) && ((g_u32EpStallLock & (1 << i)) == 0))
-                        {
-                            USBD->EP[i].CFGP &= ~USBD_CFGP_SSTALL_Msk;
-                            USBD->EP[i].CFG &= ~USBD_CFG_DSQ_SYNC_Msk;
-                            DBG_PRINTF("Clr stall ep%d %x\n", i, USBD->EP[i].CFGP);
-                        }
-                    }
-                }
-                else if(g_usbd_SetupPacket[2] == FEATURE_DEVICE_REMOTE_WAKEUP)
-                    g_usbd_RemoteWakeupEn = 0;
-                /* Status stage */
-                USBD_SET_DATA1(EP0);
-                USBD_SET_PAYLOAD_LEN(EP0, 0);
-                DBG_PRINTF("Clear feature op %d\n", g_usbd_SetupPacket[2]);
-                break;
-            }
-            case SET_ADDRESS:
-            {
-                g_usbd_UsbAddr = g_usbd_SetupPacket[2];
-                DBG_PRINTF("Set addr to %d\n", g_usbd_UsbAddr);
-
-                // DATA IN for end of setup
-                /* Status Stage */
-                USBD_SET_DATA1(EP0);
-                USBD_SET_PAYLOAD_LEN(EP0, 0);
-                break;
-            }
-            case SET_CONFIGURATION:
-            {
-                g_usbd_UsbConfig = g_usbd_SetupPacket[2];
 
-                if(g_usbd_pfnSetConfigCallback)
-                    g_usbd_pfnSetConfigCallback();
-                // DATA IN for end of setup
-                /* Status stage */
-                USBD_SET_DATA1(EP0);
-                USBD_SET_PAYLOAD_LEN(EP0, 0);
-                DBG_PRINTF("Set config to %d\n", g_usbd_UsbConfig);
-                break;
-            }
-            case SET_FEATURE:
-            {
-                if(g_usbd_SetupPacket[2] == FEATURE_ENDPOINT_HALT)
-                {
-                    USBD_SetStall(g_usbd_SetupPacket[4] & 0xF);
-                    DBG_PRINTF("Set feature. stall ep %d\n", g_usbd_SetupPacket[4] & 0xF);
-                }
-                else if(g_usbd_SetupPacket[2] == FEATURE_DEVICE_REMOTE_WAKEUP)
-                {
-                    g_usbd_RemoteWakeupEn = 1;
-                    DBG_PRINTF("Set feature. enable remote wakeup\n");
-                }
-                /* Status stage */
-                USBD_SET_DATA1(EP0);
-                USBD_SET_PAYLOAD_LEN(EP0, 0);
-                break;
-            }
-            case SET_INTERFACE:
-            {
-                g_usbd_UsbAltInterface = g_usbd_SetupPacket[2];
-                if(g_usbd_pfnSetInterface != NULL)
-                    g_usbd_pfnSetInterface();
-                /* Status stage */
-                USBD_SET_DATA1(EP0);
-                USBD_SET_PAYLOAD_LEN(EP0, 0);
-                DBG_PRINTF("Set interface to %d\n", g_usbd_UsbAltInterface);
-                break;
-            }
-            default:
-            {
-                /* Setup error, stall the device */
-                USBD_SET_EP_STALL(EP0);
-                USBD_SET_EP_STALL(EP1);
-                DBG_PRINTF("Unsupported request. stall ctrl pipe.\n");
-                break;
-            }
-        }
-    }
+    /* Setup error, stall the device */
+    USBD_SET_EP_STALL(EP0);
+    USBD_SET_EP_STALL(EP1);
+    DBG_PRINTF("Unsupported request. stall ctrl pipe.\n");
 }
 
 /**
@@ -490,25 +626,9 @@ void USBD_StandardRequest(void)
   */
 void USBD_PrepareCtrlIn(uint8_t *pu8Buf, uint32_t u32Size)
 {
-    DBG_PRINTF("Prepare Ctrl In %d\n", u32Size);
-    if(u32Size > g_usbd_CtrlMaxPktSize)
-    {
-        // Data size > MXPLD
-        g_usbd_CtrlInPointer = pu8Buf + g_usbd_CtrlMaxPktSize;
-        g_usbd_CtrlInSize = u32Size - g_usbd_CtrlMaxPktSize;
-        USBD_SET_DATA1(EP0);
-        USBD_MemCopy((uint8_t *)USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0), pu8Buf, g_usbd_CtrlMaxPktSize);
-        USBD_SET_PAYLOAD_LEN(EP0, g_usbd_CtrlMaxPktSize);
-    }
-    else
-    {
-        // Data size <= MXPLD
-        g_usbd_CtrlInPointer = 0;
-        g_usbd_CtrlInSize = 0;
-        USBD_SET_DATA1(EP0);
-        USBD_MemCopy((uint8_t *)USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0), pu8Buf, u32Size);
-        USBD_SET_PAYLOAD_LEN(EP0, u32Size);
-    }
+    g_usbd_CtrlInStr = NULL;
+    g_usbd_CtrlInPointer = pu8Buf;
+    USBD_CtrlInStart(u32Size);
 }
 
 /**
@@ -523,26 +643,15 @@ void USBD_PrepareCtrlIn(uint8_t *pu8Buf, uint32_t u32Size)
   */
 void USBD_CtrlIn(void)
 {
+    uint32_t u32Len;
+
     DBG_PRINTF("Ctrl In Ack. residue %d\n", g_usbd_CtrlInSize);
     if(g_usbd_CtrlInSize)
     {
         // Process remained data
-        if(g_usbd_CtrlInSize > g_usbd_CtrlMaxPktSize)
-        {
-            // Data size > MXPLD
-            USBD_MemCopy((uint8_t *)USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0), (uint8_t *)g_usbd_CtrlInPointer, g_usbd_CtrlMaxPktSize);
-            USBD_SET_PAYLOAD_LEN(EP0, g_usbd_CtrlMaxPktSize);
-            g_usbd_CtrlInPointer += g_usbd_CtrlMaxPktSize;
-            g_usbd_CtrlInSize -= g_usbd_CtrlMaxPktSize;
-        }
-        else
-        {
-            // Data size <= MXPLD
-            USBD_MemCopy((uint8_t *)USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0), (uint8_t *)g_usbd_CtrlInPointer, g_usbd_CtrlInSize);
-            USBD_SET_PAYLOAD_LEN(EP0, g_usbd_CtrlInSize);
-            g_usbd_CtrlInPointer = 0;
-            g_usbd_CtrlInSize = 0;
-        }
+        u32Len = Minimum(g_usbd_CtrlInSize, g_usbd_CtrlMaxPktSize);
+        USBD_CtrlInLoad(u32Len);
+        USBD_SET_PAYLOAD_LEN(EP0, u32Len);
     }
     else // No more data for IN token
     {
@@ -636,6 +745,7 @@ void USBD_SwReset(void)
     // Reset all variables for protocol
     g_usbd_CtrlInPointer = 0;
     g_usbd_CtrlInSize = 0;
+    g_usbd_CtrlInStr = NULL;
     g_usbd_CtrlOutPointer = 0;
     g_usbd_CtrlOutSize = 0;
     g_usbd_CtrlOutSizeLimit = 0;
@@ -678,6 +788,21 @@ void USBD_SetConfigCallback(SET_CONFIG_CB pfnSetConfigCallback)
     g_usbd_pfnSetConfigCallback = pfnSetConfigCallback;
 }
 
+/**
+ * @brief       The callback function which called at USB bus events
+ *
+ * @param[in]   pfnBusEvent     Callback function pointer for bus events
+ *
+ * @return      None
+ *
+ * @details     The callback function is called by \ref USBD_IRQDispatch after the bus reset, suspend or resume event
+ *              has been handled. Its argument is the bus state \ref USBD_STATE_USBRST, \ref USBD_STATE_SUSPEND
+ *              or \ref USBD_STATE_RESUME.
+ */
+void USBD_SetBusEventCallback(BUS_EVENT_CB pfnBusEvent)
+{
+    g_usbd_pfnBusEvent = pfnBusEvent;
+}
 
 /**
  * @brief       EP stall lock function to avoid stall clear by USB SET FEATURE request.
@@ -693,6 +818,260 @@ void USBD_LockEpStall(uint32_t u32EpBitmap)
 {
     g_u32EpStallLock = u32EpBitmap;
 }
+
+/**
+ * @brief       Configure endpoints and their packet buffers from a table
+ *
+ * @param[in]   psEpCfg     The endpoint configuration table.
+ * @param[in]   u32Count    Number of entries in the table.
+ *
+ * @retval      0   Success.
+ * @retval      -1  An entry is invalid or the packet buffers do not fit in the USB SRAM. No endpoint is changed.
+ *
+ * @details     This function places the setup packet buffer at offset 0 of the USB SRAM and the packet buffers of the
+ *              table entries one after another behind it, each 8-byte aligned. Every endpoint in the table is then
+ *              configured and assigned its first packet buffer. The control endpoints (address 0) also get their
+ *              stall cleared. Endpoints not in the table are left unchanged.
+ *              An endpoint with two packet buffers is not double buffered by the controller. The application swaps
+ *              them with \ref USBD_SwapEpBuf while the endpoint is not ready, e.g. in its event handler right before
+ *              the next transaction is triggered, so a packet can be copied while the other one is on the bus.
+ */
+int32_t USBD_ConfigEpTable(const S_USBD_EP_CFG_T *psEpCfg, uint32_t u32Count)
+{
+    uint32_t i, u32Ep, u32Len, u32Offset = USBD_SETUP_BUF_LEN;
+
+    /* Check the whole table before touching any endpoint */
+    for(i = 0; i < u32Count; i++)
+    {
+        if((psEpCfg[i].u8Ep >= USBD_MAX_EP) || (psEpCfg[i].u8Slots < 1) || (psEpCfg[i].u8Slots > 2))
+            return -1;
+        u32Offset += USBD_EP_BUF_LEN(psEpCfg[i].u16MaxPktSize, psEpCfg[i].u8Slots);
+    }
+    if(u32Offset > USBD_BUF_SIZE)
+        return -1;
+
+    /* Buffer range for setup packet -> [0 ~ 0x7] */
+    USBD->STBUFSEG = 0;
+
+    u32Offset = USBD_SETUP_BUF_LEN;
+    for(i = 0; i < u32Count; i++)
+    {
+        u32Ep = psEpCfg[i].u8Ep;
+        u32Len = USBD_EP_BUF_LEN(psEpCfg[i].u16MaxPktSize, 1);
+
+        g_usbd_EpBuf[u32Ep][0] = (uint16_t)u32Offset;
+        g_usbd_EpBuf[u32Ep][1] = (uint16_t)((psEpCfg[i].u8Slots > 1) ? (u32Offset + u32Len) : u32Offset);
+        u32Offset += u32Len * psEpCfg[i].u8Slots;
+
+        g_usbd_EpCfg[u32Ep] = (psEpCfg[i].u8Addr & 0xF) | ((psEpCfg[i].u8Addr & EP_INPUT) ? USBD_CFG_EPMODE_IN : USBD_CFG_EPMODE_OUT);
+        if((psEpCfg[i].u8Addr & 0xF) && (psEpCfg[i].u8Type == EP_ISO))
+            g_usbd_EpCfg[u32Ep] |= USBD_CFG_TYPE_ISO;
+
+        g_usbd_pfnEpHandler[u32Ep] = (psEpCfg[i].u8Addr & 0xF) ? psEpCfg[i].pfnHandler : NULL;
+
+        USBD_CONFIG_EP(u32Ep, g_usbd_EpCfg[u32Ep] | ((psEpCfg[i].u8Addr & 0xF) ? 0 : USBD_CFG_CSTALL));
+        USBD_SET_EP_BUF_ADDR(u32Ep, g_usbd_EpBuf[u32Ep][0]);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief       Restore an endpoint to the state set by \ref USBD_ConfigEpTable
+ *
+ * @param[in]   u32Ep   The endpoint buffer number, EP0 ~ EP7.
+ *
+ * @return      None
+ *
+ * @details     This function clears the stall and ready state of the endpoint, resets its data toggle to DATA0 and
+ *              assigns its first packet buffer again. It is usually called for the data endpoints at SET CONFIGURATION.
+ */
+void USBD_ResetEp(uint32_t u32Ep)
+{
+    /* Clear stall status and ready */
+    USBD->EP[u32Ep].CFGP = USBD_CFGP_CLRRDY_Msk;
+    USBD_CONFIG_EP(u32Ep, g_usbd_EpCfg[u32Ep]);
+    USBD_SET_EP_BUF_ADDR(u32Ep, g_usbd_EpBuf[u32Ep][0]);
+}
+
+/**
+ * @brief       Get a packet buffer of an endpoint
+ *
+ * @param[in]   u32Ep   The endpoint buffer number, EP0 ~ EP7.
+ * @param[in]   u32Slot 0 for the first packet buffer, 1 for the second one.
+ *
+ * @return      The USB SRAM offset of the packet buffer.
+ *
+ * @details     For an endpoint with one packet buffer both slots give the same offset.
+ */
+uint32_t USBD_GetEpSlotBuf(uint32_t u32Ep, uint32_t u32Slot)
+{
+    return g_usbd_EpBuf[u32Ep][u32Slot & 1];
+}
+
+/**
+ * @brief       Swap the packet buffers of an endpoint
+ *
+ * @param[in]   u32Ep   The endpoint buffer number, EP0 ~ EP7.
+ *
+ * @return      The USB SRAM offset of the packet buffer now assigned to the endpoint.
+ *
+ * @details     This function assigns the other packet buffer of a ping-pong pair to the endpoint. It must be called
+ *              only while the endpoint is not ready. For an endpoint with one packet buffer nothing changes.
+ */
+uint32_t USBD_SwapEpBuf(uint32_t u32Ep)
+{
+    uint32_t u32Buf = g_usbd_EpBuf[u32Ep][0];
+
+    if(USBD_GET_EP_BUF_ADDR(u32Ep) == u32Buf)
+        u32Buf = g_usbd_EpBuf[u32Ep][1];
+    USBD_SET_EP_BUF_ADDR(u32Ep, u32Buf);
+
+    return u32Buf;
+}
+
+/**
+ * @brief       Process USBD interrupt events
+ *
+ * @param       None
+ *
+ * @return      None
+ *
+ * @details     This function is called by USBD_IRQHandler of the application. It handles the floating detect,
+ *              wake-up and bus events and calls the callback set by \ref USBD_SetBusEventCallback for the bus events.
+ *              The control pipe is served before the data endpoints, so a setup packet is answered within one
+ *              interrupt even when bulk traffic is active. Events of the data endpoints call the handlers of
+ *              the endpoint configuration table given to \ref USBD_ConfigEpTable.
+ */
+void USBD_IRQDispatch(void)
+{
+    uint32_t u32IntSts = USBD_GET_INT_FLAG();
+    uint32_t u32State = USBD_GET_BUS_STATE();
+    uint32_t u32EpSts, i;
+
+    if(u32IntSts & USBD_INTSTS_FLDET)
+    {
+        // Floating detect
+        USBD_CLR_INT_FLAG(USBD_INTSTS_FLDET);
+
+        if(USBD_IS_ATTACHED())
+        {
+            /* USB Plug In */
+            USBD_ENABLE_USB();
+        }
+        else
+        {
+            /* USB Un-plug */
+            USBD_DISABLE_USB();
+        }
+    }
+
+    if(u32IntSts & USBD_INTSTS_WAKEUP)
+    {
+        /* Clear event flag */
+        USBD_CLR_INT_FLAG(USBD_INTSTS_WAKEUP);
+    }
+
+    if(u32IntSts & USBD_INTSTS_BUS)
+    {
+        /* Clear event flag */
+        USBD_CLR_INT_FLAG(USBD_INTSTS_BUS);
+
+        if(u32State & USBD_STATE_USBRST)
+        {
+            /* Bus reset */
+            USBD_ENABLE_USB();
+            USBD_SwReset();
+            DBG_PRINTF("Bus reset\n");
+        }
+        if(u32State & USBD_STATE_SUSPEND)
+        {
+            /* Enable USB but disable PHY */
+            USBD_DISABLE_PHY();
+            DBG_PRINTF("Suspend\n");
+        }
+        if(u32State & USBD_STATE_RESUME)
+        {
+            /* Enable USB and enable PHY */
+            USBD_ENABLE_USB();
+            DBG_PRINTF("Resume\n");
+        }
+
+        if(g_usbd_pfnBusEvent != NULL)
+            g_usbd_pfnBusEvent(u32State & (USBD_STATE_USBRST | USBD_STATE_SUSPEND | USBD_STATE_RESUME));
+    }
+
+    if(u32IntSts & USBD_INTSTS_USB)
+    {
+        /* Clear the endpoint and setup event flags at once */
+        u32EpSts = u32IntSts & (USBD_INTSTS_SETUP | (0xFFul << USBD_INTSTS_EPEVT0_Pos));
+        USBD_CLR_INT_FLAG(u32EpSts);
+
+        /* Finish the events of the previous control transfer before the new setup packet */
+        if(u32EpSts & USBD_INTSTS_EP0)
+        {
+            // control IN
+            USBD_CtrlIn();
+        }
+
+        if(u32EpSts & USBD_INTSTS_EP1)
+        {
+            // control OUT
+            USBD_CtrlOut();
+        }
+
+        if(u32EpSts & USBD_INTSTS_SETUP)
+        {
+            /* Clear the data IN/OUT ready flag of control end-points */
+            USBD_STOP_TRANSACTION(EP0);
+            USBD_STOP_TRANSACTION(EP1);
+
+            USBD_ProcessSetupPacket();
+        }
+
+        /* Data endpoints EP2 ~ EP7 */
+        u32EpSts = (u32EpSts >> USBD_INTSTS_EPEVT2_Pos) & 0x3F;
+        for(i = EP2; u32EpSts; i++, u32EpSts >>= 1)
+        {
+            if((u32EpSts & 1) && (g_usbd_pfnEpHandler[i] != NULL))
+                g_usbd_pfnEpHandler[i]();
+        }
+    }
+}
+
+#ifdef USBD_MEMCOPY_PDMA_CH
+/**
+ * @brief       Copy data by PDMA
+ *
+ * @param[in]   dest    Destination pointer. It must be word aligned.
+ * @param[in]   src     Source pointer. It must be word aligned.
+ * @param[in]   size    Byte count. It must be a multiple of 4.
+ *
+ * @return      None
+ *
+ * @details     This function is used by \ref USBD_MemCopy to copy data with PDMA channel USBD_MEMCOPY_PDMA_CH in
+ *              memory-to-memory mode. It waits until the copy is done. Interrupts are disabled meanwhile because
+ *              USBD_MemCopy is called in both the USBD interrupt handler and the main loop.
+ *              The PDMA clock must be enabled by the application.
+ */
+void USBD_MemCopyPdma(uint32_t *dest, uint32_t *src, int32_t size)
+{
+    uint32_t u32Primask = __get_PRIMASK();
+
+    __disable_irq();
+
+    PDMA_Open(1 << USBD_MEMCOPY_PDMA_CH);
+    PDMA_SetTransferMode(USBD_MEMCOPY_PDMA_CH, PDMA_MEM, FALSE, 0);
+    PDMA_SetTransferCnt(USBD_MEMCOPY_PDMA_CH, PDMA_WIDTH_32, (uint32_t)size >> 2);
+    PDMA_SetTransferAddr(USBD_MEMCOPY_PDMA_CH, (uint32_t)src, PDMA_SAR_INC, (uint32_t)dest, PDMA_DAR_INC);
+    PDMA_Trigger(USBD_MEMCOPY_PDMA_CH);
+    while(PDMA_IS_CH_BUSY(USBD_MEMCOPY_PDMA_CH));
+    PDMA_CLR_CH_INT_FLAG(USBD_MEMCOPY_PDMA_CH, PDMA_ISR_BLKD_IF_Msk);
+
+    __set_PRIMASK(u32Primask);
+}
+#endif
+
 /*@}*/ /* end of group USBD_EXPORTED_FUNCTIONS */
 
 /*@}*/ /* end of group USBD_Driver */
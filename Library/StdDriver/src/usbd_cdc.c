@@ -0,0 +1,437 @@
+/**************************************************************************//**
+ * @file     usbd_cdc.c
+ * @version  V3.00
+ * @brief    M071R_M071S series USB CDC virtual COM port driver source file
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include <string.h>
+#include "NuMicro.h"
+
+/*
+    CDC abstract control model ports bridged to UARTs. The CPU does not touch the data bytes on the way
+    from USB to the UART, and touches them once on the way back.
+
+    USB to UART: bulk OUT has two packet buffers in USB SRAM. A received packet is queued in place to
+    the UART PDMA transmit queue and the endpoint receives the next packet in the other buffer. While
+    both buffers wait for the UART the endpoint is not armed, so the host gets NAK, and the transmit
+    done callback arms it again with the buffer just sent.
+
+    UART to USB: PDMA receives into a circular buffer without stopping. A bulk IN packet is sent from
+    it as soon as it holds a full packet. The rest is sent as a short packet (or a zero length packet
+    after a full one) when the receive position has stood still for at least two characters, which
+    USBD_CDC_Process checks once per poll period of USB frames. The UART time-out interrupt cannot do
+    this because it never fires while PDMA keeps the RX FIFO empty. nRTS is deasserted when the
+    circular buffer is 3/4 full and asserted again when it has drained to half.
+*/
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup USBD_CDC_Driver USBD CDC Driver
+  @{
+*/
+
+#define CDC_OUT_BUF_NUM         2           /* Packet buffers of bulk OUT */
+
+/* Port state */
+typedef struct
+{
+    const USBD_CDC_PORT_T *psCfg;
+    UART_DMA_TX_T sTx;
+    UART_DMA_RX_T sRx;
+    USBD_CDC_LINE_CODING_T sLineCoding;     /* Set by the host */
+    USBD_CDC_LINE_CODING_T sLineApplied;    /* Programmed to the UART */
+    uint32_t u32IdleMs;                     /* Receive idle poll period in USB frames */
+    uint32_t u32PollFrame;                  /* Frame number of the last receive idle poll */
+    uint32_t u32OutToggle;
+    uint16_t u16CtrlSignal;
+    uint8_t volatile u8OutPending;          /* Bulk OUT packets queued to UART transmit */
+    uint8_t volatile u8OutPaused;           /* Bulk OUT not ready because all its packet buffers are queued */
+    uint8_t volatile u8InBusy;              /* Bulk IN packet waits for the host */
+    uint8_t volatile u8Flush;               /* Send the received data up to a short packet */
+    uint8_t u8InLast;                       /* Size of the last bulk IN packet */
+    uint8_t u8RtsOff;                       /* nRTS deasserted */
+} CDC_PORT_T;
+
+static const USBD_CDC_LINE_CODING_T s_sCdcDefLine = {115200, 0, 0, 8};
+
+static const uint32_t s_au32CdcParity[] =
+{
+    UART_PARITY_NONE, UART_PARITY_ODD, UART_PARITY_EVEN, UART_PARITY_MARK, UART_PARITY_SPACE
+};
+
+static CDC_PORT_T s_asCdcPort[USBD_CDC_MAX_PORT];
+static uint32_t s_u32CdcNum;
+static uint8_t volatile s_u8CdcConfigured;
+
+
+/* Program the line coding set by the host to the UART */
+static void CDC_SetLine(CDC_PORT_T *psPort)
+{
+    const USBD_CDC_LINE_CODING_T *psLine = &psPort->sLineApplied;
+    uint32_t u32DataWidth = UART_WORD_LEN_8;
+    uint32_t u32Parity = UART_PARITY_NONE;
+
+    if((psLine->u8DataBits >= 5) && (psLine->u8DataBits <= 8))
+        u32DataWidth = psLine->u8DataBits - 5;
+    if(psLine->u8ParityType < sizeof(s_au32CdcParity) / sizeof(s_au32CdcParity[0]))
+        u32Parity = s_au32CdcParity[psLine->u8ParityType];
+
+    UART_SetLine_Config(psPort->psCfg->uart, psLine->u32DTERate, u32DataWidth, u32Parity,
+                        (psLine->u8CharFormat == 0) ? UART_STOP_BIT_1 : UART_STOP_BIT_2);
+
+    /* Two characters of 10 bits, rounded up to whole frames */
+    if(psLine->u32DTERate != 0)
+        psPort->u32IdleMs = 1 + 20000 / psLine->u32DTERate;
+}
+
+/* Send the next bulk IN packet from the receive buffer. Called with the USB interrupt blocked. */
+static void CDC_InSend(CDC_PORT_T *psPort)
+{
+    uint32_t u32Ep = psPort->psCfg->u32InEp;
+    uint32_t u32Len;
+
+    if(!s_u8CdcConfigured || psPort->u8InBusy)
+        return;
+
+    u32Len = UART_DmaRxGetCount(&psPort->sRx);
+    if(u32Len >= USBD_CDC_MAX_PKT_SIZE)
+        u32Len = USBD_CDC_MAX_PKT_SIZE;
+    else if(!psPort->u8Flush)
+        return;
+    else
+    {
+        /* A short packet ends the transfer. Nothing to end if the last packet was short. */
+        psPort->u8Flush = 0;
+        if((u32Len == 0) && (psPort->u8InLast != USBD_CDC_MAX_PKT_SIZE))
+            return;
+    }
+
+    u32Len = UART_DmaRxRead(&psPort->sRx, (uint8_t *)(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(u32Ep)), u32Len);
+    psPort->u8InLast = (uint8_t)u32Len;
+    psPort->u8InBusy = 1;
+    USBD_SET_PAYLOAD_LEN(u32Ep, u32Len);
+}
+
+/* UART transmit done with a bulk OUT packet buffer. Called in PDMA interrupt. */
+static void CDC_TxDone(const uint8_t *pu8Buf, uint32_t u32Len)
+{
+    uint32_t u32Offset = (uint32_t)pu8Buf - USBD_BUF_BASE;
+    uint32_t i, u32Ep, u32Primask;
+    CDC_PORT_T *psPort;
+
+    (void)u32Len;
+
+    for(i = 0; i < s_u32CdcNum; i++)
+    {
+        psPort = &s_asCdcPort[i];
+        u32Ep = psPort->psCfg->u32OutEp;
+        if((u32Offset != USBD_GetEpSlotBuf(u32Ep, 0)) && (u32Offset != USBD_GetEpSlotBuf(u32Ep, 1)))
+            continue;
+
+        u32Primask = __get_PRIMASK();
+        __disable_irq();
+        psPort->u8OutPending--;
+        if(psPort->u8OutPaused)
+        {
+            /* The endpoint was left on the buffer that was queued first, which is the one just sent */
+            psPort->u8OutPaused = 0;
+            USBD_SET_PAYLOAD_LEN(u32Ep, USBD_CDC_MAX_PKT_SIZE);
+        }
+        __set_PRIMASK(u32Primask);
+        break;
+    }
+}
+
+
+/** @addtogroup USBD_CDC_EXPORTED_FUNCTIONS USBD CDC Exported Functions
+  @{
+*/
+
+/**
+ * @brief       Open the virtual COM ports
+ *
+ * @param[in]   psPorts     Configuration of the ports. It must stay valid while the driver runs.
+ * @param[in]   u32Num      Number of ports, 1 ~ \ref USBD_CDC_MAX_PORT
+ *
+ * @return      None
+ *
+ * @details     The UARTs must be opened and the PDMA clock enabled before this function is called. It sets the
+ *              UARTs to 115200 8N1 until the host sets the line coding, starts PDMA receive and asserts nRTS.
+ *              The bulk OUT endpoint of each port must have two packet buffers, see \ref USBD_ConfigEpTable.
+ *              Call \ref USBD_CDC_SetConfig from the set configuration callback, \ref USBD_CDC_ClassRequest for
+ *              the class requests, \ref USBD_CDC_BulkIn and \ref USBD_CDC_BulkOut from the endpoint events of
+ *              USBD_IRQHandler, \ref USBD_CDC_PdmaIRQHandler from PDMA_IRQHandler and \ref USBD_CDC_Process
+ *              from the main loop.
+ */
+void USBD_CDC_Open(const USBD_CDC_PORT_T *psPorts, uint32_t u32Num)
+{
+    CDC_PORT_T *psPort;
+    uint32_t i;
+
+    s_u32CdcNum = (u32Num > USBD_CDC_MAX_PORT) ? USBD_CDC_MAX_PORT : u32Num;
+    s_u8CdcConfigured = 0;
+
+    for(i = 0; i < s_u32CdcNum; i++)
+    {
+        psPort = &s_asCdcPort[i];
+        memset(psPort, 0, sizeof(CDC_PORT_T));
+        psPort->psCfg = &psPorts[i];
+        psPort->sLineCoding = s_sCdcDefLine;
+        psPort->sLineApplied = s_sCdcDefLine;
+        CDC_SetLine(psPort);
+
+        UART_CLEAR_RTS(psPorts[i].uart);
+        UART_DmaRxOpen(&psPort->sRx, psPorts[i].uart, psPorts[i].u32RxCh, psPorts[i].pu8RxBuf, psPorts[i].u32RxSize);
+        UART_DmaTxOpen(&psPort->sTx, psPorts[i].uart, psPorts[i].u32TxCh, CDC_TxDone);
+    }
+}
+
+/**
+ * @brief       Start the bulk pipes of all ports
+ *
+ * @return      None
+ *
+ * @details     Call it from the set configuration callback after the bulk endpoints are restored by
+ *              \ref USBD_ResetEp. OUT data not yet transmitted by the UARTs is dropped; received UART data
+ *              is kept and sent to the host.
+ */
+void USBD_CDC_SetConfig(void)
+{
+    CDC_PORT_T *psPort;
+    uint32_t i, u32Primask;
+
+    for(i = 0; i < s_u32CdcNum; i++)
+    {
+        psPort = &s_asCdcPort[i];
+
+        u32Primask = __get_PRIMASK();
+        __disable_irq();
+        UART_DmaTxClose(&psPort->sTx);
+        UART_DmaTxOpen(&psPort->sTx, psPort->psCfg->uart, psPort->psCfg->u32TxCh, CDC_TxDone);
+        psPort->u8OutPending = 0;
+        psPort->u8OutPaused = 0;
+        psPort->u32OutToggle = 0;
+        psPort->u8InBusy = 0;
+        psPort->u8InLast = 0;
+        __set_PRIMASK(u32Primask);
+
+        USBD_SET_PAYLOAD_LEN(psPort->psCfg->u32OutEp, USBD_CDC_MAX_PKT_SIZE);
+    }
+    s_u8CdcConfigured = 1;
+}
+
+/**
+ * @brief       Process a CDC class request
+ *
+ * @return      None
+ *
+ * @details     This function handles GET_LINE_CODING, SET_LINE_CODING and SET_CONTROL_LINE_STATE of the
+ *              communication interfaces given to \ref USBD_CDC_Open. Other requests are stalled.
+ *              A new line coding is programmed to the UART by the next \ref USBD_CDC_Process.
+ */
+void USBD_CDC_ClassRequest(void)
+{
+    uint8_t au8Buf[8];
+    CDC_PORT_T *psPort = NULL;
+    uint32_t i;
+
+    USBD_GetSetupPacket(au8Buf);
+
+    for(i = 0; i < s_u32CdcNum; i++)
+    {
+        if(au8Buf[4] == s_asCdcPort[i].psCfg->u32Intf)
+            psPort = &s_asCdcPort[i];
+    }
+
+    if((psPort != NULL) && (au8Buf[0] & EP_INPUT) && (au8Buf[1] == USBD_CDC_GET_LINE_CODING))
+    {
+        USBD_MemCopy((uint8_t *)(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0)), (uint8_t *)&psPort->sLineCoding, 7);
+        /* Data stage */
+        USBD_SET_DATA1(EP0);
+        USBD_SET_PAYLOAD_LEN(EP0, 7);
+        /* Status stage */
+        USBD_PrepareCtrlOut(0, 0);
+    }
+    else if((psPort != NULL) && !(au8Buf[0] & EP_INPUT) && (au8Buf[1] == USBD_CDC_SET_LINE_CODING))
+    {
+        USBD_PrepareCtrlOut((uint8_t *)&psPort->sLineCoding, 7);
+
+        /* Status stage */
+        USBD_SET_DATA1(EP0);
+        USBD_SET_PAYLOAD_LEN(EP0, 0);
+    }
+    else if((psPort != NULL) && !(au8Buf[0] & EP_INPUT) && (au8Buf[1] == USBD_CDC_SET_CONTROL_LINE_STATE))
+    {
+        psPort->u16CtrlSignal = (uint16_t)(au8Buf[2] | (au8Buf[3] << 8));
+
+        /* Status stage */
+        USBD_SET_DATA1(EP0);
+        USBD_SET_PAYLOAD_LEN(EP0, 0);
+    }
+    else
+    {
+        /* Setup error, stall the device */
+        USBD_SetStall(EP0);
+        USBD_SetStall(EP1);
+    }
+}
+
+/**
+ * @brief       Process a bulk IN event
+ *
+ * @param[in]   u32Port     Port index in the table given to \ref USBD_CDC_Open
+ *
+ * @return      None
+ *
+ * @details     Call it from USBD_IRQHandler on the event of the bulk IN endpoint of the port.
+ */
+void USBD_CDC_BulkIn(uint32_t u32Port)
+{
+    CDC_PORT_T *psPort = &s_asCdcPort[u32Port];
+
+    psPort->u8InBusy = 0;
+    CDC_InSend(psPort);
+}
+
+/**
+ * @brief       Process a bulk OUT event
+ *
+ * @param[in]   u32Port     Port index in the table given to \ref USBD_CDC_Open
+ *
+ * @return      None
+ *
+ * @details     Call it from USBD_IRQHandler on the event of the bulk OUT endpoint of the port. The packet is
+ *              queued to the UART in place and the endpoint is armed with the other packet buffer.
+ */
+void USBD_CDC_BulkOut(uint32_t u32Port)
+{
+    CDC_PORT_T *psPort = &s_asCdcPort[u32Port];
+    uint32_t u32Ep = psPort->psCfg->u32OutEp;
+    uint32_t u32Toggle = USBD->EPSTS & (USBD_EPSTS_EPSTS0_Msk << (3 * u32Ep));
+    uint32_t u32Len, u32Primask;
+
+    /* Drop a packet sent again because the host lost the ACK */
+    if(u32Toggle == psPort->u32OutToggle)
+    {
+        USBD_SET_PAYLOAD_LEN(u32Ep, USBD_CDC_MAX_PKT_SIZE);
+        return;
+    }
+    psPort->u32OutToggle = u32Toggle;
+
+    u32Len = USBD_GET_PAYLOAD_LEN(u32Ep);
+    if(u32Len == 0)
+    {
+        USBD_SET_PAYLOAD_LEN(u32Ep, USBD_CDC_MAX_PKT_SIZE);
+        return;
+    }
+
+    u32Primask = __get_PRIMASK();
+    __disable_irq();
+    UART_DmaTxQueue(&psPort->sTx, (uint8_t *)(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(u32Ep)), u32Len);
+    psPort->u8OutPending++;
+    USBD_SwapEpBuf(u32Ep);
+    if(psPort->u8OutPending < CDC_OUT_BUF_NUM)
+        USBD_SET_PAYLOAD_LEN(u32Ep, USBD_CDC_MAX_PKT_SIZE);
+    else
+        psPort->u8OutPaused = 1;
+    __set_PRIMASK(u32Primask);
+}
+
+/**
+ * @brief       PDMA interrupt service of the ports
+ *
+ * @return      None
+ *
+ * @details     Call it from PDMA_IRQHandler of the application.
+ */
+void USBD_CDC_PdmaIRQHandler(void)
+{
+    uint32_t i;
+
+    for(i = 0; i < s_u32CdcNum; i++)
+    {
+        UART_DmaTxIRQHandler(&s_asCdcPort[i].sTx);
+        UART_DmaRxIRQHandler(&s_asCdcPort[i].sRx);
+    }
+}
+
+/**
+ * @brief       Run the virtual COM ports
+ *
+ * @return      None
+ *
+ * @details     Call this function from the main loop at least once per USB frame. It programs a new line
+ *              coding, detects the end of received data, starts bulk IN and drives nRTS.
+ */
+void USBD_CDC_Process(void)
+{
+    CDC_PORT_T *psPort;
+    uint32_t i, u32Count, u32Size, u32Idle;
+    uint32_t u32Frame = USBD->FN;
+
+    for(i = 0; i < s_u32CdcNum; i++)
+    {
+        psPort = &s_asCdcPort[i];
+
+        if(memcmp(&psPort->sLineCoding, &psPort->sLineApplied, 7) != 0)
+        {
+            NVIC_DisableIRQ(USBD_IRQn);
+            psPort->sLineApplied = psPort->sLineCoding;
+            NVIC_EnableIRQ(USBD_IRQn);
+            CDC_SetLine(psPort);
+        }
+
+        /* The receive position did not move for a poll period */
+        u32Idle = 0;
+        if(((u32Frame - psPort->u32PollFrame) & USBD_FN_FN_Msk) >= psPort->u32IdleMs)
+        {
+            psPort->u32PollFrame = u32Frame;
+            u32Idle = UART_DmaRxPollFrame(&psPort->sRx, NULL);
+        }
+
+        NVIC_DisableIRQ(USBD_IRQn);
+        if(u32Idle)
+            psPort->u8Flush = 1;
+        CDC_InSend(psPort);
+        NVIC_EnableIRQ(USBD_IRQn);
+
+        /* Flow control on the fill level of the receive buffer */
+        u32Count = UART_DmaRxGetCount(&psPort->sRx);
+        u32Size = psPort->psCfg->u32RxSize;
+        if(!psPort->u8RtsOff && (u32Count >= u32Size - u32Size / 4))
+        {
+            UART_SET_RTS(psPort->psCfg->uart);
+            psPort->u8RtsOff = 1;
+        }
+        else if(psPort->u8RtsOff && (u32Count <= u32Size / 2))
+        {
+            UART_CLEAR_RTS(psPort->psCfg->uart);
+            psPort->u8RtsOff = 0;
+        }
+    }
+}
+
+/**
+ * @brief       Get the control signals set by the host
+ *
+ * @param[in]   u32Port     Port index in the table given to \ref USBD_CDC_Open
+ *
+ * @return      Value of the last SET_CONTROL_LINE_STATE. \ref USBD_CDC_CTRL_DTR and \ref USBD_CDC_CTRL_RTS.
+ */
+uint32_t USBD_CDC_GetCtrlSignal(uint32_t u32Port)
+{
+    return s_asCdcPort[u32Port].u16CtrlSignal;
+}
+
+/*@}*/ /* end of group USBD_CDC_EXPORTED_FUNCTIONS */
+
+/*@}*/ /* end of group USBD_CDC_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -0,0 +1,1153 @@
+/**************************************************************************//**
+ * @file     usbd_msc.c
+ * @version  V3.00
+ * @brief    M071R_M071S series USB mass storage class driver source file
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
+*****************************************************************************/
+#include <string.h>
+#include "NuMicro.h"
+
+/*
+    Bulk-only transport with one logical unit on a block device.
+
+    The USB interrupt only moves packets: USBD_MSC_BulkOut takes the CBW and the OUT data, and
+    USBD_MSC_BulkIn sends the IN data and the CSW. Commands are decoded and the block device is
+    called by USBD_MSC_Process in the main loop.
+
+    Media data goes through two storage buffers. While the interrupt streams one of them in packets,
+    the main loop reads the other from the medium (READ) or writes it to the medium (WRITE). When the
+    next buffer is not ready the interrupt leaves the endpoint idle, so the host gets NAK, and the main
+    loop restarts it when the buffer is handed over. After a READ has read all of its sectors, the
+    sectors after it are read ahead into the free buffer. A READ that starts there sends its first
+    buffer at once.
+
+    The two bulk endpoints share their packet buffers, because only one of them is active at a time.
+    IN packets are prepared in the buffer that is not being sent, and the next OUT packet is received
+    in the buffer that is not being copied.
+*/
+
+/** @addtogroup Standard_Driver Standard Driver
+  @{
+*/
+
+/** @addtogroup USBD_MSC_Driver USBD MSC Driver
+  @{
+*/
+
+#define MSC_CBW_SIGNATURE       0x43425355UL
+#define MSC_CSW_SIGNATURE       0x53425355UL
+#define MSC_CBW_SIZE            31
+#define MSC_CSW_SIZE            13
+#define MSC_CMD_BUF_SIZE        80          /* Largest command data: MODE SENSE (10) of all pages */
+
+/* Class requests */
+#define MSC_REQ_RESET           0xFF
+#define MSC_REQ_GET_MAX_LUN     0xFE
+
+/* SCSI commands */
+#define MSC_TEST_UNIT_READY     0x00
+#define MSC_REQUEST_SENSE       0x03
+#define MSC_INQUIRY             0x12
+#define MSC_MODE_SELECT_6       0x15
+#define MSC_MODE_SENSE_6        0x1A
+#define MSC_START_STOP          0x1B
+#define MSC_PREVENT_ALLOW       0x1E
+#define MSC_READ_FORMAT_CAP     0x23
+#define MSC_READ_CAPACITY       0x25
+#define MSC_READ_10             0x28
+#define MSC_WRITE_10            0x2A
+#define MSC_VERIFY_10           0x2F
+#define MSC_SYNC_CACHE          0x35
+#define MSC_MODE_SELECT_10      0x55
+#define MSC_MODE_SENSE_10       0x5A
+#define MSC_READ_12             0xA8
+#define MSC_WRITE_12            0xAA
+
+/* Bulk pipe states */
+#define MSC_STATE_CBW           0           /* Waiting for the CBW */
+#define MSC_STATE_CMD           1           /* CBW received, decoded by USBD_MSC_Process */
+#define MSC_STATE_IN            2           /* Data-in phase */
+#define MSC_STATE_OUT           3           /* Data-out phase */
+#define MSC_STATE_CSW           4           /* Sending the CSW */
+
+/* Storage buffer states */
+#define MSC_MEDIA_IDLE          0
+#define MSC_MEDIA_READ          1
+#define MSC_MEDIA_WRITE         2
+
+/* Command Block Wrapper */
+typedef struct
+{
+    uint32_t u32Signature;
+    uint32_t u32Tag;
+    uint32_t u32DataLength;
+    uint8_t  u8Flags;
+    uint8_t  u8Lun;
+    uint8_t  u8CbLength;
+    uint8_t  au8Cb[16];
+} MSC_CBW_T;
+
+/* Command Status Wrapper */
+typedef struct
+{
+    uint32_t u32Signature;
+    uint32_t u32Tag;
+    uint32_t u32Residue;
+    uint8_t  u8Status;
+} MSC_CSW_T;
+
+static const uint8_t s_au8MscInquiry[36] =
+{
+    0x00,                   /* Peripheral Device Type */
+    0x80,                   /* RMB */
+    0x00,                   /* ISO/ECMA, ANSI Version */
+    0x00,                   /* Response Data Format */
+    0x1F, 0x00, 0x00, 0x00, /* Additional Length */
+
+    /* Vendor Identification */
+    'N', 'u', 'v', 'o', 't', 'o', 'n', ' ',
+
+    /* Product Identification */
+    'U', 'S', 'B', ' ', 'M', 'a', 's', 's', ' ', 'S', 't', 'o', 'r', 'a', 'g', 'e',
+
+    /* Product Revision */
+    '1', '.', '0', '0'
+};
+
+static const uint8_t s_au8MscModePage01[12] =
+{
+    0x01, 0x0A, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00,
+    0x03, 0x00, 0x00, 0x00
+};
+
+static const uint8_t s_au8MscModePage05[32] =
+{
+    0x05, 0x1E, 0x13, 0x88, 0x08, 0x20, 0x02, 0x00,
+    0x01, 0xF4, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x05, 0x1E, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x01, 0x68, 0x00, 0x00
+};
+
+static const uint8_t s_au8MscModePage1B[12] =
+{
+    0x1B, 0x0A, 0x00, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00
+};
+
+static const uint8_t s_au8MscModePage1C[8] =
+{
+    0x1C, 0x06, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00
+};
+
+/* Configuration */
+static const USBD_MSC_BLKDEV_T *s_psMscDev;
+static const uint8_t *s_pu8MscInquiry;
+static uint32_t s_u32MscInEp, s_u32MscOutEp, s_u32MscIntf;
+static uint32_t s_u32MscBuf0, s_u32MscBuf1;     /* Packet buffers in USB SRAM, shared by bulk IN and OUT */
+static uint32_t s_u32MscSectors;
+
+/* Bulk-only transport */
+static MSC_CBW_T s_sMscCbw;
+static MSC_CSW_T s_sMscCsw;
+static uint8_t s_au8MscSense[3];                /* Sense key, ASC, ASCQ */
+static uint8_t s_u8MscEjected;
+static uint8_t volatile s_u8MscState;
+static uint8_t volatile s_u8MscCbwStall;        /* Pipes stalled by an invalid CBW. Take the next OUT packet regardless of toggle */
+static uint8_t s_u8MscStall;                    /* Stall the data pipe before the CSW because the host expects more data */
+static uint32_t volatile s_u32MscOutToggle;
+
+/* Data phase */
+static uint8_t s_u8MscMediaData;                /* Data phase moves media data through the storage buffers */
+static uint32_t volatile s_u32MscLength;        /* Bytes left in the data phase */
+static uint32_t s_u32MscAddr;                   /* RAM address of the next packet */
+static uint32_t s_u32MscBufLeft;                /* Bytes left in the storage buffer being sent */
+static uint32_t s_u32MscInNext;                 /* Size of the IN packet prepared in the idle packet buffer */
+static uint8_t volatile s_u8MscInWait;          /* Bulk IN waits for a media read */
+static uint8_t volatile s_u8MscOutWait;         /* Bulk OUT waits for a media write */
+static uint8_t volatile s_u8MscOutDone;         /* All OUT data is in the storage buffers */
+
+/* Storage buffers */
+static uint8_t volatile s_u8MscMedia;
+static uint8_t s_u8MscMediaErr;
+static uint32_t volatile s_au32MscBufLen[2];    /* Bytes in the storage buffer. 0 means the buffer is free */
+static uint32_t s_u32MscUsbIdx;                 /* Storage buffer used by the bulk pipe */
+static uint32_t s_u32MscMediaIdx;               /* Storage buffer used by the block device */
+static uint32_t s_u32MscLba;                    /* Next sector of the block device */
+static uint32_t volatile s_u32MscMediaLeft;     /* Bytes of the command not read from the medium yet */
+static uint32_t s_u32MscAheadLba;               /* First sector read ahead after the last READ */
+static uint32_t s_u32MscAheadLen;               /* Bytes read ahead after the last READ */
+
+/* Write back */
+static uint8_t s_u8MscDirty;
+static uint8_t volatile s_u8MscSyncReq;
+static uint32_t s_u32MscIdleFrame;
+
+static uint32_t s_au32MscStorage[2][USBD_MSC_BUFFER_SIZE / 4];
+static uint32_t s_au32MscCmdBuf[MSC_CMD_BUF_SIZE / 4];
+
+static uint32_t MSC_GetBe32(const uint8_t *pu8Buf)
+{
+    return ((uint32_t)pu8Buf[0] << 24) | ((uint32_t)pu8Buf[1] << 16) | ((uint32_t)pu8Buf[2] << 8) | pu8Buf[3];
+}
+
+static void MSC_PutBe32(uint8_t *pu8Buf, uint32_t u32Data)
+{
+    pu8Buf[0] = (uint8_t)(u32Data >> 24);
+    pu8Buf[1] = (uint8_t)(u32Data >> 16);
+    pu8Buf[2] = (uint8_t)(u32Data >> 8);
+    pu8Buf[3] = (uint8_t)u32Data;
+}
+
+static uint32_t MSC_OtherBuf(uint32_t u32Buf)
+{
+    return (u32Buf == s_u32MscBuf0) ? s_u32MscBuf1 : s_u32MscBuf0;
+}
+
+static void MSC_SetSense(uint8_t u8Key, uint8_t u8Asc, uint8_t u8Ascq)
+{
+    s_au8MscSense[0] = u8Key;
+    s_au8MscSense[1] = u8Asc;
+    s_au8MscSense[2] = u8Ascq;
+}
+
+static void MSC_Sync(void)
+{
+    if(s_psMscDev->pfnSync != NULL)
+    {
+        while(s_psMscDev->pfnSync() == USBD_MSC_BUSY);
+    }
+    s_u8MscDirty = 0;
+}
+
+static void MSC_SendCsw(void)
+{
+    if(s_u8MscMediaErr)
+        s_sMscCsw.u8Status = 1;
+
+    /* The host clears the stall before it reads the CSW */
+    if(s_u8MscStall)
+    {
+        s_u8MscStall = 0;
+        if(s_sMscCbw.u8Flags & 0x80)
+            USBD_SET_EP_STALL(s_u32MscInEp);
+        else
+        {
+            USBD_SET_EP_STALL(s_u32MscOutEp);
+            s_u8MscCbwStall = 1;
+        }
+    }
+
+    s_u8MscState = MSC_STATE_CSW;
+    USBD_SET_EP_BUF_ADDR(s_u32MscInEp, s_u32MscBuf1);
+    USBD_MemCopy((uint8_t *)(USBD_BUF_BASE + s_u32MscBuf1), (uint8_t *)&s_sMscCsw, MSC_CSW_SIZE);
+    USBD_SET_PAYLOAD_LEN(s_u32MscInEp, MSC_CSW_SIZE);
+}
+
+/* Copy the next IN packet to a packet buffer. Returns its size, or 0 if there is none (yet). */
+static uint32_t MSC_InFill(uint32_t u32Buf)
+{
+    uint32_t u32Size = USBD_MSC_MAX_PKT_SIZE;
+
+    if(s_u32MscLength == 0)
+        return 0;
+
+    if(s_u8MscMediaData)
+    {
+        if(s_u32MscBufLeft == 0)
+        {
+            /* Media read of the next storage buffer is not done */
+            if(s_au32MscBufLen[s_u32MscUsbIdx] == 0)
+                return 0;
+
+            s_u32MscBufLeft = s_au32MscBufLen[s_u32MscUsbIdx];
+            s_u32MscAddr = (uint32_t)s_au32MscStorage[s_u32MscUsbIdx];
+        }
+        if(u32Size > s_u32MscBufLeft)
+            u32Size = s_u32MscBufLeft;
+    }
+    if(u32Size > s_u32MscLength)
+        u32Size = s_u32MscLength;
+
+    USBD_MemCopy((uint8_t *)(USBD_BUF_BASE + u32Buf), (uint8_t *)s_u32MscAddr, u32Size);
+    s_u32MscAddr += u32Size;
+    s_u32MscLength -= u32Size;
+
+    if(s_u8MscMediaData)
+    {
+        /* Storage buffer is sent out. Give it back to the media read. */
+        s_u32MscBufLeft -= u32Size;
+        if(s_u32MscBufLeft == 0)
+        {
+            s_au32MscBufLen[s_u32MscUsbIdx] = 0;
+            s_u32MscUsbIdx ^= 1;
+        }
+        else if(s_u32MscLength == 0)
+        {
+            /* The host takes less than the sectors read (Hi < Di). Release the storage buffer and drop the
+               read ahead, which would follow the unsent part of the buffer. */
+            s_au32MscBufLen[s_u32MscUsbIdx] = 0;
+            s_u32MscBufLeft = 0;
+            s_u32MscAheadLen = 0;
+            s_u8MscMedia = MSC_MEDIA_IDLE;
+        }
+    }
+
+    return u32Size;
+}
+
+/* Bulk IN is idle. Send the next data packet or the CSW. */
+static void MSC_InTrig(void)
+{
+    uint32_t u32Buf = MSC_OtherBuf(USBD_GET_EP_BUF_ADDR(s_u32MscInEp));
+
+    if(s_u32MscInNext == 0)
+    {
+        s_u32MscInNext = MSC_InFill(u32Buf);
+        if(s_u32MscInNext == 0)
+        {
+            if(s_u32MscLength)
+                s_u8MscInWait = 1;
+            else
+                MSC_SendCsw();
+            return;
+        }
+    }
+
+    USBD_SET_EP_BUF_ADDR(s_u32MscInEp, u32Buf);
+    USBD_SET_PAYLOAD_LEN(s_u32MscInEp, s_u32MscInNext);
+
+    /* Prepare the next packet while this one is sent */
+    s_u32MscInNext = MSC_InFill(MSC_OtherBuf(u32Buf));
+}
+
+/* An OUT data packet is in the bulk OUT buffer. Take it if there is room. */
+static void MSC_OutTrig(void)
+{
+    uint32_t u32Buf = USBD_GET_EP_BUF_ADDR(s_u32MscOutEp);
+    uint32_t u32Size = USBD_GET_PAYLOAD_LEN(s_u32MscOutEp);
+    uint32_t u32Len;
+
+    if(s_u8MscMediaData && s_au32MscBufLen[s_u32MscUsbIdx])
+    {
+        s_u8MscOutWait = 1;
+        return;
+    }
+
+    if(u32Size > s_u32MscLength)
+        u32Size = s_u32MscLength;
+
+    /* Receive the next packet to the other buffer while this one is copied */
+    if(s_u32MscLength > u32Size)
+    {
+        USBD_SET_EP_BUF_ADDR(s_u32MscOutEp, MSC_OtherBuf(u32Buf));
+        USBD_SET_PAYLOAD_LEN(s_u32MscOutEp, USBD_MSC_MAX_PKT_SIZE);
+    }
+
+    if(s_u8MscMediaData || (s_u32MscAddr + u32Size <= (uint32_t)s_au32MscCmdBuf + MSC_CMD_BUF_SIZE))
+        USBD_MemCopy((uint8_t *)s_u32MscAddr, (uint8_t *)(USBD_BUF_BASE + u32Buf), u32Size);
+    s_u32MscAddr += u32Size;
+    s_u32MscLength -= u32Size;
+
+    if(s_u8MscMediaData)
+    {
+        /* Storage buffer full or last packet. Hand it to the media write. */
+        u32Len = s_u32MscAddr - (uint32_t)s_au32MscStorage[s_u32MscUsbIdx];
+        if((u32Len >= USBD_MSC_BUFFER_SIZE) || (s_u32MscLength == 0))
+        {
+            s_au32MscBufLen[s_u32MscUsbIdx] = u32Len;
+            s_u32MscUsbIdx ^= 1;
+            s_u32MscAddr = (uint32_t)s_au32MscStorage[s_u32MscUsbIdx];
+            if(s_u32MscLength == 0)
+                s_u8MscOutDone = 1;
+        }
+    }
+    else if(s_u32MscLength == 0)
+        MSC_SendCsw();
+}
+
+/* Start a data-in phase of u32Count blocks of u32Size bytes. Gives the number of bytes to send in *pu32Len and returns 0,
+   or returns -1 if the host does not take it. The count is compared in blocks first, as the byte count of READ(12) can
+   overflow 32 bits. */
+static int32_t MSC_CheckIn(uint32_t u32Count, uint32_t u32Size, uint32_t *pu32Len)
+{
+    uint32_t u32Host = s_sMscCbw.u32DataLength, u32Len;
+
+    if(u32Host == 0)
+    {
+        /* Hn < Di (Case 2) */
+        if(u32Count)
+            s_sMscCsw.u8Status = 1;
+        MSC_SendCsw();
+        return -1;
+    }
+
+    if(!(s_sMscCbw.u8Flags & 0x80))
+    {
+        /* Ho <> Di (Case 10) */
+        s_sMscCsw.u8Status = 1;
+        s_sMscCsw.u32Residue = u32Host;
+        s_u8MscStall = 1;
+        MSC_SendCsw();
+        return -1;
+    }
+
+    if(u32Count > u32Host / u32Size)
+    {
+        /* Hi < Di (Case 7) */
+        s_sMscCsw.u8Status = 1;
+        u32Len = u32Host;
+    }
+    else
+        u32Len = u32Count * u32Size;
+
+    /* Hi > Di (Case 4, 5). A short packet ends the data phase, else stall it. */
+    s_sMscCsw.u32Residue = u32Host - u32Len;
+    if(s_sMscCsw.u32Residue && ((u32Len % USBD_MSC_MAX_PKT_SIZE) == 0))
+        s_u8MscStall = 1;
+
+    *pu32Len = u32Len;
+    return 0;
+}
+
+/* Start a data-out phase of u32Count blocks of u32Size bytes. Gives the number of bytes to receive in *pu32Len and
+   returns 0, or returns -1 if the host does not send it. The count is compared in blocks first as in MSC_CheckIn. */
+static int32_t MSC_CheckOut(uint32_t u32Count, uint32_t u32Size, uint32_t *pu32Len)
+{
+    uint32_t u32Host = s_sMscCbw.u32DataLength, u32Len;
+
+    if(u32Host == 0)
+    {
+        /* Hn < Do (Case 3) */
+        if(u32Count)
+            s_sMscCsw.u8Status = 1;
+        MSC_SendCsw();
+        return -1;
+    }
+
+    if(s_sMscCbw.u8Flags & 0x80)
+    {
+        /* Hi <> Do (Case 8) */
+        s_sMscCsw.u8Status = 1;
+        s_sMscCsw.u32Residue = u32Host;
+        s_u8MscStall = 1;
+        MSC_SendCsw();
+        return -1;
+    }
+
+    if(u32Count > u32Host / u32Size)
+    {
+        /* Ho < Do (Case 13) */
+        s_sMscCsw.u8Status = 1;
+        u32Len = u32Host;
+    }
+    else
+        u32Len = u32Count * u32Size;
+
+    /* Ho > Do (Case 11). Stall the rest of the data. */
+    s_sMscCsw.u32Residue = u32Host - u32Len;
+    if(s_sMscCsw.u32Residue)
+        s_u8MscStall = 1;
+
+    *pu32Len = u32Len;
+    return 0;
+}
+
+/* Send u32Len bytes of command data from s_au32MscCmdBuf. The host gets no more than its allocation length. */
+static void MSC_DataIn(uint32_t u32Len)
+{
+    if(u32Len > s_sMscCbw.u32DataLength)
+        u32Len = s_sMscCbw.u32DataLength;
+
+    if(MSC_CheckIn(u32Len, 1, &u32Len) < 0)
+        return;
+
+    s_u8MscMediaData = 0;
+    s_u32MscAddr = (uint32_t)s_au32MscCmdBuf;
+    s_u32MscLength = u32Len;
+    s_u8MscState = MSC_STATE_IN;
+
+    if(u32Len == 0)
+        MSC_SendCsw();
+    else
+    {
+        NVIC_DisableIRQ(USBD_IRQn);
+        MSC_InTrig();
+        NVIC_EnableIRQ(USBD_IRQn);
+    }
+}
+
+/* Receive u32Len bytes of command data to s_au32MscCmdBuf. Data beyond the buffer is dropped. */
+static void MSC_DataOut(uint32_t u32Len)
+{
+    if(MSC_CheckOut(u32Len, 1, &u32Len) < 0)
+        return;
+
+    s_u8MscMediaData = 0;
+    s_u32MscAddr = (uint32_t)s_au32MscCmdBuf;
+    s_u32MscLength = u32Len;
+
+    if(u32Len == 0)
+        MSC_SendCsw();
+    else
+    {
+        s_u8MscState = MSC_STATE_OUT;
+        USBD_SET_PAYLOAD_LEN(s_u32MscOutEp, USBD_MSC_MAX_PKT_SIZE);
+    }
+}
+
+/* Command without data phase */
+static void MSC_NoData(void)
+{
+    if(s_sMscCbw.u32DataLength)
+    {
+        /* Hi > Dn (Case 4), Ho > Dn (Case 9) */
+        s_sMscCsw.u8Status = 1;
+        s_sMscCsw.u32Residue = s_sMscCbw.u32DataLength;
+        s_u8MscStall = 1;
+    }
+    MSC_SendCsw();
+}
+
+static void MSC_Fail(uint8_t u8Key, uint8_t u8Asc)
+{
+    MSC_SetSense(u8Key, u8Asc, 0);
+    s_sMscCsw.u8Status = 1;
+}
+
+static uint32_t MSC_IsReady(void)
+{
+    s_u32MscSectors = s_u8MscEjected ? 0 : s_psMscDev->pfnGetCapacity();
+    if(s_u32MscSectors == 0)
+    {
+        /* Medium not present */
+        MSC_Fail(0x02, 0x3A);
+        return 0;
+    }
+    return 1;
+}
+
+static void MSC_ModeSense10(void)
+{
+    uint8_t *pu8Buf = (uint8_t *)s_au32MscCmdBuf;
+    uint32_t u32Len = 8, u32Cyl = s_u32MscSectors / 128;
+
+    memset(pu8Buf, 0, MSC_CMD_BUF_SIZE);
+
+    switch(s_sMscCbw.au8Cb[2] & 0x3F)
+    {
+        case 0x01:
+            memcpy(&pu8Buf[u32Len], s_au8MscModePage01, sizeof(s_au8MscModePage01));
+            u32Len += sizeof(s_au8MscModePage01);
+            break;
+
+        case 0x05:
+            memcpy(&pu8Buf[u32Len], s_au8MscModePage05, sizeof(s_au8MscModePage05));
+            pu8Buf[u32Len + 4] = 2;     /* Heads */
+            pu8Buf[u32Len + 5] = 64;    /* Sectors per track */
+            pu8Buf[u32Len + 8] = (uint8_t)(u32Cyl >> 8);
+            pu8Buf[u32Len + 9] = (uint8_t)u32Cyl;
+            u32Len += sizeof(s_au8MscModePage05);
+            break;
+
+        case 0x1B:
+            memcpy(&pu8Buf[u32Len], s_au8MscModePage1B, sizeof(s_au8MscModePage1B));
+            u32Len += sizeof(s_au8MscModePage1B);
+            break;
+
+        case 0x1C:
+            memcpy(&pu8Buf[u32Len], s_au8MscModePage1C, sizeof(s_au8MscModePage1C));
+            u32Len += sizeof(s_au8MscModePage1C);
+            break;
+
+        case 0x3F:
+            memcpy(&pu8Buf[u32Len], s_au8MscModePage01, sizeof(s_au8MscModePage01));
+            u32Len += sizeof(s_au8MscModePage01);
+            memcpy(&pu8Buf[u32Len], s_au8MscModePage05, sizeof(s_au8MscModePage05));
+            pu8Buf[u32Len + 4] = 2;
+            pu8Buf[u32Len + 5] = 64;
+            pu8Buf[u32Len + 8] = (uint8_t)(u32Cyl >> 8);
+            pu8Buf[u32Len + 9] = (uint8_t)u32Cyl;
+            u32Len += sizeof(s_au8MscModePage05);
+            memcpy(&pu8Buf[u32Len], s_au8MscModePage1B, sizeof(s_au8MscModePage1B));
+            u32Len += sizeof(s_au8MscModePage1B);
+            memcpy(&pu8Buf[u32Len], s_au8MscModePage1C, sizeof(s_au8MscModePage1C));
+            u32Len += sizeof(s_au8MscModePage1C);
+            break;
+
+        default:
+            /* Invalid field in CDB */
+            MSC_Fail(0x05, 0x24);
+            MSC_DataIn(0);
+            return;
+    }
+
+    /* Mode data length */
+    pu8Buf[1] = (uint8_t)(u32Len - 2);
+    MSC_DataIn(u32Len);
+}
+
+static void MSC_StartRead(uint32_t u32Lba, uint32_t u32Count)
+{
+    uint32_t u32Len;
+
+    if(MSC_CheckIn(u32Count, USBD_MSC_SECTOR_SIZE, &u32Len) < 0)
+        return;
+
+    s_u8MscMediaData = 1;
+    s_u32MscLength = u32Len;
+    s_u32MscBufLeft = 0;
+    s_u8MscState = MSC_STATE_IN;
+
+    if(u32Len == 0)
+    {
+        MSC_SendCsw();
+        return;
+    }
+
+    if((s_u8MscMedia == MSC_MEDIA_READ) && s_u32MscAheadLen && (u32Lba == s_u32MscAheadLba) && (u32Len >= s_u32MscAheadLen))
+    {
+        /* Sequential read. The first sectors are read ahead already. */
+        s_u32MscMediaLeft = ((u32Len + USBD_MSC_SECTOR_SIZE - 1) & ~(USBD_MSC_SECTOR_SIZE - 1)) - s_u32MscAheadLen;
+    }
+    else
+    {
+        /* Read whole sectors even if the host takes less */
+        s_u8MscMedia = MSC_MEDIA_READ;
+        s_au32MscBufLen[0] = s_au32MscBufLen[1] = 0;
+        s_u32MscUsbIdx = s_u32MscMediaIdx = 0;
+        s_u32MscLba = u32Lba;
+        s_u32MscMediaLeft = (u32Len + USBD_MSC_SECTOR_SIZE - 1) & ~(USBD_MSC_SECTOR_SIZE - 1);
+    }
+    s_u32MscAheadLen = 0;
+
+    /* Send the first packet now if it is read ahead, or else when MSC_ReadAhead reads it */
+    NVIC_DisableIRQ(USBD_IRQn);
+    MSC_InTrig();
+    NVIC_EnableIRQ(USBD_IRQn);
+}
+
+static void MSC_StartWrite(uint32_t u32Lba, uint32_t u32Count)
+{
+    uint32_t u32Len;
+
+    if(MSC_CheckOut(u32Count, USBD_MSC_SECTOR_SIZE, &u32Len) < 0)
+        return;
+
+    if(u32Len == 0)
+    {
+        MSC_SendCsw();
+        return;
+    }
+
+    if(s_psMscDev->pfnWriteStart != NULL)
+        s_psMscDev->pfnWriteStart(u32Lba, u32Len / USBD_MSC_SECTOR_SIZE);
+
+    s_u8MscMedia = MSC_MEDIA_WRITE;
+    s_u8MscDirty = 1;
+    s_au32MscBufLen[0] = s_au32MscBufLen[1] = 0;
+    s_u32MscUsbIdx = s_u32MscMediaIdx = 0;
+    s_u32MscLba = u32Lba;
+    s_u32MscAheadLen = 0;
+    s_u8MscOutWait = s_u8MscOutDone = 0;
+
+    s_u8MscMediaData = 1;
+    s_u32MscAddr = (uint32_t)s_au32MscStorage[0];
+    s_u32MscLength = u32Len;
+    s_u8MscState = MSC_STATE_OUT;
+    USBD_SET_PAYLOAD_LEN(s_u32MscOutEp, USBD_MSC_MAX_PKT_SIZE);
+}
+
+static void MSC_ReadWrite(uint32_t u32Write)
+{
+    uint32_t u32Lba = MSC_GetBe32(&s_sMscCbw.au8Cb[2]);
+    uint32_t u32Count;
+
+    if((s_sMscCbw.au8Cb[0] == MSC_READ_12) || (s_sMscCbw.au8Cb[0] == MSC_WRITE_12))
+        u32Count = MSC_GetBe32(&s_sMscCbw.au8Cb[6]);
+    else
+        u32Count = ((uint32_t)s_sMscCbw.au8Cb[7] << 8) | s_sMscCbw.au8Cb[8];
+
+    if(!MSC_IsReady())
+        u32Count = 0;
+    else if((u32Lba >= s_u32MscSectors) || (u32Count > s_u32MscSectors - u32Lba))
+    {
+        /* Logical block address out of range */
+        MSC_Fail(0x05, 0x21);
+        u32Count = 0;
+    }
+
+    if(u32Write)
+        MSC_StartWrite(u32Lba, u32Count);
+    else
+        MSC_StartRead(u32Lba, u32Count);
+}
+
+static void MSC_ProcessCbw(void)
+{
+    uint8_t *pu8Buf = (uint8_t *)s_au32MscCmdBuf;
+    uint32_t u32Buf = USBD_GET_EP_BUF_ADDR(s_u32MscOutEp);
+
+    USBD_MemCopy((uint8_t *)&s_sMscCbw, (uint8_t *)(USBD_BUF_BASE + u32Buf), MSC_CBW_SIZE);
+
+    if((USBD_GET_PAYLOAD_LEN(s_u32MscOutEp) != MSC_CBW_SIZE) || (s_sMscCbw.u32Signature != MSC_CBW_SIGNATURE))
+    {
+        /* Invalid CBW. Stall both pipes until the reset recovery. */
+        USBD_SET_EP_STALL(s_u32MscInEp);
+        USBD_SET_EP_STALL(s_u32MscOutEp);
+        USBD_LockEpStall((1 << s_u32MscInEp) | (1 << s_u32MscOutEp));
+        s_u8MscCbwStall = 1;
+        s_u8MscState = MSC_STATE_CBW;
+        return;
+    }
+
+    s_sMscCsw.u32Tag = s_sMscCbw.u32Tag;
+    s_sMscCsw.u32Residue = 0;
+    s_sMscCsw.u8Status = 0;
+    s_u8MscStall = 0;
+    s_u8MscMediaErr = 0;
+    s_u32MscInNext = 0;
+    s_u32MscIdleFrame = USBD->FN;
+
+    switch(s_sMscCbw.au8Cb[0])
+    {
+        case MSC_TEST_UNIT_READY:
+            MSC_IsReady();
+            MSC_NoData();
+            break;
+
+        case MSC_REQUEST_SENSE:
+            memset(pu8Buf, 0, 18);
+            pu8Buf[0] = 0x70;
+            pu8Buf[2] = s_au8MscSense[0];
+            pu8Buf[7] = 0x0A;
+            pu8Buf[12] = s_au8MscSense[1];
+            pu8Buf[13] = s_au8MscSense[2];
+            MSC_SetSense(0, 0, 0);
+            MSC_DataIn(18);
+            break;
+
+        case MSC_INQUIRY:
+            memcpy(pu8Buf, s_pu8MscInquiry, 36);
+            MSC_DataIn(36);
+            break;
+
+        case MSC_MODE_SENSE_6:
+            memset(pu8Buf, 0, 4);
+            pu8Buf[0] = 3;
+            MSC_DataIn(4);
+            break;
+
+        case MSC_MODE_SENSE_10:
+            MSC_ModeSense10();
+            break;
+
+        case MSC_MODE_SELECT_6:
+            MSC_DataOut(s_sMscCbw.au8Cb[4]);
+            break;
+
+        case MSC_MODE_SELECT_10:
+            MSC_DataOut(((uint32_t)s_sMscCbw.au8Cb[7] << 8) | s_sMscCbw.au8Cb[8]);
+            break;
+
+        case MSC_READ_FORMAT_CAP:
+            if(MSC_IsReady())
+            {
+                memset(pu8Buf, 0, 20);
+                pu8Buf[3] = 0x10;           /* Capacity list length */
+                MSC_PutBe32(&pu8Buf[4], s_u32MscSectors);
+                pu8Buf[8] = 0x02;           /* Formatted media */
+                pu8Buf[10] = USBD_MSC_SECTOR_SIZE >> 8;
+                MSC_PutBe32(&pu8Buf[12], s_u32MscSectors);
+                pu8Buf[18] = USBD_MSC_SECTOR_SIZE >> 8;
+                MSC_DataIn(20);
+            }
+            else
+                MSC_DataIn(0);
+            break;
+
+        case MSC_READ_CAPACITY:
+            if(MSC_IsReady())
+            {
+                MSC_PutBe32(&pu8Buf[0], s_u32MscSectors - 1);
+                MSC_PutBe32(&pu8Buf[4], USBD_MSC_SECTOR_SIZE);
+                MSC_DataIn(8);
+            }
+            else
+                MSC_DataIn(0);
+            break;
+
+        case MSC_READ_10:
+        case MSC_READ_12:
+            MSC_ReadWrite(0);
+            break;
+
+        case MSC_WRITE_10:
+        case MSC_WRITE_12:
+            MSC_ReadWrite(1);
+            break;
+
+        case MSC_PREVENT_ALLOW:
+            if(s_sMscCbw.au8Cb[4] & 0x01)
+            {
+                /* Medium removal cannot be prevented */
+                MSC_Fail(0x05, 0x24);
+            }
+            else
+                MSC_Sync();
+            MSC_NoData();
+            break;
+
+        case MSC_START_STOP:
+            MSC_Sync();
+            if(s_sMscCbw.au8Cb[4] & 0x02)
+            {
+                /* Load or eject */
+                s_u8MscEjected = (s_sMscCbw.au8Cb[4] & 0x01) ? 0 : 1;
+                s_u8MscMedia = MSC_MEDIA_IDLE;
+            }
+            MSC_NoData();
+            break;
+
+        case MSC_SYNC_CACHE:
+            MSC_Sync();
+            MSC_NoData();
+            break;
+
+        case MSC_VERIFY_10:
+            MSC_NoData();
+            break;
+
+        default:
+            /* Invalid command operation code */
+            MSC_Fail(0x05, 0x20);
+            if(s_sMscCbw.u8Flags & 0x80)
+                MSC_DataIn(0);
+            else
+                MSC_DataOut(0);
+            break;
+    }
+}
+
+/* Read the free storage buffer from the medium and hand it to the bulk IN pipe */
+static void MSC_ReadAhead(void)
+{
+    uint32_t u32Idx = s_u32MscMediaIdx;
+    uint32_t u32Lba, u32Len;
+    int32_t i32Ret;
+
+    if((s_u8MscMedia != MSC_MEDIA_READ) || s_au32MscBufLen[u32Idx])
+        return;
+
+    if(s_u32MscMediaLeft)
+    {
+        u32Len = s_u32MscMediaLeft;
+        if(u32Len > USBD_MSC_BUFFER_SIZE)
+            u32Len = USBD_MSC_BUFFER_SIZE;
+    }
+    else if((s_u32MscAheadLen == 0) && (s_u32MscLba + USBD_MSC_BUFFER_SIZE / USBD_MSC_SECTOR_SIZE <= s_u32MscSectors))
+    {
+        /* All data of the command is read. Read ahead the next sectors for a sequential read. */
+        u32Len = USBD_MSC_BUFFER_SIZE;
+    }
+    else
+        return;
+
+    u32Lba = s_u32MscLba;
+    i32Ret = s_psMscDev->pfnRead(u32Lba, u32Len / USBD_MSC_SECTOR_SIZE, (uint8_t *)s_au32MscStorage[u32Idx]);
+    if(i32Ret == USBD_MSC_BUSY)
+        return;
+
+    NVIC_DisableIRQ(USBD_IRQn);
+
+    /* Drop the data if the transfer was reset meanwhile */
+    if(s_u8MscMedia == MSC_MEDIA_READ)
+    {
+        if(s_u32MscMediaLeft)
+        {
+            s_u32MscMediaLeft -= u32Len;
+            if(i32Ret != USBD_MSC_OK)
+            {
+                /* Unrecovered read error. The data is sent anyway to end the data phase. */
+                MSC_SetSense(0x03, 0x11, 0);
+                s_u8MscMediaErr = 1;
+            }
+        }
+        else if(i32Ret == USBD_MSC_OK)
+        {
+            s_u32MscAheadLba = u32Lba;
+            s_u32MscAheadLen = u32Len;
+        }
+        else
+        {
+            s_u8MscMedia = MSC_MEDIA_IDLE;
+            NVIC_EnableIRQ(USBD_IRQn);
+            return;
+        }
+        s_u32MscLba += u32Len / USBD_MSC_SECTOR_SIZE;
+        s_u32MscMediaIdx ^= 1;
+
+        /* Hand the storage buffer to the bulk IN pipe */
+        s_au32MscBufLen[u32Idx] = u32Len;
+        if(s_u8MscInWait)
+        {
+            s_u8MscInWait = 0;
+            MSC_InTrig();
+        }
+    }
+
+    NVIC_EnableIRQ(USBD_IRQn);
+}
+
+/* Write the full storage buffer to the medium and give it back to the bulk OUT pipe */
+static void MSC_WriteBehind(void)
+{
+    uint32_t u32Idx = s_u32MscMediaIdx;
+    uint32_t u32Len;
+    int32_t i32Ret;
+
+    if(s_u8MscMedia != MSC_MEDIA_WRITE)
+        return;
+
+    u32Len = s_au32MscBufLen[u32Idx];
+    if(u32Len)
+    {
+        i32Ret = s_psMscDev->pfnWrite(s_u32MscLba, u32Len / USBD_MSC_SECTOR_SIZE, (uint8_t *)s_au32MscStorage[u32Idx]);
+        if(i32Ret == USBD_MSC_BUSY)
+            return;
+        if(i32Ret != USBD_MSC_OK)
+        {
+            /* Write error */
+            MSC_SetSense(0x03, 0x0C, 0);
+            s_u8MscMediaErr = 1;
+        }
+        s_u32MscLba += u32Len / USBD_MSC_SECTOR_SIZE;
+        s_u32MscMediaIdx ^= 1;
+
+        NVIC_DisableIRQ(USBD_IRQn);
+        s_au32MscBufLen[u32Idx] = 0;
+        if(s_u8MscOutWait)
+        {
+            s_u8MscOutWait = 0;
+            MSC_OutTrig();
+        }
+        NVIC_EnableIRQ(USBD_IRQn);
+    }
+    else if(s_u8MscOutDone)
+    {
+        /* All data is written to the medium. Return the CSW. */
+        s_u8MscOutDone = 0;
+        s_u8MscMedia = MSC_MEDIA_IDLE;
+        s_u32MscIdleFrame = USBD->FN;
+        MSC_SendCsw();
+    }
+}
+
+/**
+ * @brief       Open the mass storage class driver
+ *
+ * @param[in]   psBlkDev    Block device of the logical unit
+ * @param[in]   pu8Inquiry  36 bytes of standard INQUIRY data. NULL for the default "Nuvoton USB Mass Storage".
+ * @param[in]   u32InEp     Hardware endpoint of bulk IN, e.g. \ref EP2
+ * @param[in]   u32OutEp    Hardware endpoint of bulk OUT, e.g. \ref EP3
+ * @param[in]   u32Intf     Interface number of the mass storage interface
+ *
+ * @return      None
+ *
+ * @details     The endpoints must be configured and given their packet buffers before this function is called.
+ *              Both packet buffers must hold \ref USBD_MSC_MAX_PKT_SIZE bytes; the driver uses them for both
+ *              directions. Call \ref USBD_MSC_SetConfig from the set configuration callback,
+ *              \ref USBD_MSC_ClassRequest for the class requests of the interface, \ref USBD_MSC_BulkIn and
+ *              \ref USBD_MSC_BulkOut from the endpoint events of USBD_IRQHandler, and \ref USBD_MSC_Process
+ *              from the main loop.
+ */
+void USBD_MSC_Open(const USBD_MSC_BLKDEV_T *psBlkDev, const uint8_t *pu8Inquiry, uint32_t u32InEp, uint32_t u32OutEp, uint32_t u32Intf)
+{
+    s_psMscDev = psBlkDev;
+    s_pu8MscInquiry = (pu8Inquiry != NULL) ? pu8Inquiry : s_au8MscInquiry;
+    s_u32MscInEp = u32InEp;
+    s_u32MscOutEp = u32OutEp;
+    s_u32MscIntf = u32Intf;
+    s_u32MscBuf0 = USBD_GET_EP_BUF_ADDR(u32OutEp);
+    s_u32MscBuf1 = USBD_GET_EP_BUF_ADDR(u32InEp);
+
+    s_sMscCsw.u32Signature = MSC_CSW_SIGNATURE;
+    s_u8MscEjected = 0;
+    s_u8MscDirty = 0;
+    s_u32MscSectors = psBlkDev->pfnGetCapacity();
+    USBD_MSC_SetConfig();
+}
+
+/**
+ * @brief       Reset the bulk-only transport
+ *
+ * @return      None
+ *
+ * @details     This function drops any command in progress, loads an ejected medium and prepares bulk OUT to
+ *              receive the CBW. Call it from the set configuration callback.
+ */
+void USBD_MSC_SetConfig(void)
+{
+    s_u8MscState = MSC_STATE_CBW;
+    s_u8MscMedia = MSC_MEDIA_IDLE;
+    s_u8MscInWait = s_u8MscOutWait = s_u8MscOutDone = 0;
+    s_u8MscCbwStall = 0;
+    s_u8MscEjected = 0;
+    s_u32MscOutToggle = 0;
+    s_u32MscLength = 0;
+
+    USBD_LockEpStall(0);
+    USBD_SET_EP_BUF_ADDR(s_u32MscOutEp, s_u32MscBuf0);
+    USBD_SET_PAYLOAD_LEN(s_u32MscOutEp, USBD_MSC_MAX_PKT_SIZE);
+}
+
+/**
+ * @brief       Process a mass storage class request
+ *
+ * @return      None
+ *
+ * @details     This function handles GET MAX LUN and BULK-ONLY MASS STORAGE RESET of the interface given to
+ *              \ref USBD_MSC_Open. Other requests are stalled.
+ */
+void USBD_MSC_ClassRequest(void)
+{
+    uint8_t au8Buf[8];
+
+    USBD_GetSetupPacket(au8Buf);
+
+    if((au8Buf[0] & EP_INPUT) && (au8Buf[1] == MSC_REQ_GET_MAX_LUN) &&
+            (au8Buf[4] == s_u32MscIntf) && (au8Buf[2] + au8Buf[3] + au8Buf[6] + au8Buf[7] == 1))
+    {
+        /* One logical unit */
+        M8(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0)) = 0;
+        USBD_SET_DATA1(EP0);
+        USBD_SET_PAYLOAD_LEN(EP0, 1);
+        /* Status stage */
+        USBD_PrepareCtrlOut(0, 0);
+
+        s_u32MscOutToggle = 0;
+        USBD_SET_DATA0(s_u32MscInEp);
+    }
+    else if(!(au8Buf[0] & EP_INPUT) && (au8Buf[1] == MSC_REQ_RESET) &&
+            (au8Buf[4] == s_u32MscIntf) && (au8Buf[2] + au8Buf[3] + au8Buf[6] + au8Buf[7] == 0))
+    {
+        /* Drop the command in progress */
+        s_u8MscState = MSC_STATE_CBW;
+        s_u8MscMedia = MSC_MEDIA_IDLE;
+        s_u8MscInWait = s_u8MscOutWait = s_u8MscOutDone = 0;
+        s_u32MscLength = 0;
+        USBD_LockEpStall(0);
+
+        /* Clear ready */
+        USBD->EP[s_u32MscInEp].CFGP |= USBD_CFGP_CLRRDY_Msk;
+        USBD->EP[s_u32MscOutEp].CFGP |= USBD_CFGP_CLRRDY_Msk;
+        USBD_SET_DATA0(s_u32MscInEp);
+
+        /* Prepare to receive the CBW */
+        USBD_SET_DATA1(s_u32MscOutEp);
+        USBD_SET_EP_BUF_ADDR(s_u32MscOutEp, s_u32MscBuf0);
+        USBD_SET_PAYLOAD_LEN(s_u32MscOutEp, USBD_MSC_MAX_PKT_SIZE);
+
+        /* Status stage */
+        USBD_SET_DATA1(EP0);
+        USBD_SET_PAYLOAD_LEN(EP0, 0);
+    }
+    else
+    {
+        /* Setup error, stall the device */
+        USBD_SetStall(EP0);
+        USBD_SetStall(EP1);
+    }
+}
+
+/**
+ * @brief       Bulk IN endpoint event
+ *
+ * @return      None
+ *
+ * @details     Call this function from USBD_IRQHandler when the bulk IN endpoint has sent a packet.
+ */
+void USBD_MSC_BulkIn(void)
+{
+    if(s_u8MscState == MSC_STATE_CSW)
+    {
+        /* Prepare to receive the CBW */
+        s_u8MscState = MSC_STATE_CBW;
+        USBD_SET_EP_BUF_ADDR(s_u32MscOutEp, s_u32MscBuf0);
+        USBD_SET_PAYLOAD_LEN(s_u32MscOutEp, USBD_MSC_MAX_PKT_SIZE);
+    }
+    else if(s_u8MscState == MSC_STATE_IN)
+        MSC_InTrig();
+}
+
+/**
+ * @brief       Bulk OUT endpoint event
+ *
+ * @return      None
+ *
+ * @details     Call this function from USBD_IRQHandler when the bulk OUT endpoint has received a packet.
+ */
+void USBD_MSC_BulkOut(void)
+{
+    uint32_t u32Toggle = USBD->EPSTS & (USBD_EPSTS_EPSTS0_Msk << (3 * s_u32MscOutEp));
+
+    /* The host sent the packet again because it lost the ACK. It is already taken. */
+    if((u32Toggle == s_u32MscOutToggle) && !s_u8MscCbwStall)
+    {
+        USBD_SET_PAYLOAD_LEN(s_u32MscOutEp, USBD_MSC_MAX_PKT_SIZE);
+        return;
+    }
+    s_u32MscOutToggle = u32Toggle;
+    s_u8MscCbwStall = 0;
+
+    if(s_u8MscState == MSC_STATE_CBW)
+        s_u8MscState = MSC_STATE_CMD;
+    else if(s_u8MscState == MSC_STATE_OUT)
+        MSC_OutTrig();
+}
+
+/**
+ * @brief       Run the mass storage class driver
+ *
+ * @return      None
+ *
+ * @details     Call this function from the main loop. It decodes the commands and calls the block device.
+ */
+void USBD_MSC_Process(void)
+{
+    /* Move data between the medium and the storage buffers */
+    MSC_ReadAhead();
+    MSC_WriteBehind();
+
+    if(s_u8MscState == MSC_STATE_CMD)
+        MSC_ProcessCbw();
+    else if(s_u8MscState == MSC_STATE_CBW)
+    {
+        /* Write back when the host has been idle or the bus is suspended */
+        if(s_u8MscDirty && (s_u8MscSyncReq || (((USBD->FN - s_u32MscIdleFrame) & USBD_FN_FN_Msk) >= USBD_MSC_SYNC_IDLE_MS)))
+            MSC_Sync();
+        s_u8MscSyncReq = 0;
+    }
+}
+
+/**
+ * @brief       Request a write back of the block device
+ *
+ * @return      None
+ *
+ * @details     The next \ref USBD_MSC_Process between commands calls the sync function of the block device if
+ *              data was written since the last sync. Call it on bus suspend, where the frame number used for the
+ *              idle time stops.
+ */
+void USBD_MSC_RequestSync(void)
+{
+    s_u8MscSyncReq = 1;
+}
+
+/*@}*/ /* end of group USBD_MSC_Driver */
+
+/*@}*/ /* end of group Standard_Driver */
+
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -164,4 +164,28 @@ void UpdateConfig(unsigned int *data, unsigned int *res)
     FMC_DISABLE_CFG_UPDATE();
 }
 
+int GetCRC32(unsigned int addr_start, unsigned int addr_end, uint32_t *crc)
+{
+    unsigned int u32Addr, u32Data;
+
+    /* CRC-32 as zlib crc32, by the CRC channel of PDMA. APROM is not mapped on the bus while running in
+       LDROM, so the words are read by ISP commands and written to the CRC channel by CPU. */
+    CLK->AHBCLK |= CLK_AHBCLK_PDMA_EN_Msk;
+    PDMA_GCR->GCRCSR |= PDMA_GCRCSR_CRC_CLK_EN_Msk;
+    CRC->SEED = 0xFFFFFFFF;
+    CRC->CTL = CRC_32 | CRC_WDATA_RVS | CRC_CHECKSUM_RVS | CRC_CHECKSUM_COM | CRC_CPU_WDATA_32 | CRC_CTL_CRCCEN_Msk;
+    CRC->CTL |= CRC_CTL_CRC_RST_Msk;
+
+    for (u32Addr = addr_start; u32Addr < addr_end; u32Addr += 4) {
+        if (FMC_Read_User(u32Addr, &u32Data) != 0) {
+            return -1;
+        }
+
+        CRC->WDATA = u32Data;
+    }
+
+    *crc = CRC->CHECKSUM;
+    return 0;
+}
+
 /*** (C) COPYRIGHT 2019 Nuvoton Technology Corp. ***/
@@ -16,6 +16,9 @@ __attribute__((aligned(4))) static uint8_t aprom_buf[FMC_FLASH_PAGE_SIZE];
 uint32_t bUpdateApromCmd;
 uint32_t g_apromSize, g_dataFlashAddr, g_dataFlashSize;
 
+/* CMD_UPDATE_APROM_LZ decoder state, the stream may split items across packets */
+static uint32_t g_lzflags, g_lztoken, g_lzstate, g_lzout, g_lzsize, g_lzerr;
+
 static uint16_t Checksum(unsigned char *buf, int len)
 {
     int i;
@@ -28,12 +31,104 @@ static uint16_t Checksum(unsigned char *buf, int len)
     return (c);
 }
 
+/* Ranges for CMD_GET_CRC32 are whole pages of APROM or Data Flash. A CRC-32 can be inverted only for a
+   range of no more than 4 unknown bytes, so a page cannot be recovered from its CRC. */
+static int IsCrcRange(uint32_t addr, uint32_t len)
+{
+    uint32_t aplimit = (g_apromSize < g_dataFlashAddr) ? g_apromSize : g_dataFlashAddr;
+
+    if ((len == 0) || ((addr | len) & (FMC_FLASH_PAGE_SIZE - 1))) {
+        return 0;
+    }
+
+    if ((len <= aplimit) && (addr <= aplimit - len)) {
+        return 1;
+    }
+
+    return (addr >= g_dataFlashAddr) && (len <= g_dataFlashSize) && (addr - g_dataFlashAddr <= g_dataFlashSize - len);
+}
+
+static void LzFlush(void)
+{
+    uint32_t addr, len, pad;
+    uint16_t sum;
+
+    /* Program the decoded bytes of the current page. The last page is padded to a word with 0xFF. */
+    addr = (g_lzout - 1) & ~(FMC_FLASH_PAGE_SIZE - 1);
+    len = (g_lzout - addr + 3) & ~3;
+    pad = g_lzout - addr;
+    memset(aprom_buf + pad, 0xFF, len - pad);
+
+    /* Read the page back into the window, so a programming error is caught and later matches copy
+       what is really in flash */
+    sum = Checksum(aprom_buf, len);
+    WriteData(addr, addr + len, (uint32_t *)aprom_buf);
+    ReadData(addr, addr + len, (uint32_t *)aprom_buf);
+
+    if (Checksum(aprom_buf, len) != sum) {
+        g_lzerr = 1;
+    }
+}
+
+static void LzPut(uint8_t c)
+{
+    if (g_lzout >= g_lzsize) {
+        g_lzerr = 1;
+        return;
+    }
+
+    aprom_buf[g_lzout & (FMC_FLASH_PAGE_SIZE - 1)] = c;
+
+    if ((++g_lzout & (FMC_FLASH_PAGE_SIZE - 1)) == 0) {
+        LzFlush();
+    }
+}
+
+static void LzDecode(unsigned char *buf, uint32_t len)
+{
+    uint32_t i, dist, cnt;
+
+    for (i = 0; (i < len) && (g_lzerr == 0); i++) {
+        if (g_lzstate) {
+            /* Second byte of a match */
+            g_lztoken |= (uint32_t)buf[i] << 8;
+            g_lzstate = 0;
+            dist = (g_lztoken & 0x1FF) + 1;
+            cnt = (g_lztoken >> 9) + LZ_MIN_MATCH;
+
+            if (dist > g_lzout) {
+                g_lzerr = 1;
+                break;
+            }
+
+            while (cnt--) {
+                LzPut(aprom_buf[(g_lzout - dist) & (FMC_FLASH_PAGE_SIZE - 1)]);
+            }
+        } else if (g_lzflags == 1) {
+            /* All items of the previous flag byte are done, bit 8 is the end marker */
+            g_lzflags = buf[i] | 0x100;
+        } else {
+            if (g_lzflags & 1) {
+                LzPut(buf[i]);
+            } else {
+                g_lztoken = buf[i];
+                g_lzstate = 1;
+            }
+
+            g_lzflags >>= 1;
+        }
+    }
+}
+
 int ParseCmd(unsigned char *buffer, uint8_t len)
 {
     static uint32_t StartAddress, TotalLen, LastDataLen, g_packno = 1;
+    static uint32_t g_window = 1, g_winpkts = 0;
+    static uint16_t g_wincksum = 0;
     uint8_t *response;
     uint16_t lcksum;
     uint32_t lcmd, srclen, i, regcnf0, security;
+    int32_t errppm;
     unsigned char *pSrc;
     static uint32_t	gcmd;
     response = response_buff;
@@ -47,6 +142,13 @@ int ParseCmd(unsigned char *buffer, uint8_t len)
     regcnf0 = *(uint32_t *)(response + 8);
     security = regcnf0 & 0x2;
 
+    /* Windowed data packets are streamed without waiting for responses. A packet out of sequence, e.g. after
+       a lost byte shifted the packet framing, is dropped without response; the host times out and restarts
+       the update. */
+    if ((g_window > 1) && (lcmd == 0) && (inpw(buffer + 4) != g_packno)) {
+        return ISP_RESPONSE_DEFERRED;
+    }
+
     if (lcmd == CMD_SYNC_PACKNO) {
         g_packno = inpw(pSrc);
     }
@@ -80,10 +182,51 @@ int ParseCmd(unsigned char *buffer, uint8_t len)
         while (1);
     } else if (lcmd == CMD_CONNECT) {
         g_packno = 1;
+        g_window = 1;
+        goto out;
+    } else if (lcmd == CMD_SET_WINDOW) {
+        /* Number of data packets the host may send ahead, granted up to ISP_WINDOW_MAX */
+        g_window = inpw(pSrc);
+
+        if (g_window < 1) {
+            g_window = 1;
+        } else if (g_window > ISP_WINDOW_MAX) {
+            g_window = ISP_WINDOW_MAX;
+        }
+
+        outpw(response + 8, g_window);
+        outpw(response + 12, ISP_WINDOW_ACK(g_window));
+        outpw(response + 16, CMD_SET_WINDOW);
         goto out;
     } else if (lcmd == CMD_DISCONNECT) {
         return 0;
-    } else if ((lcmd == CMD_UPDATE_APROM) || (lcmd == CMD_ERASE_ALL)) {
+    } else if (lcmd == CMD_SET_BAUDRATE) {
+        /* The device switches after this response is sent and the host switches after receiving it.
+           The response carries the accepted baud rate and its signed error in ppm, positive if the actual baud
+           rate is faster, or 0 if it is rejected. */
+        g_baudsetting = UART_CalcBaud(inpw(pSrc), &errppm);
+
+        outpw(response + 8, g_baudsetting ? inpw(pSrc) : 0);
+        outpw(response + 12, g_baudsetting ? (uint32_t)errppm : 0);
+        outpw(response + 16, CMD_SET_BAUDRATE);
+        goto out;
+    } else if (lcmd == CMD_GET_CRC32) {
+        /* CRC-32 of the page aligned range at +8 with the byte count at +12, so the host can verify an update
+           without reading the flash back. The response byte count is 0 if the range is rejected. Like
+           CMD_UPDATE_CONFIG, it is rejected on a locked chip until APROM is erased. */
+        srclen = inpw(pSrc + 4);
+
+        if (((security == 0) && (!bUpdateApromCmd)) || !IsCrcRange(inpw(pSrc), srclen) ||
+                (GetCRC32(inpw(pSrc), inpw(pSrc) + srclen, &i) != 0)) {
+            i = 0;
+            srclen = 0;
+        }
+
+        outpw(response + 8, i);
+        outpw(response + 12, srclen);
+        outpw(response + 16, CMD_GET_CRC32);
+        goto out;
+    } else if ((lcmd == CMD_UPDATE_APROM) || (lcmd == CMD_ERASE_ALL) || (lcmd == CMD_UPDATE_APROM_LZ)) {
         EraseAP(FMC_APROM_BASE, (g_apromSize < g_dataFlashAddr) ? g_apromSize : g_dataFlashAddr); // erase APROM // g_dataFlashAddr, g_apromSize
 
         if (lcmd == CMD_ERASE_ALL) {
@@ -115,6 +258,16 @@ int ParseCmd(unsigned char *buffer, uint8_t len)
         TotalLen = inpw(pSrc + 4);
         pSrc += 8;
         srclen -= 8;
+    } else if (lcmd == CMD_UPDATE_APROM_LZ) {
+        /* Image size replaces the start address, TotalLen is the compressed stream size */
+        g_lzsize = inpw(pSrc);
+        g_lzflags = 1;
+        g_lzstate = 0;
+        g_lzout = 0;
+        g_lzerr = (g_lzsize > ((g_apromSize < g_dataFlashAddr) ? g_apromSize : g_dataFlashAddr)) ? 1 : 0;
+        TotalLen = inpw(pSrc + 4);
+        pSrc += 8;
+        srclen -= 8;
     } else if (lcmd == CMD_UPDATE_CONFIG) {
         if ((security == 0) && (!bUpdateApromCmd)) { //security lock
             goto out;
@@ -124,6 +277,14 @@ int ParseCmd(unsigned char *buffer, uint8_t len)
         GetDataFlashInfo(&g_dataFlashAddr, &g_dataFlashSize);
         goto out;
     } else if (lcmd == CMD_RESEND_PACKET) { //for APROM&Data flash only
+        /* The compressed stream cannot be rewound, the host has to restart the update */
+        if (gcmd == CMD_UPDATE_APROM_LZ) {
+            g_lzerr = 1;
+            outpw(response + 8, g_lzout);
+            outpw(response + 12, g_lzerr);
+            goto out;
+        }
+
         StartAddress -= LastDataLen;
         TotalLen += LastDataLen;
 
@@ -153,14 +314,47 @@ int ParseCmd(unsigned char *buffer, uint8_t len)
         ReadData(StartAddress, StartAddress + srclen, (uint32_t *)pSrc);
         StartAddress += srclen;
         LastDataLen =  srclen;
+    } else if (gcmd == CMD_UPDATE_APROM_LZ) {
+        if (TotalLen < srclen) {
+            srclen = TotalLen;
+        }
+
+        TotalLen -= srclen;
+        LzDecode(pSrc, srclen);
+
+        /* Program the last partial page at the end of the stream */
+        if (TotalLen == 0) {
+            if ((g_lzerr == 0) && (g_lzout & (FMC_FLASH_PAGE_SIZE - 1))) {
+                LzFlush();
+            }
+
+            if (g_lzout != g_lzsize) {
+                g_lzerr = 1;
+            }
+        }
+
+        /* Report decoded size and error, CMD_RESEND_PACKET is not supported by the compressed stream */
+        outpw(response + 8, g_lzout);
+        outpw(response + 12, g_lzerr);
     }
 
 out:
+    /* The response carries the sum of checksums of all packets it acknowledges */
     lcksum = Checksum(buffer, len);
-    outps(response, lcksum);
+    g_wincksum += lcksum;
+    outps(response, g_wincksum);
     ++g_packno;
     outpw(response + 4, g_packno);
     g_packno++;
+
+    /* In windowed mode, data packets are acknowledged once per ISP_WINDOW_ACK(g_window) packets and at the
+       end of the image, so the host keeps streaming while this packet is being programmed. */
+    if ((g_window > 1) && (lcmd == 0) && (TotalLen != 0) && (++g_winpkts < ISP_WINDOW_ACK(g_window))) {
+        return ISP_RESPONSE_DEFERRED;
+    }
+
+    g_winpkts = 0;
+    g_wincksum = 0;
     return 0;
 }
 
@@ -35,6 +35,7 @@ extern void UpdateConfig(unsigned int *data, unsigned int *res);
 extern void ReadData(unsigned int addr_start, unsigned int addr_end, unsigned int *data);
 extern void WriteData(unsigned int addr_start, unsigned int addr_end, unsigned int *data);
 extern void GetDataFlashInfo(uint32_t *addr, uint32_t *size);
+extern int GetCRC32(unsigned int addr_start, unsigned int addr_end, uint32_t *crc);
 int FMC_Write_User(unsigned int u32Addr, unsigned int u32Data);
 int FMC_Read_User(unsigned int u32Addr, unsigned int *data);
 int FMC_Erase_User(unsigned int u32Addr);
@@ -34,12 +34,32 @@
 #define CMD_UPDATE_DATAFLASH 		0x000000C3
 #define CMD_WRITE_CHECKSUM 	 		0x000000C9
 #define CMD_GET_FLASHMODE 	 		0x000000CA
+#define CMD_SET_WINDOW				0x000000CB
+#define CMD_SET_BAUDRATE			0x000000CC
+#define CMD_UPDATE_APROM_LZ			0x000000CD
+#define CMD_GET_CRC32				0x000000CE
 
 #define CMD_RESEND_PACKET       	0x000000FF
 
 #define	V6M_AIRCR_VECTKEY_DATA		0x05FA0000UL
 #define V6M_AIRCR_SYSRESETREQ		0x00000004UL
 
+/* Windowed mode is granted only if the transport defines a receive window */
+#ifndef ISP_WINDOW_MAX
+#define ISP_WINDOW_MAX				1
+#define ISP_WINDOW_ACK(w)			(w)
+#endif
+
+/* CMD_UPDATE_APROM_LZ stream: a flag byte is followed by 8 items, LSB first. Flag bit 1 is a literal byte
+   and flag bit 0 is a 16-bit little endian match, bits 0~8 are distance - 1 and bits 9~15 are length - 3.
+   The distance is limited to one flash page, so the decoder window is aprom_buf. */
+#define LZ_MAX_DIST					FMC_FLASH_PAGE_SIZE
+#define LZ_MIN_MATCH				3
+#define LZ_MAX_MATCH				(127 + LZ_MIN_MATCH)
+
+/* ParseCmd return value, the response is not sent for this packet */
+#define ISP_RESPONSE_DEFERRED		1
+
 #define DISCONNECTED				0
 #define CONNECTING					1
 #define CONNECTED					2
@@ -17,6 +17,12 @@
 #define PLLCON_SETTING  CLK_PLLCON_72MHz_HIRC
 #define PLL_CLOCK       71884880
 
+/* SysTick LOAD is only 24 bits wide, so the 300 ms time-out is counted in 10 ms periods */
+#define TICK_PERIOD_US  10000
+#define TIMEOUT_TICKS   30
+
+static uint32_t s_u32Ticks;
+
 /*---------------------------------------------------------------------------------------------------------*/
 /* Define functions prototype                                                                              */
 /*---------------------------------------------------------------------------------------------------------*/
@@ -26,6 +32,23 @@ void SH_Return(void);
 void ProcessHardFault(void) { while(1); /* Halt here if hard fault occurs. */ }
 void SH_Return(void){}
 
+/* Restart the 300 ms time-out */
+static void TimeoutRestart(void)
+{
+    SysTick->VAL = 0;
+    s_u32Ticks = 0;
+}
+
+/* Count the SysTick periods and return 1 once the 300 ms time-out has passed */
+static int TimeoutExpired(void)
+{
+    if (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) {
+        s_u32Ticks++;
+    }
+
+    return (s_u32Ticks >= TIMEOUT_TICKS);
+}
+
 int32_t SYS_Init(void)
 {
     uint32_t u32TimeOutCnt;
@@ -94,6 +117,9 @@ int32_t SYS_Init(void)
 /*---------------------------------------------------------------------------------------------------------*/
 int32_t main(void)
 {
+    int i32Ret;
+    uint32_t u32BaudTrial = 0;
+
     /* Unlock protected registers */
     SYS_UnlockReg();
 
@@ -115,40 +141,62 @@ int32_t main(void)
     GetDataFlashInfo(&g_dataFlashAddr, &g_dataFlashSize);
 
     /* Set Systick time-out for 300ms */
-    SysTick->LOAD = 300000 * CyclesPerUs;
-    SysTick->VAL   = (0x00);
+    SysTick->LOAD = TICK_PERIOD_US * CyclesPerUs - 1;
+    TimeoutRestart();
     SysTick->CTRL = SysTick->CTRL | SysTick_CTRL_CLKSOURCE_Msk | SysTick_CTRL_ENABLE_Msk;   /* Use CPU clock */
 
     /* Wait for CMD_CONNECT command until Systick time-out */
     while (1) {
 
         /* Wait for CMD_CONNECT command */
-        if ((bufhead >= 4) || (bUartDataReady == TRUE)) {
+        if ((bufhead >= 4) || (pkttail != pkthead)) {
             uint32_t lcmd;
-            lcmd = inpw(uart_rcvbuf);
+            lcmd = inpw(uart_rcvbuf[pkttail]);
 
             if (lcmd == CMD_CONNECT) {
                 break;
             } else {
-                bUartDataReady = FALSE;
+                pkttail = pkthead;
                 bufhead = 0;
             }
         }
 
         /* Systick time-out, then go to APROM */
-        if (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) {
+        if (TimeoutExpired()) {
             goto _APROM;
         }
     }
 
     /* Prase command from master and send response back */
     while (1) {
-        if (bUartDataReady == TRUE) {
+        if (pkttail != pkthead) {
             WDT->WTCR &= ~(WDT_WTCR_WTE_Msk | WDT_WTCR_DBGACK_WDT_Msk);
             WDT->WTCR |= (WDT_TIMEOUT_2POW18 | WDT_WTCR_WTR_Msk);
-            bUartDataReady = FALSE;
-            ParseCmd(uart_rcvbuf, 64);
-            PutString();
+            i32Ret = ParseCmd(uart_rcvbuf[pkttail], 64);
+            u32BaudTrial = 0;
+
+            /* Release the packet slot. In windowed mode the ISR keeps receiving into the free slots
+               while this packet is being programmed. */
+            pkttail = (pkttail + 1 == MAX_PKT_NUM) ? 0 : (pkttail + 1);
+
+            if (i32Ret != ISP_RESPONSE_DEFERRED) {
+                PutString();
+            }
+
+            /* Switch baud rate after the response of CMD_SET_BAUDRATE is sent */
+            if (g_baudsetting) {
+                UART_SwitchBaud(g_baudsetting);
+                g_baudsetting = 0;
+                u32BaudTrial = 1;
+                TimeoutRestart();
+            }
+        }
+
+        /* No packet within 300 ms at the new baud rate, the host failed to switch. Fall back to the
+           baud rate after reset so that the host can connect again. */
+        if (u32BaudTrial && TimeoutExpired()) {
+            UART_SwitchBaud(ISP_BAUD_DEFAULT);
+            u32BaudTrial = 0;
         }
     }
 
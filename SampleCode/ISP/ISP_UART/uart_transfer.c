@@ -11,10 +11,12 @@
 #include <string.h>
 #include "targetdev.h"
 
-__attribute__((aligned(4))) uint8_t  uart_rcvbuf[MAX_PKT_SIZE] = {0};
+__attribute__((aligned(4))) uint8_t  uart_rcvbuf[MAX_PKT_NUM][MAX_PKT_SIZE] = {0};
 
-uint8_t volatile bUartDataReady = 0;
+uint8_t volatile pkthead = 0;   /* Packet slot being received */
+uint8_t volatile pkttail = 0;   /* Oldest received packet not parsed yet */
 uint8_t volatile bufhead = 0;
+uint32_t g_baudsetting = 0;     /* Baud rate setting to switch to after the response is sent */
 
 
 /* please check "targetdev.h" for chip specifc define option */
@@ -24,23 +26,44 @@ uint8_t volatile bufhead = 0;
 /*---------------------------------------------------------------------------------------------------------*/
 void UART_N_IRQHandler(void)
 {
+    uint8_t next;
+    uint32_t cnt;
+
     /* Determine interrupt source */
     uint32_t u32IntSrc = UART_N->ISR;
 
-    /* RDA FIFO interrupt and RDA timeout interrupt */
-    if (u32IntSrc & (UART_ISR_RDA_IF_Msk|UART_ISR_TOUT_IF_Msk)) { 
-        /* Read data until RX FIFO is empty or data is over maximum packet size */        
-        while (((UART_N->FSR & UART_FSR_RX_EMPTY_Msk) == 0) && (bufhead < MAX_PKT_SIZE)) {	
-            uart_rcvbuf[bufhead++] = UART_N->RBR;
+    /* RDA timeout interrupt, the line went idle. If the bytes in the RX FIFO do not complete the current packet,
+       the packet is partial and only these bytes are discarded. Bytes received after them start the next packet. */
+    if (u32IntSrc & UART_ISR_TOUT_IF_Msk) {
+        cnt = (UART_N->FSR & UART_FSR_RX_POINTER_Msk) >> UART_FSR_RX_POINTER_Pos;
+        if ((cnt == 0) && (UART_N->FSR & UART_FSR_RX_FULL_Msk)) {
+            cnt = 64;   /* Full 64-byte FIFO */
+        }
+
+        if (bufhead + cnt < MAX_PKT_SIZE) {
+            while (cnt--) {
+                (void)UART_N->RBR;
+            }
+            bufhead = 0;
         }
     }
-    
-    /* Reset data buffer index */  
-    if (bufhead == MAX_PKT_SIZE) {
-        bUartDataReady = TRUE;
-        bufhead = 0;
-    } else if (u32IntSrc & UART_ISR_TOUT_IF_Msk) {
-        bufhead = 0;
+
+    /* RDA FIFO interrupt and RDA timeout interrupt */
+    if (u32IntSrc & (UART_ISR_RDA_IF_Msk|UART_ISR_TOUT_IF_Msk)) {
+        /* Read data until RX FIFO is empty. In windowed mode the next packet may follow without a gap. */
+        while ((UART_N->FSR & UART_FSR_RX_EMPTY_Msk) == 0) {
+            uart_rcvbuf[pkthead][bufhead++] = UART_N->RBR;
+
+            if (bufhead == MAX_PKT_SIZE) {
+                bufhead = 0;
+                next = (pkthead + 1 == MAX_PKT_NUM) ? 0 : (pkthead + 1);
+
+                /* Queue the packet. If the host ignored the window and the queue is full, the packet is dropped. */
+                if (next != pkttail) {
+                    pkthead = next;
+                }
+            }
+        }
     }
 }
 
@@ -60,6 +83,55 @@ void PutString(void)
     }
 }
 
+/*---------------------------------------------------------------------------------------------------------*/
+/* Calculate mode 2 baud rate setting, baud rate = UART clock / (BRD + 2). Mode 2 has the finest resolution */
+/* at the high baud rates the host asks for. Returns 0 if the error is over ISP_BAUD_ERR_MAX. The error in  */
+/* ppm is positive if the actual baud rate is faster than requested.                                       */
+/*---------------------------------------------------------------------------------------------------------*/
+uint32_t UART_CalcBaud(uint32_t u32Baud, int32_t *pi32ErrPpm)
+{
+    uint32_t u32Div, u32Real, u32Diff;
+    int32_t i32Err;
+
+    if (u32Baud == 0) {
+        return 0;
+    }
+
+    u32Div = (__HIRC + u32Baud / 2) / u32Baud;
+
+    /* Keep BRD at least 8 so that the receiver has enough clocks to sample each bit */
+    if ((u32Div < 10) || (u32Div > 0xFFFF + 2)) {
+        return 0;
+    }
+
+    /* Compare UART clock with requested baud rate * divider to keep the error calculation in 32 bits */
+    u32Real = u32Baud * u32Div;
+    u32Diff = (u32Real > __HIRC) ? (u32Real - __HIRC) : (__HIRC - u32Real);
+
+    if (u32Diff > u32Real / (1000000 / ISP_BAUD_ERR_MAX)) {
+        return 0;
+    }
+
+    /* The actual baud rate is UART clock / divider, faster when the UART clock is above requested * divider */
+    i32Err = (int32_t)(u32Diff * 1000 / (u32Real / 1000));
+    *pi32ErrPpm = (__HIRC >= u32Real) ? i32Err : -i32Err;
+    return (UART_BAUD_MODE2 | (u32Div - 2));
+}
+
+void UART_SwitchBaud(uint32_t u32Setting)
+{
+    /* Wait for the response to leave the transmitter */
+    while ((UART_N->FSR & UART_FSR_TE_FLAG_Msk) == 0);
+
+    NVIC_DisableIRQ(UART_N_IRQn);
+    UART_N->BAUD = u32Setting;
+
+    /* Drop anything received while the baud rates of both sides differ */
+    UART_N->FCR |= UART_FCR_RFR_Msk;
+    bufhead = 0;
+    NVIC_EnableIRQ(UART_N_IRQn);
+}
+
 void UART_Init()
 {
     /*---------------------------------------------------------------------------------------------------------*/
@@ -76,7 +148,7 @@ void UART_Init()
     UART_N->FCR = UART_FCR_RFITL_14BYTES | UART_FCR_RTS_TRI_LEV_14BYTES;
     
     /* Set UART baud rate */    
-    UART_N->BAUD = (UART_BAUD_MODE0 | UART_BAUD_MODE0_DIVIDER(__HIRC, 115200));
+    UART_N->BAUD = ISP_BAUD_DEFAULT;
 
     /* Set time-out interrupt comparator */
     UART_N->TOR = (UART_N->TOR & ~UART_TOR_TOIC_Msk) | (0x40);
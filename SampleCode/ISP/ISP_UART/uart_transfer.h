@@ -14,16 +14,33 @@
 /* Define maximum packet size */
 #define MAX_PKT_SIZE        	64
 
+/* Windowed mode: the host may send up to ISP_WINDOW_MAX packets ahead and the device responds once per
+   ISP_WINDOW_ACK(window) packets. Responding at half window lets the host keep streaming while the
+   response is on the wire. */
+#define ISP_WINDOW_MAX          4
+#define ISP_WINDOW_ACK(w)       (((w) + 1) / 2)
+
+/* Define number of received packet slots, one slot is being received */
+#define MAX_PKT_NUM             (ISP_WINDOW_MAX + 1)
+
+/* Define baud rate after reset and maximum baud rate error in ppm accepted by CMD_SET_BAUDRATE */
+#define ISP_BAUD_DEFAULT        (UART_BAUD_MODE0 | UART_BAUD_MODE0_DIVIDER(__HIRC, 115200))
+#define ISP_BAUD_ERR_MAX        20000
+
 /*-------------------------------------------------------------*/
 
-extern uint8_t uart_rcvbuf[];
-extern uint8_t volatile bUartDataReady;
+extern uint8_t uart_rcvbuf[][MAX_PKT_SIZE];
+extern uint8_t volatile pkthead;
+extern uint8_t volatile pkttail;
 extern uint8_t volatile bufhead;
+extern uint32_t g_baudsetting;
 
 /*-------------------------------------------------------------*/
 void UART_Init(void);
 void UART0_IRQHandler(void);
 void PutString(void);
+uint32_t UART_CalcBaud(uint32_t u32Baud, int32_t *pi32ErrPpm);
+void UART_SwitchBaud(uint32_t u32Setting);
 
 #endif  /* __UART_TRANS_H__ */
 
@@ -39,21 +39,6 @@
 #define EP4_MAX_PKT_SIZE    64
 #define EP5_MAX_PKT_SIZE    64
 
-#define SETUP_BUF_BASE      0
-#define SETUP_BUF_LEN       8
-#define EP0_BUF_BASE        (SETUP_BUF_BASE + SETUP_BUF_LEN)
-#define EP0_BUF_LEN         EP0_MAX_PKT_SIZE
-#define EP1_BUF_BASE        (SETUP_BUF_BASE + SETUP_BUF_LEN)
-#define EP1_BUF_LEN         EP1_MAX_PKT_SIZE
-#define EP2_BUF_BASE        (EP1_BUF_BASE + EP1_BUF_LEN)
-#define EP2_BUF_LEN         EP2_MAX_PKT_SIZE
-#define EP3_BUF_BASE        (EP2_BUF_BASE + EP2_BUF_LEN)
-#define EP3_BUF_LEN         EP3_MAX_PKT_SIZE
-#define EP4_BUF_BASE        (EP3_BUF_BASE + EP3_BUF_LEN)
-#define EP4_BUF_LEN         EP4_MAX_PKT_SIZE
-#define EP5_BUF_BASE        (EP4_BUF_BASE + EP4_BUF_LEN)
-#define EP5_BUF_LEN         EP5_MAX_PKT_SIZE
-
 /* Define the EP numbers */
 #define INT_IN_EP_NUM       0x01
 #define INT_OUT_EP_NUM      0x02
@@ -220,7 +220,7 @@ int32_t main(void)
         }
 #endif
 
-        MSC_ProcessCmd();
+        USBD_MSC_Process();
     }
 }
 
@@ -20,22 +20,117 @@
 /*---------------------------------------------------------------------------------------------------------*/
 
 
-uint32_t g_sectorBuf[FLASH_PAGE_SIZE / 4];
+typedef struct
+{
+    uint32_t u32Addr;       /* Flash address of the cached page */
+    uint32_t u32Stamp;      /* Last access, the smallest stamp is evicted first */
+    uint8_t  u8Valid;
+    uint8_t  u8Dirty;
+} DATA_FLASH_CACHE_T;
+
+static uint32_t g_au32CacheBuf[DATA_FLASH_CACHE_SLOTS][FLASH_PAGE_SIZE / 4];
+static DATA_FLASH_CACHE_T g_asCache[DATA_FLASH_CACHE_SLOTS];
+static uint32_t g_u32CacheStamp = 0;
 
 uint32_t FMC_ReadPage(uint32_t u32StartAddr, uint32_t * u32Buf)
+{
+    /* Data Flash is bus readable, so this is a word copy instead of one ISP read per word */
+    FMC_ReadMultiple(u32StartAddr, u32Buf, FLASH_PAGE_SIZE);
+
+    return 0;
+}
+
+uint32_t FMC_ProgramPage(uint32_t u32StartAddr, uint32_t * u32Buf)
 {
     uint32_t i;
 
     for(i = 0; i < FLASH_PAGE_SIZE / 4; i++)
-        u32Buf[i] = FMC_Read(u32StartAddr + i * 4);
+    {
+        FMC_Write(u32StartAddr + i * 4, u32Buf[i]);
+    }
 
     return 0;
 }
 
+static void DataFlashWriteBack(DATA_FLASH_CACHE_T *psSlot)
+{
+    uint32_t i, *pu32Buf = g_au32CacheBuf[psSlot - g_asCache];
+
+    /* Skip the erase if the host wrote back what is already in flash */
+    for(i = 0; i < FLASH_PAGE_SIZE / 4; i++)
+    {
+        if(FMC_Read(psSlot->u32Addr + i * 4) != pu32Buf[i])
+            break;
+    }
+
+    if(i < FLASH_PAGE_SIZE / 4)
+    {
+        FMC_Erase(psSlot->u32Addr);
+        FMC_ProgramPage(psSlot->u32Addr, pu32Buf);
+    }
+
+    psSlot->u8Dirty = 0;
+}
+
+static DATA_FLASH_CACHE_T *DataFlashCacheFind(uint32_t u32Addr)
+{
+    uint32_t i;
+
+    for(i = 0; i < DATA_FLASH_CACHE_SLOTS; i++)
+    {
+        if(g_asCache[i].u8Valid && (g_asCache[i].u32Addr == u32Addr))
+        {
+            g_asCache[i].u32Stamp = ++g_u32CacheStamp;
+            return &g_asCache[i];
+        }
+    }
+
+    return NULL;
+}
+
+static DATA_FLASH_CACHE_T *DataFlashCacheGet(uint32_t u32Addr, uint32_t u32Load)
+{
+    DATA_FLASH_CACHE_T *psSlot;
+    uint32_t i;
+
+    psSlot = DataFlashCacheFind(u32Addr);
+    if(psSlot)
+        return psSlot;
+
+    /* Take a free slot or evict the least recently used one */
+    psSlot = &g_asCache[0];
+    for(i = 0; i < DATA_FLASH_CACHE_SLOTS; i++)
+    {
+        if(!g_asCache[i].u8Valid)
+        {
+            psSlot = &g_asCache[i];
+            break;
+        }
+
+        if(g_asCache[i].u32Stamp < psSlot->u32Stamp)
+            psSlot = &g_asCache[i];
+    }
+
+    if(psSlot->u8Valid && psSlot->u8Dirty)
+        DataFlashWriteBack(psSlot);
+
+    /* A page that is written as a whole does not need to be read first */
+    if(u32Load)
+        FMC_ReadPage(u32Addr, g_au32CacheBuf[psSlot - g_asCache]);
+
+    psSlot->u32Addr = u32Addr;
+    psSlot->u32Stamp = ++g_u32CacheStamp;
+    psSlot->u8Valid = 1;
+    psSlot->u8Dirty = 0;
+
+    return psSlot;
+}
+
 void DataFlashRead(uint32_t addr, uint32_t size, uint32_t buffer)
 {
     /* This is low level read function of USB Mass Storage */
     int32_t len;
+    DATA_FLASH_CACHE_T *psSlot;
 
     /* Modify the address to MASS_STORAGE_OFFSET */
     addr += MASS_STORAGE_OFFSET;
@@ -47,7 +142,12 @@ void DataFlashRead(uint32_t addr, uint32_t size, uint32_t buffer)
 
     while(len >= FLASH_PAGE_SIZE)
     {
-        FMC_ReadPage(addr, (uint32_t *)buffer);
+        /* Pages missing in the cache are read from flash without being cached */
+        psSlot = DataFlashCacheFind(addr);
+        if(psSlot)
+            memcpy((void *)buffer, g_au32CacheBuf[psSlot - g_asCache], FLASH_PAGE_SIZE);
+        else
+            FMC_ReadPage(addr, (uint32_t *)buffer);
         addr   += FLASH_PAGE_SIZE;
         buffer += FLASH_PAGE_SIZE;
         len  -= FLASH_PAGE_SIZE;
@@ -57,90 +157,53 @@ void DataFlashRead(uint32_t addr, uint32_t size, uint32_t buffer)
     SYS_LockReg();
 }
 
-
-uint32_t FMC_ProgramPage(uint32_t u32StartAddr, uint32_t * u32Buf)
-{
-    uint32_t i;
-
-    for(i = 0; i < FLASH_PAGE_SIZE / 4; i++)
-    {
-        FMC_Write(u32StartAddr + i * 4, u32Buf[i]);
-    }
-
-    return 0;
-}
-
-
 void DataFlashWrite(uint32_t addr, uint32_t size, uint32_t buffer)
 {
     /* This is low level write function of USB Mass Storage */
-    int32_t len, i, offset;
-    uint32_t *pu32;
-    uint32_t alignAddr;
+    uint32_t len, offset;
+    DATA_FLASH_CACHE_T *psSlot;
 
     /* Modify the address to MASS_STORAGE_OFFSET */
     addr += MASS_STORAGE_OFFSET;
 
-    len = (int32_t)size;
-
     SYS_UnlockReg();
     FMC_Open();
 
-    if(len == FLASH_PAGE_SIZE && ((addr & (FLASH_PAGE_SIZE - 1)) == 0))
+    while(size > 0)
     {
-        FMC_Erase(addr);
-
-        while(len >= FLASH_PAGE_SIZE)
-        {
-            FMC_ProgramPage(addr, (uint32_t *) buffer);
-            len    -= FLASH_PAGE_SIZE;
-            buffer += FLASH_PAGE_SIZE;
-            addr   += FLASH_PAGE_SIZE;
-        }
+        /* Get the page offset */
+        offset = addr & (FLASH_PAGE_SIZE - 1);
+        len = FLASH_PAGE_SIZE - offset;
+        if(size < len)
+            len = size;
+
+        /* Update the data in cache, flash is programmed when the page is evicted or flushed */
+        psSlot = DataFlashCacheGet(addr - offset, (len != FLASH_PAGE_SIZE));
+        memcpy((uint8_t *)g_au32CacheBuf[psSlot - g_asCache] + offset, (void *)buffer, len);
+        psSlot->u8Dirty = 1;
+
+        size -= len;
+        addr += len;
+        buffer += len;
     }
-    else
-    {
-        do
-        {
-            alignAddr = addr & 0x1FE00;
-
-            /* Get the sector offset*/
-            offset = (addr & (FLASH_PAGE_SIZE - 1));
-
-            if(offset || (size < FLASH_PAGE_SIZE))
-            {
-                /* Non 4k alignment. Note: It needs to avoid add MASS_STORAGE_OFFSET twice. */
-                DataFlashRead(alignAddr - MASS_STORAGE_OFFSET, FLASH_PAGE_SIZE, (uint32_t)&g_sectorBuf[0]);
-
-            }
-
-            /* Update the data */
-            pu32 = (uint32_t *)buffer;
-            len = FLASH_PAGE_SIZE - offset;
-            if(size < len)
-                len = size;
-
-            for(i = 0; i < len / 4; i++)
-            {
-                g_sectorBuf[offset / 4 + i] = pu32[i];
-            }
 
-            FMC_Erase(alignAddr);
+    FMC_Close();
+    SYS_LockReg();
+}
 
-            for(i = 0; i < 16; i++)
-            {
-                FMC_ProgramPage(alignAddr + (i << 8), (uint32_t *) g_sectorBuf + (i << 8));
-            }
+void DataFlashFlush(void)
+{
+    uint32_t i;
 
-            size -= len;
-            addr += len;
-            buffer += len;
+    SYS_UnlockReg();
+    FMC_Open();
 
-        }
-        while(size > 0);
+    for(i = 0; i < DATA_FLASH_CACHE_SLOTS; i++)
+    {
+        if(g_asCache[i].u8Valid && g_asCache[i].u8Dirty)
+            DataFlashWriteBack(&g_asCache[i]);
     }
 
     FMC_Close();
     SYS_LockReg();
 }
-
@@ -13,6 +13,13 @@
 #define FLASH_PAGE_SIZE           512
 #define BUFFER_PAGE_SIZE          512
 
+/* Write-back page cache between MSC and FMC. FAT and directory sectors are rewritten many times while
+   copying files; the cache merges them into one erase per page when the page is evicted or flushed.
+   The mass storage class driver flushes it after the host has been idle for USBD_MSC_SYNC_IDLE_MS. */
+#define DATA_FLASH_CACHE_SLOTS    4     /* Number of cached pages, LRU replacement */
+
+void DataFlashFlush(void);
+
 #endif  /* __DATA_FLASH_PROG_H__ */
 
 /*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
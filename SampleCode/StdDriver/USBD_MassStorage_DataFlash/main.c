@@ -161,7 +161,7 @@ int32_t main(void)
 
     printf("NuMicro USB MassStorage Start!\n");
 
-    USBD_Open(&gsInfo, MSC_ClassRequest, NULL);
+    USBD_Open(&gsInfo, USBD_MSC_ClassRequest, NULL);
 
     USBD_SetConfigCallback(MSC_SetConfig);
 
@@ -214,7 +214,7 @@ int32_t main(void)
         }
 #endif
 
-        MSC_ProcessCmd();
+        USBD_MSC_Process();
     }
 }
 
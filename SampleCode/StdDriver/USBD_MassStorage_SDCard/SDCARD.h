@@ -64,6 +64,17 @@ extern "C"
 
 // Mask for data response Token after an MMC write
 #define     DATA_RESP_MASK 0x11     /*!< DATA_RESP_MASK mask */
+#define     DATA_RESP_ACCEPTED 0x05 /*!< Data response token: data accepted */
+
+// Tries of a block transfer that fails
+// the CRC check
+#define     SD_RETRY_NUM   3        /*!< Block transfer tries */
+
+// PDMA channels of the block data phase
+#define     SD_PDMA_TX_CH  0        /*!< PDMA channel of SPI TX for the block data phase */
+#define     SD_PDMA_RX_CH  1        /*!< PDMA channel of SPI RX for the block data phase */
+#define     SD_DMA_TIMEOUT 0x400000 /*!< Loop count to wait for the block data phase, long enough for the 300kHz initial clock */
+#define     SD_BUSY_TIMEOUT 0x100000 /*!< Bytes to clock while the card is busy after a write, about 0.5s at 16MHz */
 
 // Mask for busy Token in R1b response
 #define     BUSY_BIT       0x80     /*!< BUSY_BIT mask */
@@ -152,8 +163,10 @@ uint32_t SDCARD_GetVersion(void);
 uint32_t MMC_Command_Exec(uint8_t cmd_loc, uint32_t argument, uint8_t *pchar, uint32_t* response);
 uint32_t GetLogicSector(void);
 uint32_t SDCARD_GetCardSize(uint32_t* pu32TotSecCnt);
-void SpiRead(uint32_t addr, uint32_t size, uint8_t* buffer);
-void SpiWrite(uint32_t addr, uint32_t size, uint8_t* buffer);
+uint32_t SpiRead(uint32_t addr, uint32_t size, uint8_t* buffer);
+uint32_t SpiWrite(uint32_t addr, uint32_t size, uint8_t* buffer);
+uint32_t SpiStop(void);
+void SpiSetWriteCount(uint32_t count);
 
 /*@}*/ /* end of group M071R_M071S_SDCARD_EXPORTED_FUNCTIONS */
 
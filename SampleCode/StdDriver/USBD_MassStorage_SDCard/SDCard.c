@@ -44,10 +44,10 @@ COMMAND __I command_list[] =
     {13, NO , 0xFF, CMD, R2 , NO }, // CMD13; SEND_STATUS: read card status;
     {16, YES, 0xFF, CMD, R1 , NO }, // CMD16; SET_BLOCKLEN: set block size;
     {17, YES, 0xFF, RDB , R1 , NO }, // CMD17; READ_SINGLE_BLOCK: read 1 block;
-    {18, YES, 0xFF, RD , R1 , YES}, // CMD18; READ_MULTIPLE_BLOCK: read > 1;
+    {18, YES, 0xFF, CMD, R1 , YES}, // CMD18; READ_MULTIPLE_BLOCK: read > 1;
     {23, NO , 0xFF, CMD, R1 , NO }, // CMD23; SET_BLOCK_COUNT
     {24, YES, 0xFF, WR , R1 , NO }, // CMD24; WRITE_BLOCK: write 1 block;
-    {25, YES, 0xFF, WR , R1 , YES}, // CMD25; WRITE_MULTIPLE_BLOCK: write > 1;
+    {25, YES, 0xFF, CMD, R1 , YES}, // CMD25; WRITE_MULTIPLE_BLOCK: write > 1;
     {27, NO , 0xFF, CMD, R1 , NO }, // CMD27; PROGRAM_CSD: program CSD;
     {28, YES, 0xFF, CMD, R1b, NO }, // CMD28; SET_WRITE_PROT: set wp for group;
     {29, YES, 0xFF, CMD, R1b, NO }, // CMD29; CLR_WRITE_PROT: clear group wp;
@@ -67,6 +67,20 @@ COMMAND __I command_list[] =
     {0x80 + 23, YES, 0xFF, CMD, R1 , NO }, // ACMD23;SD_SET_WR_BLK_ERASE_COUNT
     {0x80 + 41, YES, 0xFF, CMD, R1 , NO } // ACMD41; SD_SEND_OP_COND: initialize card;
 };
+
+// Multi-block transfer left open by SpiRead
+// or SpiWrite for the next sequential block;
+#define     XFER_NONE   0
+#define     XFER_READ   1
+#define     XFER_WRITE  2
+static uint32_t xfer_mode = XFER_NONE;  // Open transfer: XFER_NONE, XFER_READ or XFER_WRITE;
+static uint32_t xfer_next;              // LBA of the next block of the open transfer;
+static uint32_t write_count;            // Blocks to pre-erase for the next write;
+
+// PDMA data phase of a block;
+static uint8_t dma_tx_dummy = 0xFF;     // TX source while a block is received;
+static uint8_t dma_rx_dummy;            // RX destination while a block is sent;
+static volatile uint32_t dma_done;      // Set by PDMA_IRQHandler at the end of the data phase;
 /// @endcond HIDDEN_SYMBOLS
 /** @addtogroup M071R_M071S_SDCARD_EXPORTED_FUNCTIONS SDCARD Library Exported Functions
   @{
@@ -97,28 +111,81 @@ void SD_Delay(uint32_t count)
 
 */
 
+/// @cond HIDDEN_SYMBOLS
+/* CRC7 (x^7 + x^3 + 1) of a byte, shifted left by one bit as it is sent in the command CRC byte */
+static const uint8_t s_au8Crc7Table[256] =
+{
+    0x00, 0x12, 0x24, 0x36, 0x48, 0x5A, 0x6C, 0x7E, 0x90, 0x82, 0xB4, 0xA6, 0xD8, 0xCA, 0xFC, 0xEE,
+    0x32, 0x20, 0x16, 0x04, 0x7A, 0x68, 0x5E, 0x4C, 0xA2, 0xB0, 0x86, 0x94, 0xEA, 0xF8, 0xCE, 0xDC,
+    0x64, 0x76, 0x40, 0x52, 0x2C, 0x3E, 0x08, 0x1A, 0xF4, 0xE6, 0xD0, 0xC2, 0xBC, 0xAE, 0x98, 0x8A,
+    0x56, 0x44, 0x72, 0x60, 0x1E, 0x0C, 0x3A, 0x28, 0xC6, 0xD4, 0xE2, 0xF0, 0x8E, 0x9C, 0xAA, 0xB8,
+    0xC8, 0xDA, 0xEC, 0xFE, 0x80, 0x92, 0xA4, 0xB6, 0x58, 0x4A, 0x7C, 0x6E, 0x10, 0x02, 0x34, 0x26,
+    0xFA, 0xE8, 0xDE, 0xCC, 0xB2, 0xA0, 0x96, 0x84, 0x6A, 0x78, 0x4E, 0x5C, 0x22, 0x30, 0x06, 0x14,
+    0xAC, 0xBE, 0x88, 0x9A, 0xE4, 0xF6, 0xC0, 0xD2, 0x3C, 0x2E, 0x18, 0x0A, 0x74, 0x66, 0x50, 0x42,
+    0x9E, 0x8C, 0xBA, 0xA8, 0xD6, 0xC4, 0xF2, 0xE0, 0x0E, 0x1C, 0x2A, 0x38, 0x46, 0x54, 0x62, 0x70,
+    0x82, 0x90, 0xA6, 0xB4, 0xCA, 0xD8, 0xEE, 0xFC, 0x12, 0x00, 0x36, 0x24, 0x5A, 0x48, 0x7E, 0x6C,
+    0xB0, 0xA2, 0x94, 0x86, 0xF8, 0xEA, 0xDC, 0xCE, 0x20, 0x32, 0x04, 0x16, 0x68, 0x7A, 0x4C, 0x5E,
+    0xE6, 0xF4, 0xC2, 0xD0, 0xAE, 0xBC, 0x8A, 0x98, 0x76, 0x64, 0x52, 0x40, 0x3E, 0x2C, 0x1A, 0x08,
+    0xD4, 0xC6, 0xF0, 0xE2, 0x9C, 0x8E, 0xB8, 0xAA, 0x44, 0x56, 0x60, 0x72, 0x0C, 0x1E, 0x28, 0x3A,
+    0x4A, 0x58, 0x6E, 0x7C, 0x02, 0x10, 0x26, 0x34, 0xDA, 0xC8, 0xFE, 0xEC, 0x92, 0x80, 0xB6, 0xA4,
+    0x78, 0x6A, 0x5C, 0x4E, 0x30, 0x22, 0x14, 0x06, 0xE8, 0xFA, 0xCC, 0xDE, 0xA0, 0xB2, 0x84, 0x96,
+    0x2E, 0x3C, 0x0A, 0x18, 0x66, 0x74, 0x42, 0x50, 0xBE, 0xAC, 0x9A, 0x88, 0xF6, 0xE4, 0xD2, 0xC0,
+    0x1C, 0x0E, 0x38, 0x2A, 0x54, 0x46, 0x70, 0x62, 0x8C, 0x9E, 0xA8, 0xBA, 0xC4, 0xD6, 0xE0, 0xF2
+};
+
+/* CRC16-CCITT (x^16 + x^12 + x^5 + 1) of a byte */
+static const uint16_t s_au16Crc16Table[256] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+/// @endcond HIDDEN_SYMBOLS
+
 /**
-  * @brief This function is used to generate CRC value
-  * @param[in] u32Data Input Data
-  * @param[in] u32GenPoly CRC7:0x1200, CRC16:0x1021
-  * @param[in] u32Accum CRC value
-  * @return CRC value
+  * @brief Update the CRC7 of a command with one byte
+  * @param[in] u8Crc CRC7 shifted left by one bit
+  * @param[in] u8Data Input Data
+  * @return CRC7 shifted left by one bit
   */
-static uint32_t GenerateCRC(uint32_t u32Data, uint32_t u32GenPoly, uint32_t u32Accum)
-{
-    volatile uint8_t i;
+#define SD_CRC7(u8Crc, u8Data)      (s_au8Crc7Table[(uint8_t)((u8Crc) ^ (u8Data))])
 
-    u32Data <<= 8;
-    for(i = 8; i > 0; i--)
-    {
-        if((u32Data ^ u32Accum) & 0x8000)
-            u32Accum = (u32Accum << 1) ^ u32GenPoly;
-        else
-            u32Accum <<= 1;
-        u32Data <<= 1;
-    }
-    return u32Accum;
-}
+/**
+  * @brief Update the CRC16 of a data block with one byte
+  * @param[in] u16Crc CRC16 value
+  * @param[in] u8Data Input Data
+  * @return CRC16 value
+  */
+#define SD_CRC16(u16Crc, u8Data)    ((uint16_t)(((u16Crc) << 8) ^ s_au16Crc16Table[(uint8_t)(((u16Crc) >> 8) ^ (u8Data))]))
 
 /**
   * @brief This function is used to send data though SPI to general clock for SDCARD operation
@@ -134,6 +201,184 @@ static uint32_t SingleWrite(uint32_t u32Data)
     return SPI_READ_RX(g_pSPI);
 }
 
+/**
+  * @brief PDMA interrupt handler
+  * @return none
+  * @details The block done interrupt of the RX channel is the completion callback of the block data phase.
+  */
+void PDMA_IRQHandler(void)
+{
+    uint32_t status = PDMA_GET_INT_STATUS();
+
+    if(status & (1 << SD_PDMA_RX_CH))
+    {
+        if(PDMA_GET_CH_INT_STS(SD_PDMA_RX_CH) & PDMA_ISR_BLKD_IF_Msk)
+            dma_done = 1;
+        PDMA_CLR_CH_INT_FLAG(SD_PDMA_RX_CH, PDMA_ISR_BLKD_IF_Msk | PDMA_ISR_TABORT_IF_Msk);
+    }
+}
+
+/**
+  * @brief This function is used to start the data phase of a block by PDMA
+  * @param[in] *tx TX data source
+  * @param[in] tx_ctrl TX source address control, PDMA_SAR_INC or PDMA_SAR_FIX
+  * @param[out] *rx RX data destination
+  * @param[in] rx_ctrl RX destination address control, PDMA_DAR_INC or PDMA_DAR_FIX
+  * @param[in] u32Len Block length
+  * @return none
+  * @details Every byte is sent and received, so the RX channel is done when the last byte is out of the SPI.
+  */
+static void DmaStart(uint8_t *tx, uint32_t tx_ctrl, uint8_t *rx, uint32_t rx_ctrl, uint32_t u32Len)
+{
+    dma_done = 0;
+    PDMA_CLR_CH_INT_FLAG(SD_PDMA_TX_CH, PDMA_ISR_BLKD_IF_Msk | PDMA_ISR_TABORT_IF_Msk);
+
+    PDMA_SetTransferCnt(SD_PDMA_RX_CH, PDMA_WIDTH_8, u32Len);
+    PDMA_SetTransferAddr(SD_PDMA_RX_CH, (uint32_t)&g_pSPI->RX, PDMA_SAR_FIX, (uint32_t)rx, rx_ctrl);
+    PDMA_SetTransferCnt(SD_PDMA_TX_CH, PDMA_WIDTH_8, u32Len);
+    PDMA_SetTransferAddr(SD_PDMA_TX_CH, (uint32_t)tx, tx_ctrl, (uint32_t)&g_pSPI->TX, PDMA_DAR_FIX);
+
+    PDMA_Trigger(SD_PDMA_RX_CH);
+    PDMA_Trigger(SD_PDMA_TX_CH);
+    SPI_TRIGGER_TX_RX_PDMA(g_pSPI);
+}
+
+/**
+  * @brief This function is used to stop the data phase of a block that did not finish
+  * @return none
+  */
+static void DmaAbort(void)
+{
+    PDMA_STOP(SD_PDMA_TX_CH);
+    PDMA_STOP(SD_PDMA_RX_CH);
+    g_pSPI->DMA |= SPI_DMA_PDMA_RST_Msk;
+    while(SPI_IS_BUSY(g_pSPI));
+}
+
+/**
+  * @brief This function is used to receive a data block and check its CRC16
+  * @param[out] *pchar Data buffer, or NULL to discard the data
+  * @param[in] u32Len Block length
+  * @retval TRUE CRC16 of the block is correct
+  * @retval FALSE CRC16 error
+  * @details The block is moved by PDMA. The CRC16 of the bytes already stored is calculated while the rest
+  *          of the block is received.
+  */
+static uint32_t ReceiveBlock(uint8_t *pchar, uint32_t u32Len)
+{
+    PDMA_T *pdma = (PDMA_T *)((uint32_t)PDMA0_BASE + (0x100 * SD_PDMA_RX_CH));
+    volatile uint8_t *data = pchar;
+    uint32_t i = 0, received;
+    uint32_t loopguard = SD_DMA_TIMEOUT;
+    uint16_t u16Crc = 0;
+
+    if(pchar == NULL)
+        DmaStart(&dma_tx_dummy, PDMA_SAR_FIX, &dma_rx_dummy, PDMA_DAR_FIX, u32Len);
+    else
+        DmaStart(&dma_tx_dummy, PDMA_SAR_FIX, pchar, PDMA_DAR_INC, u32Len);
+
+    while(!dma_done)
+    {
+        if(pchar)
+        {
+            received = pdma->CDAR - (uint32_t)pchar;
+            if(received > u32Len)
+                received = u32Len;
+            while(i < received)
+                u16Crc = SD_CRC16(u16Crc, data[i++]);
+        }
+        __NOP();
+        if(!--loopguard)
+        {
+            DmaAbort();
+            return FALSE;
+        }
+    }
+
+    if(pchar == NULL)
+    {
+        // The data is not kept, so the CRC16 can not be checked;
+        SingleWrite(0xFF);
+        SingleWrite(0xFF);
+        return TRUE;
+    }
+
+    while(i < u32Len)
+        u16Crc = SD_CRC16(u16Crc, data[i++]);
+
+    /* The CRC16 of a block followed by its own CRC16 is zero */
+    u16Crc = SD_CRC16(u16Crc, SingleWrite(0xFF));
+    u16Crc = SD_CRC16(u16Crc, SingleWrite(0xFF));
+
+    return (u16Crc == 0) ? TRUE : FALSE;
+}
+
+/**
+  * @brief This function is used to send a data block with its CRC16 and get the data response
+  * @param[in] u8Token Start block token
+  * @param[in] *pchar Data buffer
+  * @param[in] u32Len Block length
+  * @return Data response token, DATA_RESP_ACCEPTED if the block is accepted, or 0 if there is no response
+  * @details The block is moved by PDMA and its CRC16 is calculated in the meantime.
+  */
+static uint8_t SendBlock(uint8_t u8Token, uint8_t *pchar, uint32_t u32Len)
+{
+    uint32_t i;
+    uint32_t loopguard32 = SD_DMA_TIMEOUT;
+    uint16_t u16Crc = 0;
+    uint8_t loopguard = 0, data_resp;
+
+    SingleWrite(0xFF);
+    SingleWrite(u8Token);
+
+    DmaStart(pchar, PDMA_SAR_INC, &dma_rx_dummy, PDMA_DAR_FIX, u32Len);
+
+    for(i = 0; i < u32Len; i++)
+        u16Crc = SD_CRC16(u16Crc, pchar[i]);
+
+    while(!dma_done)
+    {
+        __NOP();
+        if(!--loopguard32)
+        {
+            DmaAbort();
+            return 0;
+        }
+    }
+
+    SingleWrite(u16Crc >> 8);
+    SingleWrite(u16Crc & 0xFF);
+
+    do                            // Read Data Response from card;
+    {
+        data_resp = SingleWrite(0xFF);
+        if(!++loopguard)
+            return 0;
+    }
+    while((data_resp & DATA_RESP_MASK) != 0x01);     // When bit 0 of the MMC response
+    // is clear, a valid data response
+    // has been received;
+
+    return data_resp & 0x1F;
+}
+
+/**
+  * @brief This function is used to wait until the card releases busy after a block is written
+  * @retval TRUE The card is ready
+  * @retval FALSE The card is still busy after SD_BUSY_TIMEOUT bytes
+  */
+static uint32_t WaitReady(void)
+{
+    uint32_t loopguard32 = SD_BUSY_TIMEOUT;
+
+    while((SingleWrite(0xFF) & 0xFF) != 0xFF)
+    {
+        if(!--loopguard32)
+            return FALSE;
+    }
+    return TRUE;
+}
+
 /**
   * @brief This function is used to Send SDCARD CMD and Receive Response
   * @param[in] nCmd Set command register
@@ -153,7 +398,9 @@ uint32_t MMC_Command_Exec(uint8_t nCmd, uint32_t nArg, uint8_t *pchar, uint32_t
     int32_t counter = 0;                    // Byte counter for multi-byte fields;
     UINT16 card_response;                       // Variable for storing card response;
     uint8_t data_resp;                      // Variable for storing data response;
-    UINT16 dummy_CRC;                       // Dummy variable for storing CRC field;
+    uint8_t cmd_byte;                       // Command byte with start and transmission bits;
+    uint8_t cmd_CRC;                        // CRC7 of command, shifted left by one bit;
+    uint32_t data_ok = TRUE;                // Data block CRC and response check;
 
     card_response.i = 0;
 
@@ -169,7 +416,8 @@ uint32_t MMC_Command_Exec(uint8_t nCmd, uint32_t nArg, uint8_t *pchar, uint32_t
     PE5 = 0;//SPI_SET_SS_LOW(g_pSPI);// CS = 0
 
     SingleWrite(0xFF);
-    SingleWrite((current_command.command_byte | 0x40) & 0x7f);
+    cmd_byte = (current_command.command_byte | 0x40) & 0x7f;
+    SingleWrite(cmd_byte);
     DBG_PRINTF("CMD:%d,", current_command.command_byte & 0x7f);
 
     SD_Delay(200);
@@ -198,29 +446,20 @@ uint32_t MMC_Command_Exec(uint8_t nCmd, uint32_t nArg, uint8_t *pchar, uint32_t
     }
     // If an argument is required, transmit
     // one, otherwise transmit 4 bytes of
-    // 0x00;
-    if(current_command.arg_required == YES)
+    // 0x00; The CRC7 is sent with every
+    // command so that the card can check
+    // it once CRC_ON_OFF has enabled it;
+    if(current_command.arg_required != YES)
     {
-        dummy_CRC.i = GenerateCRC((current_command.command_byte | 0x40), 0x1200, 0);
-        for(counter = 3; counter >= 0; counter--)
-        {
-            SingleWrite(long_arg.b[counter]);
-            dummy_CRC.i = GenerateCRC(long_arg.b[counter], 0x1200, dummy_CRC.i);
-
-        }
-        dummy_CRC.i = (dummy_CRC.i >> 8) | 0x01;
-        SingleWrite(dummy_CRC.b[0]);
+        long_arg.l = 0;
     }
-    else
+    cmd_CRC = SD_CRC7(0, cmd_byte);
+    for(counter = 3; counter >= 0; counter--)
     {
-        counter = 0;
-        while(counter <= 3)
-        {
-            SingleWrite(0x00);
-            counter++;
-        }
-        SingleWrite(/*current_command.CRC*/current_command.CRC_SD);
+        SingleWrite(long_arg.b[counter]);
+        cmd_CRC = SD_CRC7(cmd_CRC, long_arg.b[counter]);
     }
+    SingleWrite(cmd_CRC | 0x01);
 
     // The command table entry will indicate
     // what type of response to expect for
@@ -248,6 +487,8 @@ uint32_t MMC_Command_Exec(uint8_t nCmd, uint32_t nArg, uint8_t *pchar, uint32_t
     }
     else if(current_command.response == R1b)   // Read the R1b response;
     {
+        if(current_command.command_byte == 12)
+            SingleWrite(0xFF);            // Skip the stuff byte after CMD12;
         loopguard = 0;
         do
         {
@@ -255,7 +496,10 @@ uint32_t MMC_Command_Exec(uint8_t nCmd, uint32_t nArg, uint8_t *pchar, uint32_t
             if(!++loopguard) break;
         }
         while((card_response.b[0] & BUSY_BIT));
-        while((SingleWrite(0xFF) & 0xFF) == 0x00);
+        if(!WaitReady())
+        {
+            BACK_FROM_ERROR;
+        }
     }
     else if(current_command.response == R2)
     {
@@ -340,31 +584,9 @@ uint32_t MMC_Command_Exec(uint8_t nCmd, uint32_t nArg, uint8_t *pchar, uint32_t
                 }
                 SD_Delay(119);
             }
-            counter = 0;                    // Reset byte counter;
-            // Read <current_blklen> bytes;
-            if(pchar)
-            {
-                for(counter = 0; counter < current_blklen; counter++)
-                {
-                    SPI_WRITE_TX(g_pSPI, 0xFF);
-                    SPI_TRIGGER(g_pSPI);
-                    while(SPI_IS_BUSY(g_pSPI));
-                    *(pchar + counter) = SPI_READ_RX(g_pSPI);
-                }
-            }
-            else
-            {
-                for(; counter < current_blklen; counter++)
-                {
-                    SPI_WRITE_TX(g_pSPI, 0xFF);
-                    SPI_TRIGGER(g_pSPI);
-                    while(SPI_IS_BUSY(g_pSPI));
-                }
-            }
-            dummy_CRC.b[1] = SingleWrite(0xFF); // After all data is read, read the two
-            dummy_CRC.b[0] = SingleWrite(0xFF); // CRC bytes;  These bytes are not used
-            // in this mode, but the place holders
-            // must be read anyway;
+            // Read <current_blklen> bytes and
+            // check the two CRC bytes after them;
+            data_ok = ReceiveBlock(pchar, current_blklen);
             break;
         case RD:                         // Read data from the MMC;
             loopguard = 0;
@@ -376,76 +598,43 @@ uint32_t MMC_Command_Exec(uint8_t nCmd, uint32_t nArg, uint8_t *pchar, uint32_t
                     BACK_FROM_ERROR;
                 }
             }
-            counter = 0;                    // Reset byte counter;
-            // Read <current_blklen> bytes;
-            if(pchar)
-            {
-                for(counter = 0; counter < current_blklen; counter++)
-                {
-                    SPI_WRITE_TX(g_pSPI, 0xFF);
-                    SPI_TRIGGER(g_pSPI);
-                    while(SPI_IS_BUSY(g_pSPI));
-                    *(pchar + counter) = SPI_READ_RX(g_pSPI);
-                }
-            }
-            else
-            {
-                for(counter = 0; counter < current_blklen; counter++)
-                {
-                    SPI_WRITE_TX(g_pSPI, 0xFF);
-                    SPI_TRIGGER(g_pSPI);
-                    while(SPI_IS_BUSY(g_pSPI));
-                }
-            }
-            dummy_CRC.b[1] = SingleWrite(0xFF); // After all data is read, read the two
-            dummy_CRC.b[0] = SingleWrite(0xFF); // CRC bytes;  These bytes are not used
-            // in this mode, but the place holders
-            // must be read anyway;
+            // Read <current_blklen> bytes and
+            // check the two CRC bytes after them;
+            data_ok = ReceiveBlock(pchar, current_blklen);
             break;
 
         case WR:
-            SingleWrite(0xFF);
-            SingleWrite(START_SBW);
-
-            for(counter = 0; counter < current_blklen; counter++)
-            {
-                SPI_WRITE_TX(g_pSPI, *(pchar + counter));
-                SPI_TRIGGER(g_pSPI);
-                dummy_CRC.i = GenerateCRC(*(pchar + counter), 0x1021, dummy_CRC.i);
-                while(SPI_IS_BUSY(g_pSPI));
-            }
-            SingleWrite(dummy_CRC.b[1]);
-            SingleWrite(dummy_CRC.b[0]);
-
-            loopguard = 0;
-            do                            // Read Data Response from card;
+            data_resp = SendBlock(START_SBW, pchar, current_blklen);
+            if(!data_resp)
             {
-                data_resp = SingleWrite(0xFF);
-                if(!++loopguard) break;
+                BACK_FROM_ERROR;
             }
-            while((data_resp & DATA_RESP_MASK) != 0x01);     // When bit 0 of the MMC response
-            // is clear, a valid data response
-            // has been received;
 
-            if(!loopguard)
+            if(!WaitReady())
             {
                 BACK_FROM_ERROR;
             }
-
-            while((SingleWrite(0xFF) & 0xFF) != 0xFF); //Wait for Busy
             SingleWrite(0xFF);
+
+            // The block is rejected on a CRC or
+            // write error;
+            if(data_resp != DATA_RESP_ACCEPTED)
+                data_ok = FALSE;
             break;
         default:
             break;
     }
 
-    PE5 = 1;//SPI_SET_SS_HIGH(g_pSPI);// CS = 1
+    // Keep the card selected for the data
+    // blocks of a multi-block transfer;
+    if(current_command.var_length != YES)
+        PE5 = 1;//SPI_SET_SS_HIGH(g_pSPI);// CS = 1
 
     if((current_command.command_byte == 9) || (current_command.command_byte == 10))
     {
         current_blklen = old_blklen;
     }
-    return TRUE;
+    return data_ok;
 }
 
 /**
@@ -540,6 +729,10 @@ void MMC_FLASH_Init(void)
         }
         MMC_Command_Exec(SET_BLOCKLEN, (uint32_t)PHYSICAL_BLOCK_SIZE, EMPTY, &response);
     }
+    // Let the card check the CRC of commands
+    // and data blocks too;
+    MMC_Command_Exec(CRC_ON_OFF, 1, EMPTY, &response);
+
     if(MMC_Command_Exec(SEND_CSD, EMPTY, pchar, &response) == FALSE)
         return;
 
@@ -605,6 +798,14 @@ uint32_t SDCARD_Open(void)
     PE5 = 1;//SPI_SET_SS_LOW(g_pSPI);
     SingleWrite(0xFFFFFFFF);
 
+    /* PDMA moves the data phase of a block between SPI1 and the buffer */
+    PDMA_Open((1 << SD_PDMA_TX_CH) | (1 << SD_PDMA_RX_CH));
+    PDMA_SetTransferMode(SD_PDMA_TX_CH, PDMA_SPI1_TX, FALSE, 0);
+    PDMA_SetTransferMode(SD_PDMA_RX_CH, PDMA_SPI1_RX, FALSE, 0);
+    PDMA_EnableInt(SD_PDMA_RX_CH, PDMA_IER_BLKD_IE_Msk);
+    NVIC_EnableIRQ(PDMA_IRQn);
+
+    xfer_mode = XFER_NONE;
     MMC_FLASH_Init();
     SD_Delay(300000);
     if(Is_Initialized)
@@ -627,6 +828,9 @@ uint32_t SDCARD_Open(void)
   */
 void SDCARD_Close(void)
 {
+    SpiStop();
+    NVIC_DisableIRQ(PDMA_IRQn);
+    PDMA_Close();
     SPI_Close(g_pSPI);
 }
 
@@ -655,39 +859,103 @@ uint32_t GetLogicSector(void)
     return LogicSector;
 }
 
+/**
+  * @brief This function is used to end the multi-block transfer left open by SpiRead or SpiWrite
+  * @retval SD_SUCCESS The transfer is ended
+  * @retval SD_FAIL The card does not finish the transfer
+  */
+uint32_t SpiStop(void)
+{
+    uint32_t response;
+    uint32_t ret = SD_SUCCESS;
+
+    if(xfer_mode == XFER_READ)
+    {
+        if(MMC_Command_Exec(STOP_TRANSMISSION, EMPTY, EMPTY, &response) != TRUE)
+            ret = SD_FAIL;
+    }
+    else if(xfer_mode == XFER_WRITE)
+    {
+        SingleWrite(STOP_MBW);
+        SingleWrite(0xFF);
+        if(!WaitReady())
+            ret = SD_FAIL;
+        SingleWrite(0xFF);
+        PE5 = 1;//SPI_SET_SS_HIGH(g_pSPI);// CS = 1
+    }
+    xfer_mode = XFER_NONE;
+    return ret;
+}
+
+/**
+  * @brief This function is used to tell how many blocks the next SpiWrite transfer will write
+  * @param[in] count Number of blocks
+  * @return none
+  * @details The blocks are pre-erased by ACMD23 when the write starts, which makes the multi-block write faster.
+  */
+void SpiSetWriteCount(uint32_t count)
+{
+    write_count = count;
+}
+
 /**
   * @brief This function is used to Get data from SD card
   * @param[in] addr Set start address for LBA
   * @param[in] size Set data size (byte)
   * @param[in] buffer Set buffer pointer
-  * @return none
+  * @retval SD_SUCCESS All blocks are read
+  * @retval SD_FAIL A block cannot be read
+  * @details The blocks are read by READ_MULTIPLE_BLOCK. The transfer is left open, so a following call that
+  *          reads the next block continues it without another command. A block with a CRC error is read
+  *          again up to SD_RETRY_NUM times. The transfer stops at the first block that still fails.
   */
-void SpiRead(uint32_t addr, uint32_t size, uint8_t* buffer)
+uint32_t SpiRead(uint32_t addr, uint32_t size, uint8_t* buffer)
 {
     /* This is low level read function of USB Mass Storage */
     uint32_t response;
-    if(SDtype & SDBlock)
+    uint32_t retry = 0;
+    uint16_t loopguard;
+
+    if(xfer_mode == XFER_WRITE)
+        SpiStop();
+
+    while(size >= PHYSICAL_BLOCK_SIZE)
     {
-        while(size >= PHYSICAL_BLOCK_SIZE)
+        if((xfer_mode != XFER_READ) || (xfer_next != addr))
         {
-            MMC_Command_Exec(READ_SINGLE_BLOCK, addr, buffer, &response);
-            addr   ++;
-            buffer += PHYSICAL_BLOCK_SIZE;
-            size  -= PHYSICAL_BLOCK_SIZE;
+            SpiStop();
+            if((MMC_Command_Exec(READ_MULTIPLE_BLOCK, (SDtype & SDBlock) ? addr : addr * PHYSICAL_BLOCK_SIZE, EMPTY, &response) == TRUE) &&
+                    (response == 0))
+            {
+                xfer_mode = XFER_READ;
+                xfer_next = addr;
+            }
         }
 
-    }
-    else
-    {
-        addr *= PHYSICAL_BLOCK_SIZE;
-        while(size >= PHYSICAL_BLOCK_SIZE)
+        if(xfer_mode == XFER_READ)
         {
-            MMC_Command_Exec(READ_SINGLE_BLOCK, addr, buffer, &response);
-            addr   += PHYSICAL_BLOCK_SIZE;
-            buffer += PHYSICAL_BLOCK_SIZE;
-            size  -= PHYSICAL_BLOCK_SIZE;
+            loopguard = 0;
+            while((SingleWrite(0xFF) & 0xFF) != START_MBR)
+            {
+                if(!++loopguard) break;
+            }
+
+            if(loopguard && ReceiveBlock(buffer, PHYSICAL_BLOCK_SIZE))
+            {
+                xfer_next++;
+                addr   ++;
+                buffer += PHYSICAL_BLOCK_SIZE;
+                size  -= PHYSICAL_BLOCK_SIZE;
+                retry = 0;
+                continue;
+            }
+            SpiStop();
         }
+
+        if(++retry >= SD_RETRY_NUM)
+            return SD_FAIL;
     }
+    return SD_SUCCESS;
 }
 
 /**
@@ -695,32 +963,66 @@ void SpiRead(uint32_t addr, uint32_t size, uint8_t* buffer)
   * @param[in] addr Set start address for LBA
   * @param[in] size Set data size (byte)
   * @param[in] buffer Set buffer pointer
-  * @return none
+  * @retval SD_SUCCESS All blocks are written
+  * @retval SD_FAIL A block cannot be written
+  * @details The blocks are written by WRITE_MULTIPLE_BLOCK after they are pre-erased by ACMD23. The transfer
+  *          is left open, so a following call that writes the next block continues it without another
+  *          command. A block rejected by the card is written again up to SD_RETRY_NUM times. The transfer
+  *          stops at the first block that still fails.
   */
-void SpiWrite(uint32_t addr, uint32_t size, uint8_t* buffer)
+uint32_t SpiWrite(uint32_t addr, uint32_t size, uint8_t* buffer)
 {
     uint32_t response;
-    if(SDtype & SDBlock)
+    uint32_t retry = 0;
+    uint32_t count;
+    uint8_t data_resp;
+
+    if(xfer_mode == XFER_READ)
+        SpiStop();
+
+    while(size >= PHYSICAL_BLOCK_SIZE)
     {
-        while(size >= PHYSICAL_BLOCK_SIZE)
+        if((xfer_mode != XFER_WRITE) || (xfer_next != addr))
         {
-            MMC_Command_Exec(WRITE_BLOCK, addr, buffer, &response);
-            addr   ++;
-            buffer += PHYSICAL_BLOCK_SIZE;
-            size  -= PHYSICAL_BLOCK_SIZE;
+            SpiStop();
+
+            count = size / PHYSICAL_BLOCK_SIZE;
+            if(count < write_count)
+                count = write_count;
+            write_count = 0;
+            if((count > 1) && !(SDtype & MMCv3))
+                MMC_Command_Exec(SD_SET_WR_BLK_ERASE_COUNT, count, EMPTY, &response);
+
+            if((MMC_Command_Exec(WRITE_MULTIPLE_BLOCK, (SDtype & SDBlock) ? addr : addr * PHYSICAL_BLOCK_SIZE, EMPTY, &response) == TRUE) &&
+                    (response == 0))
+            {
+                xfer_mode = XFER_WRITE;
+                xfer_next = addr;
+            }
         }
-    }
-    else
-    {
-        addr *= PHYSICAL_BLOCK_SIZE;
-        while(size >= PHYSICAL_BLOCK_SIZE)
+
+        if(xfer_mode == XFER_WRITE)
         {
-            MMC_Command_Exec(WRITE_BLOCK, addr, buffer, &response);
-            addr   += (PHYSICAL_BLOCK_SIZE);
-            buffer += PHYSICAL_BLOCK_SIZE;
-            size  -= PHYSICAL_BLOCK_SIZE;
+            data_resp = SendBlock(START_MBW, buffer, PHYSICAL_BLOCK_SIZE);
+            if(data_resp && !WaitReady())
+                data_resp = 0;
+
+            if(data_resp == DATA_RESP_ACCEPTED)
+            {
+                xfer_next++;
+                addr   ++;
+                buffer += PHYSICAL_BLOCK_SIZE;
+                size  -= PHYSICAL_BLOCK_SIZE;
+                retry = 0;
+                continue;
+            }
+            SpiStop();
         }
+
+        if(++retry >= SD_RETRY_NUM)
+            return SD_FAIL;
     }
+    return SD_SUCCESS;
 }
 /*@}*/ /* end of group M071R_M071S_SDCARD_EXPORTED_FUNCTIONS */
 
@@ -74,54 +74,26 @@ const uint8_t gu8ConfigDescriptor[] =
     0x00                    // bInterval
 };
 
-/*!<USB Language String Descriptor */
-const uint8_t gu8StringLang[4] =
+/*!<USB Strings. Their string descriptors are generated by the USBD driver.
+    Entry 0 is not used as the driver replies the English (United States) language ID. */
+const char * const gpcUsbString[4] =
 {
-    4,              /* bLength */
-    DESC_STRING,    /* bDescriptorType */
-    0x09, 0x04
-};
-
-/*!<USB Vendor String Descriptor */
-const uint8_t gu8VendorStringDesc[16] =
-{
-    16,
-    DESC_STRING,
-    'N', 0, 'u', 0, 'v', 0, 'o', 0, 't', 0, 'o', 0, 'n', 0
-};
-
-/*!<USB Product String Descriptor */
-const uint8_t gu8ProductStringDesc[22] =
-{
-    22,             /* bLength          */
-    DESC_STRING,    /* bDescriptorType  */
-    'U', 0, 'S', 0, 'B', 0, ' ', 0, 'D', 0, 'e', 0, 'v', 0, 'i', 0, 'c', 0, 'e', 0
-};
-
-
-uint8_t gu8StringSerial[26] =
-{
-    26,             // bLength
-    DESC_STRING,    // bDescriptorType
-    'A', 0, '0', 0, '0', 0, '0', 0, '0', 0, '8', 0, '0', 0, '4', 0, '0', 0, '1', 0, '1', 0, '5', 0
-
-};
-
-
-const uint8_t *gpu8UsbString[4] =
-{
-    gu8StringLang,
-    gu8VendorStringDesc,
-    gu8ProductStringDesc,
-    gu8StringSerial
+    NULL,
+    "Nuvoton",
+    "USB Device",
+    "A00008040115"
 };
 
 const S_USBD_INFO_T gsInfo =
 {
     gu8DeviceDescriptor,
     gu8ConfigDescriptor,
-    gpu8UsbString,
-    NULL
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    gpcUsbString,
+    sizeof(gpcUsbString) / sizeof(gpcUsbString[0])
 };
 
 /*** (C) COPYRIGHT 2019 Nuvoton Technology Corp. ***/
@@ -80,6 +80,7 @@ void SYS_Init(void)
     CLK_EnableModuleClock(UART0_MODULE);
     CLK_EnableModuleClock(USBD_MODULE);
     CLK_EnableModuleClock(SPI1_MODULE);
+    CLK_EnableModuleClock(PDMA_MODULE);
 
     CLK_SetModuleClock(SPI1_MODULE, CLK_CLKSEL1_SPI1_S_HCLK, MODULE_NoMsk);
 
@@ -129,7 +130,7 @@ int32_t main(void)
 
     SDCARD_Open();
 
-    USBD_Open(&gsInfo, MSC_ClassRequest, NULL);
+    USBD_Open(&gsInfo, USBD_MSC_ClassRequest, NULL);
 
     USBD_SetConfigCallback(MSC_SetConfig);
 
@@ -181,7 +182,7 @@ int32_t main(void)
         }
 #endif
 
-        MSC_ProcessCmd();
+        USBD_MSC_Process();
     }
 }
 
@@ -11,202 +11,81 @@
 #include "NuMicro.h"
 #include "cdc_serial.h"
 
-uint32_t volatile g_u32OutToggle0 = 0, g_u32OutToggle1 = 0;
-uint8_t volatile g_u8Suspend = 0;
-
-/*--------------------------------------------------------------------------*/
-void USBD_IRQHandler(void)
-{
-    uint32_t u32IntSts = USBD_GET_INT_FLAG();
-    uint32_t u32State = USBD_GET_BUS_STATE();
-
-//------------------------------------------------------------------
-    if(u32IntSts & USBD_INTSTS_FLDET)
-    {
-        // Floating detect
-        USBD_CLR_INT_FLAG(USBD_INTSTS_FLDET);
-
-        if(USBD_IS_ATTACHED())
-        {
-            /* USB Plug In */
-            USBD_ENABLE_USB();
-        }
-        else
-        {
-            /* USB Un-plug */
-            USBD_DISABLE_USB();
-        }
-    }
-
-//------------------------------------------------------------------
-    if(u32IntSts & USBD_INTSTS_WAKEUP)
-    {
-        /* Clear event flag */
-        USBD_CLR_INT_FLAG(USBD_INTSTS_WAKEUP);
-    }
-
-//------------------------------------------------------------------
-    if(u32IntSts & USBD_INTSTS_BUS)
-    {
-        /* Clear event flag */
-        USBD_CLR_INT_FLAG(USBD_INTSTS_BUS);
-
-        if(u32State & USBD_STATE_USBRST)
-        {
-            /* Bus reset */
-            USBD_ENABLE_USB();
-            USBD_SwReset();
-            g_u32OutToggle0 = g_u32OutToggle1 = 0;
-            g_u8Suspend = 0;
-        }
-        if(u32State & USBD_STATE_SUSPEND)
-        {
-            /* Enter power down to wait USB attached */
-            g_u8Suspend = 1;
-
-            /* Enable USB but disable PHY */
-            USBD_DISABLE_PHY();
-        }
-        if(u32State & USBD_STATE_RESUME)
-        {
-            /* Enable USB and enable PHY */
-            USBD_ENABLE_USB();
-            g_u8Suspend = 0;
-        }
-    }
-
-//------------------------------------------------------------------
-    if(u32IntSts & USBD_INTSTS_USB)
-    {
-        // USB event
-        if(u32IntSts & USBD_INTSTS_SETUP)
-        {
-            // Setup packet
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_SETUP);
-
-            /* Clear the data IN/OUT ready flag of control end-points */
-            USBD_STOP_TRANSACTION(EP0);
-            USBD_STOP_TRANSACTION(EP1);
-
-            USBD_ProcessSetupPacket();
-        }
-
-        // EP events
-        if(u32IntSts & USBD_INTSTS_EP0)
-        {
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP0);
-
-            // control IN
-            USBD_CtrlIn();
-        }
-
-        if(u32IntSts & USBD_INTSTS_EP1)
-        {
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP1);
-
-            // control OUT
-            USBD_CtrlOut();
-        }
-
-        if(u32IntSts & USBD_INTSTS_EP2)
-        {
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP2);
-            // Bulk IN
-            EP2_Handler();
-        }
+#define RXBUFSIZE           1024 /* UART RX buffer size of each port. 11 ms at 921600 bps */
 
-        if(u32IntSts & USBD_INTSTS_EP3)
-        {
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP3);
-            // Bulk Out
-            EP3_Handler();
-        }
-
-        if(u32IntSts & USBD_INTSTS_EP4)
-        {
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP4);
-        }
-
-        if(u32IntSts & USBD_INTSTS_EP5)
-        {
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP5);
-        }
-
-        if(u32IntSts & USBD_INTSTS_EP6)
-        {
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP6);
-            // Bulk Out
-            EP6_Handler();
-        }
+uint8_t volatile g_u8Suspend = 0;
 
-        if(u32IntSts & USBD_INTSTS_EP7)
-        {
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP7);
-            // Bulk IN
-            EP7_Handler();
+/* UART receive buffers of the virtual COM ports */
+static uint8_t s_au8RxBuf0[RXBUFSIZE];
+static uint8_t s_au8RxBuf1[RXBUFSIZE];
 
-        }
-    }
+/* VCOM-1 on interface 0 and UART0, VCOM-2 on interface 2 and UART1. Each port transmits and receives by PDMA. */
+static const USBD_CDC_PORT_T s_asPort[] =
+{
+    {UART0, 0, EP2, EP3, 0, 1, s_au8RxBuf0, sizeof(s_au8RxBuf0)},
+    {UART1, 2, EP7, EP6, 2, 3, s_au8RxBuf1, sizeof(s_au8RxBuf1)},
+};
 
+/* Bulk endpoint event handlers of VCOM-1 and VCOM-2 */
+static void VCOM0_BulkIn(void)
+{
+    USBD_CDC_BulkIn(0);
 }
 
-void EP2_Handler(void)
+static void VCOM0_BulkOut(void)
 {
-    gu32TxSize0 = 0;
+    USBD_CDC_BulkOut(0);
 }
 
-
-void EP3_Handler(void)
+static void VCOM1_BulkIn(void)
 {
-    /* Bulk OUT */
-    if(g_u32OutToggle0 == (USBD->EPSTS & USBD_EPSTS_EPSTS3_Msk))
-    {
-        USBD_SET_PAYLOAD_LEN(EP3, EP3_MAX_PKT_SIZE);
-    }
-    else
-    {
-        gu32RxSize0 = USBD_GET_PAYLOAD_LEN(EP3);
-        gpu8RxBuf0 = (uint8_t *)(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP3));
+    USBD_CDC_BulkIn(1);
+}
 
-        g_u32OutToggle0 = USBD->EPSTS & USBD_EPSTS_EPSTS3_Msk;
-        /* Set a flag to indicate bulk out ready */
-        gi8BulkOutReady0 = 1;
-    }
+static void VCOM1_BulkOut(void)
+{
+    USBD_CDC_BulkOut(1);
 }
 
-void EP6_Handler(void)
+/* Endpoint configuration as endpoint, address, type, packet buffers, maximum packet size and handler.
+   Bulk OUT has two packet buffers, one receiving while the UART sends the other. */
+#define EP_CFG_LIST(EP_CFG) \
+    EP_CFG(EP0, EP_INPUT | 0,                     0,          1,  EP0_MAX_PKT_SIZE,  NULL)             /* Control IN */          \
+    EP_CFG(EP1, EP_OUTPUT | 0,                    0,          1,  EP1_MAX_PKT_SIZE,  NULL)             /* Control OUT */         \
+    EP_CFG(EP2, EP_INPUT | BULK_IN_EP_NUM,        EP_BULK,    1,  EP2_MAX_PKT_SIZE,  VCOM0_BulkIn)     /* VCOM-1 bulk IN */      \
+    EP_CFG(EP3, EP_OUTPUT | BULK_OUT_EP_NUM,      EP_BULK,    2,  EP3_MAX_PKT_SIZE,  VCOM0_BulkOut)    /* VCOM-1 bulk OUT */     \
+    EP_CFG(EP4, EP_INPUT | INT_IN_EP_NUM,         EP_INT,     1,  EP4_MAX_PKT_SIZE,  NULL)             /* VCOM-1 interrupt IN */ \
+    EP_CFG(EP5, EP_INPUT | INT_IN_EP_NUM_1,       EP_INT,     1,  EP5_MAX_PKT_SIZE,  NULL)             /* VCOM-2 interrupt IN */ \
+    EP_CFG(EP6, EP_OUTPUT | BULK_OUT_EP_NUM_1,    EP_BULK,    2,  EP6_MAX_PKT_SIZE,  VCOM1_BulkOut)    /* VCOM-2 bulk OUT */     \
+    EP_CFG(EP7, EP_INPUT | BULK_IN_EP_NUM_1,      EP_BULK,    1,  EP7_MAX_PKT_SIZE,  VCOM1_BulkIn)     /* VCOM-2 bulk IN */
+
+static const S_USBD_EP_CFG_T s_asEpCfg[] =
 {
-    /* Bulk OUT */
-    if(g_u32OutToggle1 == (USBD->EPSTS & USBD_EPSTS_EPSTS6_Msk))
-    {
-        USBD_SET_PAYLOAD_LEN(EP3, EP3_MAX_PKT_SIZE);
-    }
-    else
-    {
-        gu32RxSize1 = USBD_GET_PAYLOAD_LEN(EP6);
-        gpu8RxBuf1 = (uint8_t *)(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP6));
+    EP_CFG_LIST(USBD_EP_CFG_ENTRY)
+};
 
-        g_u32OutToggle1 = USBD->EPSTS & USBD_EPSTS_EPSTS6_Msk;
-        /* Set a flag to indicate bulk out ready */
-        gi8BulkOutReady1 = 1;
-    }
-}
+#if USBD_EP_LIST_LEN(EP_CFG_LIST) > USBD_BUF_SIZE
+#error "USB packet buffers do not fit in the USB SRAM"
+#endif
 
-void EP7_Handler(void)
+/*--------------------------------------------------------------------------*/
+static void VCOM_BusEvent(uint32_t u32State)
 {
-    gu32TxSize1 = 0;
+    /* Suspended until the next reset or resume */
+    g_u8Suspend = (u32State & USBD_STATE_SUSPEND) ? 1 : 0;
 }
 
+void USBD_IRQHandler(void)
+{
+    /* Bus events, control pipe and the endpoint handlers of the endpoint configuration table */
+    USBD_IRQDispatch();
+}
 
+void PDMA_IRQHandler(void)
+{
+    /* UART transmit and receive of both virtual COM ports */
+    USBD_CDC_PdmaIRQHandler();
+}
 
 /*--------------------------------------------------------------------------*/
 /**
@@ -216,301 +95,32 @@ void EP7_Handler(void)
   */
 void VCOM_Init(void)
 {
-    /* Init setup packet buffer */
-    /* Buffer for setup packet -> [0 ~ 0x7] */
-    USBD->STBUFSEG = SETUP_BUF_BASE;
-
-    /*****************************************************/
-    /* EP0 ==> control IN endpoint, address 0 */
-    USBD_CONFIG_EP(EP0, USBD_CFG_CSTALL | USBD_CFG_EPMODE_IN | 0);
-    /* Buffer range for EP0 */
-    USBD_SET_EP_BUF_ADDR(EP0, EP0_BUF_BASE);
-
-    /* EP1 ==> control OUT endpoint, address 0 */
-    USBD_CONFIG_EP(EP1, USBD_CFG_CSTALL | USBD_CFG_EPMODE_OUT | 0);
-    /* Buffer range for EP1 */
-    USBD_SET_EP_BUF_ADDR(EP1, EP1_BUF_BASE);
-
-    /*****************************************************/
-    /* EP2 ==> Bulk IN endpoint, address 1 */
-    USBD_CONFIG_EP(EP2, USBD_CFG_EPMODE_IN | BULK_IN_EP_NUM);
-    /* Buffer offset for EP2 */
-    USBD_SET_EP_BUF_ADDR(EP2, EP2_BUF_BASE);
-
-    /* EP3 ==> Bulk Out endpoint, address 2 */
-    USBD_CONFIG_EP(EP3, USBD_CFG_EPMODE_OUT | BULK_OUT_EP_NUM);
-    /* Buffer offset for EP3 */
-    USBD_SET_EP_BUF_ADDR(EP3, EP3_BUF_BASE);
-    /* trigger receive OUT data */
-    USBD_SET_PAYLOAD_LEN(EP3, EP3_MAX_PKT_SIZE);
-
-    /* EP4 ==> Interrupt IN endpoint, address 3 */
-    USBD_CONFIG_EP(EP4, USBD_CFG_EPMODE_IN | INT_IN_EP_NUM);
-    /* Buffer offset for EP4 ->  */
-    USBD_SET_EP_BUF_ADDR(EP4, EP4_BUF_BASE);
-
-    /*****************************************************/
-    /* EP5 ==> Interrupt IN endpoint, address 6 */
-    USBD_CONFIG_EP(EP5, USBD_CFG_EPMODE_IN | INT_IN_EP_NUM_1);
-    /* Buffer offset for EP5 */
-    USBD_SET_EP_BUF_ADDR(EP5, EP5_BUF_BASE);
-
-    /* EP6 ==> Bulk Out endpoint, address 5 */
-    USBD_CONFIG_EP(EP6, USBD_CFG_EPMODE_OUT | BULK_OUT_EP_NUM_1);
-    /* Buffer offset for EP6 */
-    USBD_SET_EP_BUF_ADDR(EP6, EP6_BUF_BASE);
-    /* trigger receive OUT data */
-    USBD_SET_PAYLOAD_LEN(EP6, EP6_MAX_PKT_SIZE);
-
-    /* EP7 ==> Bulk IN endpoint, address 4 */
-    USBD_CONFIG_EP(EP7, USBD_CFG_EPMODE_IN | BULK_IN_EP_NUM_1);
-    /* Buffer offset for EP7 */
-    USBD_SET_EP_BUF_ADDR(EP7, EP7_BUF_BASE);
-}
-
-
-void VCOM_ClassRequest(void)
-{
-    uint8_t buf[8];
-
-    USBD_GetSetupPacket(buf);
-
-    if(buf[0] & 0x80)    /* request data transfer direction */
+    /* Setup packet buffer, endpoints and their packet buffers */
+    if(USBD_ConfigEpTable(s_asEpCfg, sizeof(s_asEpCfg) / sizeof(s_asEpCfg[0])) != 0)
     {
-        // Device to host
-        switch(buf[1])
-        {
-            case GET_LINE_CODE:
-            {
-                if(buf[4] == 0)    /* VCOM-1 */
-                {
-                    USBD_MemCopy((uint8_t *)(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0)), (uint8_t *)&gLineCoding0, 7);
-                }
-                if(buf[4] == 2) /* VCOM-2 */
-                {
-                    USBD_MemCopy((uint8_t *)(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0)), (uint8_t *)&gLineCoding1, 7);
-                }
-                /* Data stage */
-                USBD_SET_DATA1(EP0);
-                USBD_SET_PAYLOAD_LEN(EP0, 7);
-                /* Status stage */
-                USBD_PrepareCtrlOut(0, 0);
-                break;
-            }
-            default:
-            {
-                /* Setup error, stall the device */
-                USBD_SetStall(EP0);
-                USBD_SetStall(EP1);
-                break;
-            }
-        }
+        /* Invalid endpoint table, the device is never connected */
+        while(1);
     }
-    else
-    {
-        // Host to device
-        switch(buf[1])
-        {
-            case SET_CONTROL_LINE_STATE:
-            {
-                if(buf[4] == 0)    /* VCOM-1 */
-                {
-                    gCtrlSignal0 = buf[3];
-                    gCtrlSignal0 = (gCtrlSignal0 << 8) | buf[2];
-                    //printf("RTS=%d  DTR=%d\n", (gCtrlSignal0 >> 1) & 1, gCtrlSignal0 & 1);
-                }
-                if(buf[4] == 2) /* VCOM-2 */
-                {
-                    gCtrlSignal1 = buf[3];
-                    gCtrlSignal1 = (gCtrlSignal1 << 8) | buf[2];
-                    //printf("RTS=%d  DTR=%d\n", (gCtrlSignal0 >> 1) & 1, gCtrlSignal0 & 1);
-                }
-
-                /* Status stage */
-                USBD_SET_DATA1(EP0);
-                USBD_SET_PAYLOAD_LEN(EP0, 0);
-                break;
-            }
-            case SET_LINE_CODE:
-            {
-                if(buf[4] == 0)  /* VCOM-1 */
-                    USBD_PrepareCtrlOut((uint8_t *)&gLineCoding0, 7);
-                if(buf[4] == 2) /* VCOM-2 */
-                    USBD_PrepareCtrlOut((uint8_t *)&gLineCoding1, 7);
-
-                /* Status stage */
-                USBD_SET_DATA1(EP0);
-                USBD_SET_PAYLOAD_LEN(EP0, 0);
 
-                /* UART setting */
-                if(buf[4] == 0)  /* VCOM-1 */
-                    VCOM_LineCoding(0);
-                if(buf[4] == 2)  /* VCOM-2 */
-                    VCOM_LineCoding(1);
+    /* Track the suspend state for power down */
+    USBD_SetBusEventCallback(VCOM_BusEvent);
 
-                break;
-            }
-            default:
-            {
-                // Stall
-                /* Setup error, stall the device */
-                USBD_SetStall(EP0);
-                USBD_SetStall(EP1);
-                break;
-            }
-        }
-    }
+    /* Bridge the bulk endpoints to UART0 and UART1 */
+    USBD_CDC_Open(s_asPort, sizeof(s_asPort) / sizeof(s_asPort[0]));
 }
 
-void VCOM_LineCoding(uint8_t port)
+void VCOM_SetConfig(void)
 {
-    uint32_t u32Reg, u32Tmp, u32Baudrate, u32SysTmp;
-    uint32_t u32Div = 0;
-    //uint32_t u32Reg, u32Baud_Div;;
-
-    if(port == 0)
-    {
-        NVIC_DisableIRQ(UART02_IRQn);
-
-        u32Baudrate = gLineCoding0.u32DTERate;
-        u32Tmp = 65 * u32Baudrate;
-        u32SysTmp = PllClock / 1000;
-        /* Check we need to divide PLL clock. Note:
-           It may not work when baudrate is very small,e.g. 110 bps */
-        if(u32SysTmp > u32Tmp)
-            u32Div = u32SysTmp / u32Tmp;
-
-        /* Update UART peripheral clock frequency. */
-        u32SysTmp = PllClock / (u32Div + 1);
-
-        // Reset software fifo
-        comRbytes0 = 0;
-        comRhead0 = 0;
-        comRtail0 = 0;
-
-        comTbytes0 = 0;
-        comThead0 = 0;
-        comTtail0 = 0;
-
-        // Reset hardware fifo
-        UART0->FCR = UART_FCR_TFR_Msk | UART_FCR_RFR_Msk;
-
-        // Set baudrate, clock source and clock divider
-        UART0->BAUD = 0x30000000 + ((u32SysTmp + gLineCoding0.u32DTERate / 2) / gLineCoding0.u32DTERate - 2);
-        CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART_S_PLL, CLK_CLKDIV_UART(u32Div + 1));
-
-        // Set parity
-        if(gLineCoding0.u8ParityType == 0)
-            u32Reg = 0; // none parity
-        else if(gLineCoding0.u8ParityType == 1)
-            u32Reg = 0x08; // odd parity
-        else if(gLineCoding0.u8ParityType == 2)
-            u32Reg = 0x18; // even parity
-        else
-            u32Reg = 0;
-
-        // bit width
-        switch(gLineCoding0.u8DataBits)
-        {
-            case 5:
-                u32Reg |= 0;
-                break;
-            case 6:
-                u32Reg |= 1;
-                break;
-            case 7:
-                u32Reg |= 2;
-                break;
-            case 8:
-                u32Reg |= 3;
-                break;
-            default:
-                break;
-        }
-
-        // stop bit
-        if(gLineCoding0.u8CharFormat > 0)
-            u32Reg |= 0x4; // 2 or 1.5 bits
-
-        UART0->LCR = u32Reg;
-
-        // Re-enable UART interrupt
-        NVIC_EnableIRQ(UART02_IRQn);
-    }
-    else
-    {
-        NVIC_DisableIRQ(UART1_IRQn);
-
-        u32Baudrate = gLineCoding1.u32DTERate;
-        u32Tmp = 65 * u32Baudrate;
-        u32SysTmp = PllClock / 1000;
-        /* Check we need to divide PLL clock. Note:
-           It may not work when baudrate is very small,e.g. 110 bps */
-        if(u32SysTmp > u32Tmp)
-            u32Div = u32SysTmp / u32Tmp;
-
-        /* Update UART peripheral clock frequency. */
-        u32SysTmp = PllClock / (u32Div + 1);
-
-        // Reset software fifo
-        comRbytes1 = 0;
-        comRhead1 = 0;
-        comRtail1 = 0;
-
-        comTbytes1 = 0;
-        comThead1 = 0;
-        comTtail1 = 0;
-
-        // Reset hardware fifo
-        UART1->FCR = UART_FCR_TFR_Msk | UART_FCR_RFR_Msk;
-
-        // Set baudrate, clock source and clock divider
-        UART1->BAUD = 0x30000000 + ((u32SysTmp + gLineCoding1.u32DTERate / 2) / gLineCoding1.u32DTERate - 2);
-        CLK_SetModuleClock(UART1_MODULE, CLK_CLKSEL1_UART_S_PLL, CLK_CLKDIV_UART(u32Div + 1));
-
-        // Set parity
-        if(gLineCoding1.u8ParityType == 0)
-            u32Reg = 0; // none parity
-        else if(gLineCoding1.u8ParityType == 1)
-            u32Reg = 0x08; // odd parity
-        else if(gLineCoding1.u8ParityType == 2)
-            u32Reg = 0x18; // even parity
-        else
-            u32Reg = 0;
-
-        // bit width
-        switch(gLineCoding1.u8DataBits)
-        {
-            case 5:
-                u32Reg |= 0;
-                break;
-            case 6:
-                u32Reg |= 1;
-                break;
-            case 7:
-                u32Reg |= 2;
-                break;
-            case 8:
-                u32Reg |= 3;
-                break;
-            default:
-                break;
-        }
-
-        // stop bit
-        if(gLineCoding1.u8CharFormat > 0)
-            u32Reg |= 0x4; // 2 or 1.5 bits
-
-        UART1->LCR = u32Reg;
-
-        // Re-enable UART interrupt
-        NVIC_EnableIRQ(UART1_IRQn);
-    }
+    /* Clear stall status and ready, restore the data endpoints */
+    USBD_ResetEp(EP2);
+    USBD_ResetEp(EP3);
+    USBD_ResetEp(EP4);
+    USBD_ResetEp(EP5);
+    USBD_ResetEp(EP6);
+    USBD_ResetEp(EP7);
+
+    /* Trigger to receive OUT data */
+    USBD_CDC_SetConfig();
 }
 
-
-
-
-
-
-
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
@@ -215,52 +215,25 @@ const uint8_t gu8ConfigDescriptor[] =
     0x00,                            /* bInterval        */    		
 };
 
-/*!<USB Language String Descriptor */
-const uint8_t gu8StringLang[4] =
+/*!<USB Strings. Their string descriptors are generated by the USBD driver.
+    Entry 0 is not used as the driver replies the English (United States) language ID. */
+const char * const gpcUsbString[4] =
 {
-    4,              /* bLength */
-    DESC_STRING,    /* bDescriptorType */
-    0x09, 0x04
-};
-
-/*!<USB Vendor String Descriptor */
-const uint8_t gu8VendorStringDesc[] =
-{
-    16,
-    DESC_STRING,
-    'N', 0, 'u', 0, 'v', 0, 'o', 0, 't', 0, 'o', 0, 'n', 0
-};
-
-/*!<USB Product String Descriptor */
-const uint8_t gu8ProductStringDesc[] =
-{
-    32,             /* bLength          */
-    DESC_STRING,    /* bDescriptorType  */
-    'U', 0, 'S', 0, 'B', 0, ' ', 0, 'V', 0, 'i', 0, 'r', 0, 't', 0, 'u', 0, 'a', 0, 'l', 0, ' ', 0, 'C', 0, 'O', 0, 'M', 0
-};
-
-const uint8_t gu8StringSerial[26] =
-{
-    26,             // bLength
-    DESC_STRING,    // bDescriptorType
-    'A', 0, '0', 0, '2', 0, '0', 0, '1', 0, '5', 0, '0', 0, '8', 0, '1', 0, '3', 0, '0', 0, '1', 0
-};
-
-const uint8_t *gpu8UsbString[4] =
-{
-    gu8StringLang,
-    gu8VendorStringDesc,
-    gu8ProductStringDesc,
-    gu8StringSerial
+    NULL,
+    "Nuvoton",
+    "USB Virtual COM",
+    "A02015081301"
 };
 
 const S_USBD_INFO_T gsInfo =
 {
     gu8DeviceDescriptor,
     gu8ConfigDescriptor,
-    gpu8UsbString,
     NULL,
     NULL,
-    NULL
+    NULL,
+    NULL,
+    gpcUsbString,
+    sizeof(gpcUsbString) / sizeof(gpcUsbString[0])
 };
 
@@ -12,183 +12,65 @@
 #include "usbd.h"
 #include "cdc_serial.h"
 
-uint32_t volatile g_u32OutToggle = 0;
-uint8_t volatile g_u8Suspend = 0;
-
-/*--------------------------------------------------------------------------*/
-void USBD_IRQHandler(void)
-{
-    uint32_t u32IntSts = USBD_GET_INT_FLAG();
-    uint32_t u32State = USBD_GET_BUS_STATE();
-
-//------------------------------------------------------------------
-    if(u32IntSts & USBD_INTSTS_FLDET)
-    {
-        // Floating detect
-        USBD_CLR_INT_FLAG(USBD_INTSTS_FLDET);
-
-        if(USBD_IS_ATTACHED())
-        {
-            /* USB Plug In */
-            USBD_ENABLE_USB();
-        }
-        else
-        {
-            /* USB Un-plug */
-            USBD_DISABLE_USB();
-        }
-    }
-
-//------------------------------------------------------------------
-    if(u32IntSts & USBD_INTSTS_WAKEUP)
-    {
-        /* Clear event flag */
-        USBD_CLR_INT_FLAG(USBD_INTSTS_WAKEUP);
-    }
-
-//------------------------------------------------------------------
-    if(u32IntSts & USBD_INTSTS_BUS)
-    {
-        /* Clear event flag */
-        USBD_CLR_INT_FLAG(USBD_INTSTS_BUS);
-
-        if(u32State & USBD_STATE_USBRST)
-        {
-            /* Bus reset */
-            USBD_ENABLE_USB();
-            USBD_SwReset();
-            g_u32OutToggle = 0;
-            g_u8Suspend = 0;
-        }
-        if(u32State & USBD_STATE_SUSPEND)
-        {
-            /* Enter power down to wait USB attached */
-            g_u8Suspend = 1;
-
-            /* Enable USB but disable PHY */
-            USBD_DISABLE_PHY();
-        }
-        if(u32State & USBD_STATE_RESUME)
-        {
-            /* Enable USB and enable PHY */
-            USBD_ENABLE_USB();
-            g_u8Suspend = 0;
-        }
-    }
-
-//------------------------------------------------------------------
-    if(u32IntSts & USBD_INTSTS_USB)
-    {
-        extern uint8_t g_usbd_SetupPacket[];
+#define RXBUFSIZE           1024 /* UART RX buffer size. 11 ms at 921600 bps */
 
-        // USB event
-        if(u32IntSts & USBD_INTSTS_SETUP)
-        {
-            // Setup packet
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_SETUP);
-
-            /* Clear the data IN/OUT ready flag of control end-points */
-            USBD_STOP_TRANSACTION(EP0);
-            USBD_STOP_TRANSACTION(EP1);
-
-            USBD_ProcessSetupPacket();
-        }
-
-        // EP events
-        if(u32IntSts & USBD_INTSTS_EP0)
-        {
-
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP0);
-
-            // control IN
-            USBD_CtrlIn();
-        }
-
-        if(u32IntSts & USBD_INTSTS_EP1)
-        {
-
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP1);
-
-            // control OUT
-            USBD_CtrlOut();
+uint8_t volatile g_u8Suspend = 0;
 
-            // In ACK of SET_LINE_CODE
-            if(g_usbd_SetupPacket[1] == SET_LINE_CODE)
-            {
-                if(g_usbd_SetupPacket[4] == 0)  /* VCOM-1 */
-                    VCOM_LineCoding(0); /* Apply UART settings */
-            }
+/* UART0 receive buffer of the virtual COM port */
+static uint8_t s_au8RxBuf[RXBUFSIZE];
 
-        }
+/* VCOM-1 on interface 0 and UART0. PDMA channel 0 transmits and channel 1 receives. */
+static const USBD_CDC_PORT_T s_asPort[] =
+{
+    {UART0, 0, EP2, EP3, 0, 1, s_au8RxBuf, sizeof(s_au8RxBuf)},
+};
 
-        if(u32IntSts & USBD_INTSTS_EP2)
-        {
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP2);
-            // Bulk IN
-            EP2_Handler();
-        }
+/* Bulk endpoint event handlers of VCOM-1 */
+static void VCOM_BulkIn(void)
+{
+    USBD_CDC_BulkIn(0);
+}
 
-        if(u32IntSts & USBD_INTSTS_EP3)
-        {
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP3);
-            // Bulk Out
-            EP3_Handler();
-        }
+static void VCOM_BulkOut(void)
+{
+    USBD_CDC_BulkOut(0);
+}
 
-        if(u32IntSts & USBD_INTSTS_EP4)
-        {
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP4);
-        }
+/* Endpoint configuration as endpoint, address, type, packet buffers, maximum packet size and handler.
+   Bulk OUT has two packet buffers, one receiving while the UART sends the other. */
+#define EP_CFG_LIST(EP_CFG) \
+    EP_CFG(EP0, EP_INPUT | 0,                 0,          1,  EP0_MAX_PKT_SIZE,  NULL)            /* Control IN */   \
+    EP_CFG(EP1, EP_OUTPUT | 0,                0,          1,  EP1_MAX_PKT_SIZE,  NULL)            /* Control OUT */  \
+    EP_CFG(EP2, EP_INPUT | BULK_IN_EP_NUM,    EP_BULK,    1,  EP2_MAX_PKT_SIZE,  VCOM_BulkIn)     /* Bulk IN */      \
+    EP_CFG(EP3, EP_OUTPUT | BULK_OUT_EP_NUM,  EP_BULK,    2,  EP3_MAX_PKT_SIZE,  VCOM_BulkOut)    /* Bulk OUT */     \
+    EP_CFG(EP4, EP_INPUT | INT_IN_EP_NUM,     EP_INT,     1,  EP4_MAX_PKT_SIZE,  NULL)            /* Interrupt IN */
 
-        if(u32IntSts & USBD_INTSTS_EP5)
-        {
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP5);
-        }
+static const S_USBD_EP_CFG_T s_asEpCfg[] =
+{
+    EP_CFG_LIST(USBD_EP_CFG_ENTRY)
+};
 
-        if(u32IntSts & USBD_INTSTS_EP6)
-        {
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP6);
-        }
+#if USBD_EP_LIST_LEN(EP_CFG_LIST) > USBD_BUF_SIZE
+#error "USB packet buffers do not fit in the USB SRAM"
+#endif
 
-        if(u32IntSts & USBD_INTSTS_EP7)
-        {
-            /* Clear event flag */
-            USBD_CLR_INT_FLAG(USBD_INTSTS_EP7);
-        }
-    }
-    
+/*--------------------------------------------------------------------------*/
+static void VCOM_BusEvent(uint32_t u32State)
+{
+    /* Suspended until the next reset or resume */
+    g_u8Suspend = (u32State & USBD_STATE_SUSPEND) ? 1 : 0;
 }
 
-void EP2_Handler(void)
+void USBD_IRQHandler(void)
 {
-    gu32TxSize = 0;
+    /* Bus events, control pipe and the endpoint handlers of the endpoint configuration table */
+    USBD_IRQDispatch();
 }
 
-
-void EP3_Handler(void)
+void PDMA_IRQHandler(void)
 {
-    /* Bulk OUT */
-    if(g_u32OutToggle == (USBD->EPSTS & USBD_EPSTS_EPSTS3_Msk))
-    {
-        USBD_SET_PAYLOAD_LEN(EP3, EP3_MAX_PKT_SIZE);
-    }
-    else
-    {
-        gu32RxSize = USBD_GET_PAYLOAD_LEN(EP3);
-        gpu8RxBuf = (uint8_t *)(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP3));
-
-        g_u32OutToggle = USBD->EPSTS & USBD_EPSTS_EPSTS3_Msk;
-        /* Set a flag to indicate bulk out ready */
-        gi8BulkOutReady = 1;
-    }
+    /* UART transmit and receive of the virtual COM port */
+    USBD_CDC_PdmaIRQHandler();
 }
 
 /*--------------------------------------------------------------------------*/
@@ -199,191 +81,29 @@ void EP3_Handler(void)
   */
 void VCOM_Init(void)
 {
-    /* Init setup packet buffer */
-    /* Buffer for setup packet -> [0 ~ 0x7] */
-    USBD->STBUFSEG = SETUP_BUF_BASE;
-
-    /*****************************************************/
-    /* EP0 ==> control IN endpoint, address 0 */
-    USBD_CONFIG_EP(EP0, USBD_CFG_CSTALL | USBD_CFG_EPMODE_IN | 0);
-    /* Buffer range for EP0 */
-    USBD_SET_EP_BUF_ADDR(EP0, EP0_BUF_BASE);
-
-    /* EP1 ==> control OUT endpoint, address 0 */
-    USBD_CONFIG_EP(EP1, USBD_CFG_CSTALL | USBD_CFG_EPMODE_OUT | 0);
-    /* Buffer range for EP1 */
-    USBD_SET_EP_BUF_ADDR(EP1, EP1_BUF_BASE);
-
-    /*****************************************************/
-    /* EP2 ==> Bulk IN endpoint, address 1 */
-    USBD_CONFIG_EP(EP2, USBD_CFG_EPMODE_IN | BULK_IN_EP_NUM);
-    /* Buffer offset for EP2 */
-    USBD_SET_EP_BUF_ADDR(EP2, EP2_BUF_BASE);
-
-    /* EP3 ==> Bulk Out endpoint, address 2 */
-    USBD_CONFIG_EP(EP3, USBD_CFG_EPMODE_OUT | BULK_OUT_EP_NUM);
-    /* Buffer offset for EP3 */
-    USBD_SET_EP_BUF_ADDR(EP3, EP3_BUF_BASE);
-    /* trigger receive OUT data */
-    USBD_SET_PAYLOAD_LEN(EP3, EP3_MAX_PKT_SIZE);
-
-    /* EP4 ==> Interrupt IN endpoint, address 3 */
-    USBD_CONFIG_EP(EP4, USBD_CFG_EPMODE_IN | INT_IN_EP_NUM);
-    /* Buffer offset for EP4 ->  */
-    USBD_SET_EP_BUF_ADDR(EP4, EP4_BUF_BASE);
-}
-
-
-void VCOM_ClassRequest(void)
-{
-    uint8_t buf[8];
-
-    USBD_GetSetupPacket(buf);
-
-    if(buf[0] & 0x80)    /* request data transfer direction */
+    /* Setup packet buffer, endpoints and their packet buffers */
+    if(USBD_ConfigEpTable(s_asEpCfg, sizeof(s_asEpCfg) / sizeof(s_asEpCfg[0])) != 0)
     {
-        // Device to host
-        switch(buf[1])
-        {
-            case GET_LINE_CODE:
-            {
-                if(buf[4] == 0)    /* VCOM-1 */
-                {
-                    USBD_MemCopy((uint8_t *)(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP0)), (uint8_t *)&gLineCoding, 7);
-                }
-                /* Data stage */
-                USBD_SET_DATA1(EP0);
-                USBD_SET_PAYLOAD_LEN(EP0, 7);
-                /* Status stage */
-                USBD_PrepareCtrlOut(0, 0);
-                break;
-            }
-            default:
-            {
-                /* Setup error, stall the device */
-                USBD_SetStall(EP0);
-                USBD_SetStall(EP1);
-                break;
-            }
-        }
+        /* Invalid endpoint table, the device is never connected */
+        while(1);
     }
-    else
-    {
-        // Host to device
-        switch(buf[1])
-        {
-            case SET_CONTROL_LINE_STATE:
-            {
-                if(buf[4] == 0)    /* VCOM-1 */
-                {
-                    gCtrlSignal = buf[3];
-                    gCtrlSignal = (gCtrlSignal << 8) | buf[2];
-                    //printf("RTS=%d  DTR=%d\n", (gCtrlSignal0 >> 1) & 1, gCtrlSignal0 & 1);
-                }
-
-                /* Status stage */
-                USBD_SET_DATA1(EP0);
-                USBD_SET_PAYLOAD_LEN(EP0, 0);
-                break;
-            }
-            case SET_LINE_CODE:
-            {
-                if(buf[4] == 0)  /* VCOM-1 */
-                    USBD_PrepareCtrlOut((uint8_t *)&gLineCoding, 7);
 
-                /* Status stage */
-                USBD_SET_DATA1(EP0);
-                USBD_SET_PAYLOAD_LEN(EP0, 0);
+    /* Track the suspend state for power down */
+    USBD_SetBusEventCallback(VCOM_BusEvent);
 
-                break;
-            }
-            default:
-            {
-                // Stall
-                /* Setup error, stall the device */
-                USBD_SetStall(EP0);
-                USBD_SetStall(EP1);
-                break;
-            }
-        }
-    }
+    /* Bridge the bulk endpoints to UART0 */
+    USBD_CDC_Open(s_asPort, sizeof(s_asPort) / sizeof(s_asPort[0]));
 }
 
-void VCOM_LineCoding(uint8_t port)
+void VCOM_SetConfig(void)
 {
-    uint32_t u32Reg, u32Tmp, u32Baudrate, u32SysTmp;
-    uint32_t u32Div = 0;
-
-    if(port == 0)
-    {
-        u32Baudrate = gLineCoding.u32DTERate;
-        u32Tmp = 65 * u32Baudrate;
-        u32SysTmp = PllClock / 1000;
-        /* Check we need to divide PLL clock. Note:
-           It may not work when baudrate is very small,e.g. 110 bps */
-        if(u32SysTmp > u32Tmp)
-            u32Div = u32SysTmp / u32Tmp;
-
-
-        /* Update UART peripheral clock frequency. */
-        u32SysTmp = PllClock / (u32Div + 1);
-
-        // Reset software fifo
-        comRbytes = 0;
-        comRhead = 0;
-        comRtail = 0;
-
-        comTbytes = 0;
-        comThead = 0;
-        comTtail = 0;
-
-        // Reset hardware fifo
-        UART0->FCR = 0x6;
-
-        // Set baudrate, clock source and clock divider
-        UART0->BAUD = 0x30000000 + ((u32SysTmp + gLineCoding.u32DTERate / 2) / gLineCoding.u32DTERate - 2);
-        CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART_S_PLL, CLK_CLKDIV_UART(u32Div + 1));
-
+    /* Clear stall status and ready, restore the data endpoints */
+    USBD_ResetEp(EP2);
+    USBD_ResetEp(EP3);
+    USBD_ResetEp(EP4);
 
-        // Set parity
-        if(gLineCoding.u8ParityType == 0)
-            u32Reg = 0; // none parity
-        else if(gLineCoding.u8ParityType == 1)
-            u32Reg = 0x08; // odd parity
-        else if(gLineCoding.u8ParityType == 2)
-            u32Reg = 0x18; // even parity
-        else
-            u32Reg = 0;
-
-        /* bit width */
-        switch(gLineCoding.u8DataBits)
-        {
-            case 5:
-                u32Reg |= 0;
-                break;
-            case 6:
-                u32Reg |= 1;
-                break;
-            case 7:
-                u32Reg |= 2;
-                break;
-            case 8:
-                u32Reg |= 3;
-                break;
-            default:
-                break;
-        }
-
-        /* stop bit */
-        if(gLineCoding.u8CharFormat > 0)
-            u32Reg |= 0x4; // 2 or 1.5 bits
-
-        UART0->LCR = u32Reg;
-    }
+    /* Trigger to receive OUT data */
+    USBD_CDC_SetConfig();
 }
 
-
-
-
-
-
+/*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
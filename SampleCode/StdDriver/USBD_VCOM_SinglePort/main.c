@@ -11,39 +11,6 @@
 #define CRYSTAL_LESS        1
 #define TRIM_INIT           (GCR_BASE+0x118)
 
-/*--------------------------------------------------------------------------*/
-STR_VCOM_LINE_CODING gLineCoding = {115200, 0, 0, 8};   /* Baud rate : 115200    */
-/* Stop bit     */
-/* parity       */
-/* data bits    */
-uint16_t gCtrlSignal = 0;     /* BIT0: DTR(Data Terminal Ready) , BIT1: RTS(Request To Send) */
-
-/*--------------------------------------------------------------------------*/
-#define RXBUFSIZE           512 /* RX buffer size */
-#define TXBUFSIZE           512 /* RX buffer size */
-
-
-/*---------------------------------------------------------------------------------------------------------*/
-/* Global variables                                                                                        */
-/*---------------------------------------------------------------------------------------------------------*/
-/* UART0 */
-volatile uint8_t comRbuf[RXBUFSIZE];
-volatile uint16_t comRbytes = 0;
-volatile uint16_t comRhead = 0;
-volatile uint16_t comRtail = 0;
-
-volatile uint8_t comTbuf[TXBUFSIZE];
-volatile uint16_t comTbytes = 0;
-volatile uint16_t comThead = 0;
-volatile uint16_t comTtail = 0;
-
-uint8_t gRxBuf[64] = {0};
-volatile uint8_t *gpu8RxBuf = 0;
-volatile uint32_t gu32RxSize = 0;
-volatile uint32_t gu32TxSize = 0;
-
-volatile int8_t gi8BulkOutReady = 0;
-
 /*--------------------------------------------------------------------------*/
 
 void EnableCLKO(uint32_t u32ClkSrc, uint32_t u32ClkDiv)
@@ -106,6 +73,7 @@ void SYS_Init(void)
     /* Enable module clock */
     CLK_EnableModuleClock(UART0_MODULE);
     CLK_EnableModuleClock(USBD_MODULE);
+    CLK_EnableModuleClock(PDMA_MODULE);
 
     /*---------------------------------------------------------------------------------------------------------*/
     /* Init I/O Multi-function                                                                                 */
@@ -134,160 +102,9 @@ void UART0_Init(void)
     /* Configure UART0 and set UART0 Baudrate */
     UART0->BAUD = UART_BAUD_MODE2 | UART_BAUD_MODE2_DIVIDER(__HIRC, 115200);
     UART0->LCR = UART_WORD_LEN_8 | UART_PARITY_NONE | UART_STOP_BIT_1;
-
-    /* Enable UART Interrupt */
-    UART0->IER = UART_IER_TOUT_IEN_Msk | UART_IER_RDA_IEN_Msk;
-
 }
 
 
-/*---------------------------------------------------------------------------------------------------------*/
-/* UART Callback function                                                                                  */
-/*---------------------------------------------------------------------------------------------------------*/
-void UART02_IRQHandler(void)
-{
-    uint32_t u32IntStatus;
-    uint8_t bInChar;
-    int32_t size;
-
-    u32IntStatus = UART0->ISR;
-
-    if((u32IntStatus & 0x1 /* RDAIF */) || (u32IntStatus & 0x10 /* TOUT_IF */))
-    {
-        /* Receiver FIFO threshold level is reached or Rx time out */
-
-        /* Get all the input characters */
-        while((UART0->FSR & UART_FSR_RX_EMPTY_Msk) == 0)
-        {
-            /* Get the character from UART Buffer */
-            bInChar = UART0->DATA;
-
-            /* Check if buffer full */
-            if(comRbytes < RXBUFSIZE)
-            {
-                /* Enqueue the character */
-                comRbuf[comRtail++] = bInChar;
-                if(comRtail >= RXBUFSIZE)
-                    comRtail = 0;
-                comRbytes++;
-            }
-            else
-            {
-                /* FIFO over run */
-            }
-        }
-    }
-
-    if(u32IntStatus & 0x2 /* THRE_IF */)
-    {
-
-        if(comTbytes && (UART0->IER & UART_IER_THRE_IEN_Msk))
-        {
-            /* Fill the Tx FIFO */
-            size = comTbytes;
-            if(size >= UART0_FIFO_SIZE)
-            {
-                size = UART0_FIFO_SIZE;
-            }
-
-            while(size)
-            {
-                bInChar = comTbuf[comThead++];
-                UART0->DATA = bInChar;
-                if(comThead >= TXBUFSIZE)
-                    comThead = 0;
-                comTbytes--;
-                size--;
-            }
-        }
-        else
-        {
-            /* No more data, just stop Tx (Stop work) */
-            UART0->IER &= (~UART_IER_THRE_IEN_Msk);
-        }
-    }
-
-}
-
-void VCOM_TransferData(void)
-{
-    int32_t i, i32Len;
-
-    /* Check whether USB is ready for next packet or not */
-    if(gu32TxSize == 0)
-    {
-        /* Check whether we have new COM Rx data to send to USB or not */
-        if(comRbytes)
-        {
-            i32Len = comRbytes;
-            if(i32Len > EP2_MAX_PKT_SIZE)
-                i32Len = EP2_MAX_PKT_SIZE;
-
-            for(i = 0; i < i32Len; i++)
-            {
-                gRxBuf[i] = comRbuf[comRhead++];
-                if(comRhead >= RXBUFSIZE)
-                    comRhead = 0;
-            }
-
-            __set_PRIMASK(1);
-            comRbytes -= i32Len;
-            __set_PRIMASK(0);
-
-            gu32TxSize = i32Len;
-            USBD_MemCopy((uint8_t *)(USBD_BUF_BASE + USBD_GET_EP_BUF_ADDR(EP2)), (uint8_t *)gRxBuf, i32Len);
-            USBD_SET_PAYLOAD_LEN(EP2, i32Len);
-        }
-        else
-        {
-            /* Prepare a zero packet if previous packet size is EP2_MAX_PKT_SIZE and
-               no more data to send at this moment to note Host the transfer has been done */
-            i32Len = USBD_GET_PAYLOAD_LEN(EP2);
-            if(i32Len == EP2_MAX_PKT_SIZE)
-                USBD_SET_PAYLOAD_LEN(EP2, 0);
-        }
-    }
-
-    /* Process the Bulk out data when bulk out data is ready. */
-    if(gi8BulkOutReady && (gu32RxSize <= TXBUFSIZE - comTbytes))
-    {
-        for(i = 0; i < gu32RxSize; i++)
-        {
-            comTbuf[comTtail++] = gpu8RxBuf[i];
-            if(comTtail >= TXBUFSIZE)
-                comTtail = 0;
-        }
-
-        __set_PRIMASK(1);
-        comTbytes += gu32RxSize;
-        __set_PRIMASK(0);
-
-        gu32RxSize = 0;
-        gi8BulkOutReady = 0; /* Clear bulk out ready flag */
-
-        /* Ready to get next BULK out */
-        USBD_SET_PAYLOAD_LEN(EP3, EP3_MAX_PKT_SIZE);
-    }
-
-    /* Process the software Tx FIFO */
-    if(comTbytes)
-    {
-        /* Check if Tx is working */
-        if((UART0->IER & UART_IER_THRE_IEN_Msk) == 0)
-        {
-            /* Send one bytes out */
-            UART0->DATA = comTbuf[comThead++];
-            if(comThead >= TXBUFSIZE)
-                comThead = 0;
-
-            comTbytes--;
-
-            /* Enable Tx Empty Interrupt. (Trigger first one) */
-            UART0->IER |= UART_IER_THRE_IEN_Msk;
-        }
-    }
-}
-
 void PowerDown()
 {
     /* Unlock protected registers */
@@ -327,9 +144,10 @@ int32_t main(void)
     printf("|          NuMicro USB Virtual COM Port Sample Code          |\n");
     printf("+------------------------------------------------------------+\n");
 
-    USBD_Open(&gsInfo, VCOM_ClassRequest, NULL);
+    USBD_Open(&gsInfo, USBD_CDC_ClassRequest, NULL);
+    USBD_SetConfigCallback(VCOM_SetConfig);
 
-    /* Endpoint configuration */
+    /* Endpoint configuration. UART0 is the virtual COM port from now on. */
     VCOM_Init();
     USBD_Start();
 
@@ -343,8 +161,6 @@ int32_t main(void)
     /* Clear SOF */
     USBD->INTSTS = USBD_INTSTS_SOF_STS_Msk;
 
-    NVIC_EnableIRQ(UART02_IRQn);
-
     while(1)
     {
 #if CRYSTAL_LESS
@@ -384,7 +200,8 @@ int32_t main(void)
         if(g_u8Suspend)
             PowerDown();
 
-        VCOM_TransferData();
+        /* Move data between USB and UART0 */
+        USBD_CDC_Process();
     }
 }
 
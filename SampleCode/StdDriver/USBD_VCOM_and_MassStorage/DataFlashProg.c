@@ -24,10 +24,8 @@ uint32_t g_sectorBuf[FLASH_PAGE_SIZE / 4];
 
 uint32_t FMC_ReadPage(uint32_t u32StartAddr, uint32_t * u32Buf)
 {
-    uint32_t i;
-
-    for(i = 0; i < FLASH_PAGE_SIZE / 4; i++)
-        u32Buf[i] = FMC_Read(u32StartAddr + i * 4);
+    /* Data Flash is bus readable, so this is a word copy instead of one ISP read per word */
+    FMC_ReadMultiple(u32StartAddr, u32Buf, FLASH_PAGE_SIZE);
 
     return 0;
 }
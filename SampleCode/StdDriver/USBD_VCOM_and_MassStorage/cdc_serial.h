@@ -5,8 +5,8 @@
  * @note
  * Copyright (C) 2017 Nuvoton Technology Corp. All rights reserved.
  ******************************************************************************/
-#ifndef __USBD_CDC_H__
-#define __USBD_CDC_H__
+#ifndef __CDC_SERIAL_H__
+#define __CDC_SERIAL_H__
 
 /* Define the vendor id and product id */
 #define USBD_VID        0x0416
@@ -27,23 +27,6 @@
 #define EP5_MAX_PKT_SIZE    64
 #define EP6_MAX_PKT_SIZE    64
 
-#define SETUP_BUF_BASE      0
-#define SETUP_BUF_LEN       8
-#define EP0_BUF_BASE        (SETUP_BUF_BASE + SETUP_BUF_LEN)
-#define EP0_BUF_LEN         EP0_MAX_PKT_SIZE
-#define EP1_BUF_BASE        (SETUP_BUF_BASE + SETUP_BUF_LEN)
-#define EP1_BUF_LEN         EP1_MAX_PKT_SIZE
-#define EP2_BUF_BASE        (EP1_BUF_BASE + EP1_BUF_LEN)
-#define EP2_BUF_LEN         EP2_MAX_PKT_SIZE
-#define EP3_BUF_BASE        (EP2_BUF_BASE + EP2_BUF_LEN)
-#define EP3_BUF_LEN         EP3_MAX_PKT_SIZE
-#define EP4_BUF_BASE        (EP3_BUF_BASE + EP3_BUF_LEN)
-#define EP4_BUF_LEN         EP4_MAX_PKT_SIZE
-#define EP5_BUF_BASE        (EP4_BUF_BASE + EP4_BUF_LEN)
-#define EP5_BUF_LEN         EP5_MAX_PKT_SIZE
-#define EP6_BUF_BASE        (EP5_BUF_BASE + EP5_BUF_LEN)
-#define EP6_BUF_LEN         EP6_MAX_PKT_SIZE
-
 /* Define the interrupt In EP number */
 #define BULK_IN_EP_NUM      0x01
 #define BULK_OUT_EP_NUM     0x02
@@ -98,6 +81,6 @@ void EP6_Handler(void);
 void VCOM_LineCoding(uint8_t port);
 void VCOM_TransferData(void);
 
-#endif  /* __USBD_CDC_H_ */
+#endif  /* __CDC_SERIAL_H__ */
 
 /*** (C) COPYRIGHT 2017 Nuvoton Technology Corp. ***/
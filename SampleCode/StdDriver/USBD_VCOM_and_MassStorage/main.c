@@ -407,7 +407,7 @@ int32_t main(void)
 #endif
 
         VCOM_TransferData();
-        MSC_ProcessCmd();
+        USBD_MSC_Process();
     }
 }
 
@@ -0,0 +1,197 @@
+/**************************************************************************//**
+ * @file     isp_lz.c
+ * @version  V3.00
+ * @brief    Host-side compressor for the CMD_UPDATE_APROM_LZ image stream of the ISP samples
+ *
+ * @details  The stream is a flag byte followed by 8 items, LSB first. Flag bit 1 is a literal byte and flag
+ *           bit 0 is a 16-bit little endian match, bits 0~8 are distance - 1 and bits 9~15 are length - 3.
+ *           The distance is limited to one 512 byte flash page, so the LDROM decoder needs no memory beyond
+ *           its page buffer.
+ *
+ *           Build:       cc -O2 -o isp_lz isp_lz.c
+ *           Compress:    isp_lz firmware.bin firmware.lz
+ *           Decompress:  isp_lz -d firmware.lz firmware.bin
+ *
+ *           The ISP host sends CMD_UPDATE_APROM_LZ with the size of firmware.bin at offset 8 and the size of
+ *           firmware.lz at offset 12 of the first packet, followed by the compressed stream.
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2019 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define LZ_MAX_DIST         512
+#define LZ_MIN_MATCH        3
+#define LZ_MAX_MATCH        (127 + LZ_MIN_MATCH)
+
+static uint8_t *ReadFile(const char *pcName, size_t *pSize)
+{
+    FILE *fp;
+    uint8_t *pu8Buf;
+    long size;
+
+    fp = fopen(pcName, "rb");
+    if(fp == NULL)
+    {
+        perror(pcName);
+        return NULL;
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    pu8Buf = malloc((size_t)size + 1);
+    if((pu8Buf == NULL) || (fread(pu8Buf, 1, (size_t)size, fp) != (size_t)size))
+    {
+        fclose(fp);
+        free(pu8Buf);
+        return NULL;
+    }
+    fclose(fp);
+    *pSize = (size_t)size;
+    return pu8Buf;
+}
+
+static size_t Lz_Compress(const uint8_t *pu8In, size_t inLen, uint8_t *pu8Out)
+{
+    size_t i = 0, outLen = 0, flagPos = 0, dist, bestDist = 0, len, bestLen;
+    uint32_t u32Item = 8, u32Token;
+
+    while(i < inLen)
+    {
+        if(u32Item == 8)
+        {
+            flagPos = outLen++;
+            pu8Out[flagPos] = 0;
+            u32Item = 0;
+        }
+
+        /* Greedy search of the longest match in the last page */
+        bestLen = 0;
+        for(dist = 1; (dist <= LZ_MAX_DIST) && (dist <= i); dist++)
+        {
+            for(len = 0; (len < LZ_MAX_MATCH) && (i + len < inLen) && (pu8In[i + len] == pu8In[i + len - dist]); len++);
+            if(len > bestLen)
+            {
+                bestLen = len;
+                bestDist = dist;
+                if(len == LZ_MAX_MATCH)
+                    break;
+            }
+        }
+
+        if(bestLen >= LZ_MIN_MATCH)
+        {
+            u32Token = (uint32_t)(bestDist - 1) | ((uint32_t)(bestLen - LZ_MIN_MATCH) << 9);
+            pu8Out[outLen++] = (uint8_t)u32Token;
+            pu8Out[outLen++] = (uint8_t)(u32Token >> 8);
+            i += bestLen;
+        }
+        else
+        {
+            pu8Out[flagPos] |= (uint8_t)(1 << u32Item);
+            pu8Out[outLen++] = pu8In[i++];
+        }
+        u32Item++;
+    }
+
+    return outLen;
+}
+
+static size_t Lz_Decompress(const uint8_t *pu8In, size_t inLen, uint8_t *pu8Out, size_t outMax)
+{
+    size_t i = 0, outLen = 0, dist, len;
+    uint32_t u32Flags = 1, u32Token;
+
+    while(i < inLen)
+    {
+        if(u32Flags == 1)
+        {
+            u32Flags = pu8In[i++] | 0x100;
+            continue;
+        }
+
+        if(u32Flags & 1)
+        {
+            if(outLen >= outMax)
+                return 0;
+            pu8Out[outLen++] = pu8In[i++];
+        }
+        else
+        {
+            if(i + 2 > inLen)
+                return 0;
+            u32Token = pu8In[i] | ((uint32_t)pu8In[i + 1] << 8);
+            i += 2;
+            dist = (u32Token & 0x1FF) + 1;
+            len = (u32Token >> 9) + LZ_MIN_MATCH;
+            if((dist > outLen) || (outLen + len > outMax))
+                return 0;
+            while(len--)
+            {
+                pu8Out[outLen] = pu8Out[outLen - dist];
+                outLen++;
+            }
+        }
+        u32Flags >>= 1;
+    }
+
+    return outLen;
+}
+
+int main(int argc, char *argv[])
+{
+    int i32Decompress = 0, i32Arg = 1;
+    uint8_t *pu8In, *pu8Out;
+    size_t inLen, outLen, outMax;
+    FILE *fp;
+
+    if((argc > 1) && (strcmp(argv[1], "-d") == 0))
+    {
+        i32Decompress = 1;
+        i32Arg++;
+    }
+    if(argc != i32Arg + 2)
+    {
+        fprintf(stderr, "Usage: %s [-d] <input> <output>\n", argv[0]);
+        return 1;
+    }
+
+    pu8In = ReadFile(argv[i32Arg], &inLen);
+    if(pu8In == NULL)
+        return 1;
+
+    /* Worst case of compression is one flag byte per 8 literals; a match expands to at most LZ_MAX_MATCH bytes */
+    outMax = i32Decompress ? (inLen * LZ_MAX_MATCH / 2 + 1) : (inLen + inLen / 8 + 1);
+    pu8Out = malloc(outMax);
+    if(pu8Out == NULL)
+        return 1;
+
+    if(i32Decompress)
+    {
+        outLen = Lz_Decompress(pu8In, inLen, pu8Out, outMax);
+        if((outLen == 0) && (inLen != 0))
+        {
+            fprintf(stderr, "%s: invalid stream\n", argv[i32Arg]);
+            return 1;
+        }
+    }
+    else
+    {
+        outLen = Lz_Compress(pu8In, inLen, pu8Out);
+    }
+
+    fp = fopen(argv[i32Arg + 1], "wb");
+    if((fp == NULL) || (fwrite(pu8Out, 1, outLen, fp) != outLen))
+    {
+        perror(argv[i32Arg + 1]);
+        return 1;
+    }
+    fclose(fp);
+
+    fprintf(stderr, "%lu -> %lu bytes\n", (unsigned long)inLen, (unsigned long)outLen);
+    return 0;
+}
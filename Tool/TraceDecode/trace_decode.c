@@ -0,0 +1,447 @@
+/**************************************************************************//**
+ * @file     trace_decode.c
+ * @version  V3.00
+ * @brief    Host-side decoder for the StdDriver tokenized trace records
+ *
+ * @details  The firmware emits TRACE0 ~ TRACE4 records whose ID is the address of the format string in the
+ *           trace_fmt section. This tool rebuilds the dictionary from the ELF/AXF image, or from a dictionary
+ *           file exported at build time, and prints the records as text.
+ *
+ *           Build:   cc -O2 -o trace_decode trace_decode.c
+ *           Export:  trace_decode -x firmware.elf > firmware.dict
+ *           Decode:  trace_decode firmware.dict /dev/ttyUSB0
+ *                    trace_decode firmware.elf < capture.bin
+ *
+ *           The serial port must already be set up in raw mode, e.g. "stty -F /dev/ttyUSB0 115200 raw".
+ *           Records are COBS frames ended by 0x00, so decoding can start at any point of the stream and
+ *           continues with the next frame after a lost or corrupted byte.
+ *
+ * @note
+ * SPDX-License-Identifier: Apache-2.0
+ * Copyright (C) 2013 Nuvoton Technology Corp. All rights reserved.
+ *****************************************************************************/
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <ctype.h>
+
+#define TRACE_MAX_ARGS      4
+#define TRACE_ID_DROPPED    0xFFFFFFFFUL
+
+typedef struct
+{
+    uint32_t u32Addr;
+    char *pcFmt;
+} DICT_ENTRY_T;
+
+static DICT_ENTRY_T *s_psDict = NULL;
+static uint32_t s_u32DictNum = 0;
+
+static void Dict_Add(uint32_t u32Addr, const char *pcFmt, size_t len)
+{
+    s_psDict = realloc(s_psDict, (s_u32DictNum + 1) * sizeof(DICT_ENTRY_T));
+    s_psDict[s_u32DictNum].u32Addr = u32Addr;
+    s_psDict[s_u32DictNum].pcFmt = malloc(len + 1);
+    memcpy(s_psDict[s_u32DictNum].pcFmt, pcFmt, len);
+    s_psDict[s_u32DictNum].pcFmt[len] = '\0';
+    s_u32DictNum++;
+}
+
+static const char *Dict_Find(uint32_t u32Addr)
+{
+    uint32_t i;
+
+    for(i = 0; i < s_u32DictNum; i++)
+    {
+        if(s_psDict[i].u32Addr == u32Addr)
+            return s_psDict[i].pcFmt;
+    }
+    return NULL;
+}
+
+static uint32_t Get16(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8);
+}
+
+static uint32_t Get32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/* Collect the strings of section trace_fmt from a little endian ELF32 image */
+static int Dict_LoadElf(const uint8_t *pu8Img, size_t size)
+{
+    uint32_t u32ShOff, u32ShEntSize, u32ShNum, u32ShStrNdx, i;
+    const uint8_t *pu8StrSh;
+
+    if((size < 52) || (pu8Img[4] != 1) || (pu8Img[5] != 1))
+    {
+        fprintf(stderr, "Only little endian ELF32 images are supported\n");
+        return -1;
+    }
+
+    u32ShOff = Get32(&pu8Img[32]);
+    u32ShEntSize = Get16(&pu8Img[46]);
+    u32ShNum = Get16(&pu8Img[48]);
+    u32ShStrNdx = Get16(&pu8Img[50]);
+    if((u32ShOff + u32ShNum * u32ShEntSize > size) || (u32ShStrNdx >= u32ShNum))
+        return -1;
+
+    pu8StrSh = &pu8Img[u32ShOff + u32ShStrNdx * u32ShEntSize];
+
+    for(i = 0; i < u32ShNum; i++)
+    {
+        const uint8_t *pu8Sh = &pu8Img[u32ShOff + i * u32ShEntSize];
+        const char *pcName = (const char *)&pu8Img[Get32(&pu8StrSh[16]) + Get32(&pu8Sh[0])];
+        uint32_t u32Addr = Get32(&pu8Sh[12]);
+        uint32_t u32Off = Get32(&pu8Sh[16]);
+        uint32_t u32Size = Get32(&pu8Sh[20]);
+        uint32_t u32Pos = 0;
+
+        if(strcmp(pcName, "trace_fmt") != 0)
+            continue;
+        if(u32Off + u32Size > size)
+            return -1;
+
+        /* Strings are NUL terminated; compilers may pad between them */
+        while(u32Pos < u32Size)
+        {
+            const char *pcStr = (const char *)&pu8Img[u32Off + u32Pos];
+            size_t len = strnlen(pcStr, u32Size - u32Pos);
+
+            if(len)
+                Dict_Add(u32Addr + u32Pos, pcStr, len);
+            u32Pos += len + 1;
+        }
+        return 0;
+    }
+
+    fprintf(stderr, "Section trace_fmt not found\n");
+    return -1;
+}
+
+/* Dictionary file lines are "<hex address> <escaped format string>" */
+static int Dict_LoadText(FILE *fp)
+{
+    char acLine[1024], acFmt[1024];
+    char *pcSrc;
+    size_t len;
+    uint32_t u32Addr;
+
+    while(fgets(acLine, sizeof(acLine), fp))
+    {
+        u32Addr = (uint32_t)strtoul(acLine, &pcSrc, 16);
+        if((pcSrc == acLine) || (*pcSrc != ' '))
+            continue;
+        pcSrc++;
+
+        len = 0;
+        while(*pcSrc && (*pcSrc != '\n') && (len < sizeof(acFmt)))
+        {
+            if(*pcSrc != '\\')
+            {
+                acFmt[len++] = *pcSrc++;
+                continue;
+            }
+            pcSrc++;
+            switch(*pcSrc)
+            {
+                case 'n':
+                    acFmt[len++] = '\n';
+                    pcSrc++;
+                    break;
+                case 'r':
+                    acFmt[len++] = '\r';
+                    pcSrc++;
+                    break;
+                case 't':
+                    acFmt[len++] = '\t';
+                    pcSrc++;
+                    break;
+                case 'x':
+                    acFmt[len++] = (char)strtoul(pcSrc + 1, &pcSrc, 16);
+                    break;
+                default:
+                    acFmt[len++] = *pcSrc++;
+            }
+        }
+        Dict_Add(u32Addr, acFmt, len);
+    }
+    return 0;
+}
+
+static void Dict_Export(void)
+{
+    uint32_t i;
+    const char *pc;
+
+    for(i = 0; i < s_u32DictNum; i++)
+    {
+        printf("%08x ", s_psDict[i].u32Addr);
+        for(pc = s_psDict[i].pcFmt; *pc; pc++)
+        {
+            if(*pc == '\n')
+                printf("\\n");
+            else if(*pc == '\r')
+                printf("\\r");
+            else if(*pc == '\t')
+                printf("\\t");
+            else if(*pc == '\\')
+                printf("\\\\");
+            else if(!isprint((unsigned char)*pc))
+                printf("\\x%02x", (unsigned char)*pc);
+            else
+                putchar(*pc);
+        }
+        putchar('\n');
+    }
+}
+
+/* printf the format with 32-bit raw arguments, mapping each conversion to a host type of the same width */
+static void Trace_Print(const char *pcFmt, const uint32_t *pu32Argv, uint32_t u32Argc)
+{
+    char acSpec[32];
+    uint32_t u32Arg = 0;
+    size_t len;
+
+    while(*pcFmt)
+    {
+        if(*pcFmt != '%')
+        {
+            putchar(*pcFmt++);
+            continue;
+        }
+        if(pcFmt[1] == '%')
+        {
+            putchar('%');
+            pcFmt += 2;
+            continue;
+        }
+
+        /* Copy flags, width and precision; drop length modifiers since every argument is 32-bit */
+        len = 0;
+        acSpec[len++] = *pcFmt++;
+        while(*pcFmt && strchr("-+ #0123456789.*hlLzjt", *pcFmt) && (len < sizeof(acSpec) - 3))
+        {
+            if(*pcFmt == '*')
+            {
+                len += snprintf(&acSpec[len], sizeof(acSpec) - len, "%d", (u32Arg < u32Argc) ? (int32_t)pu32Argv[u32Arg] : 0);
+                u32Arg++;
+            }
+            else if(!strchr("hlLzjt", *pcFmt))
+                acSpec[len++] = *pcFmt;
+            pcFmt++;
+        }
+        if(*pcFmt == '\0')
+            break;
+
+        acSpec[len++] = *pcFmt;
+        acSpec[len] = '\0';
+
+        if(u32Arg >= u32Argc)
+        {
+            printf("<missing>");
+            pcFmt++;
+            continue;
+        }
+
+        switch(*pcFmt)
+        {
+            case 'd':
+            case 'i':
+            case 'c':
+                printf(acSpec, (int)(int32_t)pu32Argv[u32Arg]);
+                break;
+            case 'u':
+            case 'x':
+            case 'X':
+            case 'o':
+                printf(acSpec, (unsigned int)pu32Argv[u32Arg]);
+                break;
+            case 'p':
+                printf("0x%08x", pu32Argv[u32Arg]);
+                break;
+            case 's':
+                /* Only strings from the dictionary can be shown */
+                if(Dict_Find(pu32Argv[u32Arg]))
+                    printf(acSpec, Dict_Find(pu32Argv[u32Arg]));
+                else
+                    printf("<str 0x%08x>", pu32Argv[u32Arg]);
+                break;
+            default:
+                printf("<%s 0x%08x>", acSpec, pu32Argv[u32Arg]);
+        }
+        u32Arg++;
+        pcFmt++;
+    }
+}
+
+static int Trace_GetVarint(const uint8_t *pu8Rec, uint32_t u32Len, uint32_t *pu32Pos, uint32_t *pu32Val)
+{
+    uint32_t u32Val = 0, u32Shift = 0;
+
+    while(*pu32Pos < u32Len)
+    {
+        uint8_t u8 = pu8Rec[(*pu32Pos)++];
+
+        u32Val |= (uint32_t)(u8 & 0x7F) << u32Shift;
+        if((u8 & 0x80) == 0)
+        {
+            *pu32Val = u32Val;
+            return 0;
+        }
+        u32Shift += 7;
+        if(u32Shift > 28)
+            break;
+    }
+    return -1;
+}
+
+/* Decode a COBS frame without its 0x00 delimiter. Returns the record length, or -1 if the frame is corrupted. */
+static int Trace_Unframe(const uint8_t *pu8Frame, uint32_t u32Len, uint8_t *pu8Rec)
+{
+    uint32_t u32Pos = 0, u32Out = 0, u32Code, i;
+
+    while(u32Pos < u32Len)
+    {
+        u32Code = pu8Frame[u32Pos++];
+        if((u32Code == 0) || (u32Pos + u32Code - 1 > u32Len))
+            return -1;
+
+        for(i = 1; i < u32Code; i++)
+            pu8Rec[u32Out++] = pu8Frame[u32Pos++];
+        if((u32Code != 0xFF) && (u32Pos < u32Len))
+            pu8Rec[u32Out++] = 0;
+    }
+    return (int)u32Out;
+}
+
+static void Trace_Decode(FILE *fp)
+{
+    uint8_t au8Frame[256], au8Rec[256];
+    uint32_t au32Argv[TRACE_MAX_ARGS];
+    uint32_t u32Id, u32Argc, u32Pos, u32Val, u32FrameLen = 0;
+    int i32Ch, i32Len, i32Overrun = 0;
+    const char *pcFmt;
+
+    while((i32Ch = fgetc(fp)) != EOF)
+    {
+        if(i32Ch != 0)
+        {
+            if(u32FrameLen < sizeof(au8Frame))
+                au8Frame[u32FrameLen++] = (uint8_t)i32Ch;
+            else
+                i32Overrun = 1;
+            continue;
+        }
+
+        /* End of frame. A frame with a missing or wrong byte is skipped and decoding resumes at the next one. */
+        i32Len = i32Overrun ? -1 : Trace_Unframe(au8Frame, u32FrameLen, au8Rec);
+        u32FrameLen = 0;
+        i32Overrun = 0;
+        if(i32Len < 0)
+        {
+            printf("<bad record>\n");
+            continue;
+        }
+        if(i32Len == 0)
+            continue;
+        if(au8Rec[0] != (uint32_t)i32Len - 1)
+        {
+            printf("<bad record>\n");
+            continue;
+        }
+
+        u32Pos = 1;
+        if(Trace_GetVarint(au8Rec, (uint32_t)i32Len, &u32Pos, &u32Id) != 0)
+        {
+            printf("<bad record>\n");
+            continue;
+        }
+
+        u32Argc = 0;
+        while((u32Argc < TRACE_MAX_ARGS) && (Trace_GetVarint(au8Rec, (uint32_t)i32Len, &u32Pos, &u32Val) == 0))
+            au32Argv[u32Argc++] = (u32Val >> 1) ^ ((u32Val & 1) ? 0xFFFFFFFFUL : 0);
+
+        if(u32Id == TRACE_ID_DROPPED)
+        {
+            printf("<%u records dropped>\n", (u32Argc > 0) ? au32Argv[0] : 0);
+            continue;
+        }
+
+        pcFmt = Dict_Find(u32Id);
+        if(pcFmt == NULL)
+        {
+            printf("<unknown id 0x%08x>\n", u32Id);
+            continue;
+        }
+        Trace_Print(pcFmt, au32Argv, u32Argc);
+        fflush(stdout);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int i32Export = 0, i32Arg = 1;
+    FILE *fp;
+    uint8_t *pu8Img;
+    long size;
+
+    if((argc > 1) && (strcmp(argv[1], "-x") == 0))
+    {
+        i32Export = 1;
+        i32Arg++;
+    }
+    if(argc <= i32Arg)
+    {
+        fprintf(stderr, "Usage: %s [-x] <image.elf | image.dict> [stream]\n", argv[0]);
+        return 1;
+    }
+
+    fp = fopen(argv[i32Arg], "rb");
+    if(fp == NULL)
+    {
+        perror(argv[i32Arg]);
+        return 1;
+    }
+    fseek(fp, 0, SEEK_END);
+    size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+    pu8Img = malloc((size_t)size + 1);
+    if((pu8Img == NULL) || (fread(pu8Img, 1, (size_t)size, fp) != (size_t)size))
+        return 1;
+
+    if((size >= 4) && (memcmp(pu8Img, "\177ELF", 4) == 0))
+    {
+        if(Dict_LoadElf(pu8Img, (size_t)size) != 0)
+            return 1;
+    }
+    else
+    {
+        rewind(fp);
+        Dict_LoadText(fp);
+    }
+    fclose(fp);
+
+    if(i32Export)
+    {
+        Dict_Export();
+        return 0;
+    }
+
+    fp = stdin;
+    if(argc > i32Arg + 1)
+    {
+        fp = fopen(argv[i32Arg + 1], "rb");
+        if(fp == NULL)
+        {
+            perror(argv[i32Arg + 1]);
+            return 1;
+        }
+    }
+    Trace_Decode(fp);
+
+    return 0;
+}